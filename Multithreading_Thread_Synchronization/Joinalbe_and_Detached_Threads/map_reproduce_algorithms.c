@@ -1,126 +1,182 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <pthread.h>
-#include <unistd.h>
-
-#define FILENAME		"story_novel.txt"
-#define PROCESS_LINE	200
-#define MAX_LINE_LENGTH	1024
-
-typedef struct {
-	const char* filename;
-	int start_offset;
-	int end_offset;
-	int total_characters;
-} thread_data;
-
-void* worker_thread (void* arg) {
-
-	thread_data* data = arg;
-	int pcurrent = data->start_offset;
-	FILE* fd = fopen(data->filename, "r");
-
-	data->total_characters = 0;
-
-	if (fd == NULL) {
-		printf("Error opening file\n");
-		pthread_exit(NULL);
-	}
-
-	fseek(fd, data->start_offset, SEEK_SET);
-	char buffer[MAX_LINE_LENGTH];
-
-	while (fgets(buffer, MAX_LINE_LENGTH, fd)) {
-		int len = strlen(buffer);
-		
-		if (buffer[len - 1] == '\n') {
-			--len;
-		}
-
-		data->total_characters += len;
-
-		if ((pcurrent += ftell(fd)) >= data->end_offset) {
-			break;
-		}
-	}
-
-	fclose(fd);
-	pthread_exit;
-}
-
-int main (int argc, char* argv[]) {
-
-	FILE* fd 						= NULL;
-	pthread_t* thread_pool 			= NULL;
-	thread_data* thread_datas 		= NULL;
-	int lines = 0, num_of_workers 	= 0;
-	int (*content_range)[2];
-	int start = 0, end = PROCESS_LINE - 1;
-	char ch;
-
-	fd = fopen(FILENAME, "r");
-
-	if (fd == NULL) {
-		printf("Error opening file\n");
-		return -1;
-	}
-
-	while ((ch = fgetc(fd)) != EOF) {
-		if (ch == '\n') {
-			++lines;
-		}
-	}
-
-	printf("this file contain %d lines\n", lines);
-
-	if (lines == 0) {
-		printf("No content in this file\n");
-		return 0;
-	}
-
-	if (lines <= end) {
-		end = lines - 1;
-	}
-
-	num_of_workers = lines / PROCESS_LINE;
-	num_of_workers = lines % PROCESS_LINE ? num_of_workers + 1 : num_of_workers;
-
-	if ((thread_pool = malloc(sizeof(pthread_t) * num_of_workers)) == NULL) {
-		printf("malloc failed : run out of memory\n");
-	}
-
-	if ((thread_datas = malloc(sizeof(thread_data) * num_of_workers)) == NULL) {
-		printf("malloc failed : run out of memory\n");
-	}	
-
-	if ((content_range = malloc(sizeof(int) * 2 * num_of_workers)) == NULL) {
-		printf("malloc failed : run out of memory\n");
-	}
-
-	for (int i = 0; i < num_of_workers; ++i) {
-		content_range[i][0] = start;
-		content_range[i][1] = end;
-
-		start += PROCESS_LINE;
-		end = end + PROCESS_LINE >= lines ? lines : end + PROCESS_LINE;
-
-		thread_datas[i].filename 	= FILENAME;
-		thread_datas[i].start_offset = start;
-		thread_datas[i].end_offset 	= end;
-
-		pthread_create(&thread_pool[i], NULL, worker_thread, (void*)&thread_datas[i]);
-	}
-
-	int total_characters = 0;
-
-	for (int i = 0; i < num_of_workers; ++i) {
-		pthread_join(thread_pool[i], NULL);
-		printf("worker thread %d : %d\n", i, thread_datas[i].total_characters);
-		total_characters += thread_datas[i].total_characters;
-	}
-
-	printf("Total characters in the file: %d\n", total_characters);
-
-	return 0;
-}
\ No newline at end of file
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "text_scan.h"
+
+#define FILENAME		"story_novel.txt"
+#define MIN_CHUNK_SIZE	(64 * 1024)
+#define MAX_CHUNK_SIZE	(64 * 1024 * 1024)
+
+/*
+ * The file is mapped once and cut in chunks of about size / workers bytes,
+ * at most MAX_CHUNK_SIZE, so a multi-GB file is handled by the same fixed
+ * set of workers pulling chunk after chunk. A chunk boundary is moved
+ * forward to just past the next newline, both workers sharing a boundary
+ * compute the same position so every line belongs to exactly one chunk.
+ *
+ * Reported lines include a last line without a newline, one more than
+ * wc -l for such a file. Characters leave the newlines out, see text_scan.h.
+ *
+ * gcc -O2 map_reproduce_algorithms.c text_scan.c -o map_reduce -lpthread
+ */
+typedef struct {
+	const char* base;
+	size_t size;
+	size_t chunk_size;
+	uint64_t num_of_chunks;
+	uint64_t next_chunk;		// Next chunk to hand out, atomic
+	uint64_t total_lines;		// Reduced results, atomic
+	uint64_t total_characters;
+	uint64_t total_words;
+} map_input;
+
+typedef struct {
+	pthread_t thread;
+	map_input* input;
+	uint64_t chunks;
+	text_counts counts;
+} thread_data;
+
+static size_t chunk_boundary (const map_input* in, uint64_t chunk) {
+
+	size_t pos = chunk * in->chunk_size;
+	const char* nl;
+
+	if (chunk == 0) {
+		return 0;
+	}
+	if (pos >= in->size) {
+		return in->size;
+	}
+
+	nl = memchr(in->base + pos - 1, '\n', in->size - pos + 1);
+	return nl ? (size_t)(nl - in->base) + 1 : in->size;
+}
+
+void* worker_thread (void* arg) {
+
+	thread_data* data = arg;
+	map_input* in = data->input;
+	uint64_t chunk;
+	size_t start, end;
+
+	data->chunks = 0;
+	memset(&data->counts, 0, sizeof(text_counts));
+
+	while ((chunk = __atomic_fetch_add(&in->next_chunk, 1, __ATOMIC_RELAXED)) < in->num_of_chunks) {
+
+		start = chunk_boundary(in, chunk);
+		end = chunk_boundary(in, chunk + 1);
+		if (start >= end) {
+			continue;		// A single line spans the whole chunk
+		}
+
+		// Chunks start on a line start, words are not split between two
+		text_count(in->base + start, end - start, &data->counts);
+
+		// A last line without its newline still counts as a line
+		data->counts.lines += end == in->size && in->base[end - 1] != '\n';
+		data->chunks++;
+	}
+
+	__atomic_fetch_add(&in->total_lines, data->counts.lines, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&in->total_characters, data->counts.chars, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&in->total_words, data->counts.words, __ATOMIC_RELAXED);
+	return NULL;
+}
+
+int main (int argc, char* argv[]) {
+
+	const char* filename 			= argc > 1 ? argv[1] : FILENAME;
+	thread_data* thread_datas 		= NULL;
+	map_input input 				= {0};
+	long num_of_workers 			= sysconf(_SC_NPROCESSORS_ONLN);
+	struct stat st;
+	int fd, rc;
+
+	fd = open(filename, O_RDONLY);
+
+	if (fd < 0 || fstat(fd, &st) < 0) {
+		printf("Error opening file\n");
+		return -1;
+	}
+
+	if (st.st_size == 0) {
+		printf("No content in this file\n");
+		close(fd);
+		return 0;
+	}
+
+	input.size = st.st_size;
+	input.base = mmap(NULL, input.size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (input.base == MAP_FAILED) {
+		perror("mmap");
+		return -1;
+	}
+	madvise((void*)input.base, input.size, MADV_SEQUENTIAL);
+
+	if (num_of_workers < 1) {
+		num_of_workers = 1;
+	}
+
+	input.chunk_size = input.size / num_of_workers + 1;
+	if (input.chunk_size < MIN_CHUNK_SIZE) {
+		input.chunk_size = MIN_CHUNK_SIZE;
+	}
+	if (input.chunk_size > MAX_CHUNK_SIZE) {
+		input.chunk_size = MAX_CHUNK_SIZE;
+	}
+	input.num_of_chunks = (input.size + input.chunk_size - 1) / input.chunk_size;
+
+	if ((uint64_t)num_of_workers > input.num_of_chunks) {
+		num_of_workers = input.num_of_chunks;
+	}
+
+	if ((thread_datas = calloc(num_of_workers, sizeof(thread_data))) == NULL) {
+		printf("malloc failed : run out of memory\n");
+		munmap((void*)input.base, input.size);
+		return -1;
+	}
+
+	for (int i = 0; i < num_of_workers; ++i) {
+		thread_datas[i].input = &input;
+
+		if ((rc = pthread_create(&thread_datas[i].thread, NULL, worker_thread, &thread_datas[i]))) {
+			printf("Error: unable to create thread, return value: %d\n", rc);
+			num_of_workers = i;
+			break;
+		}
+	}
+
+	// No worker could be started, map the file from here
+	if (num_of_workers == 0) {
+		thread_datas[0].input = &input;
+		worker_thread(&thread_datas[0]);
+	}
+
+	for (int i = 0; i < num_of_workers; ++i) {
+		pthread_join(thread_datas[i].thread, NULL);
+		printf("worker thread %d : %llu chunks, %llu lines, %llu characters, %llu words\n", i,
+			   (unsigned long long)thread_datas[i].chunks,
+			   (unsigned long long)thread_datas[i].counts.lines,
+			   (unsigned long long)thread_datas[i].counts.chars,
+			   (unsigned long long)thread_datas[i].counts.words);
+	}
+
+	printf("this file contain %llu lines\n", (unsigned long long)input.total_lines);
+	printf("Total characters in the file: %llu\n", (unsigned long long)input.total_characters);
+	printf("Total words in the file: %llu (%s scan)\n", (unsigned long long)input.total_words, text_scan->name);
+
+	munmap((void*)input.base, input.size);
+	free(thread_datas);
+	return 0;
+}
@@ -0,0 +1,237 @@
+#include <string.h>
+#include "text_scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TEXT_SCAN_X86
+#include <immintrin.h>
+#endif
+
+static inline int is_blank (unsigned char c) {
+	return c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t';
+}
+
+/* Eight bytes at a time : a byte of w ^ 0x0a0a..0a is zero exactly
+ * where the input byte is a newline, and ((v & 0x7f..) + 0x7f..) | v has
+ * its high bit clear only for zero bytes, without carries between bytes */
+static uint64_t count_newlines_scalar (const char* p, size_t len) {
+
+	const uint64_t ones = 0x0101010101010101ULL;
+	const uint64_t low7 = 0x7f7f7f7f7f7f7f7fULL;
+	uint64_t count = 0, w, v;
+	size_t i = 0;
+
+	for (; i + 8 <= len; i += 8) {
+		memcpy(&w, p + i, 8);
+		v = w ^ (ones * '\n');
+		v = ~(((v & low7) + low7) | v | low7);
+		count += __builtin_popcountll(v);
+	}
+	for (; i < len; ++i) {
+		count += p[i] == '\n';
+	}
+	return count;
+}
+
+static void count_tail (const unsigned char* p, size_t len, text_counts* counts, int prev_blank) {
+
+	int blank;
+
+	for (size_t i = 0; i < len; ++i) {
+		blank = is_blank(p[i]);
+		counts->lines += p[i] == '\n';
+		counts->chars += p[i] != '\n' && (p[i] & 0xc0) != 0x80;
+		counts->words += !blank && prev_blank;
+		prev_blank = blank;
+	}
+}
+
+static void count_scalar (const char* p, size_t len, text_counts* counts) {
+	count_tail((const unsigned char*)p, len, counts, 1);
+}
+
+static const text_scan_impl text_scan_scalar = {
+	"scalar", count_newlines_scalar, count_scalar
+};
+
+#ifdef TEXT_SCAN_X86
+
+/*
+ * The SIMD kernels compare a whole vector at once and subtract the 0xff
+ * masks from byte wide accumulators, each byte counting up to 255 hits.
+ * Every 255 vectors the accumulators are summed into 64 bit counters with
+ * psadbw. A byte is blank when it is ' ' or when byte - '\t' <= 4 unsigned,
+ * done with min_epu8 as SSE2/AVX2 have no unsigned byte compare. A word
+ * starts on a non blank byte whose previous byte, possibly the last one of
+ * the previous vector, is blank.
+ */
+#define TEXT_SCAN_FLUSH		255
+
+__attribute__((target("sse2")))
+static inline uint64_t hsum_sse2 (__m128i acc) {
+
+	__m128i sum = _mm_sad_epu8(acc, _mm_setzero_si128());
+	return (uint64_t)_mm_cvtsi128_si32(sum) + (uint64_t)_mm_cvtsi128_si32(_mm_unpackhi_epi64(sum, sum));
+}
+
+__attribute__((target("sse2")))
+static inline __m128i blank_sse2 (__m128i v) {
+
+	__m128i t = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+	return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+						_mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8('\r' - '\t')), t));
+}
+
+__attribute__((target("sse2")))
+static uint64_t count_newlines_sse2 (const char* p, size_t len) {
+
+	const __m128i nl = _mm_set1_epi8('\n');
+	__m128i acc;
+	uint64_t count = 0;
+	size_t i = 0;
+	int n;
+
+	while (i + 16 <= len) {
+		acc = _mm_setzero_si128();
+		for (n = 0; n < TEXT_SCAN_FLUSH && i + 16 <= len; ++n, i += 16) {
+			acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i)), nl));
+		}
+		count += hsum_sse2(acc);
+	}
+	return count + count_newlines_scalar(p + i, len - i);
+}
+
+__attribute__((target("sse2")))
+static void count_sse2 (const char* p, size_t len, text_counts* counts) {
+
+	const __m128i nl = _mm_set1_epi8('\n');
+	const __m128i cont_mask = _mm_set1_epi8((char)0xc0);
+	const __m128i cont = _mm_set1_epi8((char)0x80);
+	__m128i v, blank, prev_blank = _mm_set1_epi8(-1);
+	__m128i acc_nl, acc_cont, acc_words;
+	uint64_t lines, skipped = 0;
+	size_t i = 0;
+	int n;
+
+	while (i + 16 <= len) {
+		acc_nl = acc_cont = acc_words = _mm_setzero_si128();
+		for (n = 0; n < TEXT_SCAN_FLUSH && i + 16 <= len; ++n, i += 16) {
+			v = _mm_loadu_si128((const __m128i*)(p + i));
+			blank = blank_sse2(v);
+			acc_nl = _mm_sub_epi8(acc_nl, _mm_cmpeq_epi8(v, nl));
+			acc_cont = _mm_sub_epi8(acc_cont, _mm_cmpeq_epi8(_mm_and_si128(v, cont_mask), cont));
+			// Blank mask of the previous byte of every lane
+			prev_blank = _mm_or_si128(_mm_slli_si128(blank, 1), _mm_srli_si128(prev_blank, 15));
+			acc_words = _mm_sub_epi8(acc_words, _mm_andnot_si128(blank, prev_blank));
+			prev_blank = blank;
+		}
+		lines = hsum_sse2(acc_nl);
+		counts->lines += lines;
+		skipped += lines + hsum_sse2(acc_cont);
+		counts->words += hsum_sse2(acc_words);
+	}
+	counts->chars += i - skipped;
+	count_tail((const unsigned char*)p + i, len - i, counts, i ? is_blank(p[i - 1]) : 1);
+}
+
+__attribute__((target("avx2")))
+static inline uint64_t hsum_avx2 (__m256i acc) {
+
+	__m256i sum = _mm256_sad_epu8(acc, _mm256_setzero_si256());
+	__m128i s = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	return (uint64_t)_mm_cvtsi128_si32(s) + (uint64_t)_mm_cvtsi128_si32(_mm_unpackhi_epi64(s, s));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i blank_avx2 (__m256i v) {
+
+	__m256i t = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+	return _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+						   _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8('\r' - '\t')), t));
+}
+
+__attribute__((target("avx2")))
+static uint64_t count_newlines_avx2 (const char* p, size_t len) {
+
+	const __m256i nl = _mm256_set1_epi8('\n');
+	__m256i acc;
+	uint64_t count = 0;
+	size_t i = 0;
+	int n;
+
+	while (i + 32 <= len) {
+		acc = _mm256_setzero_si256();
+		for (n = 0; n < TEXT_SCAN_FLUSH && i + 32 <= len; ++n, i += 32) {
+			acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i)), nl));
+		}
+		count += hsum_avx2(acc);
+	}
+	return count + count_newlines_scalar(p + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static void count_avx2 (const char* p, size_t len, text_counts* counts) {
+
+	const __m256i nl = _mm256_set1_epi8('\n');
+	const __m256i cont_mask = _mm256_set1_epi8((char)0xc0);
+	const __m256i cont = _mm256_set1_epi8((char)0x80);
+	__m256i v, blank, prev_blank = _mm256_set1_epi8(-1);
+	__m256i acc_nl, acc_cont, acc_words;
+	uint64_t lines, skipped = 0;
+	size_t i = 0;
+	int n;
+
+	while (i + 32 <= len) {
+		acc_nl = acc_cont = acc_words = _mm256_setzero_si256();
+		for (n = 0; n < TEXT_SCAN_FLUSH && i + 32 <= len; ++n, i += 32) {
+			v = _mm256_loadu_si256((const __m256i*)(p + i));
+			blank = blank_avx2(v);
+			acc_nl = _mm256_sub_epi8(acc_nl, _mm256_cmpeq_epi8(v, nl));
+			acc_cont = _mm256_sub_epi8(acc_cont, _mm256_cmpeq_epi8(_mm256_and_si256(v, cont_mask), cont));
+			// Shift by one byte across the 128 bit lanes, pulling in the
+			// last byte of the previous vector
+			prev_blank = _mm256_alignr_epi8(blank, _mm256_permute2x128_si256(prev_blank, blank, 0x21), 15);
+			acc_words = _mm256_sub_epi8(acc_words, _mm256_andnot_si256(blank, prev_blank));
+			prev_blank = blank;
+		}
+		lines = hsum_avx2(acc_nl);
+		counts->lines += lines;
+		skipped += lines + hsum_avx2(acc_cont);
+		counts->words += hsum_avx2(acc_words);
+	}
+	counts->chars += i - skipped;
+	count_tail((const unsigned char*)p + i, len - i, counts, i ? is_blank(p[i - 1]) : 1);
+}
+
+static const text_scan_impl text_scan_sse2 = {
+	"sse2", count_newlines_sse2, count_sse2
+};
+
+static const text_scan_impl text_scan_avx2 = {
+	"avx2", count_newlines_avx2, count_avx2
+};
+
+#endif
+
+const text_scan_impl* text_scan = &text_scan_scalar;
+
+int text_scan_impls (const text_scan_impl** impls, int max) {
+
+	int n = 0;
+
+	if (n < max) impls[n++] = &text_scan_scalar;
+#ifdef TEXT_SCAN_X86
+	__builtin_cpu_init();
+	if (n < max && __builtin_cpu_supports("sse2")) impls[n++] = &text_scan_sse2;
+	if (n < max && __builtin_cpu_supports("avx2")) impls[n++] = &text_scan_avx2;
+#endif
+	return n;
+}
+
+/* Pick the last, hence widest, implementation before main( ) runs */
+__attribute__((constructor))
+static void text_scan_select (void) {
+
+	const text_scan_impl* impls[3];
+
+	text_scan = impls[text_scan_impls(impls, 3) - 1];
+}
@@ -0,0 +1,45 @@
+#ifndef TEXT_SCAN_H
+#define TEXT_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Byte scanning kernels for the map-reduce workers, in scalar, SSE2 and
+ * AVX2 flavours. The best one the CPU supports is picked once at startup.
+ *
+ * lines : newline bytes, what wc -l reports
+ * chars : UTF-8 characters other than '\n' (bytes not of the 10xxxxxx form).
+ *         wc -m counts the newlines too, so on valid UTF-8 this is wc -m - wc -l
+ * words : word starts, a non blank byte after a blank one (' ', \t \n \v \f \r).
+ *         The byte before the buffer is taken as blank, so buffers must start
+ *         at a line start to count words across chunks without overlap.
+ *         Matches wc -w unless the text has non ASCII spaces, which wc
+ *         splits on in a UTF-8 locale.
+ */
+typedef struct {
+	uint64_t lines;
+	uint64_t chars;
+	uint64_t words;
+} text_counts;
+
+typedef struct {
+	const char* name;
+	uint64_t (*count_newlines) (const char* p, size_t len);
+	void (*count) (const char* p, size_t len, text_counts* counts);	// Adds to counts
+} text_scan_impl;
+
+extern const text_scan_impl* text_scan;
+
+static inline uint64_t text_count_newlines (const char* p, size_t len) {
+	return text_scan->count_newlines(p, len);
+}
+
+static inline void text_count (const char* p, size_t len, text_counts* counts) {
+	text_scan->count(p, len, counts);
+}
+
+/* Every implementation this CPU can run, scalar first, for benchmarks */
+int text_scan_impls (const text_scan_impl** impls, int max);
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ * GB/s of the text_scan kernels against the byte at a time loops
+ * map_reproduce_algorithms.c used to run : fgetc( ) for newlines and
+ * fgets( ) + strlen( ) for characters. The input file is repeated in
+ * memory up to size_mb, every kernel result is checked against scalar.
+ *
+ * gcc -O2 text_scan_bench.c text_scan.c -o text_scan_bench
+ * ./text_scan_bench [file] [size_mb]
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "text_scan.h"
+
+#define FILENAME		"story_novel.txt"
+#define BENCH_ROUNDS	5
+#define MAX_LINE_LENGTH	1024
+
+static double now_sec (void) {
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t fgetc_newlines (const char* buf, size_t len) {
+
+	FILE* fd = fmemopen((void*)buf, len, "r");
+	uint64_t lines = 0;
+	int ch;
+
+	while ((ch = fgetc(fd)) != EOF) {
+		if (ch == '\n') {
+			++lines;
+		}
+	}
+	fclose(fd);
+	return lines;
+}
+
+static uint64_t fgets_characters (const char* buf, size_t len) {
+
+	FILE* fd = fmemopen((void*)buf, len, "r");
+	char line[MAX_LINE_LENGTH];
+	uint64_t total_characters = 0;
+
+	while (fgets(line, MAX_LINE_LENGTH, fd)) {
+		size_t n = strlen(line);
+
+		if (line[n - 1] == '\n') {
+			--n;
+		}
+		total_characters += n;
+	}
+	fclose(fd);
+	return total_characters;
+}
+
+static char* load_input (const char* filename, size_t size) {
+
+	FILE* fd = fopen(filename, "r");
+	char* buf;
+	size_t len = 0, n;
+
+	if (fd == NULL || (buf = malloc(size)) == NULL) {
+		return NULL;
+	}
+
+	while (len < size) {
+		n = fread(buf + len, 1, size - len, fd);
+		if (n == 0) {
+			if (len == 0) {
+				free(buf);
+				fclose(fd);
+				return NULL;
+			}
+			rewind(fd);
+		}
+		len += n;
+	}
+	fclose(fd);
+	return buf;
+}
+
+/* Best of BENCH_ROUNDS, in GB/s */
+#define BENCH(gbps, size, expr) do {						\
+	double best = 1e30, start;								\
+	for (int round = 0; round < BENCH_ROUNDS; ++round) {	\
+		start = now_sec();									\
+		expr;												\
+		start = now_sec() - start;							\
+		if (start < best) best = start;						\
+	}														\
+	gbps = (size) / best / 1e9;								\
+} while (0)
+
+int main (int argc, char* argv[]) {
+
+	const char* filename = argc > 1 ? argv[1] : FILENAME;
+	size_t size = (size_t)(argc > 2 ? atoi(argv[2]) : 64) << 20;
+	const text_scan_impl* impls[4];
+	text_counts ref = {0}, counts;
+	uint64_t lines = 0, chars = 0;
+	int n_impls;
+	double gbps;
+	char* buf;
+
+	if ((buf = load_input(filename, size)) == NULL) {
+		printf("Error opening file\n");
+		return -1;
+	}
+
+	n_impls = text_scan_impls(impls, 4);
+	impls[0]->count(buf, size, &ref);
+	printf("%llu MB, %llu lines, %llu characters, %llu words, dispatching to %s\n\n",
+		   (unsigned long long)(size >> 20), (unsigned long long)ref.lines,
+		   (unsigned long long)ref.chars, (unsigned long long)ref.words, text_scan->name);
+
+	printf("%-24s %8s\n", "kernel", "GB/s");
+
+	BENCH(gbps, size, lines = fgetc_newlines(buf, size));
+	printf("%-24s %8.2f%s\n", "fgetc newlines", gbps, lines == ref.lines ? "" : "  MISMATCH");
+
+	BENCH(gbps, size, chars = fgets_characters(buf, size));
+	printf("%-24s %8.2f\n", "fgets+strlen characters", gbps);
+
+	for (int i = 0; i < n_impls; ++i) {
+		char name[32];
+
+		BENCH(gbps, size, lines = impls[i]->count_newlines(buf, size));
+		snprintf(name, sizeof(name), "%s newlines", impls[i]->name);
+		printf("%-24s %8.2f%s\n", name, gbps, lines == ref.lines ? "" : "  MISMATCH");
+
+		BENCH(gbps, size, memset(&counts, 0, sizeof(counts)); impls[i]->count(buf, size, &counts));
+		snprintf(name, sizeof(name), "%s lines/chars/words", impls[i]->name);
+		printf("%-24s %8.2f%s\n", name, gbps, memcmp(&counts, &ref, sizeof(ref)) ? "  MISMATCH" : "");
+	}
+
+	(void)chars;
+	free(buf);
+	return 0;
+}
@@ -1,5 +1,4 @@
 // Main demo program to demonstrate publisher-subscriber notification mechanism
-#define _GNU_SOURCE  // For strdup
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
@@ -13,9 +12,9 @@ void *publisher_thread_fn(void *arg) {
     printf("\n=== Publisher initializing routes ===\n");
     
     // Create initial route table entries
-    route_table_node_t *node1 = create_route_table_node(strdup("192.168.1.2"), strdup("255.255.255.0"), strdup("eth0"), strdup("192.168.0.1"));
-    route_table_node_t *node2 = create_route_table_node(strdup("192.168.1.3"), strdup("255.255.255.0"), strdup("eth0"), strdup("192.168.0.2"));
-    route_table_node_t *node3 = create_route_table_node(strdup("192.168.1.4"), strdup("255.255.255.0"), strdup("eth0"), strdup("192.168.0.3"));
+    route_table_node_t *node1 = create_route_table_node("192.168.1.2", "255.255.255.0", "eth0", "192.168.0.1");
+    route_table_node_t *node2 = create_route_table_node("192.168.1.3", "255.255.255.0", "eth0", "192.168.0.2");
+    route_table_node_t *node3 = create_route_table_node("192.168.1.4", "255.255.255.0", "eth0", "192.168.0.3");
 
     // Add the entries to the route table
     add_route_table_node(node1);
@@ -59,7 +58,8 @@ void *publisher_thread_fn(void *arg) {
                 printf("Enter gateway address: ");
                 scanf("%s", gateway);
                 
-                route_table_node_t *new_node = create_route_table_node(strdup(dest_addr), strdup(mask), strdup(oif), strdup(gateway));
+                route_table_node_t *new_node = create_route_table_node(dest_addr, mask, oif, gateway);
+                if (!new_node) break;
                 add_route_table_node(new_node);
                 printf("Route entry added successfully!\n");
                 break;
@@ -96,10 +96,13 @@ void *publisher_thread_fn(void *arg) {
                 }
                 
                 printf("\nCurrent entry:\n");
+                char mask_str[ROUTE_TABLE_ADDR_STR_LEN];
+                const char *node_oif = route_table_node_oif(node);
+                const char *node_gateway = route_table_node_gateway(node);
                 printf("Destination: %s, Mask: %s, OIF: %s, Gateway: %s\n",
-                       node->dest_addr, node->mask, 
-                       node->oif ? node->oif : "(null)", 
-                       node->gateway ? node->gateway : "(null)");
+                       route_table_node_dest_str(node, dest_addr), route_table_node_mask_str(node, mask_str), 
+                       node_oif ? node_oif : "(null)", 
+                       node_gateway ? node_gateway : "(null)");
                 
                 printf("\nWhich fields would you like to modify?\n");
                 printf("1. Mask\n");
@@ -164,6 +167,8 @@ void *publisher_thread_fn(void *arg) {
                 break;
             case 5:
                 printf("Exiting...\n");
+                route_table_dispatch_shutdown();
+                print_route_table_notif_stats();
                 exit(0);
             default:
                 printf("Invalid choice. Please try again.\n");
@@ -193,6 +198,9 @@ int main(int argc, char *argv[]) {
     set_route_table_head(table);
     printf("Route table initialized.\n");
 
+    // Worker pool delivering notifications of async subscribers
+    route_table_dispatch_init(ROUTE_TABLE_DISPATCH_DEFAULT_WORKERS);
+
     printf("DEBUG: About to create subscriber thread\n");
     fflush(stdout);
     
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include "rcu.h"
+
+typedef struct rcu_retired {
+    void *ptr;
+    void (*free_fn)(void *);
+    struct rcu_retired *next;
+} rcu_retired_t;
+
+// Epoch 0 is reserved for "quiescent"
+static uint64_t rcu_global_epoch = 1;
+
+// Registry of reader records, guarded by rcu_registry_mutex. Records are
+// never freed, an exiting thread leaves its record quiescent for reuse
+static rcu_reader_t *rcu_readers = NULL;
+static pthread_mutex_t rcu_registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Objects waiting for a grace period, guarded by rcu_retire_mutex
+static rcu_retired_t *rcu_retired_list = NULL;
+static uint32_t rcu_retired_count = 0;
+static pthread_mutex_t rcu_retire_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static __thread rcu_reader_t *rcu_self = NULL;
+
+static rcu_reader_t *rcu_register_thread(void) {
+    rcu_reader_t *reader;
+
+    pthread_mutex_lock(&rcu_registry_mutex);
+    // Reuse the record of a thread which has exited
+    for (reader = rcu_readers; reader; reader = reader->next) {
+        if (!reader->in_use) break;
+    }
+    if (!reader) {
+        reader = (rcu_reader_t *)calloc(1, sizeof(rcu_reader_t));
+        if (!reader) {
+            perror("Failed to allocate memory for rcu reader");
+            exit(EXIT_FAILURE);
+        }
+        reader->next = rcu_readers;
+        rcu_readers = reader;
+    }
+    reader->nesting = 0;
+    reader->in_use = true;
+    pthread_mutex_unlock(&rcu_registry_mutex);
+    return reader;
+}
+
+// Function to be called by reader threads before they exit
+void rcu_unregister_thread(void) {
+    if (!rcu_self) return;
+    pthread_mutex_lock(&rcu_registry_mutex);
+    __atomic_store_n(&rcu_self->epoch, 0, __ATOMIC_RELEASE);
+    rcu_self->in_use = false;
+    pthread_mutex_unlock(&rcu_registry_mutex);
+    rcu_self = NULL;
+}
+
+void rcu_read_lock(void) {
+    rcu_reader_t *self = rcu_self;
+
+    if (!self) {
+        self = rcu_self = rcu_register_thread();
+    }
+    if (self->nesting++) return;
+
+    __atomic_store_n(&self->epoch, __atomic_load_n(&rcu_global_epoch, __ATOMIC_RELAXED),
+                     __ATOMIC_RELAXED);
+    // Order the epoch publication before any read of the protected data
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void rcu_read_unlock(void) {
+    rcu_reader_t *self = rcu_self;
+
+    if (--self->nesting) return;
+    __atomic_store_n(&self->epoch, 0, __ATOMIC_RELEASE);
+}
+
+// Function to wait until every reader which entered its read-side section
+// before this call has left it
+void rcu_synchronize(void) {
+    rcu_reader_t *reader;
+    uint64_t epoch, new_epoch;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    new_epoch = __atomic_add_fetch(&rcu_global_epoch, 1, __ATOMIC_SEQ_CST);
+
+    pthread_mutex_lock(&rcu_registry_mutex);
+    for (reader = rcu_readers; reader; reader = reader->next) {
+        // A writer calling back into readers must not wait for itself
+        if (reader == rcu_self) continue;
+        while ((epoch = __atomic_load_n(&reader->epoch, __ATOMIC_ACQUIRE)) &&
+               epoch < new_epoch) {
+            sched_yield();
+        }
+    }
+    pthread_mutex_unlock(&rcu_registry_mutex);
+}
+
+// Function to free every object retired so far, after a grace period
+void rcu_barrier(void) {
+    rcu_retired_t *list, *next;
+
+    pthread_mutex_lock(&rcu_retire_mutex);
+    list = rcu_retired_list;
+    rcu_retired_list = NULL;
+    rcu_retired_count = 0;
+    pthread_mutex_unlock(&rcu_retire_mutex);
+
+    if (!list) return;
+
+    rcu_synchronize();
+
+    for (; list; list = next) {
+        next = list->next;
+        list->free_fn(list->ptr);
+        free(list);
+    }
+}
+
+// Function to defer the free of an object which readers may still see
+void rcu_retire(void *ptr, void (*free_fn)(void *)) {
+    bool reclaim;
+
+    if (!ptr) return;
+
+    rcu_retired_t *retired = (rcu_retired_t *)malloc(sizeof(rcu_retired_t));
+    if (!retired) {
+        perror("Failed to allocate memory for rcu retired object");
+        exit(EXIT_FAILURE);
+    }
+    retired->ptr = ptr;
+    retired->free_fn = free_fn;
+
+    pthread_mutex_lock(&rcu_retire_mutex);
+    retired->next = rcu_retired_list;
+    rcu_retired_list = retired;
+    reclaim = (++rcu_retired_count >= RCU_RETIRE_BATCH);
+    pthread_mutex_unlock(&rcu_retire_mutex);
+
+    if (reclaim) {
+        rcu_barrier();
+    }
+}
+
+// Function to insert new_glthread after curr_glthread. The new node is fully
+// linked before it becomes reachable from curr_glthread
+void rcu_glthread_add_next(glthread_t *curr_glthread, glthread_t *new_glthread) {
+    glthread_t *next = curr_glthread->right;
+
+    new_glthread->left = curr_glthread;
+    new_glthread->right = next;
+    rcu_assign_pointer(curr_glthread->right, new_glthread);
+    if (next) {
+        next->left = new_glthread;
+    }
+}
+
+// Function to unlink a node. Its right pointer is left intact for readers
+// which are standing on it, the caller must rcu_retire() the node
+void rcu_glthread_remove(glthread_t *glthread) {
+    glthread_t *prev = glthread->left;
+    glthread_t *next = glthread->right;
+
+    if (prev) {
+        rcu_assign_pointer(prev->right, next);
+    }
+    if (next) {
+        next->left = prev;
+    }
+    glthread->left = NULL;
+}
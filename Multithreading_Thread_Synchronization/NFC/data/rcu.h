@@ -0,0 +1,60 @@
+/* Minimal epoch based RCU for the route table.
+
+    @ Readers bracket lock-free traversals with rcu_read_lock()/rcu_read_unlock().
+    These only publish the global epoch observed at entry in a per-thread
+    record, they never block and never write shared cache lines.
+    @ Writers (serialized by the data structure's own writer lock) unlink
+    objects with the rcu_glthread_* helpers and hand them to rcu_retire().
+    Retired objects are freed in batches, once every reader which could
+    still see them has left its read-side section (grace period).
+    @ Pointers obtained inside a read-side section must not be used after
+    rcu_read_unlock().
+*/
+
+#ifndef RCU_H
+#define RCU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "../gtheard/glthread.h"
+
+// No of retired objects after which the writer waits for a grace period
+#define RCU_RETIRE_BATCH 128
+
+typedef struct rcu_reader {
+    uint64_t epoch;    // Epoch seen at read-side entry, 0 when quiescent
+    uint32_t nesting;  // Read-side sections can nest
+    bool in_use;       // Owned by a live thread, guarded by registry mutex
+    struct rcu_reader *next;
+    char pad[64 - 2 * sizeof(uint64_t) - sizeof(void *)]; // Own cache line per reader
+} rcu_reader_t;
+
+// Publish / read a pointer which lock-free readers may follow
+#define rcu_assign_pointer(p, v) __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+#define rcu_dereference(p)       __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+
+// Read-side safe glthread traversal, unlinked nodes keep their right pointer
+// so that readers standing on them still reach the rest of the list
+#define ITERATE_GLTHREAD_RCU_BEGIN(glthreadptrstart, glthreadptr)          \
+{                                                                          \
+    for(glthreadptr = rcu_dereference(BASE(glthreadptrstart));             \
+        glthreadptr != NULL;                                               \
+        glthreadptr = rcu_dereference((glthreadptr)->right)){
+
+#define ITERATE_GLTHREAD_RCU_END(glthreadptrstart, glthreadptr)            \
+        }}
+
+// APIs declaration
+void rcu_read_lock(void);
+void rcu_read_unlock(void);
+void rcu_synchronize(void);
+void rcu_retire(void *ptr, void (*free_fn)(void *));
+void rcu_barrier(void);
+void rcu_unregister_thread(void);
+
+// Writer side list updates, caller holds the writer lock
+void rcu_glthread_add_next(glthread_t *curr_glthread, glthread_t *new_glthread);
+void rcu_glthread_remove(glthread_t *glthread);
+
+#endif // RCU_H
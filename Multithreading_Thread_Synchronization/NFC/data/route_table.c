@@ -1,39 +1,109 @@
-#define _GNU_SOURCE  // For strdup
+#define _GNU_SOURCE  // For PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP
 #include "route_table.h"
 #include <stddef.h>
+#include <arpa/inet.h>
+#include "rcu.h"
+#include "route_table_dispatch.h"
+#include "../mem/obj_pool.h"
 
 // Global variable to hold the route table head
+// Readers reach it with rcu_dereference(), writers update it under the writer lock
 static route_table_instance_t *route_table_head = NULL;
 
+// Serializes all writers, recursive so that subscriber code can group a
+// lookup and an add under one critical section
+static pthread_mutex_t route_table_writer_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+// Per route INFO logs, turned off when loading large route sets
+static bool route_table_verbose = true;
+
+// All route nodes come from this pool. There is no reclaim thread, the
+// writer whose rcu_retire() fills the RCU_RETIRE_BATCH waits out the grace
+// period and frees the batch inline, under the writer lock. A node allocated
+// on another thread goes back to that thread's cache
+static obj_pool_t route_table_node_pool = OBJ_POOL_INITIALIZER(route_table_node_t, "route_table_node");
+
+// Notification of a route batch waiting for delivery
+typedef struct route_table_batch_event {
+    route_table_notif_elem_t *subscriber;
+    route_table_notif_snapshot_t *snapshot;
+    nfc_op_t op;
+    uint32_t seq;
+    bool async;  // Queued for the dispatcher rather than called after the batch
+} route_table_batch_event_t;
+
+typedef struct route_table_batch_collector {
+    route_table_batch_event_t *events;
+    uint32_t n_events;
+    uint32_t capacity;
+    uint32_t n_async;
+} route_table_batch_collector_t;
+
+// Set by route_table_apply_batch() while it holds the writer lock, all
+// notifications are collected here instead of being delivered one by one
+static route_table_batch_collector_t *route_table_batch_collector = NULL;
+
+void route_table_read_lock(void) {
+    rcu_read_lock();
+}
+
+void route_table_read_unlock(void) {
+    rcu_read_unlock();
+}
+
+void route_table_writer_lock(void) {
+    pthread_mutex_lock(&route_table_writer_mutex);
+}
+
+void route_table_writer_unlock(void) {
+    pthread_mutex_unlock(&route_table_writer_mutex);
+}
+
+void set_route_table_verbose(bool verbose) {
+    route_table_verbose = verbose;
+}
+
 // Function to set the route table head
 void set_route_table_head(route_table_instance_t* table) {
-    route_table_head = table;
+    route_table_writer_lock();
+    rcu_assign_pointer(route_table_head, table);
+    route_table_writer_unlock();
 }
 
 // Function to print the route table
 void print_route_table(void) {
-    if (!route_table_head) {
+    route_table_read_lock();
+    route_table_instance_t *table = rcu_dereference(route_table_head);
+
+    if (!table) {
         printf("Route table is empty.\n");
+        route_table_read_unlock();
         return;
     }
-    printf("Route Table: %s\n", route_table_head->description);
+    printf("Route Table: %s\n", table->description);
     
-    if (IS_GLTHREAD_LIST_EMPTY(&route_table_head->list)) {
+    if (!rcu_dereference(BASE(&table->list))) {
         printf("No routes in table.\n");
+        route_table_read_unlock();
         return;
     }
     
     glthread_t *curr;
     route_table_node_t *node;
+    char dest_addr[ROUTE_TABLE_ADDR_STR_LEN], mask[ROUTE_TABLE_ADDR_STR_LEN];
+    const char *oif, *gateway;
     
-    ITERATE_GLTHREAD_BEGIN(&route_table_head->list, curr) {
+    ITERATE_GLTHREAD_RCU_BEGIN(&table->list, curr) {
         node = glue_to_route_node(curr);
+        oif = route_table_node_oif(node);
+        gateway = route_table_node_gateway(node);
         printf("Destination: %s, Mask: %s, OIF: %s, Gateway: %s\n",
-               node->dest_addr ? node->dest_addr : "(null)", 
-               node->mask ? node->mask : "(null)", 
-               node->oif ? node->oif : "(null)", 
-               node->gateway ? node->gateway : "(null)");
-    } ITERATE_GLTHREAD_END(&route_table_head->list, curr);
+               route_table_node_dest_str(node, dest_addr), 
+               route_table_node_mask_str(node, mask), 
+               oif ? oif : "(null)", 
+               gateway ? gateway : "(null)");
+    } ITERATE_GLTHREAD_RCU_END(&table->list, curr);
+    route_table_read_unlock();
 }
 
 // Function to initialize the route table
@@ -46,212 +116,657 @@ route_table_instance_t* init_route_table(char *description) {
     new_route_table->description = description;
     init_glthread(&new_route_table->list);
     new_route_table->count = 0;
+    new_route_table->trie = route_trie_create();
     return new_route_table;
 }
 
-// Function to create a new route table node
-route_table_node_t *create_route_table_node(char *dest_addr, char *mask, char *oif, char *gateway) {
-    route_table_node_t *new_node = (route_table_node_t *)malloc(sizeof(route_table_node_t));
-    if (!new_node) {
-        perror("Failed to allocate memory for route table node");
-        exit(EXIT_FAILURE);
+// Function to convert dotted dest_addr/mask strings to a binary prefix
+// Returns false if either is not a valid IPv4 address or mask is not contiguous
+bool route_table_parse_prefix(const char *dest_addr, const char *mask, uint32_t *prefix, uint8_t *prefix_len) {
+    struct in_addr addr, netmask;
+    uint32_t mask_bits;
+    uint8_t len = 0;
+
+    if (!dest_addr || !mask) return false;
+    if (inet_pton(AF_INET, dest_addr, &addr) != 1) return false;
+    if (inet_pton(AF_INET, mask, &netmask) != 1) return false;
+
+    mask_bits = ntohl(netmask.s_addr);
+    while (len < ROUTE_TRIE_MAX_PREFIX_LEN && (mask_bits & (0x80000000u >> len))) {
+        len++;
     }
-    new_node->dest_addr = dest_addr;
-    new_node->mask = mask;
-    new_node->oif = oif;
-    new_node->gateway = gateway;
+    if (mask_bits != route_trie_len_to_mask(len)) return false;
+
+    *prefix = ntohl(addr.s_addr);
+    *prefix_len = len;
+    return true;
+}
+
+// Trie key is the masked prefix, host bits of the destination are kept in the node
+// Index updates are done by writers only
+static void route_table_index_node(route_table_node_t *node) {
+    route_trie_insert(route_table_head->trie,
+                      node->prefix & route_trie_len_to_mask(node->prefix_len),
+                      node->prefix_len, &node->trie_glue);
+    node->is_indexed = true;
+}
+
+static void route_table_unindex_node(route_table_node_t *node) {
+    if (!node->is_indexed) return;
+    route_trie_remove(route_table_head->trie,
+                      node->prefix & route_trie_len_to_mask(node->prefix_len),
+                      node->prefix_len, &node->trie_glue);
+    node->is_indexed = false;
+}
+
+// Function to take references on the interned oif and gateway of a route
+// Returns false, holding neither, when the intern table is full
+static bool route_table_intern_fields(const char *oif, const char *gateway,
+                                      uint32_t *oif_id, uint32_t *gateway_id) {
+    if (route_intern_string(oif, oif_id)) {
+        if (route_intern_string(gateway, gateway_id)) return true;
+        route_intern_unref(*oif_id);
+    }
+    printf("ERROR: Route intern table full, no room for %s / %s\n",
+           oif ? oif : "(null)", gateway ? gateway : "(null)");
+    return false;
+}
+
+// Function to create a new route table node, strings are copied (interned)
+// Returns NULL if dest_addr/mask is not a valid IPv4 address/contiguous mask,
+// or if the intern table has no room left for oif/gateway
+route_table_node_t *create_route_table_node(const char *dest_addr, const char *mask, const char *oif, const char *gateway) {
+    uint32_t prefix, oif_id, gateway_id;
+    uint8_t prefix_len;
+
+    if (!route_table_parse_prefix(dest_addr, mask, &prefix, &prefix_len)) {
+        printf("ERROR: Invalid route %s/%s\n", dest_addr ? dest_addr : "(null)", mask ? mask : "(null)");
+        return NULL;
+    }
+    if (!route_table_intern_fields(oif, gateway, &oif_id, &gateway_id)) return NULL;
+
+    route_table_node_t *new_node = (route_table_node_t *)obj_pool_alloc(&route_table_node_pool);
+    new_node->prefix = prefix;
+    new_node->prefix_len = prefix_len;
+    new_node->is_indexed = false;
+    new_node->oif_id = oif_id;
+    new_node->gateway_id = gateway_id;
     init_glthread(&new_node->list);
     init_glthread(&new_node->subscriber_list);
+    init_glthread(&new_node->trie_glue);
 
     return new_node;
 }
 
+// Deferred free of an unlinked route, once readers are done with it
+// The route drops its string references, which are freed a grace period later
+static void route_table_free_node(void *arg) {
+    route_table_node_t *node = (route_table_node_t *)arg;
+
+    route_intern_unref(node->oif_id);
+    route_intern_unref(node->gateway_id);
+    obj_pool_free(&route_table_node_pool, node);
+}
+
+// Function to replace an interned field of a published route with id, whose
+// reference the route takes over. Readers see either the old or the new id,
+// the old string is only freed after a grace period
+static void route_table_replace_field(uint32_t *field, uint32_t id) {
+    route_intern_unref(__atomic_exchange_n(field, id, __ATOMIC_ACQ_REL));
+}
+
+char *route_table_node_dest_str(route_table_node_t *node, char *buf) {
+    struct in_addr addr;
+
+    addr.s_addr = htonl(node->prefix);
+    inet_ntop(AF_INET, &addr, buf, ROUTE_TABLE_ADDR_STR_LEN);
+    return buf;
+}
+
+char *route_table_node_mask_str(route_table_node_t *node, char *buf) {
+    struct in_addr addr;
+
+    addr.s_addr = htonl(route_trie_len_to_mask(node->prefix_len));
+    inet_ntop(AF_INET, &addr, buf, ROUTE_TABLE_ADDR_STR_LEN);
+    return buf;
+}
+
+// Function to get the memory held by route nodes and the trie index
+size_t route_table_mem_bytes(void) {
+    route_table_instance_t *table = rcu_dereference(route_table_head);
+    size_t bytes = obj_pool_bytes(&route_table_node_pool);
+
+    if (table) {
+        bytes += (size_t)__atomic_load_n(&table->trie->n_nodes, __ATOMIC_RELAXED) * sizeof(route_trie_node_t);
+    }
+    return bytes;
+}
+
+void route_table_print_pool_stats(void) {
+    obj_pool_print_stats(&route_table_node_pool);
+}
+
 // Function to add a new route table node to the route_table_head
 // Implements prefix-based uniqueness (dest_addr + mask as composite key)
 void add_route_table_node(route_table_node_t *new_node) {
+    char dest_addr[ROUTE_TABLE_ADDR_STR_LEN], mask[ROUTE_TABLE_ADDR_STR_LEN];
+
+    if (!new_node) return;
+    route_table_writer_lock();
+
     if (!route_table_head) {
         printf("Route table is not initialized. Initializing now...\n");
-        route_table_head = init_route_table("Default Route Table");
+        rcu_assign_pointer(route_table_head, init_route_table("Default Route Table"));
     }
     
     // Check if route with same prefix already exists
-    route_table_node_t *existing = get_route_table_node_by_dest_and_mask(new_node->dest_addr, new_node->mask);
+    route_table_node_t *existing = get_route_table_node_by_prefix(new_node->prefix, new_node->prefix_len);
     if (existing) {
-        printf("INFO: Route entry %s/%s already exists. Updating existing entry.\n", 
-               new_node->dest_addr, new_node->mask);
+        if (route_table_verbose) {
+            printf("INFO: Route entry %s/%s already exists. Updating existing entry.\n", 
+                   route_table_node_dest_str(new_node, dest_addr), route_table_node_mask_str(new_node, mask));
+        }
         
-        // Update existing entry instead of creating duplicate
-        if (new_node->oif) {
-            if (existing->oif) free(existing->oif);
-            existing->oif = strdup(new_node->oif);
+        // Update existing entry instead of creating duplicate, it takes over
+        // the string references of the new node
+        if (new_node->oif_id != ROUTE_INTERN_NULL_ID) {
+            route_table_replace_field(&existing->oif_id, new_node->oif_id);
         }
-        if (new_node->gateway) {
-            if (existing->gateway) free(existing->gateway);
-            existing->gateway = strdup(new_node->gateway);
+        if (new_node->gateway_id != ROUTE_INTERN_NULL_ID) {
+            route_table_replace_field(&existing->gateway_id, new_node->gateway_id);
         }
         
         // Notify subscribers about the modification
         notify_subscribers(existing, NFC_MOD);
         
-        // Free the new node since we're not using it
-        free(new_node->dest_addr);
-        free(new_node->mask);
-        if (new_node->oif) free(new_node->oif);
-        if (new_node->gateway) free(new_node->gateway);
-        free(new_node);
+        // Free the new node since we're not using it, it was never published
+        obj_pool_free(&route_table_node_pool, new_node);
+        route_table_writer_unlock();
         return;
     }
     
-    // Add new unique route entry
-    glthread_add_next(&route_table_head->list, &new_node->list);
-    route_table_head->count++;
+    // Add new unique route entry, node is fully built before readers can see it
+    route_table_index_node(new_node);
+    rcu_glthread_add_next(&route_table_head->list, &new_node->list);
+    __atomic_add_fetch(&route_table_head->count, 1, __ATOMIC_RELAXED);
     
-    printf("INFO: Added new route entry: %s/%s via %s (OIF: %s)\n",
-           new_node->dest_addr ? new_node->dest_addr : "(null)",
-           new_node->mask ? new_node->mask : "(null)",
-           new_node->gateway ? new_node->gateway : "(null)",
-           new_node->oif ? new_node->oif : "(null)");
+    if (route_table_verbose) {
+        printf("INFO: Added new route entry: %s/%s via %s (OIF: %s)\n",
+               route_table_node_dest_str(new_node, dest_addr),
+               route_table_node_mask_str(new_node, mask),
+               route_table_node_gateway(new_node) ? route_table_node_gateway(new_node) : "(null)",
+               route_table_node_oif(new_node) ? route_table_node_oif(new_node) : "(null)");
+    }
     
     // Notify subscribers about the new route
     notify_subscribers(new_node, NFC_ADD);
+    route_table_writer_unlock();
 }
 
 // Function to remove a route table node from the route_table_head
+// The node is freed after a grace period, lock-free readers may still hold it
 void remove_route_table_node(route_table_node_t *node) {
+    route_table_writer_lock();
+
     if (!route_table_head || !node) {
+        route_table_writer_unlock();
         return;
     }
     
     // Notify subscribers before removal
     notify_subscribers(node, NFC_DEL);
     
-    // Remove from glthread list
-    remove_glthread(&node->list);
+    // Unlink from glthread list and prefix index
+    rcu_glthread_remove(&node->list);
+    route_table_unindex_node(node);
     
-    free(node);
-    route_table_head->count--;
+    rcu_retire(node, route_table_free_node);
+    __atomic_sub_fetch(&route_table_head->count, 1, __ATOMIC_RELAXED);
+    route_table_writer_unlock();
+}
+
+typedef struct route_table_dest_search {
+    uint32_t dest;
+    route_table_node_t *result;
+} route_table_dest_search_t;
+
+static bool route_table_match_dest_cb(route_trie_node_t *trie_node, uint8_t depth, void *arg) {
+    route_table_dest_search_t *search = (route_table_dest_search_t *)arg;
+    glthread_t *curr;
+    route_table_node_t *node;
+
+    (void)depth;
+    ITERATE_GLTHREAD_RCU_BEGIN(&trie_node->routes, curr) {
+        node = trie_glue_to_route_node(curr);
+        if (node->prefix == search->dest) {
+            search->result = node;
+            return true;
+        }
+    } ITERATE_GLTHREAD_RCU_END(&trie_node->routes, curr);
+    return false;
 }
 
+// Lookups below are lock-free. The returned node stays valid only while the
+// caller is inside route_table_read_lock()/unlock(), or holds the writer lock
+
 // Function to get the route table node by destination address
 route_table_node_t *get_route_table_node(char *dest_addr) {
-    if (!route_table_head || !dest_addr) {
+    route_table_read_lock();
+    route_table_instance_t *table = rcu_dereference(route_table_head);
+
+    if (!table || !dest_addr) {
+        route_table_read_unlock();
         return NULL;
     }
     
-    glthread_t *curr;
-    route_table_node_t *node;
-    
-    ITERATE_GLTHREAD_BEGIN(&route_table_head->list, curr) {
-        node = glue_to_route_node(curr);
-        if (node->dest_addr && strcmp(node->dest_addr, dest_addr) == 0) {
-            return node;
-        }
-    } ITERATE_GLTHREAD_END(&route_table_head->list, curr);
-    
-    return NULL;
+    struct in_addr addr;
+    route_table_dest_search_t search = { 0, NULL };
+
+    // Any route for dest_addr sits on the trie path of dest_addr
+    if (inet_pton(AF_INET, dest_addr, &addr) == 1) {
+        search.dest = ntohl(addr.s_addr);
+        route_trie_walk_path(table->trie, search.dest, route_table_match_dest_cb, &search);
+    }
+    route_table_read_unlock();
+    return search.result;
 }
 
 // Function to get the route table node by gateway address
 route_table_node_t *get_route_table_node_by_gateway(char *gateway) {
-    if (!route_table_head || !gateway) {
+    route_table_read_lock();
+    route_table_instance_t *table = rcu_dereference(route_table_head);
+
+    if (!table || !gateway) {
+        route_table_read_unlock();
         return NULL;
     }
     
     glthread_t *curr;
-    route_table_node_t *node;
+    route_table_node_t *node, *result = NULL;
+    uint32_t gateway_id;
+
+    // A gateway nobody has used is on no route
+    if (!route_intern_find(gateway, &gateway_id)) {
+        route_table_read_unlock();
+        return NULL;
+    }
     
-    ITERATE_GLTHREAD_BEGIN(&route_table_head->list, curr) {
+    ITERATE_GLTHREAD_RCU_BEGIN(&table->list, curr) {
         node = glue_to_route_node(curr);
-        if (node->gateway && strcmp(node->gateway, gateway) == 0) {
-            return node;
+        if (__atomic_load_n(&node->gateway_id, __ATOMIC_RELAXED) == gateway_id) {
+            result = node;
+            break;
         }
-    } ITERATE_GLTHREAD_END(&route_table_head->list, curr);
+    } ITERATE_GLTHREAD_RCU_END(&table->list, curr);
     
-    return NULL;
+    route_table_read_unlock();
+    return result;
 }
 
 // Function to get the route table by both destination address and mask
 route_table_node_t *get_route_table_node_by_dest_and_mask(char *dest_addr, char *mask) {
-    if (!route_table_head || !dest_addr || !mask) {
+    route_table_read_lock();
+    route_table_instance_t *table = rcu_dereference(route_table_head);
+
+    if (!table || !dest_addr || !mask) {
+        route_table_read_unlock();
         return NULL;
     }
     
+    route_table_node_t *result = NULL;
+    uint32_t prefix;
+    uint8_t prefix_len;
+
+    // Every route is indexed, no need to walk the list
+    if (route_table_parse_prefix(dest_addr, mask, &prefix, &prefix_len)) {
+        result = get_route_table_node_by_prefix(prefix, prefix_len);
+    }
+    route_table_read_unlock();
+    return result;
+}
+
+// Function to get the route by binary dest_addr and prefix length
+route_table_node_t *get_route_table_node_by_prefix(uint32_t prefix, uint8_t prefix_len) {
+    route_table_read_lock();
+    route_table_instance_t *table = rcu_dereference(route_table_head);
+
+    if (!table || prefix_len > ROUTE_TRIE_MAX_PREFIX_LEN) {
+        route_table_read_unlock();
+        return NULL;
+    }
+
     glthread_t *curr;
-    route_table_node_t *node;
-    
-    ITERATE_GLTHREAD_BEGIN(&route_table_head->list, curr) {
-        node = glue_to_route_node(curr);
-        if (node->dest_addr && node->mask && 
-            strcmp(node->dest_addr, dest_addr) == 0 && 
-            strcmp(node->mask, mask) == 0) {
-            return node;
+    route_table_node_t *node, *result = NULL;
+    route_trie_node_t *trie_node = route_trie_find_exact(table->trie,
+                                        prefix & route_trie_len_to_mask(prefix_len), prefix_len);
+
+    // Routes differing only in host bits share the trie node
+    if (trie_node) {
+        ITERATE_GLTHREAD_RCU_BEGIN(&trie_node->routes, curr) {
+            node = trie_glue_to_route_node(curr);
+            if (node->prefix == prefix && node->prefix_len == prefix_len) {
+                result = node;
+                break;
+            }
+        } ITERATE_GLTHREAD_RCU_END(&trie_node->routes, curr);
+    }
+
+    route_table_read_unlock();
+    return result;
+}
+
+// Function to get the most specific route covering addr
+route_table_node_t *route_table_lookup_lpm(uint32_t addr) {
+    route_table_read_lock();
+    route_table_instance_t *table = rcu_dereference(route_table_head);
+    route_table_node_t *result = NULL;
+    route_trie_node_t *trie_node;
+    glthread_t *first;
+
+    if (table) {
+        trie_node = route_trie_find_lpm(table->trie, addr);
+        // Last route of the trie node may have just been unlinked
+        first = trie_node ? rcu_dereference(BASE(&trie_node->routes)) : NULL;
+        if (first) {
+            result = trie_glue_to_route_node(first);
         }
-    } ITERATE_GLTHREAD_END(&route_table_head->list, curr);
-    
-    return NULL;
+    }
+
+    route_table_read_unlock();
+    return result;
 }
 
 // Function to free the route table
 void free_route_table(void) {
-    if (!route_table_head) {
+    route_table_writer_lock();
+
+    route_table_instance_t *table = route_table_head;
+    if (!table) {
+        route_table_writer_unlock();
         return;
     }
+
+    // Unpublish the table, wait for readers still walking it and flush
+    // routes retired earlier before tearing the table down
+    rcu_assign_pointer(route_table_head, NULL);
+    rcu_barrier();
     
     glthread_t *curr, *next;
     route_table_node_t *node;
     
     // Use delete safe iteration
-    for(curr = BASE(&route_table_head->list); curr != NULL; curr = next) {
+    for(curr = BASE(&table->list); curr != NULL; curr = next) {
         next = curr->right;
         node = glue_to_route_node(curr);
         
-        // Free dynamically allocated string fields (dest_addr, mask, oif, gateway)
-        free(node->dest_addr);
-        free(node->mask);
-        free(node->oif);
-        free(node->gateway);
-        free(node);
+        route_table_free_node(node);
     }
     
-    if (route_table_head) {
-        free(route_table_head);
-        route_table_head = NULL;
-    }
+    route_trie_destroy(table->trie);
+    free(table);
+    route_table_writer_unlock();
 }
 
 // Function to count the number of route table nodes
 int count_route_table_nodes(void) {
-    if (!route_table_head) {
+    route_table_instance_t *table = rcu_dereference(route_table_head);
+
+    if (!table) {
         return 0;
     }
-    return route_table_head->count;
+    return __atomic_load_n(&table->count, __ATOMIC_RELAXED);
 }
 
 // Function to get the route table head
 route_table_instance_t* get_route_table_head(void) {
-    return route_table_head;
+    return rcu_dereference(route_table_head);
+}
+
+static void route_table_batch_collect(route_table_notif_elem_t *subscriber,
+                                      route_table_notif_snapshot_t *snapshot, nfc_op_t op, bool async) {
+    route_table_batch_collector_t *collector = route_table_batch_collector;
+    route_table_batch_event_t *event;
+
+    if (collector->n_events == collector->capacity) {
+        collector->capacity = collector->capacity ? collector->capacity * 2 : 64;
+        collector->events = realloc(collector->events,
+                                    collector->capacity * sizeof(route_table_batch_event_t));
+        if (!collector->events) {
+            perror("Failed to allocate memory for route batch notifications");
+            exit(EXIT_FAILURE);
+        }
+    }
+    event = &collector->events[collector->n_events];
+    event->subscriber = subscriber;
+    event->snapshot = snapshot;
+    event->op = op;
+    event->seq = collector->n_events++;
+    event->async = async;
+    collector->n_async += async;
+    route_table_notif_snapshot_ref(snapshot);
+}
+
+// Group a batch by subscriber, keeping the order of operations within each
+static int route_table_batch_event_cmp(const void *a, const void *b) {
+    const route_table_batch_event_t *ea = a, *eb = b;
+
+    if (ea->subscriber->subs_id != eb->subscriber->subs_id) {
+        return ea->subscriber->subs_id < eb->subscriber->subs_id ? -1 : 1;
+    }
+    return ea->seq < eb->seq ? -1 : (ea->seq > eb->seq);
+}
+
+// Function to queue one route batch per async subscriber. Called before the
+// writer lock is released, so no other notification is queued in between
+static void route_table_batch_enqueue(route_table_batch_collector_t *collector) {
+    route_table_notif_batch_t *batch;
+    route_table_batch_event_t *event;
+    uint32_t i, j, subs_id;
+
+    if (!collector->n_async) return;
+
+    qsort(collector->events, collector->n_events, sizeof(route_table_batch_event_t),
+          route_table_batch_event_cmp);
+
+    for (i = 0; i < collector->n_events; i = j) {
+        subs_id = collector->events[i].subscriber->subs_id;
+        batch = NULL;
+
+        for (j = i; j < collector->n_events && collector->events[j].subscriber->subs_id == subs_id; j++) {
+            event = &collector->events[j];
+            if (!event->async) continue;
+            if (!batch) batch = route_table_notif_batch_create();
+            route_table_notif_batch_add(batch, event->subscriber->queue, event->snapshot, event->op);
+        }
+        if (batch) route_table_notif_enqueue_batch(batch);
+    }
+}
+
+// Function to deliver collected notifications, one batch_cb call per subscriber
+// Subscribers without batch_cb get one app_cb call per route. Async ones have
+// been queued by route_table_batch_enqueue()
+static void route_table_batch_deliver(route_table_batch_collector_t *collector) {
+    route_table_notif_batch_entry_t *entries;
+    route_table_batch_event_t *event;
+    nfc_app_batch_cb batch_cb;
+    uint32_t i, j, n_entries, subs_id;
+
+    if (!collector->n_events) return;
+
+    entries = malloc(collector->n_events * sizeof(route_table_notif_batch_entry_t));
+    if (!entries) {
+        perror("Failed to allocate memory for route batch notifications");
+        exit(EXIT_FAILURE);
+    }
+    // Already in order if route_table_batch_enqueue() had async events to queue
+    if (!collector->n_async) {
+        qsort(collector->events, collector->n_events, sizeof(route_table_batch_event_t),
+              route_table_batch_event_cmp);
+    }
+
+    for (i = 0; i < collector->n_events; i = j) {
+        subs_id = collector->events[i].subscriber->subs_id;
+        batch_cb = NULL;
+        n_entries = 0;
+
+        for (j = i; j < collector->n_events && collector->events[j].subscriber->subs_id == subs_id; j++) {
+            event = &collector->events[j];
+            if (event->async) continue;
+            if (event->subscriber->batch_cb) {
+                batch_cb = event->subscriber->batch_cb;
+                entries[n_entries].route = &event->snapshot->route;
+                entries[n_entries].op = event->op;
+                n_entries++;
+            } else {
+                event->subscriber->app_cb(&event->snapshot->route, sizeof(route_table_node_t),
+                                          event->op, subs_id);
+            }
+        }
+        if (batch_cb) batch_cb(entries, n_entries, subs_id);
+    }
+
+    for (i = 0; i < collector->n_events; i++) {
+        route_table_notif_snapshot_unref(collector->events[i].snapshot);
+    }
+    free(entries);
+}
+
+// Function to apply many route operations under a single writer critical
+// section. Nodes for NFC_ADD are allocated before the lock is taken. Each
+// subscriber gets one batched callback: async ones from a single event queued
+// before the lock is released, the others after it is released. Returns the number of operations applied, ops[i].status
+// tells which ones
+int route_table_apply_batch(route_table_op_t *ops, uint32_t n_ops) {
+    route_table_batch_collector_t collector = { NULL, 0, 0, 0 };
+    route_table_node_t **new_nodes;
+    route_table_node_t *node;
+    bool verbose;
+    uint32_t i;
+    int applied = 0;
+
+    if (!ops || !n_ops) return 0;
+
+    new_nodes = calloc(n_ops, sizeof(route_table_node_t *));
+    if (!new_nodes) {
+        perror("Failed to allocate memory for route batch");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < n_ops; i++) {
+        ops[i].status = 0;
+        if (ops[i].op == NFC_ADD && ops[i].dest_addr && ops[i].mask) {
+            new_nodes[i] = create_route_table_node(ops[i].dest_addr, ops[i].mask,
+                                                   ops[i].oif, ops[i].gateway);
+        }
+    }
+
+    route_table_writer_lock();
+    // Per route logs would dominate a bulk load
+    verbose = route_table_verbose;
+    route_table_verbose = false;
+    route_table_batch_collector = &collector;
+
+    for (i = 0; i < n_ops; i++) {
+        switch (ops[i].op) {
+            case NFC_ADD:
+                if (!new_nodes[i]) break;
+                add_route_table_node(new_nodes[i]);
+                ops[i].status = 1;
+                break;
+            case NFC_MOD:
+                ops[i].status = modify_route_table_node(ops[i].dest_addr, ops[i].mask, ops[i].new_mask,
+                                                        ops[i].oif, ops[i].gateway);
+                break;
+            case NFC_DEL:
+                node = get_route_table_node_by_dest_and_mask(ops[i].dest_addr, ops[i].mask);
+                if (!node) break;
+                remove_route_table_node(node);
+                ops[i].status = 1;
+                break;
+            default:
+                break;
+        }
+        applied += ops[i].status;
+    }
+
+    route_table_batch_collector = NULL;
+    route_table_verbose = verbose;
+    route_table_batch_enqueue(&collector);
+    route_table_writer_unlock();
+
+    if (verbose) {
+        printf("INFO: Route batch applied %d of %u operations\n", applied, n_ops);
+    }
+
+    route_table_batch_deliver(&collector);
+    free(collector.events);
+    free(new_nodes);
+    return applied;
 }
 
 // Function to notify all subscribers
+// Called by writers only, subscriber lists are updated under the writer lock
+// Async subscribers get a queued snapshot of the route, the others are called
+// synchronously (also async ones once the dispatcher has been shut down).
+// Within route_table_apply_batch() every notification is collected instead
 void notify_subscribers(route_table_node_t *node, nfc_op_t op) {
     if (!node) return;
     
     glthread_t *curr;
     route_table_notif_elem_t *subscriber;
+    route_table_notif_snapshot_t *snapshot = NULL;
+    bool async = route_table_dispatch_is_running();
     
     ITERATE_GLTHREAD_BEGIN(&node->subscriber_list, curr) {
         subscriber = glue_to_notif_elem(curr);
-        if (subscriber->app_cb) {
+        if (!subscriber->app_cb) continue;
+
+        if (route_table_batch_collector) {
+            if (!snapshot) snapshot = route_table_notif_snapshot_create(node);
+            route_table_batch_collect(subscriber, snapshot, op, subscriber->queue && async);
+        } else if (subscriber->queue && async) {
+            // One snapshot is shared by all async subscribers of the route
+            if (!snapshot) snapshot = route_table_notif_snapshot_create(node);
+            route_table_notif_enqueue(subscriber->queue, snapshot, op);
+        } else {
             subscriber->app_cb(node, sizeof(route_table_node_t), op, subscriber->subs_id);
         }
     } ITERATE_GLTHREAD_END(&node->subscriber_list, curr);
+
+    if (snapshot) route_table_notif_snapshot_unref(snapshot);
+}
+
+// Function to publish new_node in place of a route, new_node takes over its
+// subscribers. Readers find either node until the old one is unlinked, the old
+// one is freed after a grace period and is never written once published
+static void route_table_replace_node(route_table_node_t *old_node, route_table_node_t *new_node) {
+    glthread_t *first;
+
+    // Subscriber lists are only walked under the writer lock
+    new_node->subscriber_list = old_node->subscriber_list;
+    first = BASE(&new_node->subscriber_list);
+    if (first) first->left = &new_node->subscriber_list;
+    init_glthread(&old_node->subscriber_list);
+
+    route_table_index_node(new_node);
+    rcu_glthread_add_next(&old_node->list, &new_node->list);
+
+    rcu_glthread_remove(&old_node->list);
+    route_table_unindex_node(old_node);
+    rcu_retire(old_node, route_table_free_node);
 }
 
 // Function to modify a route table node
 // Uses dest_addr + current_mask as composite key for lookup
 int modify_route_table_node(char *dest_addr, char *current_mask, char *new_mask, char *new_oif, char *new_gateway) {
+    char dest_str[ROUTE_TABLE_ADDR_STR_LEN], mask_str[ROUTE_TABLE_ADDR_STR_LEN];
+    uint32_t prefix, oif_id, gateway_id;
+    uint8_t new_prefix_len = 0;
+
+    route_table_writer_lock();
+
     if (!route_table_head || !dest_addr || !current_mask) {
         printf("ERROR: Invalid parameters for modify operation\n");
+        route_table_writer_unlock();
         return 0; // Failed - invalid parameters
     }
     
@@ -259,35 +774,72 @@ int modify_route_table_node(char *dest_addr, char *current_mask, char *new_mask,
     route_table_node_t *node = get_route_table_node_by_dest_and_mask(dest_addr, current_mask);
     if (!node) {
         printf("ERROR: Route entry %s/%s not found\n", dest_addr, current_mask);
+        route_table_writer_unlock();
         return 0; // Failed - node not found
     }
     
-    // Update mask if provided
-    if (new_mask) {
-        free(node->mask);
-        node->mask = strdup(new_mask);
+    if (new_mask && !route_table_parse_prefix(dest_addr, new_mask, &prefix, &new_prefix_len)) {
+        printf("ERROR: Invalid mask %s\n", new_mask);
+        route_table_writer_unlock();
+        return 0; // Failed - invalid mask
+    }
+
+    if (new_mask && new_prefix_len != node->prefix_len &&
+        get_route_table_node_by_prefix(node->prefix, new_prefix_len)) {
+        printf("ERROR: Route entry %s/%s already exists\n", dest_addr, new_mask);
+        route_table_writer_unlock();
+        return 0; // Failed - would duplicate a route
+    }
+
+    // New strings are interned before anything changes
+    if (!route_table_intern_fields(new_oif, new_gateway, &oif_id, &gateway_id)) {
+        route_table_writer_unlock();
+        return 0; // Failed - intern table full
+    }
+
+    // Update mask if provided. The route moves to another trie node, readers
+    // must not find it on the old path with the new mask, so a modified copy
+    // replaces it
+    if (new_mask && new_prefix_len != node->prefix_len) {
+        route_table_node_t *new_node = (route_table_node_t *)obj_pool_alloc(&route_table_node_pool);
+        new_node->prefix = node->prefix;
+        new_node->prefix_len = new_prefix_len;
+        new_node->is_indexed = false;
+        // Strings kept from the old node get their own references, the old
+        // node drops its ones when it is freed
+        new_node->oif_id = new_oif ? oif_id : node->oif_id;
+        new_node->gateway_id = new_gateway ? gateway_id : node->gateway_id;
+        if (!new_oif) route_intern_ref(node->oif_id);
+        if (!new_gateway) route_intern_ref(node->gateway_id);
+        init_glthread(&new_node->list);
+        init_glthread(&new_node->trie_glue);
+
+        route_table_replace_node(node, new_node);
+        node = new_node;
+        new_oif = new_gateway = NULL;
     }
     
     // Update OIF if provided
     if (new_oif) {
-        free(node->oif);
-        node->oif = strdup(new_oif);
+        route_table_replace_field(&node->oif_id, oif_id);
     }
     
     // Update gateway if provided
     if (new_gateway) {
-        free(node->gateway);
-        node->gateway = strdup(new_gateway);
+        route_table_replace_field(&node->gateway_id, gateway_id);
     }
     
-    printf("INFO: Modified route entry: %s/%s via %s (OIF: %s)\n",
-           node->dest_addr ? node->dest_addr : "(null)",
-           node->mask ? node->mask : "(null)",
-           node->gateway ? node->gateway : "(null)",
-           node->oif ? node->oif : "(null)");
+    if (route_table_verbose) {
+        printf("INFO: Modified route entry: %s/%s via %s (OIF: %s)\n",
+               route_table_node_dest_str(node, dest_str),
+               route_table_node_mask_str(node, mask_str),
+               route_table_node_gateway(node) ? route_table_node_gateway(node) : "(null)",
+               route_table_node_oif(node) ? route_table_node_oif(node) : "(null)");
+    }
     
     // Notify subscribers about the modification
     notify_subscribers(node, NFC_MOD);
     
+    route_table_writer_unlock();
     return 1; // Success
 }
\ No newline at end of file
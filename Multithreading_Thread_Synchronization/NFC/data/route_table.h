@@ -1,10 +1,16 @@
 /* In order to learn Notification chain mechanism, I'd like to write a simple 
     route table program. 
     
-    @ The route table will be a simple linked list of routes.
-    @ Each route table linked list node will contain the information of destination address, 
-    Maskm Oif, gateway address and linked list head for subscriber nodes, glthread pointer to
-    the next route table node.
+    @ Routes are indexed in a binary trie on (prefix, prefix length), see route_trie.h.
+    Exact lookups and longest prefix match walk at most 32 trie levels, whatever the
+    number of routes. The table also keeps all routes on one linked list, which is only
+    walked to print the table, to look up by gateway and to free it.
+    @ Each route table node contains the destination address, mask, Oif, gateway address,
+    the list head for subscriber nodes, and glthread glues for the route list and for the
+    route list of its trie node.
+    @ Nodes are packed: destination and mask are kept as a binary prefix, Oif and gateway as
+    interned string ids, and nodes come from an object pool (see mem/obj_pool.h). Use the
+    route_table_node_*() accessors to get them back as strings.
 */
 
 #ifndef ROUTE_TABLE_H
@@ -16,7 +22,12 @@
 #include <pthread.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include "../gtheard/glthread.h"
+#include "route_trie.h"
+#include "route_table_alloc.h"
+
+#define ROUTE_TABLE_ADDR_STR_LEN 16 // Dotted IPv4 string with terminating NUL
 
 // Forward declarations for notification system
 typedef enum{
@@ -29,9 +40,21 @@ typedef enum{
 
 typedef void (*nfc_app_cb)(void *, size_t, nfc_op_t, uint32_t);
 
+// One notification of a route batch, route is a snapshot valid during the callback
+typedef struct route_table_notif_batch_entry {
+    struct route_table_node *route;
+    nfc_op_t op;
+} route_table_notif_batch_entry_t;
+
+typedef void (*nfc_app_batch_cb)(route_table_notif_batch_entry_t *, uint32_t, uint32_t);
+
+struct route_table_notif_queue;
+
 typedef struct route_table_notif_elem {
     uint32_t subs_id;
     nfc_app_cb app_cb;
+    struct route_table_notif_queue *queue; // Async delivery queue, NULL for synchronous callbacks
+    nfc_app_batch_cb batch_cb; // Called once per route batch, NULL to get one app_cb per route
     glthread_t glue;
 } route_table_notif_elem_t;
 
@@ -40,27 +63,31 @@ GLTHREAD_TO_STRUCT(glue_to_notif_elem, route_table_notif_elem_t, glue);
 
 // Route table node structure
 typedef struct route_table_node {
-    char *dest_addr; // Destination address
-    char *mask;      // Mask
-    char *oif;       // Outgoing interface
-    char *gateway;   // Gateway address
+    uint32_t prefix;     // Destination address in host byte order, host bits kept
+    uint8_t prefix_len;  // Mask as prefix length, a new mask publishes a new node
+    bool is_indexed;     // Node is in the trie index
+    uint32_t oif_id;     // Interned outgoing interface
+    uint32_t gateway_id; // Interned gateway address
     glthread_t subscriber_list; // Linked list of subscribers
     glthread_t list; // Double Linked list pointer to the next route table node
+    glthread_t trie_glue; // Glue into the route list of a trie node
 } route_table_node_t;
 
 // Macro to convert glthread to route_table_node_t
 GLTHREAD_TO_STRUCT(glue_to_route_node, route_table_node_t, list);
+GLTHREAD_TO_STRUCT(trie_glue_to_route_node, route_table_node_t, trie_glue);
 
 // Route table structure
 typedef struct route_table {
     char* description; // Description of the route table
     glthread_t list;  // Head of the route table linked list
-    int count;
+    int count;          // Updated by writers, read without lock
+    route_trie_t *trie; // Prefix index over the routes in list
 } route_table_instance_t;
 
 // APIs declaration
 route_table_instance_t* init_route_table(char *description);
-route_table_node_t *create_route_table_node(char *dest_addr, char *mask, char *oif, char *gateway);
+route_table_node_t *create_route_table_node(const char *dest_addr, const char *mask, const char *oif, const char *gateway);
 void add_route_table_node(route_table_node_t *node);
 void remove_route_table_node(route_table_node_t *node);
 route_table_node_t *get_route_table_node(char *dest_addr);
@@ -74,4 +101,49 @@ void notify_subscribers(route_table_node_t *node, nfc_op_t op);
 int modify_route_table_node(char *dest_addr, char *current_mask, char *new_mask, char *new_oif, char *new_gateway);
 void set_route_table_head(route_table_instance_t* table);
 
+// String accessors, oif/gateway return NULL when unset. Like the route, their
+// strings are valid inside a read-side section or under the writer lock (for
+// a notification snapshot, during the callback). buf must hold
+// ROUTE_TABLE_ADDR_STR_LEN bytes
+static inline const char *route_table_node_oif(route_table_node_t *node) {
+    return route_intern_get(__atomic_load_n(&node->oif_id, __ATOMIC_ACQUIRE));
+}
+
+static inline const char *route_table_node_gateway(route_table_node_t *node) {
+    return route_intern_get(__atomic_load_n(&node->gateway_id, __ATOMIC_ACQUIRE));
+}
+
+char *route_table_node_dest_str(route_table_node_t *node, char *buf);
+char *route_table_node_mask_str(route_table_node_t *node, char *buf);
+size_t route_table_mem_bytes(void);
+void route_table_print_pool_stats(void);
+
+// Prefix index APIs, prefix and addr are IPv4 addresses in host byte order
+bool route_table_parse_prefix(const char *dest_addr, const char *mask, uint32_t *prefix, uint8_t *prefix_len);
+route_table_node_t *get_route_table_node_by_prefix(uint32_t prefix, uint8_t prefix_len);
+route_table_node_t *route_table_lookup_lpm(uint32_t addr);
+
+// Bulk route programming, one entry per route operation
+typedef struct route_table_op {
+    nfc_op_t op;       // NFC_ADD, NFC_MOD or NFC_DEL
+    char *dest_addr;
+    char *mask;
+    char *new_mask;    // NFC_MOD only, NULL keeps the mask
+    char *oif;         // NFC_ADD/NFC_MOD, NULL keeps the current value on NFC_MOD
+    char *gateway;
+    int status;        // Out, 1 if the operation was applied
+} route_table_op_t;
+
+int route_table_apply_batch(route_table_op_t *ops, uint32_t n_ops);
+
+// Concurrency, lookups are lock-free RCU readers and all updates are serialized
+// by one writer lock. A route returned by a lookup may be freed by a concurrent
+// remove, so callers keep using it only inside a read-side section or while
+// holding the writer lock
+void route_table_read_lock(void);
+void route_table_read_unlock(void);
+void route_table_writer_lock(void);
+void route_table_writer_unlock(void);
+void set_route_table_verbose(bool verbose);
+
 #endif // ROUTE_TABLE_H
\ No newline at end of file
@@ -0,0 +1,234 @@
+#define _GNU_SOURCE  // For strdup
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "route_table_alloc.h"
+#include "rcu.h"
+
+// Interned strings, string to id through a chained hash table guarded by the
+// mutex, id to entry through chunks which never move once published
+typedef struct route_intern_entry {
+    char *str;
+    uint32_t id;
+    uint32_t ref_count;
+    uint64_t hash;
+    struct route_intern_entry *next;
+} route_intern_entry_t;
+
+static route_intern_entry_t **route_intern_chunks[ROUTE_INTERN_MAX_CHUNKS];
+static route_intern_entry_t **route_intern_buckets = NULL;
+static uint32_t route_intern_n_buckets = 0;
+static uint32_t route_intern_n_entries = 0;
+static uint32_t route_intern_next_id = 1;
+// Ids of freed strings, handed out again before route_intern_next_id grows
+static uint32_t *route_intern_free_ids = NULL;
+static uint32_t route_intern_n_free_ids = 0;
+static uint32_t route_intern_free_ids_capacity = 0;
+static pthread_mutex_t route_intern_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t route_intern_hash(const char *str) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+
+    for (; *str; str++) {
+        hash ^= (unsigned char)*str;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Caller holds route_intern_mutex
+static route_intern_entry_t *route_intern_lookup(const char *str, uint64_t hash) {
+    route_intern_entry_t *entry;
+
+    if (!route_intern_n_buckets) return NULL;
+    for (entry = route_intern_buckets[hash & (route_intern_n_buckets - 1)]; entry; entry = entry->next) {
+        if (entry->hash == hash && strcmp(entry->str, str) == 0) return entry;
+    }
+    return NULL;
+}
+
+static void route_intern_resize(uint32_t n_buckets) {
+    route_intern_entry_t **buckets = calloc(n_buckets, sizeof(route_intern_entry_t *));
+    route_intern_entry_t *entry, *next;
+    uint32_t i;
+
+    if (!buckets) {
+        perror("Failed to allocate memory for intern table");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < route_intern_n_buckets; i++) {
+        for (entry = route_intern_buckets[i]; entry; entry = next) {
+            next = entry->next;
+            entry->next = buckets[entry->hash & (n_buckets - 1)];
+            buckets[entry->hash & (n_buckets - 1)] = entry;
+        }
+    }
+    free(route_intern_buckets);
+    route_intern_buckets = buckets;
+    route_intern_n_buckets = n_buckets;
+}
+
+// Caller holds route_intern_mutex. Returns NULL if the id is out of range
+static route_intern_entry_t **route_intern_slot(uint32_t id) {
+    route_intern_entry_t **ids;
+    uint32_t chunk = id / ROUTE_INTERN_CHUNK_SIZE;
+
+    if (chunk >= ROUTE_INTERN_MAX_CHUNKS) return NULL;
+    ids = route_intern_chunks[chunk];
+    if (!ids) {
+        ids = calloc(ROUTE_INTERN_CHUNK_SIZE, sizeof(route_intern_entry_t *));
+        if (!ids) {
+            perror("Failed to allocate memory for intern table");
+            exit(EXIT_FAILURE);
+        }
+        __atomic_store_n(&route_intern_chunks[chunk], ids, __ATOMIC_RELEASE);
+    }
+    return &ids[id % ROUTE_INTERN_CHUNK_SIZE];
+}
+
+// Function to get a reference on the id of str, interning it on first use
+// Returns false, with *id untouched, when every id is in use
+bool route_intern_string(const char *str, uint32_t *id) {
+    route_intern_entry_t *entry, **slot;
+    uint64_t hash;
+    uint32_t new_id;
+
+    if (!str) {
+        *id = ROUTE_INTERN_NULL_ID;
+        return true;
+    }
+
+    hash = route_intern_hash(str);
+    pthread_mutex_lock(&route_intern_mutex);
+    entry = route_intern_lookup(str, hash);
+    if (entry) {
+        entry->ref_count++;
+        *id = entry->id;
+        pthread_mutex_unlock(&route_intern_mutex);
+        return true;
+    }
+
+    new_id = route_intern_n_free_ids ? route_intern_free_ids[route_intern_n_free_ids - 1]
+                                     : route_intern_next_id;
+    slot = route_intern_slot(new_id);
+    if (!slot) {
+        pthread_mutex_unlock(&route_intern_mutex);
+        return false;
+    }
+    if (new_id == route_intern_next_id) {
+        route_intern_next_id++;
+    } else {
+        route_intern_n_free_ids--;
+    }
+    if (route_intern_n_entries >= route_intern_n_buckets) {
+        route_intern_resize(route_intern_n_buckets ? route_intern_n_buckets * 2 : 64);
+    }
+
+    entry = malloc(sizeof(route_intern_entry_t));
+    if (!entry || !(entry->str = strdup(str))) {
+        perror("Failed to allocate memory for interned string");
+        exit(EXIT_FAILURE);
+    }
+    entry->id = new_id;
+    entry->ref_count = 1;
+    entry->hash = hash;
+    entry->next = route_intern_buckets[hash & (route_intern_n_buckets - 1)];
+    route_intern_buckets[hash & (route_intern_n_buckets - 1)] = entry;
+    route_intern_n_entries++;
+
+    // The string is published before the id can be handed out
+    __atomic_store_n(slot, entry, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&route_intern_mutex);
+    *id = new_id;
+    return true;
+}
+
+// Function to take one more reference on an id already held by the caller
+void route_intern_ref(uint32_t id) {
+    if (id == ROUTE_INTERN_NULL_ID) return;
+    pthread_mutex_lock(&route_intern_mutex);
+    (*route_intern_slot(id))->ref_count++;
+    pthread_mutex_unlock(&route_intern_mutex);
+}
+
+// Deferred free of an unreferenced string, no reader can hold its id anymore
+static void route_intern_free_entry(void *arg) {
+    route_intern_entry_t *entry = (route_intern_entry_t *)arg;
+
+    pthread_mutex_lock(&route_intern_mutex);
+    __atomic_store_n(route_intern_slot(entry->id), NULL, __ATOMIC_RELAXED);
+    if (route_intern_n_free_ids == route_intern_free_ids_capacity) {
+        route_intern_free_ids_capacity = route_intern_free_ids_capacity ? route_intern_free_ids_capacity * 2 : 64;
+        route_intern_free_ids = realloc(route_intern_free_ids,
+                                        route_intern_free_ids_capacity * sizeof(uint32_t));
+        if (!route_intern_free_ids) {
+            perror("Failed to allocate memory for intern table");
+            exit(EXIT_FAILURE);
+        }
+    }
+    route_intern_free_ids[route_intern_n_free_ids++] = entry->id;
+    pthread_mutex_unlock(&route_intern_mutex);
+
+    free(entry->str);
+    free(entry);
+}
+
+// Function to drop a reference. The last one unlinks the string at once, so
+// interning it again gets a new id, and frees it after a grace period
+void route_intern_unref(uint32_t id) {
+    route_intern_entry_t *entry, **link;
+
+    if (id == ROUTE_INTERN_NULL_ID) return;
+    pthread_mutex_lock(&route_intern_mutex);
+    entry = *route_intern_slot(id);
+    if (--entry->ref_count) {
+        pthread_mutex_unlock(&route_intern_mutex);
+        return;
+    }
+    for (link = &route_intern_buckets[entry->hash & (route_intern_n_buckets - 1)]; *link != entry;
+         link = &(*link)->next);
+    *link = entry->next;
+    route_intern_n_entries--;
+    pthread_mutex_unlock(&route_intern_mutex);
+
+    rcu_retire(entry, route_intern_free_entry);
+}
+
+// Function to get the id of an already interned string without adding it
+bool route_intern_find(const char *str, uint32_t *id) {
+    route_intern_entry_t *entry;
+
+    if (!str) {
+        *id = ROUTE_INTERN_NULL_ID;
+        return true;
+    }
+    pthread_mutex_lock(&route_intern_mutex);
+    entry = route_intern_lookup(str, route_intern_hash(str));
+    if (entry) *id = entry->id;
+    pthread_mutex_unlock(&route_intern_mutex);
+    return entry != NULL;
+}
+
+// Function to resolve an id, lock-free
+const char *route_intern_get(uint32_t id) {
+    route_intern_entry_t **ids, *entry;
+
+    if (id == ROUTE_INTERN_NULL_ID || id / ROUTE_INTERN_CHUNK_SIZE >= ROUTE_INTERN_MAX_CHUNKS) {
+        return NULL;
+    }
+    ids = __atomic_load_n(&route_intern_chunks[id / ROUTE_INTERN_CHUNK_SIZE], __ATOMIC_ACQUIRE);
+    entry = ids ? __atomic_load_n(&ids[id % ROUTE_INTERN_CHUNK_SIZE], __ATOMIC_ACQUIRE) : NULL;
+    return entry ? entry->str : NULL;
+}
+
+// Function to get the number of strings in use
+uint32_t route_intern_count(void) {
+    uint32_t count;
+
+    pthread_mutex_lock(&route_intern_mutex);
+    count = route_intern_n_entries;
+    pthread_mutex_unlock(&route_intern_mutex);
+    return count;
+}
@@ -0,0 +1,33 @@
+/* Interned strings for packed route table nodes.
+
+    Interface and gateway names are interned. A route stores a 32 bit id,
+    each distinct string is kept once and readers resolve an id to its
+    string without any lock. Id 0 stands for "no string".
+    @ Every id handed out by route_intern_string() or taken with
+    route_intern_ref() is a reference, drop it with route_intern_unref().
+    @ The last unref frees the string and recycles its id after an RCU grace
+    period, so a string is valid inside a read-side section or for as long
+    as a reference is held.
+    Route nodes themselves come from an object pool, see mem/obj_pool.h.
+*/
+
+#ifndef ROUTE_TABLE_ALLOC_H
+#define ROUTE_TABLE_ALLOC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ROUTE_INTERN_NULL_ID     0
+#define ROUTE_INTERN_CHUNK_SIZE  1024   // Ids per chunk of the id to string table
+#define ROUTE_INTERN_MAX_CHUNKS  1024   // Up to 1M strings in use at once
+
+// String interning APIs, NULL maps to ROUTE_INTERN_NULL_ID
+// route_intern_string() returns false when every id is in use
+bool route_intern_string(const char *str, uint32_t *id);
+void route_intern_ref(uint32_t id);
+void route_intern_unref(uint32_t id);
+bool route_intern_find(const char *str, uint32_t *id);
+const char *route_intern_get(uint32_t id);
+uint32_t route_intern_count(void);
+
+#endif // ROUTE_TABLE_ALLOC_H
@@ -0,0 +1,648 @@
+#define _GNU_SOURCE  // For clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "route_table_dispatch.h"
+
+// Dispatcher worker pool, queues with pending events wait on the ready list
+typedef struct route_table_dispatcher {
+    pthread_t *workers;
+    uint32_t n_workers;
+    bool running;
+    uint64_t coalesce_window_ns; // 0 when coalescing is off
+    route_table_notif_queue_t *ready_head;
+    route_table_notif_queue_t *ready_tail;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} route_table_dispatcher_t;
+
+// cond runs on CLOCK_MONOTONIC, it is set up by route_table_dispatch_init()
+static route_table_dispatcher_t dispatcher = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static uint64_t route_table_dispatch_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Function to copy the fields a subscriber can look at, glue fields stay empty
+// The copy holds its own references on the interned strings. Called under the
+// writer lock, so the ids cannot change meanwhile
+route_table_notif_snapshot_t *route_table_notif_snapshot_create(route_table_node_t *node) {
+    route_table_notif_snapshot_t *snapshot = calloc(1, sizeof(route_table_notif_snapshot_t));
+    if (!snapshot) {
+        perror("Failed to allocate memory for notification snapshot");
+        exit(EXIT_FAILURE);
+    }
+    snapshot->route.prefix = node->prefix;
+    snapshot->route.prefix_len = node->prefix_len;
+    snapshot->route.oif_id = __atomic_load_n(&node->oif_id, __ATOMIC_ACQUIRE);
+    snapshot->route.gateway_id = __atomic_load_n(&node->gateway_id, __ATOMIC_ACQUIRE);
+    route_intern_ref(snapshot->route.oif_id);
+    route_intern_ref(snapshot->route.gateway_id);
+    snapshot->route.is_indexed = node->is_indexed;
+    init_glthread(&snapshot->route.subscriber_list);
+    init_glthread(&snapshot->route.list);
+    init_glthread(&snapshot->route.trie_glue);
+    snapshot->ref_count = 1;
+    return snapshot;
+}
+
+void route_table_notif_snapshot_ref(route_table_notif_snapshot_t *snapshot) {
+    __atomic_add_fetch(&snapshot->ref_count, 1, __ATOMIC_RELAXED);
+}
+
+void route_table_notif_snapshot_unref(route_table_notif_snapshot_t *snapshot) {
+    if (__atomic_sub_fetch(&snapshot->ref_count, 1, __ATOMIC_ACQ_REL)) return;
+    route_intern_unref(snapshot->route.oif_id);
+    route_intern_unref(snapshot->route.gateway_id);
+    free(snapshot);
+}
+
+// Function to create an empty route batch for one async subscriber
+route_table_notif_batch_t *route_table_notif_batch_create(void) {
+    route_table_notif_batch_t *batch = calloc(1, sizeof(route_table_notif_batch_t));
+    if (!batch) {
+        perror("Failed to allocate memory for notification batch");
+        exit(EXIT_FAILURE);
+    }
+    return batch;
+}
+
+// Entries and held queues must have been handed over or released
+static void route_table_notif_batch_free(route_table_notif_batch_t *batch) {
+    free(batch->entries);
+    free(batch->snapshots);
+    free(batch->held);
+    free(batch);
+}
+
+// Append an entry, the batch takes over the caller's snapshot reference
+static void route_table_notif_batch_append(route_table_notif_batch_t *batch,
+                                           route_table_notif_snapshot_t *snapshot, nfc_op_t op) {
+    if (batch->n_entries == batch->capacity) {
+        batch->capacity = batch->capacity ? batch->capacity * 2 : 16;
+        batch->entries = realloc(batch->entries, batch->capacity * sizeof(route_table_notif_batch_entry_t));
+        batch->snapshots = realloc(batch->snapshots, batch->capacity * sizeof(route_table_notif_snapshot_t *));
+        if (!batch->entries || !batch->snapshots) {
+            perror("Failed to allocate memory for notification batch");
+            exit(EXIT_FAILURE);
+        }
+    }
+    batch->entries[batch->n_entries].route = &snapshot->route;
+    batch->entries[batch->n_entries].op = op;
+    batch->snapshots[batch->n_entries++] = snapshot;
+}
+
+// Move the entries of src behind those of dst, src is left empty
+static void route_table_notif_batch_move(route_table_notif_batch_t *dst, route_table_notif_batch_t *src) {
+    uint32_t i;
+
+    for (i = 0; i < src->n_entries; i++) {
+        route_table_notif_batch_append(dst, src->snapshots[i], src->entries[i].op);
+    }
+    src->n_entries = 0;
+}
+
+static void route_table_notif_batch_hold(route_table_notif_batch_t *batch, route_table_notif_queue_t *queue) {
+    // Consecutive entries mostly come from one route
+    if (batch->n_held && batch->held[batch->n_held - 1] == queue) return;
+    if (batch->n_held == batch->held_capacity) {
+        batch->held_capacity = batch->held_capacity ? batch->held_capacity * 2 : 16;
+        batch->held = realloc(batch->held, batch->held_capacity * sizeof(route_table_notif_queue_t *));
+        if (!batch->held) {
+            perror("Failed to allocate memory for notification batch");
+            exit(EXIT_FAILURE);
+        }
+    }
+    batch->held[batch->n_held++] = queue;
+}
+
+// Function to add the notification of one route to a batch, takes its own
+// reference on snapshot. queue is the subscriber queue of that route, the
+// batch is queued on the queue of its first entry
+void route_table_notif_batch_add(route_table_notif_batch_t *batch, route_table_notif_queue_t *queue,
+                                 route_table_notif_snapshot_t *snapshot, nfc_op_t op) {
+    route_table_notif_snapshot_ref(snapshot);
+    route_table_notif_batch_append(batch, snapshot, op);
+    route_table_notif_batch_hold(batch, queue);
+}
+
+// Caller holds dispatcher.mutex. Ready list is kept in deadline order, a queue
+// rescheduled after a drain or a window change can be due before the tail
+static void route_table_dispatch_push_ready(route_table_notif_queue_t *queue, uint64_t deadline_ns) {
+    route_table_notif_queue_t **link = &dispatcher.ready_head;
+
+    queue->deadline_ns = deadline_ns;
+    if (dispatcher.ready_tail && dispatcher.ready_tail->deadline_ns <= deadline_ns) {
+        link = &dispatcher.ready_tail->next_ready;
+    } else {
+        // Equal deadlines keep their push order
+        while (*link && (*link)->deadline_ns <= deadline_ns) {
+            link = &(*link)->next_ready;
+        }
+    }
+    queue->next_ready = *link;
+    *link = queue;
+    if (!queue->next_ready) dispatcher.ready_tail = queue;
+}
+
+static route_table_notif_queue_t *route_table_dispatch_pop_ready(void) {
+    route_table_notif_queue_t *queue = dispatcher.ready_head;
+    if (queue) {
+        dispatcher.ready_head = queue->next_ready;
+        if (!dispatcher.ready_head) dispatcher.ready_tail = NULL;
+        queue->next_ready = NULL;
+    }
+    return queue;
+}
+
+static void route_table_dispatch_schedule(route_table_notif_queue_t *queue, uint64_t enqueue_ns) {
+    pthread_mutex_lock(&dispatcher.mutex);
+    route_table_dispatch_push_ready(queue, enqueue_ns + dispatcher.coalesce_window_ns);
+    pthread_cond_signal(&dispatcher.cond);
+    pthread_mutex_unlock(&dispatcher.mutex);
+}
+
+// One batch_cb call, or one app_cb call per entry without batch_cb
+static void route_table_dispatch_deliver_batch(route_table_notif_elem_t *subscriber,
+                                               route_table_notif_batch_t *batch) {
+    uint32_t i;
+
+    if (subscriber->batch_cb) {
+        subscriber->batch_cb(batch->entries, batch->n_entries, subscriber->subs_id);
+    } else {
+        for (i = 0; i < batch->n_entries; i++) {
+            subscriber->app_cb(batch->entries[i].route, sizeof(route_table_node_t),
+                               batch->entries[i].op, subscriber->subs_id);
+        }
+    }
+    for (i = 0; i < batch->n_entries; i++) {
+        route_table_notif_snapshot_unref(batch->snapshots[i]);
+    }
+}
+
+// Function to let go the queues a delivered batch held back, those with
+// pending events go back on the ready list. A queue folded into a later
+// batch meanwhile is held by that one and is left alone
+static void route_table_dispatch_release(route_table_notif_batch_t *batch) {
+    route_table_notif_queue_t *queue;
+    uint64_t enqueue_ns = 0;
+    bool schedule;
+    uint32_t i;
+
+    for (i = 0; i < batch->n_held; i++) {
+        queue = batch->held[i];
+        schedule = false;
+        pthread_mutex_lock(&queue->mutex);
+        if (queue->held_by == batch) {
+            queue->held_by = NULL;
+            if (queue->count && !queue->scheduled) {
+                queue->scheduled = schedule = true;
+                enqueue_ns = queue->events[queue->head].enqueue_ns;
+            }
+        }
+        pthread_mutex_unlock(&queue->mutex);
+        if (schedule) route_table_dispatch_schedule(queue, enqueue_ns);
+    }
+}
+
+// Function to deliver up to ROUTE_TABLE_DISPATCH_BATCH events of one queue
+// Returns true if the queue still has events and must be rescheduled, the
+// enqueue time of the oldest of them is returned in next_enqueue_ns
+static bool route_table_dispatch_drain(route_table_notif_queue_t *queue, uint64_t *next_enqueue_ns) {
+    route_table_notif_elem_t *subscriber = queue->subscriber;
+    route_table_notif_event_t event;
+    uint64_t lag_ns;
+    uint32_t n;
+    bool pending;
+
+    pthread_mutex_lock(&queue->mutex);
+    // A held queue waits for a route batch queued elsewhere to be delivered
+    for (n = 0; n < ROUTE_TABLE_DISPATCH_BATCH && queue->count && !queue->held_by; n++) {
+        event = queue->events[queue->head];
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count--;
+        queue->delivering = true;
+        pthread_cond_signal(&queue->not_full);
+
+        lag_ns = route_table_dispatch_now_ns() - event.enqueue_ns;
+        queue->stats.last_lag_ns = lag_ns;
+        if (lag_ns > queue->stats.max_lag_ns) queue->stats.max_lag_ns = lag_ns;
+        queue->total_lag_ns += lag_ns;
+        pthread_mutex_unlock(&queue->mutex);
+
+        // Callback runs without any lock held, the publisher is free to enqueue
+        if (event.batch) {
+            route_table_dispatch_deliver_batch(subscriber, event.batch);
+            route_table_dispatch_release(event.batch);
+            route_table_notif_batch_free(event.batch);
+        } else {
+            subscriber->app_cb(&event.snapshot->route, sizeof(route_table_node_t),
+                               event.op, subscriber->subs_id);
+            route_table_notif_snapshot_unref(event.snapshot);
+        }
+
+        pthread_mutex_lock(&queue->mutex);
+        queue->stats.delivered++;
+        queue->delivering = false;
+        pthread_cond_broadcast(&queue->not_full);
+    }
+    pending = queue->count && !queue->held_by;
+    if (pending) {
+        *next_enqueue_ns = queue->events[queue->head].enqueue_ns;
+    } else {
+        queue->scheduled = false;
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return pending;
+}
+
+static void *route_table_dispatch_worker_fn(void *arg) {
+    route_table_notif_queue_t *queue;
+    uint64_t next_enqueue_ns = 0;
+    struct timespec until;
+    bool pending;
+    (void)arg;
+
+    pthread_mutex_lock(&dispatcher.mutex);
+    while (1) {
+        while (dispatcher.running && !dispatcher.ready_head) {
+            pthread_cond_wait(&dispatcher.cond, &dispatcher.mutex);
+        }
+        // Ready list is in deadline order.
+        // Hold the head queue back until its coalescing window has expired
+        queue = dispatcher.ready_head;
+        if (queue && dispatcher.running && queue->deadline_ns > route_table_dispatch_now_ns()) {
+            until.tv_sec = queue->deadline_ns / 1000000000ull;
+            until.tv_nsec = queue->deadline_ns % 1000000000ull;
+            pthread_cond_timedwait(&dispatcher.cond, &dispatcher.mutex, &until);
+            continue;
+        }
+        // Pending events are delivered before the pool stops
+        queue = route_table_dispatch_pop_ready();
+        if (!queue) break;
+        pthread_mutex_unlock(&dispatcher.mutex);
+
+        // Round robin between queues keeps one busy subscriber from starving others
+        pending = route_table_dispatch_drain(queue, &next_enqueue_ns);
+
+        pthread_mutex_lock(&dispatcher.mutex);
+        if (pending) {
+            route_table_dispatch_push_ready(queue, next_enqueue_ns + dispatcher.coalesce_window_ns);
+        }
+    }
+    pthread_mutex_unlock(&dispatcher.mutex);
+    return NULL;
+}
+
+// Function to start the dispatcher worker pool
+void route_table_dispatch_init(uint32_t n_workers) {
+    pthread_condattr_t attr;
+    uint32_t i;
+
+    if (!n_workers) n_workers = ROUTE_TABLE_DISPATCH_DEFAULT_WORKERS;
+
+    pthread_mutex_lock(&dispatcher.mutex);
+    if (dispatcher.running) {
+        pthread_mutex_unlock(&dispatcher.mutex);
+        return;
+    }
+    dispatcher.workers = calloc(n_workers, sizeof(pthread_t));
+    if (!dispatcher.workers) {
+        perror("Failed to allocate memory for dispatcher workers");
+        exit(EXIT_FAILURE);
+    }
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&dispatcher.cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    dispatcher.n_workers = n_workers;
+    __atomic_store_n(&dispatcher.running, true, __ATOMIC_RELEASE);
+    for (i = 0; i < n_workers; i++) {
+        pthread_create(&dispatcher.workers[i], NULL, route_table_dispatch_worker_fn, NULL);
+    }
+    pthread_mutex_unlock(&dispatcher.mutex);
+}
+
+// Function to stop the worker pool once every queued event has been delivered
+void route_table_dispatch_shutdown(void) {
+    uint32_t i;
+
+    pthread_mutex_lock(&dispatcher.mutex);
+    if (!dispatcher.running) {
+        pthread_mutex_unlock(&dispatcher.mutex);
+        return;
+    }
+    __atomic_store_n(&dispatcher.running, false, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&dispatcher.cond);
+    pthread_mutex_unlock(&dispatcher.mutex);
+
+    for (i = 0; i < dispatcher.n_workers; i++) {
+        pthread_join(dispatcher.workers[i], NULL);
+    }
+    free(dispatcher.workers);
+    dispatcher.workers = NULL;
+    dispatcher.n_workers = 0;
+    pthread_cond_destroy(&dispatcher.cond);
+}
+
+// Function to set how long an async event may wait for later events on the
+// same route to be folded into it. 0 delivers as soon as a worker is free
+void route_table_dispatch_set_coalesce_window(uint32_t max_delay_us) {
+    pthread_mutex_lock(&dispatcher.mutex);
+    __atomic_store_n(&dispatcher.coalesce_window_ns, (uint64_t)max_delay_us * 1000, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&dispatcher.mutex);
+}
+
+bool route_table_dispatch_is_running(void) {
+    return __atomic_load_n(&dispatcher.running, __ATOMIC_ACQUIRE);
+}
+
+// Function to create the event queue of an async subscriber
+route_table_notif_queue_t *route_table_notif_queue_create(route_table_notif_elem_t *subscriber,
+                                        uint32_t capacity, nfc_overflow_policy_t policy) {
+    route_table_notif_queue_t *queue = calloc(1, sizeof(route_table_notif_queue_t));
+    if (!queue) {
+        perror("Failed to allocate memory for notification queue");
+        exit(EXIT_FAILURE);
+    }
+    if (!capacity) capacity = 1;
+    queue->events = calloc(capacity, sizeof(route_table_notif_event_t));
+    if (!queue->events) {
+        perror("Failed to allocate memory for notification queue");
+        exit(EXIT_FAILURE);
+    }
+    queue->subscriber = subscriber;
+    queue->capacity = capacity;
+    queue->policy = policy;
+    queue->stats.capacity = capacity;
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+    return queue;
+}
+
+// Net effect of two events on a route the subscriber has seen neither of.
+// NFC_UNKNOWN means they cancel out
+static nfc_op_t route_table_notif_merge_op(nfc_op_t queued_op, nfc_op_t op) {
+    switch (op) {
+        case NFC_MOD:
+            // Route is still new (or still the initial state) to the subscriber
+            if (queued_op == NFC_ADD || queued_op == NFC_SUB) return queued_op;
+            return NFC_MOD;
+        case NFC_DEL:
+            // Route came and went unseen
+            if (queued_op == NFC_ADD) return NFC_UNKNOWN;
+            return NFC_DEL;
+        case NFC_ADD:
+            // Subscriber knows the route from before the DEL
+            if (queued_op == NFC_DEL) return NFC_MOD;
+            return NFC_ADD;
+        default:
+            return op;
+    }
+}
+
+// Merge a new event into the newest queued one, the latest snapshot wins
+// Caller holds queue->mutex, the queue is not empty
+static void route_table_notif_coalesce(route_table_notif_queue_t *queue,
+                                       route_table_notif_snapshot_t *snapshot, nfc_op_t op) {
+    route_table_notif_event_t *queued =
+        &queue->events[(queue->head + queue->count - 1) % queue->capacity];
+    nfc_op_t net_op;
+
+    queue->stats.coalesced++;
+    if (queued->batch) {
+        // Entries of one route are delivered in order
+        route_table_notif_batch_append(queued->batch, snapshot, op);
+        return;
+    }
+    net_op = route_table_notif_merge_op(queued->op, op);
+    route_table_notif_snapshot_unref(queued->snapshot);
+
+    if (net_op == NFC_UNKNOWN) {
+        route_table_notif_snapshot_unref(snapshot);
+        queue->count--;
+        return;
+    }
+    queued->snapshot = snapshot;
+    queued->op = net_op;
+}
+
+// Function to queue a notification for an async subscriber, takes its own
+// reference on snapshot. Called on the publisher (writer) thread
+void route_table_notif_enqueue(route_table_notif_queue_t *queue,
+                               route_table_notif_snapshot_t *snapshot, nfc_op_t op) {
+    route_table_notif_event_t *event;
+    uint64_t enqueue_ns;
+    bool schedule;
+
+    route_table_notif_snapshot_ref(snapshot);
+
+    pthread_mutex_lock(&queue->mutex);
+    queue->stats.enqueued++;
+
+    if (queue->count == queue->capacity) {
+        switch (queue->policy) {
+            case NFC_OVERFLOW_COALESCE:
+                route_table_notif_coalesce(queue, snapshot, op);
+                pthread_mutex_unlock(&queue->mutex);
+                return;
+            case NFC_OVERFLOW_DROP_OLDEST:
+                // A route batch is never dropped
+                if (queue->events[queue->head].batch) {
+                    route_table_notif_coalesce(queue, snapshot, op);
+                    pthread_mutex_unlock(&queue->mutex);
+                    return;
+                }
+                route_table_notif_snapshot_unref(queue->events[queue->head].snapshot);
+                queue->head = (queue->head + 1) % queue->capacity;
+                queue->count--;
+                queue->stats.dropped++;
+                break;
+            case NFC_OVERFLOW_BLOCK:
+                queue->stats.blocked++;
+                while (queue->count == queue->capacity) {
+                    pthread_cond_wait(&queue->not_full, &queue->mutex);
+                }
+                break;
+        }
+    }
+
+    // Within the coalescing window a route has at most one undelivered event.
+    // The overflow policy above has already run, so a full queue never gets
+    // here by merging. Queue is non empty hence already scheduled
+    if (queue->count && __atomic_load_n(&dispatcher.coalesce_window_ns, __ATOMIC_RELAXED)) {
+        route_table_notif_coalesce(queue, snapshot, op);
+        pthread_mutex_unlock(&queue->mutex);
+        return;
+    }
+
+    event = &queue->events[(queue->head + queue->count) % queue->capacity];
+    event->snapshot = snapshot;
+    event->op = op;
+    event->batch = NULL;
+    event->enqueue_ns = enqueue_ns = route_table_dispatch_now_ns();
+    queue->count++;
+    if (queue->count > queue->stats.max_depth) queue->stats.max_depth = queue->count;
+
+    // A held queue is scheduled once the batch holding it has been delivered
+    schedule = !queue->scheduled && !queue->held_by;
+    if (schedule) queue->scheduled = true;
+    pthread_mutex_unlock(&queue->mutex);
+
+    if (schedule) route_table_dispatch_schedule(queue, enqueue_ns);
+}
+
+// Function to queue a route batch on the queue of its first entry. Events
+// still queued for any route of the batch are folded in ahead of its entries,
+// and those queues are held back until the batch has been delivered. A queue
+// held by an undelivered earlier batch pulls that batch in as well, so each
+// route keeps its publish order. Caller holds the route table writer lock
+void route_table_notif_enqueue_batch(route_table_notif_batch_t *batch) {
+    route_table_notif_batch_t *involved = route_table_notif_batch_create(); // Queues to fold
+    route_table_notif_batch_t *folded = route_table_notif_batch_create();   // Earlier batches
+    route_table_notif_batch_t *single = route_table_notif_batch_create();   // Single events
+    route_table_notif_batch_t *done = NULL;
+    route_table_notif_queue_t *queue, *target = batch->held[0];
+    route_table_notif_event_t *event;
+    uint64_t enqueue_ns;
+    bool schedule;
+    uint32_t i, j;
+
+    // The held list is rebuilt once the queues have been folded
+    involved->held = batch->held;
+    involved->n_held = batch->n_held;
+    involved->held_capacity = batch->held_capacity;
+    batch->held = NULL;
+    batch->n_held = batch->held_capacity = 0;
+
+    for (i = 0; i < involved->n_held; i++) {
+        queue = involved->held[i];
+        if (queue->in_batch) continue;
+        queue->in_batch = true;
+
+        pthread_mutex_lock(&queue->mutex);
+        // An event in flight is older than anything folded, let it finish
+        while (queue->delivering) {
+            pthread_cond_wait(&queue->not_full, &queue->mutex);
+        }
+        // Pending batches never sit on a held queue, they are folded first
+        if (queue->held_by) route_table_notif_batch_hold(involved, queue->held_by->queue);
+
+        for (; queue->count; queue->count--) {
+            event = &queue->events[queue->head];
+            queue->head = (queue->head + 1) % queue->capacity;
+            queue->stats.coalesced++;
+            if (!event->batch) {
+                route_table_notif_batch_append(single, event->snapshot, event->op);
+                continue;
+            }
+            for (j = 0; j < event->batch->n_held; j++) {
+                route_table_notif_batch_hold(involved, event->batch->held[j]);
+            }
+            route_table_notif_batch_move(folded, event->batch);
+            // Queues it holds may still be visited and look it up
+            event->batch->next_folded = done;
+            done = event->batch;
+        }
+        pthread_mutex_unlock(&queue->mutex);
+    }
+
+    // Routes of distinct earlier batches never overlap, and single events
+    // were all published after the batch holding their queue
+    route_table_notif_batch_move(folded, single);
+    route_table_notif_batch_move(folded, batch);
+    route_table_notif_batch_move(batch, folded);
+    batch->queue = target;
+
+    for (i = 0; i < involved->n_held; i++) {
+        queue = involved->held[i];
+        if (!queue->in_batch) continue;
+        queue->in_batch = false;
+        if (queue == target) continue;
+        pthread_mutex_lock(&queue->mutex);
+        queue->held_by = batch;
+        pthread_mutex_unlock(&queue->mutex);
+        route_table_notif_batch_hold(batch, queue);
+    }
+    route_table_notif_batch_free(involved);
+    route_table_notif_batch_free(folded);
+    route_table_notif_batch_free(single);
+    while (done) {
+        folded = done;
+        done = done->next_folded;
+        route_table_notif_batch_free(folded);
+    }
+
+    // Folding emptied the target
+    pthread_mutex_lock(&target->mutex);
+    target->held_by = NULL;
+    event = &target->events[target->head];
+    event->snapshot = NULL;
+    event->op = NFC_UNKNOWN;
+    event->batch = batch;
+    event->enqueue_ns = enqueue_ns = route_table_dispatch_now_ns();
+    target->count = 1;
+    target->stats.enqueued++;
+    if (!target->stats.max_depth) target->stats.max_depth = 1;
+
+    schedule = !target->scheduled;
+    target->scheduled = true;
+    pthread_mutex_unlock(&target->mutex);
+
+    if (schedule) route_table_dispatch_schedule(target, enqueue_ns);
+}
+
+void route_table_notif_get_stats(route_table_notif_queue_t *queue, route_table_notif_stats_t *stats) {
+    pthread_mutex_lock(&queue->mutex);
+    *stats = queue->stats;
+    stats->depth = queue->count;
+    stats->avg_lag_ns = stats->delivered ? queue->total_lag_ns / stats->delivered : 0;
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+// Function to print lag metrics of every async subscriber
+void print_route_table_notif_stats(void) {
+    route_table_instance_t *table;
+    route_table_node_t *node;
+    route_table_notif_elem_t *subscriber;
+    route_table_notif_stats_t stats;
+    glthread_t *curr, *curr_sub;
+    char dest_addr[ROUTE_TABLE_ADDR_STR_LEN];
+
+    // Subscriber lists only change under the writer lock
+    route_table_writer_lock();
+    table = get_route_table_head();
+    if (!table) {
+        route_table_writer_unlock();
+        return;
+    }
+
+    printf("%-8s %-20s %-12s %6s %6s %8s %8s %8s %8s %8s %10s %10s\n",
+           "subs_id", "route", "policy", "depth", "max", "enqueued", "deliver",
+           "dropped", "coalesce", "blocked", "avg lag us", "max lag us");
+
+    ITERATE_GLTHREAD_BEGIN(&table->list, curr) {
+        node = glue_to_route_node(curr);
+        ITERATE_GLTHREAD_BEGIN(&node->subscriber_list, curr_sub) {
+            subscriber = glue_to_notif_elem(curr_sub);
+            if (!subscriber->queue) continue;
+            route_table_notif_get_stats(subscriber->queue, &stats);
+            printf("%-8u %-20s %-12s %6u %6u %8lu %8lu %8lu %8lu %8lu %10.1f %10.1f\n",
+                   subscriber->subs_id, route_table_node_dest_str(node, dest_addr),
+                   nfc_get_str_overflow_policy(subscriber->queue->policy),
+                   stats.depth, stats.max_depth,
+                   (unsigned long)stats.enqueued, (unsigned long)stats.delivered,
+                   (unsigned long)stats.dropped, (unsigned long)stats.coalesced,
+                   (unsigned long)stats.blocked,
+                   stats.avg_lag_ns / 1000.0, stats.max_lag_ns / 1000.0);
+        } ITERATE_GLTHREAD_END(&node->subscriber_list, curr_sub);
+    } ITERATE_GLTHREAD_END(&table->list, curr);
+
+    route_table_writer_unlock();
+}
@@ -0,0 +1,143 @@
+/* Asynchronous delivery of route table notifications.
+
+    @ A subscriber registered in async mode owns a bounded event queue. The
+    writer thread only snapshots the route and enqueues it, callbacks run on a
+    small pool of dispatcher worker threads, so a slow subscriber no longer
+    stalls route add/modify/delete.
+    @ A queue is drained by at most one worker at a time, so every subscriber
+    sees its events in publish order.
+    @ When a queue is full the subscriber's overflow policy decides what happens:
+    coalesce the new event into the newest queued one, drop the oldest queued
+    event, or block the publisher until the worker makes room.
+    @ With a coalescing window set, an event is held back up to max delay and
+    later events of the same route are folded into it (net ADD/MOD/DEL state),
+    so subscriber work follows the number of changed prefixes, not the churn.
+    A full queue still goes through the overflow policy first, so with the
+    block policy the publisher can wait up to max delay for room.
+    @ The route handed to an async callback is a read-only snapshot which is
+    valid for the duration of the callback only.
+    @ With the block policy the publisher waits while holding the route table
+    writer lock, so async callbacks must not call route table update APIs.
+    @ route_table_apply_batch() queues one event per async subscriber, on the
+    queue of one of its routes, delivered with one batch_cb call (one app_cb
+    per route without batch_cb). Events still queued for the other routes of
+    the batch are folded into it and those queues are held back until it has
+    been delivered, so every route still sees its events in publish order.
+    A batch event is never dropped, events arriving behind it in a full queue
+    are appended to it.
+    @ route_table_dispatch_shutdown() delivers what is queued, call it once
+    publishers are done. Later notifications fall back to synchronous calls.
+*/
+
+#ifndef ROUTE_TABLE_DISPATCH_H
+#define ROUTE_TABLE_DISPATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "route_table.h"
+
+#define ROUTE_TABLE_DISPATCH_DEFAULT_WORKERS 2
+#define ROUTE_TABLE_DISPATCH_BATCH 16 // Events a worker delivers before moving to another queue
+
+typedef enum {
+    NFC_OVERFLOW_COALESCE,    // Merge into the newest queued event, publisher never waits
+    NFC_OVERFLOW_DROP_OLDEST, // Discard the oldest queued event, publisher never waits
+    NFC_OVERFLOW_BLOCK,       // Publisher waits for room, no event is lost
+} nfc_overflow_policy_t;
+
+// Route copy shared by all subscriber queues a notification was fanned out to
+typedef struct route_table_notif_snapshot {
+    route_table_node_t route;
+    uint32_t ref_count;
+} route_table_notif_snapshot_t;
+
+// Notifications of one route batch for one async subscriber
+typedef struct route_table_notif_batch {
+    route_table_notif_batch_entry_t *entries;
+    route_table_notif_snapshot_t **snapshots; // Referenced, one per entry
+    uint32_t n_entries;
+    uint32_t capacity;
+    struct route_table_notif_queue *queue;  // Queue the batch event sits on
+    struct route_table_notif_queue **held; // Queues held back until delivery
+    uint32_t n_held;
+    uint32_t held_capacity;
+    struct route_table_notif_batch *next_folded; // Freed once folding is done
+} route_table_notif_batch_t;
+
+typedef struct route_table_notif_event {
+    route_table_notif_snapshot_t *snapshot;
+    nfc_op_t op;
+    uint64_t enqueue_ns;
+    route_table_notif_batch_t *batch; // Route batch event, snapshot and op unused
+} route_table_notif_event_t;
+
+// Per subscriber delivery metrics, lag is enqueue to callback start
+typedef struct route_table_notif_stats {
+    uint32_t depth;
+    uint32_t max_depth;
+    uint32_t capacity;
+    uint64_t enqueued;
+    uint64_t delivered;
+    uint64_t dropped;
+    uint64_t coalesced;
+    uint64_t blocked;   // Publishes which had to wait for room
+    uint64_t last_lag_ns;
+    uint64_t max_lag_ns;
+    uint64_t avg_lag_ns;
+} route_table_notif_stats_t;
+
+typedef struct route_table_notif_queue {
+    route_table_notif_elem_t *subscriber;
+    route_table_notif_event_t *events; // Ring of capacity events
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t count;
+    nfc_overflow_policy_t policy;
+    bool scheduled;    // On the dispatcher ready list or being drained
+    bool delivering;   // A worker is running a callback of this queue
+    bool in_batch;     // Being folded into a batch, guarded by the writer lock
+    route_table_notif_batch_t *held_by; // Undelivered batch this queue waits for
+    uint64_t deadline_ns; // Not delivered before, guarded by the dispatcher mutex
+    pthread_mutex_t mutex;
+    pthread_cond_t not_full;
+    struct route_table_notif_queue *next_ready;
+    route_table_notif_stats_t stats;
+    uint64_t total_lag_ns;
+} route_table_notif_queue_t;
+
+// Dispatcher worker pool
+void route_table_dispatch_init(uint32_t n_workers);
+void route_table_dispatch_shutdown(void);
+bool route_table_dispatch_is_running(void);
+void route_table_dispatch_set_coalesce_window(uint32_t max_delay_us);
+
+// Subscriber queues
+route_table_notif_queue_t *route_table_notif_queue_create(route_table_notif_elem_t *subscriber,
+                                        uint32_t capacity, nfc_overflow_policy_t policy);
+route_table_notif_snapshot_t *route_table_notif_snapshot_create(route_table_node_t *node);
+void route_table_notif_snapshot_ref(route_table_notif_snapshot_t *snapshot);
+void route_table_notif_snapshot_unref(route_table_notif_snapshot_t *snapshot);
+void route_table_notif_enqueue(route_table_notif_queue_t *queue,
+                               route_table_notif_snapshot_t *snapshot, nfc_op_t op);
+route_table_notif_batch_t *route_table_notif_batch_create(void);
+void route_table_notif_batch_add(route_table_notif_batch_t *batch, route_table_notif_queue_t *queue,
+                                 route_table_notif_snapshot_t *snapshot, nfc_op_t op);
+void route_table_notif_enqueue_batch(route_table_notif_batch_t *batch);
+void route_table_notif_get_stats(route_table_notif_queue_t *queue, route_table_notif_stats_t *stats);
+void print_route_table_notif_stats(void);
+
+static inline char *nfc_get_str_overflow_policy(nfc_overflow_policy_t policy) {
+    switch(policy) {
+        case NFC_OVERFLOW_COALESCE:
+            return "coalesce";
+        case NFC_OVERFLOW_DROP_OLDEST:
+            return "drop-oldest";
+        case NFC_OVERFLOW_BLOCK:
+            return "block";
+        default:
+            return NULL;
+    }
+}
+
+#endif // ROUTE_TABLE_DISPATCH_H
@@ -0,0 +1,173 @@
+// Tests for async notification delivery with a coalescing window set
+// A full queue must go through the subscriber's overflow policy before any
+// window merge, and a queue due early must not wait behind one due later.
+// A route batch reaches an async subscriber of many routes as one batch_cb.
+// Exits 0 on success, killed by SIGALRM if delivery hangs.
+#define _GNU_SOURCE  // For clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <signal.h>
+#include <unistd.h>
+#include <time.h>
+#include "route_table_dispatch.h"
+#include "route_table_subscriber.h"
+
+#define TEST_EVENTS     8
+#define TEST_WINDOW_US  20000
+#define TEST_ROUTES     8
+
+static uint32_t test_seq;
+static uint32_t test_delivered_seq[2]; // Delivery order per subs_id
+static nfc_op_t test_last_op;
+
+static void test_app_cb(void *route, size_t size, nfc_op_t op, uint32_t subs_id) {
+    (void)route;
+    (void)size;
+    test_delivered_seq[subs_id] = __atomic_add_fetch(&test_seq, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&test_last_op, op, __ATOMIC_RELAXED);
+}
+
+static uint32_t test_batch_calls;
+static uint32_t test_batch_entries;
+static nfc_op_t test_batch_first_op;
+static uint32_t test_app_calls;
+
+static void test_batch_app_cb(void *route, size_t size, nfc_op_t op, uint32_t subs_id) {
+    (void)route;
+    (void)size;
+    (void)op;
+    (void)subs_id;
+    __atomic_add_fetch(&test_app_calls, 1, __ATOMIC_RELAXED);
+}
+
+static void test_batch_cb(route_table_notif_batch_entry_t *entries, uint32_t n_entries, uint32_t subs_id) {
+    (void)subs_id;
+    test_batch_first_op = entries[0].op;
+    test_batch_entries = n_entries;
+    __atomic_add_fetch(&test_batch_calls, 1, __ATOMIC_RELEASE);
+}
+
+static uint64_t test_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static route_table_notif_queue_t *test_queue_create(route_table_notif_elem_t *subscriber, uint32_t subs_id,
+                                                    uint32_t capacity, nfc_overflow_policy_t policy) {
+    subscriber->subs_id = subs_id;
+    subscriber->app_cb = test_app_cb;
+    subscriber->queue = route_table_notif_queue_create(subscriber, capacity, policy);
+    return subscriber->queue;
+}
+
+static void test_publish(route_table_notif_queue_t *queue, route_table_node_t *node, nfc_op_t op) {
+    route_table_notif_snapshot_t *snapshot = route_table_notif_snapshot_create(node);
+    route_table_notif_enqueue(queue, snapshot, op);
+    route_table_notif_snapshot_unref(snapshot);
+}
+
+// One slot queue, every publish after the first finds it full while the
+// window still holds the first event back
+static void test_full_queue(nfc_overflow_policy_t policy) {
+    route_table_notif_elem_t subscriber = {0};
+    route_table_node_t node = {0};
+    route_table_notif_queue_t *queue;
+    route_table_notif_stats_t stats;
+    uint32_t i;
+
+    route_table_dispatch_init(1);
+    route_table_dispatch_set_coalesce_window(TEST_WINDOW_US);
+    queue = test_queue_create(&subscriber, 0, 1, policy);
+
+    test_publish(queue, &node, NFC_ADD);
+    for (i = 1; i < TEST_EVENTS; i++) {
+        test_publish(queue, &node, NFC_MOD);
+    }
+    route_table_dispatch_shutdown();
+    route_table_notif_get_stats(queue, &stats);
+
+    assert(stats.max_depth <= stats.capacity);
+    assert(stats.enqueued == TEST_EVENTS);
+    switch (policy) {
+        case NFC_OVERFLOW_COALESCE:
+            assert(stats.coalesced == TEST_EVENTS - 1);
+            assert(stats.delivered == 1 && test_last_op == NFC_ADD);
+            break;
+        case NFC_OVERFLOW_DROP_OLDEST:
+            assert(stats.dropped == TEST_EVENTS - 1 && stats.coalesced == 0);
+            assert(stats.delivered == 1 && test_last_op == NFC_MOD);
+            break;
+        case NFC_OVERFLOW_BLOCK:
+            // No event is lost, each one waits out the window of the one before
+            assert(stats.blocked == TEST_EVENTS - 1 && stats.coalesced == 0);
+            assert(stats.delivered == TEST_EVENTS);
+            break;
+    }
+    printf("full queue with %u us window, %s : ok\n", TEST_WINDOW_US, nfc_get_str_overflow_policy(policy));
+}
+
+// Queue 0 is scheduled under a long window, queue 1 after the window is
+// turned off. Queue 1 is due first and must be delivered first
+static void test_deadline_order(void) {
+    route_table_notif_elem_t subscriber[2] = {{0}};
+    route_table_node_t node = {0};
+    route_table_notif_queue_t *late, *early;
+    uint64_t start_ms;
+
+    route_table_dispatch_init(1);
+    late = test_queue_create(&subscriber[0], 0, 4, NFC_OVERFLOW_BLOCK);
+    early = test_queue_create(&subscriber[1], 1, 4, NFC_OVERFLOW_BLOCK);
+    test_seq = 0;
+
+    route_table_dispatch_set_coalesce_window(10 * TEST_WINDOW_US);
+    test_publish(late, &node, NFC_ADD);
+    route_table_dispatch_set_coalesce_window(0);
+    start_ms = test_now_ms();
+    test_publish(early, &node, NFC_ADD);
+
+    while (!__atomic_load_n(&test_delivered_seq[1], __ATOMIC_RELAXED)) usleep(1000);
+    assert(test_now_ms() - start_ms < 10 * TEST_WINDOW_US / 1000);
+    route_table_dispatch_shutdown();
+    assert(test_delivered_seq[1] == 1 && test_delivered_seq[0] == 2);
+    printf("queue due first is delivered first : ok\n");
+}
+
+// One async subscriber on TEST_ROUTES routes, one of which still has an event
+// queued when a batch modifies them all. The queued event is folded in first
+static void test_route_batch(void) {
+    route_table_op_t ops[TEST_ROUTES];
+    char dest[TEST_ROUTES][ROUTE_TABLE_ADDR_STR_LEN];
+    uint32_t i;
+
+    route_table_dispatch_init(2);
+    for (i = 0; i < TEST_ROUTES; i++) {
+        snprintf(dest[i], sizeof(dest[i]), "10.0.0.%u", i + 1);
+        add_async_batch_subscriber_to_route_table(dest[i], "255.255.255.255", test_batch_app_cb,
+                                                  test_batch_cb, 7, 4, NFC_OVERFLOW_DROP_OLDEST);
+        ops[i] = (route_table_op_t){ .op = NFC_MOD, .dest_addr = dest[i],
+                                     .mask = "255.255.255.255", .oif = "eth1" };
+    }
+
+    // Held back by the window until the batch has been queued
+    route_table_dispatch_set_coalesce_window(10 * TEST_WINDOW_US);
+    modify_route_table_node(dest[TEST_ROUTES - 1], "255.255.255.255", NULL, "eth0", NULL);
+    assert(route_table_apply_batch(ops, TEST_ROUTES) == TEST_ROUTES);
+    route_table_dispatch_shutdown();
+    route_table_dispatch_set_coalesce_window(0);
+
+    assert(test_batch_calls == 1 && test_app_calls == 0);
+    assert(test_batch_entries == TEST_ROUTES + 1 && test_batch_first_op == NFC_MOD);
+    printf("route batch to an async subscriber of %u routes : ok\n", TEST_ROUTES);
+}
+
+int main(void) {
+    alarm(10);
+    test_full_queue(NFC_OVERFLOW_COALESCE);
+    test_full_queue(NFC_OVERFLOW_DROP_OLDEST);
+    test_full_queue(NFC_OVERFLOW_BLOCK);
+    test_deadline_order();
+    test_route_batch();
+    return 0;
+}
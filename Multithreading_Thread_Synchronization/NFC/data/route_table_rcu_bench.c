@@ -0,0 +1,179 @@
+// Benchmark for lock-free route table lookups
+// Loads a route set, then runs 1..MAX_READERS threads doing LPM lookups under
+// route_table_read_lock() while one writer keeps modifying, adding and removing
+// routes. Reports aggregate lookups per second for each reader count.
+#define _GNU_SOURCE  // For strdup
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include "route_table.h"
+#include "rcu.h"
+
+#define BENCH_ROUTES       10000
+#define BENCH_MAX_READERS  8
+#define BENCH_RUN_MS       500
+
+static volatile int bench_stop;
+static uint32_t *bench_addrs;
+
+typedef struct bench_reader_ {
+    pthread_t thread;
+    unsigned int seed;
+    unsigned long lookups;
+    unsigned long hits;
+} bench_reader_t;
+
+static void bench_addr_to_str(uint32_t addr, char *buf) {
+    struct in_addr in;
+    in.s_addr = htonl(addr);
+    inet_ntop(AF_INET, &in, buf, INET_ADDRSTRLEN);
+}
+
+static char *bench_len_to_mask_str(uint8_t len) {
+    char buf[INET_ADDRSTRLEN];
+    bench_addr_to_str(route_trie_len_to_mask(len), buf);
+    return strdup(buf);
+}
+
+static void bench_add_route(uint32_t addr, uint8_t len) {
+    char buf[INET_ADDRSTRLEN], mask[INET_ADDRSTRLEN];
+    bench_addr_to_str(addr & route_trie_len_to_mask(len), buf);
+    bench_addr_to_str(route_trie_len_to_mask(len), mask);
+    add_route_table_node(create_route_table_node(buf, mask, "eth0", "10.0.0.1"));
+}
+
+static void *bench_reader_fn(void *arg) {
+    bench_reader_t *reader = (bench_reader_t *)arg;
+    route_table_node_t *node;
+    uint32_t addr;
+
+    while (!__atomic_load_n(&bench_stop, __ATOMIC_RELAXED)) {
+        addr = bench_addrs[rand_r(&reader->seed) % BENCH_ROUTES] | (rand_r(&reader->seed) & 0xff);
+        route_table_read_lock();
+        node = route_table_lookup_lpm(addr);
+        // Touch the route while still inside the read-side section
+        if (node && route_table_node_oif(node)[0] == 'e') {
+            reader->hits++;
+        }
+        route_table_read_unlock();
+        reader->lookups++;
+    }
+    rcu_unregister_thread();
+    return NULL;
+}
+
+static void *bench_writer_fn(void *arg) {
+    unsigned int seed = 7;
+    unsigned long *updates = (unsigned long *)arg;
+    char dest[INET_ADDRSTRLEN];
+    char *mask = bench_len_to_mask_str(24);
+    uint32_t addr;
+    route_table_node_t *node;
+
+    while (!__atomic_load_n(&bench_stop, __ATOMIC_RELAXED)) {
+        addr = bench_addrs[rand_r(&seed) % BENCH_ROUTES];
+        bench_addr_to_str(addr, dest);
+
+        route_table_writer_lock();
+        node = get_route_table_node_by_dest_and_mask(dest, mask);
+        switch ((*updates) % 3) {
+            case 0:
+                if (node) modify_route_table_node(dest, mask, NULL, (*updates & 8) ? "eth1" : "eth0", NULL);
+                break;
+            case 1:
+                if (node) remove_route_table_node(node);
+                break;
+            default:
+                if (!node) bench_add_route(addr, 24);
+                break;
+        }
+        route_table_writer_unlock();
+        (*updates)++;
+    }
+    free(mask);
+    return NULL;
+}
+
+static double bench_now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    int max_readers = (argc > 1) ? atoi(argv[1]) : BENCH_MAX_READERS;
+    unsigned int seed = 1;
+    bench_reader_t readers[BENCH_MAX_READERS * 8];
+    pthread_t writer;
+    unsigned long updates, lookups;
+    double start, elapsed;
+    int i, n;
+
+    if (max_readers < 1 || max_readers > BENCH_MAX_READERS * 8) max_readers = BENCH_MAX_READERS;
+
+    set_route_table_verbose(false);
+    set_route_table_head(init_route_table("RCU bench table"));
+
+    // /24 routes with a few covering /16 and /8, loaded as one batch
+    bench_addrs = calloc(BENCH_ROUTES, sizeof(uint32_t));
+    route_table_op_t *ops = calloc(BENCH_ROUTES * 2, sizeof(route_table_op_t));
+    char (*dests)[INET_ADDRSTRLEN] = calloc(BENCH_ROUTES * 2, INET_ADDRSTRLEN);
+    char *masks[3] = { bench_len_to_mask_str(24), bench_len_to_mask_str(16), bench_len_to_mask_str(8) };
+    uint8_t lens[3] = { 24, 16, 8 };
+    uint32_t n_ops = 0;
+    int k;
+
+    for (i = 0; i < BENCH_ROUTES; i++) {
+        bench_addrs[i] = ((uint32_t)rand_r(&seed) << 8) & 0xffffff00u;
+        for (k = 0; k < 3; k++) {
+            if ((k == 1 && i % 100) || (k == 2 && i % 1000)) continue;
+            bench_addr_to_str(bench_addrs[i] & route_trie_len_to_mask(lens[k]), dests[n_ops]);
+            ops[n_ops] = (route_table_op_t){ NFC_ADD, dests[n_ops], masks[k], NULL, "eth0", "10.0.0.1", 0 };
+            n_ops++;
+        }
+    }
+    start = bench_now_sec();
+    route_table_apply_batch(ops, n_ops);
+    printf("Loaded %d routes in %.1f ms, %.1f bytes/route (node %zu bytes, pool and trie included)\n",
+           count_route_table_nodes(), (bench_now_sec() - start) * 1e3,
+           (double)route_table_mem_bytes() / count_route_table_nodes(), sizeof(route_table_node_t));
+    for (k = 0; k < 3; k++) free(masks[k]);
+    free(dests);
+    free(ops);
+    printf("%8s %16s %16s %12s\n", "readers", "lookups/sec", "per reader/sec", "updates/sec");
+
+    for (n = 1; n <= max_readers; n *= 2) {
+        bench_stop = 0;
+        updates = 0;
+        start = bench_now_sec();
+        for (i = 0; i < n; i++) {
+            memset(&readers[i], 0, sizeof(bench_reader_t));
+            readers[i].seed = i + 1;
+            pthread_create(&readers[i].thread, NULL, bench_reader_fn, &readers[i]);
+        }
+        pthread_create(&writer, NULL, bench_writer_fn, &updates);
+
+        usleep(BENCH_RUN_MS * 1000);
+        __atomic_store_n(&bench_stop, 1, __ATOMIC_RELAXED);
+
+        lookups = 0;
+        for (i = 0; i < n; i++) {
+            pthread_join(readers[i].thread, NULL);
+            lookups += readers[i].lookups;
+        }
+        pthread_join(writer, NULL);
+        elapsed = bench_now_sec() - start;
+
+        printf("%8d %16.0f %16.0f %12.0f\n", n, lookups / elapsed,
+               lookups / elapsed / n, updates / elapsed);
+    }
+
+    route_table_print_pool_stats();
+    free_route_table();
+    free(bench_addrs);
+    return 0;
+}
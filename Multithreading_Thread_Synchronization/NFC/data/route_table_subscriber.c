@@ -1,4 +1,3 @@
-#define _GNU_SOURCE  // For strdup
 #include "route_table_subscriber.h"
 
 // app_cb function
@@ -7,6 +6,8 @@
 void app_callback(void *arg, size_t arg_size, nfc_op_t nfc_op_code, uint32_t client_id) {
     (void)arg_size; // Suppress unused parameter warning
     route_table_node_t *node = (route_table_node_t *)arg;
+    char dest_addr[ROUTE_TABLE_ADDR_STR_LEN], mask[ROUTE_TABLE_ADDR_STR_LEN];
+    const char *oif, *gateway;
     
     printf("Notification received for subscriber %u with operation %s\n", 
            client_id, nfc_get_str_op_code(nfc_op_code));
@@ -17,18 +18,26 @@ void app_callback(void *arg, size_t arg_size, nfc_op_t nfc_op_code, uint32_t cli
         return;
     }
     
+    oif = route_table_node_oif(node);
+    gateway = route_table_node_gateway(node);
     printf("Route Table Entry: Destination: %s, Mask: %s, OIF: %s, Gateway: %s\n",
-           node->dest_addr ? node->dest_addr : "(null)", 
-           node->mask ? node->mask : "(null)", 
-           node->oif ? node->oif : "(null)", 
-           node->gateway ? node->gateway : "(null)");
+           route_table_node_dest_str(node, dest_addr), 
+           route_table_node_mask_str(node, mask), 
+           oif ? oif : "(null)", 
+           gateway ? gateway : "(null)");
 }
 
 // function for inserting a new subscriber to the route table
 // this functio will first check if the route table entry exists
 // if it does, it will add the subscriber to the list of subscribers
 // if it does not, it will create a new route table entry and add the subscriber to it
-void add_subscriber_to_route_table(char *dest_addr, char *mask, nfc_app_cb app_cb, uint32_t subs_id) {
+// queue_size 0 registers a synchronous subscriber, called on the publisher thread
+static void route_table_subscribe(char *dest_addr, char *mask, nfc_app_cb app_cb,
+                                  nfc_app_batch_cb batch_cb, uint32_t subs_id,
+                                  uint32_t queue_size, nfc_overflow_policy_t policy) {
+    // Writer lock keeps the route alive and stops a concurrent add of the same prefix
+    route_table_writer_lock();
+
     // Check if route entry with exact prefix already exists
     route_table_node_t *node = get_route_table_node_by_dest_and_mask(dest_addr, mask);
     bool new_entry_created = false;
@@ -38,11 +47,15 @@ void add_subscriber_to_route_table(char *dest_addr, char *mask, nfc_app_cb app_c
         printf("INFO: Creating placeholder route entry for subscriber %u: %s/%s\n", 
                subs_id, dest_addr, mask);
         node = create_route_table_node(
-            strdup(dest_addr), 
-            strdup(mask), 
-            strdup("(placeholder)"),    // Placeholder OIF
-            strdup("(placeholder)")     // Placeholder Gateway
+            dest_addr, 
+            mask, 
+            "(placeholder)",    // Placeholder OIF
+            "(placeholder)"     // Placeholder Gateway
         );
+        if (!node) {
+            route_table_writer_unlock();
+            return;
+        }
         add_route_table_node(node);
         new_entry_created = true;
     }
@@ -51,21 +64,64 @@ void add_subscriber_to_route_table(char *dest_addr, char *mask, nfc_app_cb app_c
     route_table_notif_elem_t *new_nfce = calloc(1, sizeof(route_table_notif_elem_t));
     if (!new_nfce) {
         printf("ERROR: Failed to allocate memory for subscriber\n");
+        route_table_writer_unlock();
         return;
     }
     new_nfce->app_cb = app_cb;
     new_nfce->subs_id = subs_id;
+    new_nfce->batch_cb = batch_cb;
+    if (queue_size) {
+        new_nfce->queue = route_table_notif_queue_create(new_nfce, queue_size, policy);
+    }
     init_glthread(&new_nfce->glue);
     
     // Add subscriber to the route's subscriber list
     glthread_add_next(&node->subscriber_list, &new_nfce->glue);
     
-    printf("INFO: Subscriber %u registered for route %s/%s\n", subs_id, dest_addr, mask);
+    if (new_nfce->queue) {
+        printf("INFO: Async subscriber %u registered for route %s/%s (queue %u, %s)\n", subs_id,
+               dest_addr, mask, queue_size, nfc_get_str_overflow_policy(policy));
+    } else {
+        printf("INFO: Subscriber %u registered for route %s/%s\n", subs_id, dest_addr, mask);
+    }
     
     // If this is an existing route (not placeholder), notify subscriber immediately
     if (!new_entry_created) {
-        app_cb(node, sizeof(route_table_node_t), NFC_SUB, subs_id);
+        if (new_nfce->queue && route_table_dispatch_is_running()) {
+            route_table_notif_snapshot_t *snapshot = route_table_notif_snapshot_create(node);
+            route_table_notif_enqueue(new_nfce->queue, snapshot, NFC_SUB);
+            route_table_notif_snapshot_unref(snapshot);
+        } else {
+            app_cb(node, sizeof(route_table_node_t), NFC_SUB, subs_id);
+        }
     }
+    route_table_writer_unlock();
+}
+
+void add_subscriber_to_route_table(char *dest_addr, char *mask, nfc_app_cb app_cb, uint32_t subs_id) {
+    route_table_subscribe(dest_addr, mask, app_cb, NULL, subs_id, 0, NFC_OVERFLOW_BLOCK);
+}
+
+// Function for inserting a synchronous subscriber which gets the changes of a
+// route_table_apply_batch() in one batch_cb call, single updates still use app_cb
+void add_batch_subscriber_to_route_table(char *dest_addr, char *mask, nfc_app_cb app_cb,
+                                         nfc_app_batch_cb batch_cb, uint32_t subs_id) {
+    route_table_subscribe(dest_addr, mask, app_cb, batch_cb, subs_id, 0, NFC_OVERFLOW_BLOCK);
+}
+
+// Function for inserting a subscriber whose callbacks run on the dispatcher
+// worker pool, through a queue of queue_size events
+void add_async_subscriber_to_route_table(char *dest_addr, char *mask, nfc_app_cb app_cb, uint32_t subs_id,
+                                         uint32_t queue_size, nfc_overflow_policy_t policy) {
+    route_table_subscribe(dest_addr, mask, app_cb, NULL, subs_id, queue_size ? queue_size : 1, policy);
+}
+
+// Function for inserting an async subscriber which gets the changes of a
+// route_table_apply_batch() in one batch_cb call on the dispatcher
+void add_async_batch_subscriber_to_route_table(char *dest_addr, char *mask, nfc_app_cb app_cb,
+                                               nfc_app_batch_cb batch_cb, uint32_t subs_id,
+                                               uint32_t queue_size, nfc_overflow_policy_t policy) {
+    route_table_subscribe(dest_addr, mask, app_cb, batch_cb, subs_id, queue_size ? queue_size : 1, policy);
 }
 
 // Function to be executed by the subscriber thread
@@ -75,7 +131,8 @@ void *subscriber_thread_fn(void *arg) {
     add_subscriber_to_route_table("192.168.1.1", "255.255.255.0", app_callback, 1);
     add_subscriber_to_route_table("192.168.1.2", "255.255.255.0", app_callback, 2);
     add_subscriber_to_route_table("192.168.1.10", "255.255.255.0", app_callback, 3);
-    add_subscriber_to_route_table("192.168.1.11", "255.255.255.0", app_callback, 4);
+    add_async_subscriber_to_route_table("192.168.1.11", "255.255.255.0", app_callback, 4,
+                                        ROUTE_TABLE_SUBSCRIBER_QUEUE_SIZE, NFC_OVERFLOW_COALESCE);
     
     printf("Subscriber thread completed - 4 subscribers added\n");
     return NULL;
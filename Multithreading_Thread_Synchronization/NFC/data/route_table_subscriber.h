@@ -8,9 +8,11 @@
 #include <stdint.h>
 #include <pthread.h>
 #include "route_table.h"
+#include "route_table_dispatch.h"
 #include "../gtheard/glthread.h"
 
 #define MAX_NOTIF_KEY_SIZE	64
+#define ROUTE_TABLE_SUBSCRIBER_QUEUE_SIZE	64
 
 static inline char *nfc_get_str_op_code(nfc_op_t nfc_op_code) {
 	switch(nfc_op_code) {
@@ -31,5 +33,13 @@ static inline char *nfc_get_str_op_code(nfc_op_t nfc_op_code) {
 }
 
 void create_subscriber_thread(void);
+void add_subscriber_to_route_table(char *dest_addr, char *mask, nfc_app_cb app_cb, uint32_t subs_id);
+void add_batch_subscriber_to_route_table(char *dest_addr, char *mask, nfc_app_cb app_cb,
+                                         nfc_app_batch_cb batch_cb, uint32_t subs_id);
+void add_async_subscriber_to_route_table(char *dest_addr, char *mask, nfc_app_cb app_cb, uint32_t subs_id,
+                                         uint32_t queue_size, nfc_overflow_policy_t policy);
+void add_async_batch_subscriber_to_route_table(char *dest_addr, char *mask, nfc_app_cb app_cb,
+                                               nfc_app_batch_cb batch_cb, uint32_t subs_id,
+                                               uint32_t queue_size, nfc_overflow_policy_t policy);
 
 #endif /* __ROUTE_TABLE_SUBSCRIBER__ */
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "route_trie.h"
+#include "rcu.h"
+
+// Bit of addr which selects the child at given depth (0 = MSB)
+static inline int route_trie_bit(uint32_t addr, uint8_t depth) {
+    return (addr >> (ROUTE_TRIE_MAX_PREFIX_LEN - 1 - depth)) & 1;
+}
+
+static route_trie_node_t *route_trie_new_node(route_trie_t *trie) {
+    route_trie_node_t *node = (route_trie_node_t *)calloc(1, sizeof(route_trie_node_t));
+    if (!node) {
+        perror("Failed to allocate memory for route trie node");
+        exit(EXIT_FAILURE);
+    }
+    init_glthread(&node->routes);
+    trie->n_nodes++;
+    return node;
+}
+
+// Function to create an empty trie
+route_trie_t *route_trie_create(void) {
+    route_trie_t *trie = (route_trie_t *)calloc(1, sizeof(route_trie_t));
+    if (!trie) {
+        perror("Failed to allocate memory for route trie");
+        exit(EXIT_FAILURE);
+    }
+    trie->root = route_trie_new_node(trie);
+    return trie;
+}
+
+static void route_trie_free_subtree(route_trie_node_t *node) {
+    if (!node) return;
+    route_trie_free_subtree(node->child[0]);
+    route_trie_free_subtree(node->child[1]);
+    free(node);
+}
+
+// Function to free the trie. Routes are owned by the route table and
+// are not touched
+void route_trie_destroy(route_trie_t *trie) {
+    if (!trie) return;
+    route_trie_free_subtree(trie->root);
+    free(trie);
+}
+
+// Function to index a route under prefix/len
+void route_trie_insert(route_trie_t *trie, uint32_t prefix, uint8_t len, glthread_t *route_glue) {
+    route_trie_node_t *node = trie->root;
+    uint8_t depth;
+    int bit;
+
+    for (depth = 0; depth < len; depth++) {
+        bit = route_trie_bit(prefix, depth);
+        if (!node->child[bit]) {
+            // New node is fully initialized before readers can reach it
+            rcu_assign_pointer(node->child[bit], route_trie_new_node(trie));
+        }
+        node = node->child[bit];
+    }
+
+    init_glthread(route_glue);
+    rcu_glthread_add_next(&node->routes, route_glue);
+    trie->n_routes++;
+}
+
+// Function to remove a route from the index. Trie nodes left without
+// routes and children are pruned on the way back up, and freed once
+// concurrent readers are done with them
+void route_trie_remove(route_trie_t *trie, uint32_t prefix, uint8_t len, glthread_t *route_glue) {
+    route_trie_node_t *path[ROUTE_TRIE_MAX_PREFIX_LEN + 1];
+    route_trie_node_t *node = trie->root;
+    uint8_t depth;
+
+    path[0] = node;
+    for (depth = 0; depth < len; depth++) {
+        node = node->child[route_trie_bit(prefix, depth)];
+        if (!node) return; // Not indexed
+        path[depth + 1] = node;
+    }
+
+    rcu_glthread_remove(route_glue);
+    trie->n_routes--;
+
+    // Never free the root
+    for (depth = len; depth > 0; depth--) {
+        node = path[depth];
+        if (route_trie_node_has_routes(node) || node->child[0] || node->child[1]) {
+            break;
+        }
+        rcu_assign_pointer(path[depth - 1]->child[route_trie_bit(prefix, depth - 1)], NULL);
+        rcu_retire(node, free);
+        trie->n_nodes--;
+    }
+}
+
+// Function to get the trie node holding routes for exactly prefix/len
+route_trie_node_t *route_trie_find_exact(route_trie_t *trie, uint32_t prefix, uint8_t len) {
+    route_trie_node_t *node = trie->root;
+    uint8_t depth;
+
+    for (depth = 0; depth < len && node; depth++) {
+        node = rcu_dereference(node->child[route_trie_bit(prefix, depth)]);
+    }
+
+    if (!node || !route_trie_node_has_routes(node)) {
+        return NULL;
+    }
+    return node;
+}
+
+// Function to get the trie node with the longest prefix covering addr
+route_trie_node_t *route_trie_find_lpm(route_trie_t *trie, uint32_t addr) {
+    route_trie_node_t *node = trie->root;
+    route_trie_node_t *best = NULL;
+    uint8_t depth = 0;
+
+    while (node) {
+        if (route_trie_node_has_routes(node)) {
+            best = node;
+        }
+        if (depth == ROUTE_TRIE_MAX_PREFIX_LEN) break;
+        node = rcu_dereference(node->child[route_trie_bit(addr, depth++)]);
+    }
+    return best;
+}
+
+// Function to visit every node with routes on the path of addr, shortest
+// prefix first, until cb returns true
+void route_trie_walk_path(route_trie_t *trie, uint32_t addr, route_trie_walk_cb cb, void *arg) {
+    route_trie_node_t *node = trie->root;
+    uint8_t depth = 0;
+
+    while (node) {
+        if (route_trie_node_has_routes(node) && cb(node, depth, arg)) {
+            return;
+        }
+        if (depth == ROUTE_TRIE_MAX_PREFIX_LEN) break;
+        node = rcu_dereference(node->child[route_trie_bit(addr, depth++)]);
+    }
+}
@@ -0,0 +1,55 @@
+/* Binary trie index for IPv4 prefixes, used by the route table to find
+    routes by prefix/length and by longest prefix match without walking the
+    whole route list.
+
+    @ Each trie node stands for one prefix (bits taken from the MSB down to
+    the node's depth). Routes whose (dest & mask, length) equal that prefix
+    hang off the node's route list through a glthread glue.
+    @ Insert, remove and lookups cost O(prefix length), independent of the
+    number of routes in the table.
+    @ Lookups are lock-free and may run concurrently with one writer, as long
+    as they are done inside rcu_read_lock()/rcu_read_unlock(). Pruned trie
+    nodes are freed through rcu_retire().
+*/
+
+#ifndef ROUTE_TRIE_H
+#define ROUTE_TRIE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../gtheard/glthread.h"
+
+#define ROUTE_TRIE_MAX_PREFIX_LEN 32
+
+typedef struct route_trie_node {
+    struct route_trie_node *child[2];
+    glthread_t routes;  // Routes with exactly this prefix
+} route_trie_node_t;
+
+typedef struct route_trie {
+    route_trie_node_t *root; // 0.0.0.0/0
+    uint32_t n_nodes;        // Trie nodes, root included
+    uint32_t n_routes;       // Routes indexed
+} route_trie_t;
+
+static inline bool route_trie_node_has_routes(route_trie_node_t *node) {
+    return __atomic_load_n(&node->routes.right, __ATOMIC_ACQUIRE) != NULL;
+}
+
+// Returns true to stop the walk
+typedef bool (*route_trie_walk_cb)(route_trie_node_t *node, uint8_t depth, void *arg);
+
+static inline uint32_t route_trie_len_to_mask(uint8_t len) {
+    return len ? (uint32_t)(0xFFFFFFFFu << (ROUTE_TRIE_MAX_PREFIX_LEN - len)) : 0;
+}
+
+// APIs declaration
+route_trie_t *route_trie_create(void);
+void route_trie_destroy(route_trie_t *trie);
+void route_trie_insert(route_trie_t *trie, uint32_t prefix, uint8_t len, glthread_t *route_glue);
+void route_trie_remove(route_trie_t *trie, uint32_t prefix, uint8_t len, glthread_t *route_glue);
+route_trie_node_t *route_trie_find_exact(route_trie_t *trie, uint32_t prefix, uint8_t len);
+route_trie_node_t *route_trie_find_lpm(route_trie_t *trie, uint32_t addr);
+void route_trie_walk_path(route_trie_t *trie, uint32_t addr, route_trie_walk_cb cb, void *arg);
+
+#endif // ROUTE_TRIE_H
@@ -0,0 +1,329 @@
+#define _POSIX_C_SOURCE 200112L  // For posix_memalign
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "obj_pool.h"
+
+// Chunk header, objects start on the next cache line
+typedef struct obj_pool_chunk {
+    obj_pool_cache_t *owner;
+} obj_pool_chunk_t;
+
+#define OBJ_POOL_CHUNK_HDR  64
+#define OBJ_POOL_CHUNK_OF(obj) \
+    ((obj_pool_chunk_t *)((uintptr_t)(obj) & ~((uintptr_t)OBJ_POOL_CHUNK_SIZE - 1)))
+
+struct obj_pool_cache {
+    obj_pool_t *pool;
+    obj_pool_cache_t *next;       // In pool->caches
+    bool in_use;                  // Held by a live thread, guarded by pool->mutex
+    obj_pool_mag_t *loaded;       // Alloc and free work on this one
+    obj_pool_mag_t *prev;         // Swapped in when loaded is empty or full
+    void *remote_frees;           // Objects of our chunks freed by other threads, linked through their first word
+    char *carve;                  // Untouched tail of the chunk being carved
+    char *carve_end;
+    // Written by the thread holding the cache only
+    uint64_t n_allocs;
+    uint64_t n_frees;
+    uint64_t n_cache_hits;
+    uint64_t n_remote_frees;
+};
+
+static __thread obj_pool_cache_t *obj_pool_tcaches[OBJ_POOL_MAX_POOLS];
+static uint32_t obj_pool_n_ids = 0;
+static pthread_mutex_t obj_pool_ids_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t obj_pool_key;
+static pthread_once_t obj_pool_key_once = PTHREAD_ONCE_INIT;
+
+// Counters have a single writer, stats readers load them relaxed
+#define OBJ_POOL_STAT_INC(field) __atomic_store_n(&(field), (field) + 1, __ATOMIC_RELAXED)
+
+static obj_pool_mag_t *obj_pool_mag_new(void) {
+    obj_pool_mag_t *mag = calloc(1, sizeof(obj_pool_mag_t));
+
+    if (!mag) {
+        perror("Failed to allocate memory for object pool magazine");
+        exit(EXIT_FAILURE);
+    }
+    return mag;
+}
+
+// Caller holds pool->mutex
+static obj_pool_mag_t *obj_pool_depot_get_empty(obj_pool_t *pool) {
+    obj_pool_mag_t *mag = pool->empty_mags;
+
+    if (!mag) return obj_pool_mag_new();
+    pool->empty_mags = mag->next;
+    return mag;
+}
+
+// Caller holds pool->mutex
+static void obj_pool_depot_put(obj_pool_t *pool, obj_pool_mag_t *mag) {
+    if (mag->n_objs) {
+        mag->next = pool->full_mags;
+        pool->full_mags = mag;
+    } else {
+        mag->next = pool->empty_mags;
+        pool->empty_mags = mag;
+    }
+}
+
+static void obj_pool_push_remote(obj_pool_cache_t *owner, void *head, void *tail) {
+    void *old = __atomic_load_n(&owner->remote_frees, __ATOMIC_RELAXED);
+
+    do {
+        *(void **)tail = old;
+    } while (!__atomic_compare_exchange_n(&owner->remote_frees, &old, head, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+// Function to move the remote frees of src into the magazines of cache,
+// whatever does not fit goes back to src
+static void obj_pool_cache_fill_remote(obj_pool_cache_t *cache, obj_pool_cache_t *src) {
+    obj_pool_mag_t *mags[2] = { cache->loaded, cache->prev };
+    void *list, *tail;
+    int i;
+
+    if (!__atomic_load_n(&src->remote_frees, __ATOMIC_RELAXED)) return;
+
+    list = __atomic_exchange_n(&src->remote_frees, NULL, __ATOMIC_ACQUIRE);
+    for (i = 0; i < 2; i++) {
+        while (list && mags[i]->n_objs < OBJ_POOL_MAG_SIZE) {
+            mags[i]->objs[mags[i]->n_objs++] = list;
+            list = *(void **)list;
+        }
+    }
+    if (!list) return;
+
+    for (tail = list; *(void **)tail; tail = *(void **)tail);
+    obj_pool_push_remote(src, list, tail);
+}
+
+// Thread exit, hand the magazines to the depot and leave the cache for
+// the next thread to adopt
+static void obj_pool_cache_release(obj_pool_cache_t *cache) {
+    obj_pool_t *pool = cache->pool;
+
+    pthread_mutex_lock(&pool->mutex);
+    obj_pool_depot_put(pool, cache->loaded);
+    obj_pool_depot_put(pool, cache->prev);
+    cache->loaded = NULL;
+    cache->prev = NULL;
+    cache->in_use = false;
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void obj_pool_thread_exit(void *arg) {
+    uint32_t i;
+
+    (void)arg;
+    for (i = 0; i < OBJ_POOL_MAX_POOLS; i++) {
+        if (obj_pool_tcaches[i]) {
+            obj_pool_cache_release(obj_pool_tcaches[i]);
+            obj_pool_tcaches[i] = NULL;
+        }
+    }
+}
+
+static void obj_pool_key_init(void) {
+    pthread_key_create(&obj_pool_key, obj_pool_thread_exit);
+}
+
+static obj_pool_cache_t *obj_pool_cache_attach(obj_pool_t *pool) {
+    obj_pool_cache_t *cache;
+    uint32_t id;
+
+    pthread_once(&obj_pool_key_once, obj_pool_key_init);
+
+    pthread_mutex_lock(&obj_pool_ids_mutex);
+    if (!pool->id) {
+        if (obj_pool_n_ids == OBJ_POOL_MAX_POOLS) {
+            fprintf(stderr, "Too many object pools, %s not created\n", pool->name);
+            exit(EXIT_FAILURE);
+        }
+        __atomic_store_n(&pool->id, ++obj_pool_n_ids, __ATOMIC_RELEASE);
+    }
+    id = pool->id;
+    pthread_mutex_unlock(&obj_pool_ids_mutex);
+
+    pthread_mutex_lock(&pool->mutex);
+    for (cache = pool->caches; cache; cache = cache->next) {
+        if (!cache->in_use) break;
+    }
+    if (!cache) {
+        cache = calloc(1, sizeof(obj_pool_cache_t));
+        if (!cache) {
+            perror("Failed to allocate memory for object pool cache");
+            exit(EXIT_FAILURE);
+        }
+        cache->pool = pool;
+        cache->next = pool->caches;
+        pool->caches = cache;
+    }
+    cache->in_use = true;
+    cache->loaded = obj_pool_depot_get_empty(pool);
+    cache->prev = obj_pool_depot_get_empty(pool);
+    pthread_mutex_unlock(&pool->mutex);
+
+    obj_pool_tcaches[id - 1] = cache;
+    pthread_setspecific(obj_pool_key, obj_pool_tcaches);
+    return cache;
+}
+
+static inline obj_pool_cache_t *obj_pool_cache_get(obj_pool_t *pool) {
+    uint32_t id = __atomic_load_n(&pool->id, __ATOMIC_ACQUIRE);
+
+    if (id && obj_pool_tcaches[id - 1]) return obj_pool_tcaches[id - 1];
+    return obj_pool_cache_attach(pool);
+}
+
+// Both magazines are empty and nobody gave objects back, go to the depot,
+// then to the remote frees of exited threads, then carve new memory
+static void *obj_pool_alloc_slow(obj_pool_t *pool, obj_pool_cache_t *cache) {
+    obj_pool_cache_t *orphan;
+    obj_pool_chunk_t *chunk;
+    void *obj;
+
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->full_mags) {
+        obj_pool_depot_put(pool, cache->loaded);
+        cache->loaded = pool->full_mags;
+        pool->full_mags = cache->loaded->next;
+    } else {
+        for (orphan = pool->caches; orphan && !cache->loaded->n_objs; orphan = orphan->next) {
+            if (!orphan->in_use) obj_pool_cache_fill_remote(cache, orphan);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (cache->loaded->n_objs) {
+        return cache->loaded->objs[--cache->loaded->n_objs];
+    }
+
+    if (cache->carve == cache->carve_end) {
+        if (posix_memalign((void **)&chunk, OBJ_POOL_CHUNK_SIZE, OBJ_POOL_CHUNK_SIZE)) {
+            perror("Failed to allocate memory for object pool chunk");
+            exit(EXIT_FAILURE);
+        }
+        chunk->owner = cache;
+        cache->carve = (char *)chunk + OBJ_POOL_CHUNK_HDR;
+        cache->carve_end = cache->carve +
+            (OBJ_POOL_CHUNK_SIZE - OBJ_POOL_CHUNK_HDR) / pool->obj_size * pool->obj_size;
+        __atomic_add_fetch(&pool->n_chunks, 1, __ATOMIC_RELAXED);
+    }
+    obj = cache->carve;
+    cache->carve += pool->obj_size;
+    return obj;
+}
+
+// Function to take one object from the calling thread's cache
+void *obj_pool_alloc(obj_pool_t *pool) {
+    obj_pool_cache_t *cache = obj_pool_cache_get(pool);
+    obj_pool_mag_t *mag;
+
+    OBJ_POOL_STAT_INC(cache->n_allocs);
+
+    if (!cache->loaded->n_objs) {
+        if (cache->prev->n_objs) {
+            mag = cache->loaded;
+            cache->loaded = cache->prev;
+            cache->prev = mag;
+        } else {
+            obj_pool_cache_fill_remote(cache, cache);
+        }
+    }
+    if (!cache->loaded->n_objs) {
+        return obj_pool_alloc_slow(pool, cache);
+    }
+
+    OBJ_POOL_STAT_INC(cache->n_cache_hits);
+    return cache->loaded->objs[--cache->loaded->n_objs];
+}
+
+void *obj_pool_calloc(obj_pool_t *pool) {
+    void *obj = obj_pool_alloc(pool);
+
+    memset(obj, 0, pool->obj_size);
+    return obj;
+}
+
+// Both magazines are full, the older one goes to the depot
+static void obj_pool_free_slow(obj_pool_t *pool, obj_pool_cache_t *cache) {
+    obj_pool_mag_t *mag;
+
+    pthread_mutex_lock(&pool->mutex);
+    obj_pool_depot_put(pool, cache->prev);
+    mag = obj_pool_depot_get_empty(pool);
+    pthread_mutex_unlock(&pool->mutex);
+
+    cache->prev = cache->loaded;
+    cache->loaded = mag;
+}
+
+void obj_pool_free(obj_pool_t *pool, void *obj) {
+    obj_pool_cache_t *cache, *owner;
+    obj_pool_mag_t *mag;
+
+    if (!obj) return;
+
+    cache = obj_pool_cache_get(pool);
+    OBJ_POOL_STAT_INC(cache->n_frees);
+
+    // Give it back to the thread which carved it
+    owner = OBJ_POOL_CHUNK_OF(obj)->owner;
+    if (owner != cache) {
+        OBJ_POOL_STAT_INC(cache->n_remote_frees);
+        obj_pool_push_remote(owner, obj, obj);
+        return;
+    }
+
+    if (cache->loaded->n_objs == OBJ_POOL_MAG_SIZE) {
+        if (cache->prev->n_objs < OBJ_POOL_MAG_SIZE) {
+            mag = cache->loaded;
+            cache->loaded = cache->prev;
+            cache->prev = mag;
+        } else {
+            obj_pool_free_slow(pool, cache);
+        }
+    }
+    cache->loaded->objs[cache->loaded->n_objs++] = obj;
+}
+
+void obj_pool_get_stats(obj_pool_t *pool, obj_pool_stats_t *stats) {
+    obj_pool_cache_t *cache;
+
+    memset(stats, 0, sizeof(obj_pool_stats_t));
+
+    pthread_mutex_lock(&pool->mutex);
+    for (cache = pool->caches; cache; cache = cache->next) {
+        stats->n_allocs += __atomic_load_n(&cache->n_allocs, __ATOMIC_RELAXED);
+        stats->n_frees += __atomic_load_n(&cache->n_frees, __ATOMIC_RELAXED);
+        stats->n_cache_hits += __atomic_load_n(&cache->n_cache_hits, __ATOMIC_RELAXED);
+        stats->n_remote_frees += __atomic_load_n(&cache->n_remote_frees, __ATOMIC_RELAXED);
+        stats->n_caches++;
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    stats->n_live = stats->n_allocs > stats->n_frees ? stats->n_allocs - stats->n_frees : 0;
+    stats->bytes = obj_pool_bytes(pool);
+}
+
+void obj_pool_print_stats(obj_pool_t *pool) {
+    obj_pool_stats_t stats;
+
+    obj_pool_get_stats(pool, &stats);
+    printf("Pool %s: %llu live, %llu allocs, %llu frees, %.1f%% cache hits, "
+           "%llu remote frees, %u thread caches, %zu bytes\n",
+           pool->name,
+           (unsigned long long)stats.n_live,
+           (unsigned long long)stats.n_allocs,
+           (unsigned long long)stats.n_frees,
+           stats.n_allocs ? 100.0 * stats.n_cache_hits / stats.n_allocs : 0.0,
+           (unsigned long long)stats.n_remote_frees,
+           stats.n_caches, stats.bytes);
+}
+
+// Function to get the memory held by the pool, in use or not
+size_t obj_pool_bytes(obj_pool_t *pool) {
+    return (size_t)__atomic_load_n(&pool->n_chunks, __ATOMIC_RELAXED) * OBJ_POOL_CHUNK_SIZE;
+}
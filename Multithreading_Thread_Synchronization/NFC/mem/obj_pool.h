@@ -0,0 +1,84 @@
+/* Thread caching pools of fixed size objects.
+
+    @ Every thread keeps a small cache of free objects per pool, two
+    magazines of OBJ_POOL_MAG_SIZE pointers. Alloc and free of a thread
+    work on its magazines without any lock or atomic instruction, the
+    pool's depot (a locked stack of magazines) is only visited once a
+    magazine worth of objects has been consumed or released.
+    @ Objects are carved from OBJ_POOL_CHUNK_SIZE aligned chunks, a chunk
+    belongs to the thread cache which carved it. An object freed by another
+    thread is pushed back to its owner's lock-free remote free list, and the
+    owner reuses it once its magazines are empty. Objects handed from one
+    thread to another thus go home instead of piling up in the freeing
+    thread's cache. For route nodes that is the writer whose rcu_retire()
+    fills the batch, it runs the grace period and the frees inline.
+    @ A cache outlives its thread, it is adopted by the next thread using
+    the pool, and its remote frees are reclaimed by other threads meanwhile.
+    @ Chunks are never returned to the system.
+    @ Route nodes and notif chain elements use it. The standalone programs
+    under references/ (asl_object_t, threadlib's thread_t, CRUD's student_t)
+    still malloc, they vendor their own gluethread and would vendor this
+    file the same way.
+
+    Pools are meant to be static:
+
+        static obj_pool_t my_pool = OBJ_POOL_INITIALIZER(my_type_t, "my_type");
+        my_type_t *obj = obj_pool_calloc(&my_pool);
+        ...
+        obj_pool_free(&my_pool, obj);
+*/
+
+#ifndef OBJ_POOL_H
+#define OBJ_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#define OBJ_POOL_MAG_SIZE      64
+#define OBJ_POOL_CHUNK_SIZE    (64 * 1024)   // Power of 2, chunks are aligned on it
+#define OBJ_POOL_MAX_POOLS     32            // Pools a thread can have a cache for
+
+typedef struct obj_pool_mag {
+    struct obj_pool_mag *next;
+    uint32_t n_objs;
+    void *objs[OBJ_POOL_MAG_SIZE];
+} obj_pool_mag_t;
+
+typedef struct obj_pool_cache obj_pool_cache_t;
+
+typedef struct obj_pool {
+    const char *name;
+    size_t obj_size;
+    uint32_t id;                  // Slot in the per thread cache tables, 0 until first use
+    pthread_mutex_t mutex;        // Guards the depot and the list of caches
+    obj_pool_mag_t *full_mags;    // Depot, magazines holding at least one object
+    obj_pool_mag_t *empty_mags;
+    obj_pool_cache_t *caches;     // Every cache ever created for this pool
+    uint32_t n_chunks;
+} obj_pool_t;
+
+#define OBJ_POOL_INITIALIZER(type, name) \
+    { (name), ((sizeof(type) + 7) & ~(size_t)7), 0, PTHREAD_MUTEX_INITIALIZER, NULL, NULL, NULL, 0 }
+
+typedef struct obj_pool_stats {
+    uint64_t n_allocs;
+    uint64_t n_frees;
+    uint64_t n_live;
+    uint64_t n_cache_hits;      // Allocs served by the thread cache, no lock, no new memory
+    uint64_t n_remote_frees;    // Frees by a thread other than the object's owner
+    uint32_t n_caches;
+    size_t bytes;
+} obj_pool_stats_t;
+
+void *obj_pool_alloc(obj_pool_t *pool);
+void *obj_pool_calloc(obj_pool_t *pool);
+void obj_pool_free(obj_pool_t *pool, void *obj);
+
+// Stats are summed over all caches, only exact once the pool is quiet
+void obj_pool_get_stats(obj_pool_t *pool, obj_pool_stats_t *stats);
+void obj_pool_print_stats(obj_pool_t *pool);
+size_t obj_pool_bytes(obj_pool_t *pool);
+
+#endif // OBJ_POOL_H
@@ -0,0 +1,171 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  obj_pool_bench.c
+ *
+ *    Description: Alloc/free throughput of obj_pool vs malloc, for threads
+ *                 churning their own objects and for objects allocated by
+ *                 one thread and freed by another
+ *
+ * =====================================================================================
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "obj_pool.h"
+
+#define BENCH_MAX_THREADS   16
+#define BENCH_WORKING_SET   1024     // Objects held by each churning thread
+#define BENCH_RING_SIZE     1024     // Producer to consumer hand off
+#define BENCH_RUN_MS        300
+
+typedef struct bench_obj {
+    char payload[64];                // Size of a route table node
+} bench_obj_t;
+
+typedef struct bench_thread {
+    pthread_t thread;
+    unsigned int seed;
+    bool use_pool;
+    uint64_t n_ops;
+    // Producer/consumer pair
+    void *ring[BENCH_RING_SIZE];
+    uint64_t head;
+    uint64_t tail;
+} bench_thread_t;
+
+static obj_pool_t bench_pool = OBJ_POOL_INITIALIZER(bench_obj_t, "bench_obj");
+static volatile int bench_stop;
+
+static inline void *bench_alloc(bool use_pool) {
+    void *obj = use_pool ? obj_pool_alloc(&bench_pool) : malloc(sizeof(bench_obj_t));
+
+    ((bench_obj_t *)obj)->payload[0] = 1;
+    return obj;
+}
+
+static inline void bench_free(bool use_pool, void *obj) {
+    if (use_pool) obj_pool_free(&bench_pool, obj);
+    else free(obj);
+}
+
+// Replace random objects of a private working set
+static void *bench_churn_fn(void *arg) {
+    bench_thread_t *bt = arg;
+    void *objs[BENCH_WORKING_SET];
+    uint32_t i;
+
+    for (i = 0; i < BENCH_WORKING_SET; i++) objs[i] = bench_alloc(bt->use_pool);
+
+    while (!__atomic_load_n(&bench_stop, __ATOMIC_RELAXED)) {
+        i = rand_r(&bt->seed) % BENCH_WORKING_SET;
+        bench_free(bt->use_pool, objs[i]);
+        objs[i] = bench_alloc(bt->use_pool);
+        bt->n_ops++;
+    }
+
+    for (i = 0; i < BENCH_WORKING_SET; i++) bench_free(bt->use_pool, objs[i]);
+    return NULL;
+}
+
+static void *bench_producer_fn(void *arg) {
+    bench_thread_t *bt = arg;
+    uint64_t head = 0;
+
+    while (!__atomic_load_n(&bench_stop, __ATOMIC_RELAXED)) {
+        if (head - __atomic_load_n(&bt->tail, __ATOMIC_ACQUIRE) == BENCH_RING_SIZE) {
+            sched_yield();
+            continue;
+        }
+        bt->ring[head % BENCH_RING_SIZE] = bench_alloc(bt->use_pool);
+        __atomic_store_n(&bt->head, ++head, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+static void *bench_consumer_fn(void *arg) {
+    bench_thread_t *bt = arg;
+    uint64_t tail = 0, head;
+
+    while (1) {
+        head = __atomic_load_n(&bt->head, __ATOMIC_ACQUIRE);
+        if (tail == head) {
+            if (__atomic_load_n(&bench_stop, __ATOMIC_RELAXED) &&
+                head == __atomic_load_n(&bt->head, __ATOMIC_ACQUIRE)) break;
+            sched_yield();
+            continue;
+        }
+        for (; tail != head; tail++) {
+            bench_free(bt->use_pool, bt->ring[tail % BENCH_RING_SIZE]);
+            bt->n_ops++;
+        }
+        __atomic_store_n(&bt->tail, tail, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+static double bench_now_sec(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// n_threads churning threads, or n_threads / 2 producer/consumer pairs.
+// Returns alloc+free pairs per second
+static double bench_run(bool use_pool, bool cross_thread, int n_threads) {
+    static bench_thread_t bt[BENCH_MAX_THREADS];
+    pthread_t consumers[BENCH_MAX_THREADS];
+    int n = cross_thread ? (n_threads + 1) / 2 : n_threads;
+    uint64_t n_ops = 0;
+    double start, elapsed;
+    int i;
+
+    bench_stop = 0;
+    start = bench_now_sec();
+    for (i = 0; i < n; i++) {
+        memset(&bt[i], 0, sizeof(bench_thread_t));
+        bt[i].seed = i + 1;
+        bt[i].use_pool = use_pool;
+        if (cross_thread) {
+            pthread_create(&bt[i].thread, NULL, bench_producer_fn, &bt[i]);
+            pthread_create(&consumers[i], NULL, bench_consumer_fn, &bt[i]);
+        } else {
+            pthread_create(&bt[i].thread, NULL, bench_churn_fn, &bt[i]);
+        }
+    }
+    usleep(BENCH_RUN_MS * 1000);
+    __atomic_store_n(&bench_stop, 1, __ATOMIC_RELAXED);
+
+    for (i = 0; i < n; i++) {
+        pthread_join(bt[i].thread, NULL);
+        if (cross_thread) pthread_join(consumers[i], NULL);
+        n_ops += bt[i].n_ops;
+    }
+    elapsed = bench_now_sec() - start;
+    return n_ops / elapsed;
+}
+
+int main(int argc, char **argv) {
+    int max_threads = (argc > 1) ? atoi(argv[1]) : 8;
+    int n, cross;
+
+    if (max_threads < 1 || max_threads > BENCH_MAX_THREADS) max_threads = 8;
+
+    printf("%-22s %8s %16s %16s\n", "pattern", "threads", "malloc ops/sec", "pool ops/sec");
+    for (cross = 0; cross < 2; cross++) {
+        for (n = cross ? 2 : 1; n <= max_threads; n *= 2) {
+            printf("%-22s %8d %16.0f", cross ? "alloc here, free there" : "private churn", n,
+                   bench_run(false, cross, n));
+            printf(" %16.0f\n", bench_run(true, cross, n));
+            fflush(stdout);
+        }
+    }
+    obj_pool_print_stats(&bench_pool);
+    return 0;
+}
@@ -20,6 +20,97 @@
 #include <memory.h>
 #include <assert.h>
 #include "notif.h"
+#include "../mem/obj_pool.h"
+
+/* Subscriptions come and go with their subscribers, recycle them */
+static obj_pool_t notif_chain_elem_pool = OBJ_POOL_INITIALIZER(notif_chain_elem_t, "notif_chain_elem");
+
+/* Keyed subscribers are indexed by key in a chained hash table, subscribers
+ * without a key sit on a separate wildcard list. A keyed event then only
+ * visits the wildcard list and the subscribers of its own key. */
+
+static uint64_t
+nfc_key_hash(char *key, size_t key_size) {
+
+	/* FNV-1a */
+	uint64_t hash = 14695981039346656037ull;
+	size_t i;
+
+	for (i = 0; i < key_size; i++) {
+		hash ^= (unsigned char)key[i];
+		hash *= 1099511628211ull;
+	}
+	return hash ^ key_size;
+}
+
+static notif_key_node_t *
+nfc_lookup_key_node(notif_chain_t *nfc, char *key,
+					size_t key_size, uint64_t hash) {
+
+	notif_key_node_t *key_node;
+
+	if (!nfc->n_key_buckets) return NULL;
+
+	for (key_node = nfc->key_buckets[hash & (nfc->n_key_buckets - 1)];
+		 key_node; key_node = key_node->next) {
+
+		if (key_node->hash == hash && key_node->key_size == key_size &&
+			memcmp(key_node->key, key, key_size) == 0) {
+			return key_node;
+		}
+	}
+	return NULL;
+}
+
+static void
+nfc_resize_key_buckets(notif_chain_t *nfc, uint32_t n_buckets) {
+
+	notif_key_node_t **buckets = calloc(n_buckets, sizeof(notif_key_node_t *));
+	notif_key_node_t *key_node, *next;
+	uint32_t i;
+
+	assert(buckets);
+
+	for (i = 0; i < nfc->n_key_buckets; i++) {
+		for (key_node = nfc->key_buckets[i]; key_node; key_node = next) {
+			next = key_node->next;
+			key_node->next = buckets[key_node->hash & (n_buckets - 1)];
+			buckets[key_node->hash & (n_buckets - 1)] = key_node;
+		}
+	}
+	free(nfc->key_buckets);
+	nfc->key_buckets = buckets;
+	nfc->n_key_buckets = n_buckets;
+}
+
+static notif_key_node_t *
+nfc_get_key_node(notif_chain_t *nfc, char *key, size_t key_size) {
+
+	uint64_t hash = nfc_key_hash(key, key_size);
+	notif_key_node_t *key_node = nfc_lookup_key_node(nfc, key, key_size, hash);
+	uint32_t bucket;
+
+	if (key_node) return key_node;
+
+	/* Keep the load factor at or below 1 */
+	if (nfc->n_keys >= nfc->n_key_buckets) {
+		nfc_resize_key_buckets(nfc, nfc->n_key_buckets ?
+							   nfc->n_key_buckets * 2 : NFC_KEY_HASH_INIT_BUCKETS);
+	}
+
+	key_node = calloc(1, sizeof(notif_key_node_t));
+	assert(key_node);
+	memcpy(key_node->key, key, key_size);
+	key_node->key_size = key_size;
+	key_node->hash = hash;
+	init_glthread(&key_node->subscribers);
+
+	bucket = hash & (nfc->n_key_buckets - 1);
+	key_node->next = nfc->key_buckets[bucket];
+	nfc->key_buckets[bucket] = key_node;
+	nfc->n_keys++;
+	return key_node;
+}
 
 notif_chain_t *
 nfc_create_new_notif_chain(char *notif_chain_name) {
@@ -27,9 +118,10 @@ nfc_create_new_notif_chain(char *notif_chain_name) {
     notif_chain_t *nfc = calloc(1, sizeof(notif_chain_t));
     if(notif_chain_name) {
         strncpy(nfc->nfc_name, notif_chain_name,
-				sizeof(nfc->nfc_name));
+				sizeof(nfc->nfc_name) - 1);
     }
     init_glthread(&nfc->notif_chain_head);
+    init_glthread(&nfc->wildcard_head);
     return nfc;
 }
 
@@ -37,10 +129,20 @@ void
 nfc_register_notif_chain(notif_chain_t *nfc,
 					 notif_chain_elem_t *nfce){
 
-	notif_chain_elem_t *new_nfce = calloc(1, sizeof(notif_chain_elem_t));
+	notif_chain_elem_t *new_nfce = obj_pool_alloc(&notif_chain_elem_pool);
 	memcpy(new_nfce, nfce, sizeof(notif_chain_elem_t));
 	init_glthread(&new_nfce->glue);
+	init_glthread(&new_nfce->key_glue);
 	glthread_add_next(&nfc->notif_chain_head, &new_nfce->glue);	
+
+	if (new_nfce->is_key_set && new_nfce->key_size) {
+		assert(new_nfce->key_size <= MAX_NOTIF_KEY_SIZE);
+		glthread_add_next(&nfc_get_key_node(nfc, new_nfce->key,
+							new_nfce->key_size)->subscribers, &new_nfce->key_glue);
+	}
+	else {
+		glthread_add_next(&nfc->wildcard_head, &new_nfce->key_glue);
+	}
 }
 
 void
@@ -48,15 +150,31 @@ nfc_delete_all_nfce(notif_chain_t *nfc){
 
 	glthread_t *curr;
 	notif_chain_elem_t *nfce;
+	notif_key_node_t *key_node, *next;
+	uint32_t i;
 	
 	ITERATE_GLTHREAD_BEGIN(&nfc->notif_chain_head, curr){
 
 		nfce = glthread_glue_to_notif_chain_elem(curr);
 		remove_glthread(&nfce->glue);
-		free(nfce);	
+		obj_pool_free(&notif_chain_elem_pool, nfce);
 	} ITERATE_GLTHREAD_END(&nfc->notif_chain_head, curr);
+
+	init_glthread(&nfc->wildcard_head);
+	for (i = 0; i < nfc->n_key_buckets; i++) {
+		for (key_node = nfc->key_buckets[i]; key_node; key_node = next) {
+			next = key_node->next;
+			free(key_node);
+		}
+	}
+	free(nfc->key_buckets);
+	nfc->key_buckets = NULL;
+	nfc->n_key_buckets = 0;
+	nfc->n_keys = 0;
 }
 
+/* Unkeyed events go to every subscriber. Keyed events go to subscribers
+ * registered without a key and to those registered with the same key */
 void
 nfc_invoke_notif_chain(notif_chain_t *nfc,
 					   void *arg, size_t arg_size,
@@ -65,6 +183,7 @@ nfc_invoke_notif_chain(notif_chain_t *nfc,
 
 	glthread_t *curr;
 	notif_chain_elem_t *nfce;
+	notif_key_node_t *key_node;
 
 	if(IS_GLTHREAD_LIST_EMPTY(&nfc->notif_chain_head)) {
 		return;
@@ -72,22 +191,28 @@ nfc_invoke_notif_chain(notif_chain_t *nfc,
 
 	assert(key_size <= MAX_NOTIF_KEY_SIZE);
 
-	ITERATE_GLTHREAD_BEGIN(&nfc->notif_chain_head, curr){
+	if (!(key && key_size)) {
 
-		nfce = glthread_glue_to_notif_chain_elem(curr);
+		ITERATE_GLTHREAD_BEGIN(&nfc->notif_chain_head, curr){
 
-		if(!(key && key_size && 
-			 nfce->is_key_set && (key_size == nfce->key_size))){
-				
-				nfce->app_cb(arg, arg_size, nfc_op_code, nfce->subs_id);
-		}
-		else {
-			
-			if(memcmp(key, nfce->key, key_size) == 0) {
+			nfce = glthread_glue_to_notif_chain_elem(curr);
+			nfce->app_cb(arg, arg_size, nfc_op_code, nfce->subs_id);
+		}ITERATE_GLTHREAD_END(&nfc->notif_chain_head, curr);
+		return;
+	}
 
-				nfce->app_cb(arg, arg_size, nfc_op_code, nfce->subs_id);
-			}
-		}
-	}ITERATE_GLTHREAD_END(&nfc->notif_chain_head, curr);
-}
+	ITERATE_GLTHREAD_BEGIN(&nfc->wildcard_head, curr){
+
+		nfce = glthread_key_glue_to_notif_chain_elem(curr);
+		nfce->app_cb(arg, arg_size, nfc_op_code, nfce->subs_id);
+	}ITERATE_GLTHREAD_END(&nfc->wildcard_head, curr);
+
+	key_node = nfc_lookup_key_node(nfc, key, key_size, nfc_key_hash(key, key_size));
+	if (!key_node) return;
 
+	ITERATE_GLTHREAD_BEGIN(&key_node->subscribers, curr){
+
+		nfce = glthread_key_glue_to_notif_chain_elem(curr);
+		nfce->app_cb(arg, arg_size, nfc_op_code, nfce->subs_id);
+	}ITERATE_GLTHREAD_END(&key_node->subscribers, curr);
+}
@@ -20,10 +20,12 @@
 #define __NOTIF_CHAIN_
 
 #include <stddef.h>  /* for size_t */
-#include "utils.h"
-#include "glthread/glthread.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include "../gtheard/glthread.h"
 
 #define MAX_NOTIF_KEY_SIZE	64
+#define NFC_KEY_HASH_INIT_BUCKETS	64
 
 typedef enum{
 
@@ -37,8 +39,6 @@ typedef enum{
 static inline char *
 nfc_get_str_op_code(nfc_op_t nfc_op_code) {
 
-	static char op_code_str[16];
-
 	switch(nfc_op_code) {
 
 		case NFC_UNKNOWN:
@@ -64,17 +64,34 @@ typedef struct notif_chain_elem_{
     char key[MAX_NOTIF_KEY_SIZE];
     size_t key_size;
 	uint32_t subs_id;
-    bool_t is_key_set;
+    bool is_key_set;
     nfc_app_cb app_cb;
     glthread_t glue;
+    glthread_t key_glue;	/* into wildcard list or its key's subscriber list */
 } notif_chain_elem_t;
 GLTHREAD_TO_STRUCT(glthread_glue_to_notif_chain_elem,
                    notif_chain_elem_t, glue);
+GLTHREAD_TO_STRUCT(glthread_key_glue_to_notif_chain_elem,
+                   notif_chain_elem_t, key_glue);
+
+/* All subscribers of one distinct key, hashed into notif_chain_t buckets */
+typedef struct notif_key_node_ {
+
+    char key[MAX_NOTIF_KEY_SIZE];
+    size_t key_size;
+    uint64_t hash;
+    glthread_t subscribers;
+    struct notif_key_node_ *next;
+} notif_key_node_t;
 
 typedef struct notif_chain_ {
 
     char nfc_name[64];
-    glthread_t notif_chain_head;
+    glthread_t notif_chain_head;	/* every subscriber, for unkeyed events */
+    glthread_t wildcard_head;		/* subscribers without a key */
+    notif_key_node_t **key_buckets;
+    uint32_t n_key_buckets;
+    uint32_t n_keys;
 } notif_chain_t;
 
 notif_chain_t *
@@ -0,0 +1,133 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename:  notif_bench.c
+ *
+ *    Description: Keyed event fan-out cost of a notif chain, hash indexed
+ *                 nfc_invoke_notif_chain vs a linear walk of every subscriber
+ *
+ * =====================================================================================
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory.h>
+#include <time.h>
+#include "notif.h"
+
+#define NFC_BENCH_WILDCARDS	8
+#define NFC_BENCH_SUBS_PER_KEY	2
+#define NFC_BENCH_WORK		50000000ull	/* linear walk budget, subscriber visits */
+
+static unsigned long nfc_bench_calls;
+
+static void
+nfc_bench_cb(void *arg, size_t arg_size, nfc_op_t nfc_op_code, uint32_t subs_id) {
+
+	(void)arg; (void)arg_size; (void)nfc_op_code; (void)subs_id;
+	nfc_bench_calls++;
+}
+
+static double
+nfc_bench_now(void) {
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Pre index dispatch, every subscriber key is compared for every event */
+static void
+nfc_invoke_notif_chain_linear(notif_chain_t *nfc,
+							  void *arg, size_t arg_size,
+							  char *key, size_t key_size,
+							  nfc_op_t nfc_op_code) {
+
+	glthread_t *curr;
+	notif_chain_elem_t *nfce;
+
+	ITERATE_GLTHREAD_BEGIN(&nfc->notif_chain_head, curr){
+
+		nfce = glthread_glue_to_notif_chain_elem(curr);
+		if (!nfce->is_key_set ||
+			(key_size == nfce->key_size && memcmp(key, nfce->key, key_size) == 0)) {
+			nfce->app_cb(arg, arg_size, nfc_op_code, nfce->subs_id);
+		}
+	}ITERATE_GLTHREAD_END(&nfc->notif_chain_head, curr);
+}
+
+static void
+nfc_bench_make_key(char *key, uint32_t n) {
+
+	/* Route style key, dest/mask */
+	memset(key, 0, MAX_NOTIF_KEY_SIZE);
+	snprintf(key, MAX_NOTIF_KEY_SIZE, "10.%u.%u.%u/255.255.255.255",
+			 (n >> 16) & 0xff, (n >> 8) & 0xff, n & 0xff);
+}
+
+int
+main(int argc, char **argv) {
+
+	uint32_t n_subs, n_keys, i, n_events;
+	uint32_t max_subs = (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+	unsigned int seed = 1;
+	char key[MAX_NOTIF_KEY_SIZE];
+	notif_chain_elem_t nfce;
+	notif_chain_t *nfc;
+	unsigned long calls;
+	double start, hash_ns, linear_ns;
+
+	printf("%10s %10s %14s %14s %10s\n", "subs", "events", "hash ns/event",
+		   "linear ns/event", "calls/event");
+
+	for (n_subs = 1000; n_subs <= max_subs; n_subs *= 10) {
+
+		nfc = nfc_create_new_notif_chain("bench");
+		n_keys = n_subs / NFC_BENCH_SUBS_PER_KEY;
+
+		memset(&nfce, 0, sizeof(nfce));
+		nfce.app_cb = nfc_bench_cb;
+		for (i = 0; i < NFC_BENCH_WILDCARDS; i++) {
+			nfce.subs_id = i;
+			nfc_register_notif_chain(nfc, &nfce);
+		}
+		nfce.is_key_set = true;
+		nfce.key_size = MAX_NOTIF_KEY_SIZE;
+		for (i = 0; i < n_subs; i++) {
+			nfc_bench_make_key(nfce.key, i % n_keys);
+			nfce.subs_id = NFC_BENCH_WILDCARDS + i;
+			nfc_register_notif_chain(nfc, &nfce);
+		}
+
+		n_events = NFC_BENCH_WORK / n_subs;
+
+		nfc_bench_calls = 0;
+		start = nfc_bench_now();
+		for (i = 0; i < n_events; i++) {
+			nfc_bench_make_key(key, rand_r(&seed) % n_keys);
+			nfc_invoke_notif_chain(nfc, NULL, 0, key, MAX_NOTIF_KEY_SIZE, NFC_MOD);
+		}
+		hash_ns = (nfc_bench_now() - start) * 1e9 / n_events;
+		calls = nfc_bench_calls;
+
+		nfc_bench_calls = 0;
+		start = nfc_bench_now();
+		for (i = 0; i < n_events; i++) {
+			nfc_bench_make_key(key, rand_r(&seed) % n_keys);
+			nfc_invoke_notif_chain_linear(nfc, NULL, 0, key, MAX_NOTIF_KEY_SIZE, NFC_MOD);
+		}
+		linear_ns = (nfc_bench_now() - start) * 1e9 / n_events;
+
+		if (calls != nfc_bench_calls) {
+			printf("Mismatch: hash index made %lu calls, linear walk %lu\n",
+				   calls, nfc_bench_calls);
+		}
+		printf("%10u %10u %14.0f %14.0f %10.1f\n", n_subs, n_events,
+			   hash_ns, linear_ns, (double)calls / n_events);
+
+		nfc_delete_all_nfce(nfc);
+		free(nfc);
+	}
+	return 0;
+}
@@ -1,131 +1,589 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
 #include <assert.h>
+#include <sched.h>
 #include "asl.h"
 
-static void
-asl_workers_in_operation(asl_t *asl, bool incremenet) {
+/* Pool mode worker */
+typedef struct asl_pool_worker_ {
+
+    /* Stages with an affinity to this worker */
+    asl_channel_t ready;
+    pthread_t thread;
+    uint32_t id;
+    asl_pool_t *pool;
+} asl_pool_worker_t;
+
+struct asl_pool_ {
+
+    /* Stages with no affinity */
+    asl_channel_t ready;
+    uint32_t n_workers;
+    asl_pool_worker_t *workers;
+    uint32_t n_stages;
+    bool stop;
+    /* Idle workers, asleep on cv */
+    uint32_t n_sleeping;
+    pthread_mutex_t mutex;
+    pthread_cond_t cv;
+};
+
+/* Stages and the asl embed cache line aligned channels */
+static void *
+asl_calloc_aligned(size_t size) {
 
-    pthread_mutex_lock(&asl->asl_state_mutex);
+    void *ptr;
 
-    if (incremenet) {
-        asl->n_workers_in_operation++;
-    }
-    else {
-        asl->n_workers_in_operation--;
+    if (posix_memalign(&ptr, ASL_CACHE_LINE, size)) return NULL;
+    memset(ptr, 0, size);
+    return ptr;
+}
 
-        if (asl->accept_new_object == false) {
-            pthread_cond_signal(&asl->cv);
-        }
+/* Pins the thread to the index'th CPU this process may run on */
+static void
+asl_thread_set_cpu(pthread_t thread, uint32_t index) {
 
-    }
-    pthread_mutex_unlock(&asl->asl_state_mutex);
-} 
+    int cpu;
+    uint32_t n = 0;
+    cpu_set_t allowed, cpus;
 
+    if (sched_getaffinity(0, sizeof(allowed), &allowed)) return;
+
+    index %= CPU_COUNT(&allowed);
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed) && n++ == index) break;
+    }
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+}
 
 asl_t *
 asl_create_new(char *name, asl_emit_fnptr_t asl_emit_cbk) {
 
-    asl_t *asl = (asl_t *)calloc(1, sizeof(asl_t));
+    int i;
+    asl_t *asl = (asl_t *)asl_calloc_aligned(sizeof(asl_t));
 
     strncpy(asl->name, name, sizeof(asl->name));
     asl->name[sizeof(asl->name) - 1] = '\0';
     asl->asl_emit_cbk = asl_emit_cbk;
     asl->accept_new_object = true;
     pthread_mutex_init(&asl->asl_state_mutex, NULL);
-    pthread_cond_init(&asl->cv, NULL);
-    sem_init(&asl->sem0, 0, 0);
-    asl->n_workers_in_operation = 0;
+#ifdef ASL_STATS
+    asl_stats_init(asl);
+#endif
+
+    /* Any thread allocates (asl_enqueue), any last stage frees */
+    asl->object_pool = (asl_object_t *)calloc(ASL_OBJECT_POOL_SIZE, sizeof(asl_object_t));
+    asl_channel_init(&asl->free_objects, ASL_OBJECT_POOL_SIZE, true, true);
+    asl_channel_add_producer(&asl->free_objects);
+    for (i = 0; i < ASL_OBJECT_POOL_SIZE; i++) {
+#ifdef ASL_STATS
+        asl->object_pool[i].timed = (i % ASL_STATS_SAMPLE == 0);
+#endif
+        asl_channel_try_push(&asl->free_objects, &asl->object_pool[i]);
+    }
     return asl;
 }
 
+static asl_object_t *
+asl_object_alloc(asl_t *asl) {
+
+    asl_object_t *asl_object;
+
+    /* Blocks while ASL_OBJECT_POOL_SIZE objects are in flight */
+    asl_object = (asl_object_t *)asl_channel_pop(&asl->free_objects);
+    asl_object->refcount = 1;
+    return asl_object;
+}
+
+static void
+asl_object_free(asl_t *asl, asl_object_t *asl_object) {
+
+    asl_object->obj = NULL;
+#ifdef ASL_STATS
+    /* Cleared if the object was shared */
+    asl_object->timed = ((asl_object - asl->object_pool) % ASL_STATS_SAMPLE == 0);
+#endif
+    asl_channel_push(&asl->free_objects, asl_object);
+}
+
+/* The object leaves the line at a stage with no next stage, it is emitted
+   when the last stage sharing it is done with it */
+static void
+asl_object_release(asl_t *asl, asl_object_t *asl_object) {
+
+    if (__atomic_load_n(&asl_object->refcount, __ATOMIC_ACQUIRE) != 1 &&
+        __atomic_sub_fetch(&asl_object->refcount, 1, __ATOMIC_ACQ_REL)) {
+        return;
+    }
+    asl->asl_emit_cbk(asl_object->obj);
+    asl_object_free(asl, asl_object);
+}
+
+/* Runs the stage callback on the object, returns the stage it goes to next,
+   ASL_ALL_CHILDREN or NULL if it leaves the line */
+static asl_stage_t *
+asl_stage_process(asl_stage_t *asl_stage, asl_object_t *asl_object) {
+
+    int i;
+    uint32_t n_children = 0;
+    asl_stage_t *asl_next_stage;
+#ifdef ASL_STATS
+    uint64_t t_start = 0, t_end;
+#endif
+
+#ifdef ASL_DEBUG
+    printf ("Asl Object %p , Entering Stage : %s\n", asl_object->obj, asl_stage->name);
+#endif
+#ifdef ASL_STATS
+    asl_stage_stats_count(&asl_stage->stats);
+    if (asl_object->timed) {
+        t_start = asl_ticks();
+    }
+#endif
+    asl_next_stage = asl_stage->stage_processing_cbk(asl_stage, asl_object->obj);
+#ifdef ASL_STATS
+    /* The end of service is when the object gets queued to the next
+       stage, save a clock read in asl_stage_enqueue( ) */
+    if (asl_object->timed) {
+        t_end = asl_ticks();
+        asl_stage_stats_record(&asl_stage->stats,
+                               t_start - asl_object->enq_ticks,
+                               t_end - t_start);
+        asl_object->enq_ticks = t_end;
+    }
+#endif
+
+    /* By default Queue it to the next stage */
+    if (!asl_next_stage) {
+        return asl_stage->next_stage[0];
+    }
+    if (asl_next_stage != ASL_ALL_CHILDREN) {
+        return asl_next_stage;
+    }
+
+    for (i = 0; i < asl_stage->fanout; i++) {
+        if (asl_stage->next_stage[i]) n_children++;
+    }
+    if (!n_children) return NULL;
+
+    /* Still the only holder, no other stage may read the object yet */
+    if (n_children > 1) {
+#ifdef ASL_STATS
+        /* The children would race on enq_ticks */
+        if (asl_object->timed) {
+            asl_object->timed = false;
+        }
+#endif
+        __atomic_add_fetch(&asl_object->refcount, n_children - 1, __ATOMIC_RELAXED);
+    }
+    return ASL_ALL_CHILDREN;
+}
+
 static void *
 worker_thread_fn(void *arg) {
 
+    int i;
     asl_stage_t *asl_stage;
     asl_object_t *asl_object;
     asl_stage_t *asl_next_stage;
 
     asl_stage = (asl_stage_t *)arg;
-    asl_workers_in_operation(asl_stage->asl, true);
-    
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
-    pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL);
 
-    sem_post(&asl_stage->asl->sem0);
-    
-    while(1) {
+    /* NULL once every parent has closed its end and the channel is drained */
+    while ((asl_object = (asl_object_t *)asl_channel_pop(&asl_stage->in_channel))) {
+
+        asl_next_stage = asl_stage_process(asl_stage, asl_object);
+
+        if (!asl_next_stage) {
+            asl_object_release(asl_stage->asl, asl_object);
+            continue;
+        }
+        if (asl_next_stage != ASL_ALL_CHILDREN) {
+            asl_channel_push(&asl_next_stage->in_channel, asl_object);
+            continue;
+        }
+        for (i = 0; i < asl_stage->fanout; i++) {
+            if (asl_stage->next_stage[i]) {
+                asl_channel_push(&asl_stage->next_stage[i]->in_channel, asl_object);
+            }
+        }
+    }
 
-        pthread_mutex_lock(&asl_stage->q_mutex);
-    
-        while(IS_GLTHREAD_LIST_EMPTY(&asl_stage->object_queue)) {
-            asl_workers_in_operation(asl_stage->asl, false);
-            pthread_cond_wait(&asl_stage->cv, &asl_stage->q_mutex);
-            asl_workers_in_operation(asl_stage->asl, true);
+    /* Pass the end of input on to the children */
+    for (i = 0; i < asl_stage->fanout; i++) {
+        if (asl_stage->next_stage[i]) {
+            asl_channel_close(&asl_stage->next_stage[i]->in_channel);
         }
+    }
+    return NULL;
+}
+
+/*
+ * Pool mode.
+ *
+ * A stage with objects in its in_channel is in exactly one ready queue, or
+ * being run by a worker : the producer which makes its channel non empty
+ * sets asl_stage->scheduled and queues it, the worker running it clears the
+ * flag once the channel is drained. So a stage never runs on two workers at
+ * once and its channel keeps a single consumer. Workers never block on a
+ * channel : a stage whose output does not fit a child is parked on that
+ * child with the output as pending, and queued again by the worker which
+ * next pops the child. The stage graph being a DAG, leaves always drain.
+ */
+
+static void
+asl_pool_wake(asl_pool_t *pool) {
+
+    /* Pairs with the n_sleeping increment of an idle worker, which then
+       checks the ready queues again before sleeping */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pool->n_sleeping, __ATOMIC_RELAXED)) {
+        pthread_mutex_lock(&pool->mutex);
+        pthread_cond_signal(&pool->cv);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
+/* The stage is scheduled already */
+static void
+asl_pool_queue(asl_pool_t *pool, asl_stage_t *asl_stage) {
+
+    asl_channel_t *ready = &pool->ready;
+
+    if (asl_stage->affinity >= 0) {
+        ready = &pool->workers[asl_stage->affinity % pool->n_workers].ready;
+    }
+    /* Holds every stage at worst */
+    if (!asl_channel_try_push(ready, asl_stage)) assert(0);
+    asl_pool_wake(pool);
+}
+
+/* Called once objects have been pushed to the stage */
+static void
+asl_pool_schedule(asl_pool_t *pool, asl_stage_t *asl_stage) {
+
+    /* Pairs with the fence of asl_pool_run_stage( ) after it clears the
+       flag : either it sees the objects, or we see the flag cleared */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&asl_stage->scheduled, __ATOMIC_RELAXED)) return;
+    if (__atomic_exchange_n(&asl_stage->scheduled, true, __ATOMIC_ACQ_REL)) return;
+    asl_pool_queue(pool, asl_stage);
+}
+
+/* Stages are picked from the worker's own ready queue first, then from the
+   shared one, then stolen from the other workers */
+static asl_stage_t *
+asl_pool_next_stage(asl_pool_t *pool, uint32_t id) {
+
+    uint32_t i;
+    asl_stage_t *asl_stage;
 
-        asl_next_stage = NULL;
-        asl_object = glue_to_asl_object(dequeue_glthread_first(&asl_stage->object_queue));
+    if ((asl_stage = (asl_stage_t *)asl_channel_try_pop(&pool->workers[id].ready))) {
+        return asl_stage;
+    }
+    if ((asl_stage = (asl_stage_t *)asl_channel_try_pop(&pool->ready))) {
+        return asl_stage;
+    }
+    for (i = 1; i < pool->n_workers; i++) {
+        asl_stage = (asl_stage_t *)asl_channel_try_pop
+            (&pool->workers[(id + i) % pool->n_workers].ready);
+        if (asl_stage) return asl_stage;
+    }
+    return NULL;
+}
 
-        pthread_mutex_unlock(&asl_stage->q_mutex);
+/* Queues again the stages parked on this one, it has popped */
+static void
+asl_pool_unpark(asl_pool_t *pool, asl_stage_t *asl_stage) {
+
+    asl_stage_t *parked, *next;
+
+    /* Pairs with the n_parked increment in asl_pool_push( ) */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&asl_stage->n_parked, __ATOMIC_RELAXED)) return;
+
+    pthread_mutex_lock(&asl_stage->parked_mutex);
+    parked = asl_stage->parked_head;
+    asl_stage->parked_head = NULL;
+    __atomic_store_n(&asl_stage->n_parked, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&asl_stage->parked_mutex);
+
+    for (; parked; parked = next) {
+        /* Another worker may park it again as soon as it is queued */
+        next = parked->parked_next;
+        asl_pool_queue(pool, parked);
+    }
+}
 
-        printf ("Asl Object %p , Entering Stage : %s\n", asl_object->obj, asl_stage->name);
-        asl_next_stage = asl_stage->stage_processing_cbk(asl_stage, asl_object->obj);
+/* false if the child is full, asl_stage is then parked on it */
+static bool
+asl_pool_push(asl_pool_t *pool, asl_stage_t *asl_stage,
+              asl_stage_t *child, asl_object_t *asl_object) {
 
-        /* By default Queue it to the next stage */
-        if (!asl_next_stage) {   
-            asl_next_stage = asl_stage->next_stage[0];
+    bool pushed;
+
+    if (!asl_channel_try_push(&child->in_channel, asl_object)) {
+
+        /* Park, unless the child popped meanwhile */
+        pthread_mutex_lock(&child->parked_mutex);
+        __atomic_add_fetch(&child->n_parked, 1, __ATOMIC_SEQ_CST);
+        pushed = asl_channel_try_push(&child->in_channel, asl_object);
+        if (pushed) {
+            __atomic_sub_fetch(&child->n_parked, 1, __ATOMIC_RELAXED);
+        }
+        else {
+            asl_stage->parked_next = child->parked_head;
+            child->parked_head = asl_stage;
         }
+        pthread_mutex_unlock(&child->parked_mutex);
+        if (!pushed) return false;
+    }
+    asl_pool_schedule(pool, child);
+    return true;
+}
+
+/* Hands asl_stage->pending over to its next stage(s). false if the stage
+   got parked : it then belongs to whichever worker unparks it, the caller
+   must not touch it any more */
+static bool
+asl_pool_deliver(asl_pool_t *pool, asl_stage_t *asl_stage) {
+
+    asl_stage_t *child;
+    asl_object_t *asl_object = asl_stage->pending;
+
+    if (asl_stage->pending_target) {
+        if (!asl_pool_push(pool, asl_stage, asl_stage->pending_target, asl_object)) {
+            return false;
+        }
+    }
+    else {
+        for (; asl_stage->pending_child < asl_stage->fanout; asl_stage->pending_child++) {
+            child = asl_stage->next_stage[asl_stage->pending_child];
+            if (child && !asl_pool_push(pool, asl_stage, child, asl_object)) {
+                return false;
+            }
+        }
+    }
+    asl_stage->pending = NULL;
+    return true;
+}
+
+static void
+asl_pool_run_stage(asl_pool_t *pool, asl_stage_t *asl_stage) {
+
+    uint32_t n_popped = 0;
+    bool parked = false;
+    asl_object_t *asl_object;
+    asl_stage_t *asl_next_stage;
+
+    /* Resumed after being parked */
+    if (asl_stage->pending && !asl_pool_deliver(pool, asl_stage)) return;
+
+    while (n_popped < ASL_POOL_BATCH) {
+
+        if (!(asl_object = (asl_object_t *)asl_channel_poll(&asl_stage->in_channel))) {
+            break;
+        }
+        n_popped++;
+
+        asl_next_stage = asl_stage_process(asl_stage, asl_object);
 
         if (!asl_next_stage) {
-            asl_stage->asl->asl_emit_cbk(asl_object->obj);
-            free(asl_object);
+            asl_object_release(asl_stage->asl, asl_object);
             continue;
         }
-        asl_stage_enqueue(asl_next_stage, asl_object);
+        asl_stage->pending = asl_object;
+        asl_stage->pending_target =
+            asl_next_stage == ASL_ALL_CHILDREN ? NULL : asl_next_stage;
+        asl_stage->pending_child = 0;
+        if (!asl_pool_deliver(pool, asl_stage)) {
+            parked = true;
+            break;
+        }
+    }
+
+    /* Only the parked list is touched, fine even once parked */
+    if (n_popped) {
+        asl_pool_unpark(pool, asl_stage);
+    }
+    if (parked) return;
+
+    /* Let the other ready stages have their turn */
+    if (n_popped == ASL_POOL_BATCH) {
+        asl_pool_queue(pool, asl_stage);
+        return;
+    }
+
+    __atomic_store_n(&asl_stage->scheduled, false, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (asl_channel_count(&asl_stage->in_channel) &&
+        !__atomic_exchange_n(&asl_stage->scheduled, true, __ATOMIC_ACQ_REL)) {
+        asl_pool_queue(pool, asl_stage);
+    }
+}
+
+static void *
+asl_pool_worker_fn(void *arg) {
+
+    int spin;
+    asl_pool_worker_t *worker = (asl_pool_worker_t *)arg;
+    asl_pool_t *pool = worker->pool;
+    asl_stage_t *asl_stage;
+
+    while (1) {
+
+        for (spin = 0; spin < ASL_CHANNEL_SPIN; spin++) {
+            if ((asl_stage = asl_pool_next_stage(pool, worker->id))) break;
+        }
+
+        if (!asl_stage) {
+            pthread_mutex_lock(&pool->mutex);
+            __atomic_add_fetch(&pool->n_sleeping, 1, __ATOMIC_SEQ_CST);
+            while (!(asl_stage = asl_pool_next_stage(pool, worker->id)) &&
+                   !pool->stop) {
+                pthread_cond_wait(&pool->cv, &pool->mutex);
+            }
+            __atomic_sub_fetch(&pool->n_sleeping, 1, __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&pool->mutex);
+            /* Stopped once the line is drained */
+            if (!asl_stage) break;
+        }
+
+        asl_pool_run_stage(pool, asl_stage);
     }
     return NULL;
 }
 
+static asl_pool_t *
+asl_pool_create(uint32_t n_workers) {
+
+    uint32_t i;
+    cpu_set_t allowed;
+    asl_pool_t *pool = (asl_pool_t *)asl_calloc_aligned(sizeof(asl_pool_t));
+
+    if (!n_workers) {
+        n_workers = sched_getaffinity(0, sizeof(allowed), &allowed) ?
+                        1 : CPU_COUNT(&allowed);
+    }
+
+    asl_channel_init(&pool->ready, ASL_POOL_MAX_STAGES, true, true);
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->cv, NULL);
+    pool->n_workers = n_workers;
+    pool->workers = (asl_pool_worker_t *)asl_calloc_aligned
+        (n_workers * sizeof(asl_pool_worker_t));
+
+    for (i = 0; i < n_workers; i++) {
+        asl_channel_init(&pool->workers[i].ready, ASL_POOL_MAX_STAGES, true, true);
+        pool->workers[i].id = i;
+        pool->workers[i].pool = pool;
+    }
+    for (i = 0; i < n_workers; i++) {
+        pthread_create(&pool->workers[i].thread, NULL, asl_pool_worker_fn,
+                       (void *)&pool->workers[i]);
+        asl_thread_set_cpu(pool->workers[i].thread, i);
+    }
+    return pool;
+}
+
+/* The line is drained, stages left in the ready queues have no objects */
+static void
+asl_pool_destroy(asl_pool_t *pool) {
+
+    uint32_t i;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->cv);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (i = 0; i < pool->n_workers; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+    for (i = 0; i < pool->n_workers; i++) {
+        asl_channel_destroy(&pool->workers[i].ready);
+    }
+    asl_channel_destroy(&pool->ready);
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->cv);
+    free(pool->workers);
+    free(pool);
+}
+
+asl_t *
+asl_create_new_pooled(char *name, asl_emit_fnptr_t asl_emit_cbk,
+                      uint32_t n_workers) {
+
+    asl_t *asl = asl_create_new(name, asl_emit_cbk);
+
+    asl->pool = asl_pool_create(n_workers);
+    return asl;
+}
+
 asl_stage_t *
-asl_create_new_stage(asl_t *asl, char *name, 
+asl_create_new_stage(asl_t *asl, char *name,
                                     stage_processing_fnptr_t stage_processing_cbk,
                                     uint8_t fanout) {
 
     pthread_attr_t attr;
 
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
-    asl_stage_t *asl_stage = (asl_stage_t *)calloc
-        (1, sizeof(asl_stage_t) + (sizeof(asl_stage_t *) *fanout));
+    asl_stage_t *asl_stage = (asl_stage_t *)asl_calloc_aligned
+        (sizeof(asl_stage_t) + (sizeof(asl_stage_t *) *fanout));
 
     strncpy(asl_stage->name, name, sizeof(asl_stage->name));
     asl_stage->name[sizeof(asl_stage->name) -1] = '\0';
 
     asl_stage->stage_processing_cbk = stage_processing_cbk;
 
-    init_glthread(&asl_stage->object_queue);
-
-    pthread_mutex_init(&asl_stage->q_mutex, NULL);
-    pthread_cond_init(&asl_stage->cv, NULL);
+    /* Single producer until a second parent or the root role shows up.
+       The asl holds a producer end of every stage until asl_destroy( ) */
+    asl_channel_init(&asl_stage->in_channel, ASL_CHANNEL_SIZE, false, false);
+    asl_channel_add_producer(&asl_stage->in_channel);
 
     asl_stage->asl = asl;
     asl_stage->fanout = fanout;
+    asl_stage->affinity = -1;
+    pthread_mutex_init(&asl_stage->parked_mutex, NULL);
+    asl_stage->asl_next = asl->stages;
+    asl->stages = asl_stage;
+
+    if (asl->pool) {
+        /* A ready queue never holds more than every stage */
+        assert(asl->pool->n_stages < ASL_POOL_MAX_STAGES);
+        asl->pool->n_stages++;
+        return asl_stage;
+    }
 
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
     pthread_create(&asl_stage->worker_thread, &attr, worker_thread_fn, (void *)asl_stage);
-
-    sem_wait(&asl->sem0);
+    pthread_attr_destroy(&attr);
 
     return asl_stage;
 }
 
+void
+asl_stage_set_affinity(asl_stage_t *asl_stage, int affinity) {
+
+    asl_stage->affinity = affinity;
+    if (!asl_stage->asl->pool && affinity >= 0) {
+        asl_thread_set_cpu(asl_stage->worker_thread, affinity);
+    }
+}
+
+/* The stage graph must be complete before the first asl_enqueue( ), as
+   the number of producers of a channel decides how it is filled */
 void
 asl_add_root_stage(asl_t *asl, asl_stage_t *root_stage) {
 
     assert(asl->root_stage == NULL);
     asl->root_stage = root_stage;
+    /* asl_enqueue( ) may be called from any application thread */
+    root_stage->in_channel.multi_producer = true;
 }
 
 void
@@ -136,6 +594,11 @@ asl_add_child_stage(asl_t *asl, asl_stage_t *pstage, asl_stage_t *cstage) {
     for (i = 0; i < pstage->fanout; i++) {
         if (pstage->next_stage[i]) continue;
         pstage->next_stage[i] = cstage;
+        /* Fan-in, the first producer end is the asl's own */
+        if (cstage->in_channel.n_producers > 1) {
+            cstage->in_channel.multi_producer = true;
+        }
+        asl_channel_add_producer(&cstage->in_channel);
         return;
     }
     assert(0);
@@ -144,76 +607,86 @@ asl_add_child_stage(asl_t *asl, asl_stage_t *pstage, asl_stage_t *cstage) {
 void
 asl_enqueue(asl_t *asl, void *object) {
 
-    pthread_mutex_lock(&asl->asl_state_mutex);
-    if (!asl->accept_new_object) {
-        pthread_mutex_unlock(&asl->asl_state_mutex);
-        return;
+    asl_object_t *asl_object;
+
+    /* asl_destroy( ) waits for n_enqueuers to drop to 0 before closing
+       the root stage */
+    __atomic_add_fetch(&asl->n_enqueuers, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&asl->accept_new_object, __ATOMIC_SEQ_CST)) {
+        asl_object = asl_object_alloc(asl);
+        asl_object->obj = object;
+        asl_stage_enqueue(asl->root_stage, asl_object);
     }
-    pthread_mutex_unlock(&asl->asl_state_mutex);
-    asl_object_t *asl_object = (asl_object_t *)calloc(1, sizeof(asl_object_t));
-    asl_object->obj = object;
-    init_glthread(&asl_object->glue);
-    asl_stage_enqueue(asl->root_stage, asl_object);
+    __atomic_sub_fetch(&asl->n_enqueuers, 1, __ATOMIC_RELEASE);
 }
 
 void
 asl_stage_enqueue(asl_stage_t *asl_stage, asl_object_t *asl_object) {
 
-    pthread_mutex_lock(&asl_stage->q_mutex);
-
-    if (IS_GLTHREAD_LIST_EMPTY(&asl_stage->object_queue)) {
-        pthread_cond_signal(&asl_stage->cv);
+#ifdef ASL_STATS
+    if (asl_object->timed) {
+        asl_object->enq_ticks = asl_ticks();
     }
-
-     glthread_add_last(&asl_stage->object_queue, &asl_object->glue);
-     pthread_mutex_unlock(&asl_stage->q_mutex);
-}
-
-/* post order traversal */
-static void
-asl_traverse_all_stages (asl_stage_t *asl_stage, 
-                                        void (*asl_stage_processing_cbk)(asl_stage_t *)) {
-
-    int i;
-
-    for (i = 0; i < asl_stage->fanout; i++) {
-
-        if (asl_stage->next_stage[i]) {
-            asl_traverse_all_stages(asl_stage->next_stage[i], asl_stage_processing_cbk);
-        }
+#endif
+    /* Blocks while the stage is ASL_CHANNEL_SIZE objects behind */
+    asl_channel_push(&asl_stage->in_channel, asl_object);
+    if (asl_stage->asl->pool) {
+        asl_pool_schedule(asl_stage->asl->pool, asl_stage);
     }
-
-    asl_stage_processing_cbk(asl_stage);
 }
 
 static void
 asl_stage_cleanup(asl_stage_t *asl_stage) {
 
-    pthread_cancel(asl_stage->worker_thread);
-    pthread_join(asl_stage->worker_thread, NULL);
-    pthread_mutex_destroy(&asl_stage->q_mutex);
-    pthread_cond_destroy(&asl_stage->cv);
+    if (!asl_stage->asl->pool) {
+        pthread_join(asl_stage->worker_thread, NULL);
+    }
+    pthread_mutex_destroy(&asl_stage->parked_mutex);
+    asl_channel_destroy(&asl_stage->in_channel);
     free(asl_stage);
 }
 
+/* Drains the assembly line : objects already enqueued are processed, then
+   every worker exits once all its parents have exited */
 void
 asl_destroy(asl_t *asl) {
 
+    asl_stage_t *asl_stage, *next;
+
     pthread_mutex_lock(&asl->asl_state_mutex);
-    asl->accept_new_object = false;
+    __atomic_store_n(&asl->accept_new_object, false, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&asl->asl_state_mutex);
 
-    while (asl->n_workers_in_operation) {
-        pthread_cond_wait(&asl->cv, &asl->asl_state_mutex);
+    while (__atomic_load_n(&asl->n_enqueuers, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+
+#ifdef ASL_STATS
+    /* The dump thread walks the stages */
+    asl_stats_destroy(asl);
+#endif
+
+    if (asl->pool) {
+        /* Drained once every object is back in the pool */
+        while (asl_channel_count(&asl->free_objects) != ASL_OBJECT_POOL_SIZE) {
+            sched_yield();
+        }
+        asl_pool_destroy(asl->pool);
+    }
+    else {
+        /* Now happily shut down all threads */
+        for (asl_stage = asl->stages; asl_stage; asl_stage = asl_stage->asl_next) {
+            asl_channel_close(&asl_stage->in_channel);
+        }
     }
-    pthread_mutex_unlock(&asl->asl_state_mutex);
 
-    /* Now happily shut down all threads */
-    asl_stage_t *root_stage = asl->root_stage;
-    asl_traverse_all_stages (root_stage, asl_stage_cleanup);
+    for (asl_stage = asl->stages; asl_stage; asl_stage = next) {
+        next = asl_stage->asl_next;
+        asl_stage_cleanup(asl_stage);
+    }
 
-    sem_destroy(&asl->sem0);
     pthread_mutex_destroy(&asl->asl_state_mutex);
-    pthread_cond_destroy(&asl->cv);
-    assert(!asl->n_workers_in_operation);
+    asl_channel_destroy(&asl->free_objects);
+    free(asl->object_pool);
     free(asl);
-}
\ No newline at end of file
+}
@@ -6,9 +6,29 @@
 #include <semaphore.h>
 #include <stdbool.h>
 #include "gluethread/glthread.h"
+#include "asl_channel.h"
+#ifdef ASL_STATS
+#include "asl_stats.h"
+#endif
+
+/* Objects a stage input channel can hold, power of 2 */
+#define ASL_CHANNEL_SIZE        256
+/* Objects in flight in an assembly line, asl_enqueue( ) blocks beyond */
+#define ASL_OBJECT_POOL_SIZE    4096
+/* Pool mode : objects a worker takes from a stage before moving on to
+   the next ready stage */
+#define ASL_POOL_BATCH          64
+/* Pool mode : stages per asl, power of 2 */
+#define ASL_POOL_MAX_STAGES     1024
+
+/* Returned by a stage callback to hand the object to every child stage.
+   The children share the object, which must be treated as read only from
+   there on, and asl_emit_cbk is called once the last of them is done */
+#define ASL_ALL_CHILDREN        ((asl_stage_t *)-1)
 
 typedef struct asl_stage_ asl_stage_t;
 typedef struct asl_ asl_t;
+typedef struct asl_pool_ asl_pool_t;
 
 typedef asl_stage_t * (*stage_processing_fnptr_t)(asl_stage_t *, void *);
 typedef void (*asl_emit_fnptr_t)(void *);
@@ -18,10 +38,30 @@ struct asl_stage_ {
 	uint8_t fanout;
 	pthread_t worker_thread;
 	stage_processing_fnptr_t stage_processing_cbk;
-	glthread_t object_queue;
-	pthread_mutex_t q_mutex;
-	pthread_cond_t cv;
+	/* Objects queued for this stage, fed by the parent stages */
+	asl_channel_t in_channel;
 	asl_t *asl;
+	/* All stages of the asl, for teardown */
+	asl_stage_t *asl_next;
+	/* Worker (pool mode) or CPU the stage prefers, -1 if none */
+	int affinity;
+	/* Pool mode. Set while the stage sits in a ready queue or runs, so
+	   that a single worker at a time runs it */
+	bool scheduled;
+	/* Output which did not fit the in_channel of a child, the stage is
+	   parked on that child until it pops. To pending_target, else to the
+	   children from pending_child on */
+	struct asl_object_ *pending;
+	asl_stage_t *pending_target;
+	uint8_t pending_child;
+	/* Stages parked on the in_channel of this one */
+	asl_stage_t *parked_head;
+	asl_stage_t *parked_next;
+	uint32_t n_parked;
+	pthread_mutex_t parked_mutex;
+#ifdef ASL_STATS
+	asl_stage_stats_t stats;
+#endif
 	/* Assignment on stretchable arrays */
 	asl_stage_t *next_stage[0];
 };
@@ -32,26 +72,64 @@ struct asl_{
     char name[32];
 	asl_emit_fnptr_t asl_emit_cbk;
 	asl_stage_t *root_stage;
-	sem_t sem0;
+	asl_stage_t *stages;
 	bool accept_new_object;
+	/* Threads inside asl_enqueue( ) */
+	uint32_t n_enqueuers;
 	pthread_mutex_t asl_state_mutex;
-	pthread_cond_t cv;
-	uint8_t n_workers_in_operation;
+	/* Object wrappers, allocated once and recycled through free_objects */
+	struct asl_object_ *object_pool;
+	asl_channel_t free_objects;
+	/* Workers running the stages in pool mode, NULL if every stage runs
+	   its own thread */
+	asl_pool_t *pool;
+#ifdef ASL_STATS
+	/* Origin of the stats clock, to turn ticks into ns and counts into rates */
+	uint64_t stats_start_ticks;
+	struct timespec stats_start;
+	/* Periodic dump, see asl_stats_start_dump( ) */
+	pthread_t stats_dump_thread;
+	bool stats_dump_running;
+	uint32_t stats_dump_period_ms;
+	FILE *stats_dump_out;
+	pthread_mutex_t stats_mutex;
+	pthread_cond_t stats_cv;
+#endif
 };
 
 typedef struct asl_object_ {
 
     void *obj;
-    glthread_t glue;
+    /* Stages holding the object, more than one after ASL_ALL_CHILDREN */
+    uint32_t refcount;
+#ifdef ASL_STATS
+    /* Timed object, see ASL_STATS_SAMPLE */
+    bool timed;
+    /* When queued to its current stage, if timed */
+    uint64_t enq_ticks;
+#endif
 } asl_object_t;
-GLTHREAD_TO_STRUCT(glue_to_asl_object, asl_object_t, glue);
 
 asl_t *
 asl_create_new(char *name, asl_emit_fnptr_t asl_emit_cbk);
 
+/* Pool mode : stages get no thread of their own, a ready stage is run by
+ * one of n_workers workers (0 for one per online CPU), each pinned to a
+ * CPU. A stage whose child is full is parked instead of blocking its
+ * worker, and resumed when the child pops */
+asl_t *
+asl_create_new_pooled(char *name, asl_emit_fnptr_t asl_emit_cbk,
+                      uint32_t n_workers);
+
 asl_stage_t *
 asl_create_new_stage(asl_t *asl, char *name, stage_processing_fnptr_t stage_processing_cbk, uint8_t fanout);
 
+/* Hint, before the first asl_enqueue( ) : in pool mode the stage is
+ * queued to worker (affinity % n_workers), which runs it unless idle
+ * workers steal it. Otherwise its thread is pinned to that CPU */
+void
+asl_stage_set_affinity(asl_stage_t *asl_stage, int affinity);
+
 void
 asl_add_root_stage(asl_t *asl, asl_stage_t *root_stage);
 
@@ -67,4 +145,25 @@ asl_stage_enqueue(asl_stage_t *asl_stage, asl_object_t *asl_object);
 void
 asl_destroy(asl_t *asl);
 
+#ifdef ASL_STATS
+void
+asl_stats_init(asl_t *asl);
+
+void
+asl_stats_destroy(asl_t *asl);
+
+/* Fills up to max_stages snapshots, in stage creation order, and returns
+   the no of stages. Safe to call while the asl is running */
+int
+asl_stats_snapshot(asl_t *asl, asl_stage_snapshot_t *snapshots, int max_stages);
+
+void
+asl_stats_dump(asl_t *asl, FILE *out);
+
+/* Dumps every period_ms, with rates over the period, until asl_destroy( ).
+   The stage graph must be complete */
+void
+asl_stats_start_dump(asl_t *asl, uint32_t period_ms, FILE *out);
+#endif
+
 #endif 
\ No newline at end of file
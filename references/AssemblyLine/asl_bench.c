@@ -0,0 +1,105 @@
+/*
+ * Throughput of a linear assembly line of trivial stages.
+ * Every stage bumps a counter in the object, the emit callback checks it.
+ * Reported time runs from the first asl_enqueue( ) to asl_destroy( )
+ * returning, i.e. until the line is drained.
+ *
+ * gcc -O2 -c gluethread/glthread.c -o gluethread/glthread.o
+ * gcc -O2 asl_bench.c asl.c asl_channel.c asl_stats.c gluethread/glthread.o -o asl_bench -lpthread
+ * ./asl_bench [n_stages] [n_objects] [n_workers]
+ *
+ * Stages get a thread each, unless n_workers is given : they then share a
+ * pool of n_workers threads, 0 for one per CPU
+ *
+ * Add -DASL_STATS to all sources to get the per stage stats once drained
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sched.h>
+#include "asl.h"
+
+#define BENCH_MAX_STAGES    64
+
+typedef struct bench_obj_ {
+
+    uint32_t n_stages_done;
+} bench_obj_t;
+
+static uint32_t n_stages;
+static uint64_t n_emitted;
+static uint64_t n_errors;
+
+static asl_stage_t *
+bench_stage_fn(asl_stage_t *curr_stage, void *obj) {
+
+    ((bench_obj_t *)obj)->n_stages_done++;
+    return NULL;
+}
+
+static void
+bench_emit(void *obj) {
+
+    if (((bench_obj_t *)obj)->n_stages_done != n_stages) n_errors++;
+    __atomic_store_n(&n_emitted, n_emitted + 1, __ATOMIC_RELEASE);
+}
+
+static double
+now_sec(void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int
+main(int argc, char **argv) {
+
+    uint32_t i;
+    char name[32];
+    double start, elapsed;
+    asl_stage_t *stage, *prev = NULL;
+    uint64_t n_objects = argc > 2 ? strtoull(argv[2], NULL, 10) : 1000000;
+    bench_obj_t *objs;
+    asl_t *asl;
+
+    n_stages = argc > 1 ? atoi(argv[1]) : 5;
+    if (n_stages < 1 || n_stages > BENCH_MAX_STAGES) n_stages = 5;
+
+    objs = calloc(n_objects, sizeof(bench_obj_t));
+    if (argc > 3) {
+        asl = asl_create_new_pooled("Bench Line", bench_emit, atoi(argv[3]));
+    }
+    else {
+        asl = asl_create_new("Bench Line", bench_emit);
+    }
+
+    for (i = 0; i < n_stages; i++) {
+        snprintf(name, sizeof(name), "Stage %u", i);
+        stage = asl_create_new_stage(asl, name, bench_stage_fn, 1);
+        if (prev) asl_add_child_stage(asl, prev, stage);
+        else asl_add_root_stage(asl, stage);
+        prev = stage;
+    }
+
+    start = now_sec();
+    for (i = 0; i < n_objects; i++) {
+        asl_enqueue(asl, &objs[i]);
+    }
+#ifdef ASL_STATS
+    while (__atomic_load_n(&n_emitted, __ATOMIC_ACQUIRE) != n_objects) {
+        sched_yield();
+    }
+    asl_stats_dump(asl, stdout);
+#endif
+    asl_destroy(asl);
+    elapsed = now_sec() - start;
+
+    printf("%u stages, %llu objects : %.0f objects/sec, %.0f ns/object%s\n",
+           n_stages, (unsigned long long)n_emitted, n_emitted / elapsed,
+           elapsed * 1e9 / n_objects,
+           (n_errors || n_emitted != n_objects) ? "  ERROR" : "");
+    free(objs);
+    return 0;
+}
@@ -0,0 +1,231 @@
+#include <stdlib.h>
+#include <assert.h>
+#include "asl_channel.h"
+
+static inline void
+asl_cpu_relax(void) {
+
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+void
+asl_channel_init(asl_channel_t *ch, uint32_t size,
+                 bool multi_producer, bool multi_consumer) {
+
+    uint32_t i;
+
+    assert(size && !(size & (size - 1)));
+
+    ch->tail = 0;
+    ch->head = 0;
+    ch->size = size;
+    ch->cells = (asl_channel_cell_t *)calloc(size, sizeof(asl_channel_cell_t));
+    for (i = 0; i < size; i++) {
+        ch->cells[i].seq = i;
+    }
+    ch->multi_producer = multi_producer;
+    ch->multi_consumer = multi_consumer;
+    ch->n_producers = 0;
+    ch->closed = false;
+    ch->n_waiters = 0;
+    pthread_mutex_init(&ch->mutex, NULL);
+    pthread_cond_init(&ch->not_empty, NULL);
+    pthread_cond_init(&ch->not_full, NULL);
+}
+
+void
+asl_channel_destroy(asl_channel_t *ch) {
+
+    pthread_mutex_destroy(&ch->mutex);
+    pthread_cond_destroy(&ch->not_empty);
+    pthread_cond_destroy(&ch->not_full);
+    free(ch->cells);
+    ch->cells = NULL;
+}
+
+void
+asl_channel_add_producer(asl_channel_t *ch) {
+
+    pthread_mutex_lock(&ch->mutex);
+    assert(!ch->closed);
+    ch->n_producers++;
+    pthread_mutex_unlock(&ch->mutex);
+}
+
+void
+asl_channel_close(asl_channel_t *ch) {
+
+    pthread_mutex_lock(&ch->mutex);
+    assert(ch->n_producers);
+    if (--ch->n_producers == 0) {
+        ch->closed = true;
+        pthread_cond_broadcast(&ch->not_empty);
+    }
+    pthread_mutex_unlock(&ch->mutex);
+}
+
+bool
+asl_channel_try_push(asl_channel_t *ch, void *data) {
+
+    asl_channel_cell_t *cell;
+    uint64_t pos, seq;
+    int64_t diff;
+
+    pos = __atomic_load_n(&ch->tail, __ATOMIC_RELAXED);
+
+    while (1) {
+
+        cell = &ch->cells[pos & (ch->size - 1)];
+        seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        diff = (int64_t)(seq - pos);
+
+        if (diff == 0) {
+            if (!ch->multi_producer) {
+                __atomic_store_n(&ch->tail, pos + 1, __ATOMIC_RELAXED);
+                break;
+            }
+            if (__atomic_compare_exchange_n(&ch->tail, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            /* The cell still holds data from the previous lap */
+            return false;
+        }
+        else {
+            pos = __atomic_load_n(&ch->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->data = data;
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void *
+asl_channel_try_pop(asl_channel_t *ch) {
+
+    asl_channel_cell_t *cell;
+    uint64_t pos, seq;
+    int64_t diff;
+    void *data;
+
+    pos = __atomic_load_n(&ch->head, __ATOMIC_RELAXED);
+
+    while (1) {
+
+        cell = &ch->cells[pos & (ch->size - 1)];
+        seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        diff = (int64_t)(seq - (pos + 1));
+
+        if (diff == 0) {
+            if (!ch->multi_consumer) {
+                __atomic_store_n(&ch->head, pos + 1, __ATOMIC_RELAXED);
+                break;
+            }
+            if (__atomic_compare_exchange_n(&ch->head, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            return NULL;
+        }
+        else {
+            pos = __atomic_load_n(&ch->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    data = cell->data;
+    __atomic_store_n(&cell->seq, pos + ch->size, __ATOMIC_RELEASE);
+    return data;
+}
+
+/* Waiters bump n_waiters then retry under the mutex before sleeping, the
+ * other side publishes its cell then checks n_waiters. The seq_cst fences
+ * make sure at least one of them sees the other, and the mutex makes the
+ * wake up wait until the waiter is actually asleep on the cv */
+static void
+asl_channel_wake(asl_channel_t *ch, pthread_cond_t *cv) {
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ch->n_waiters, __ATOMIC_RELAXED)) {
+        pthread_mutex_lock(&ch->mutex);
+        pthread_cond_signal(cv);
+        pthread_mutex_unlock(&ch->mutex);
+    }
+}
+
+void
+asl_channel_push(asl_channel_t *ch, void *data) {
+
+    int spin;
+
+    assert(data);
+
+    for (spin = 0; spin < ASL_CHANNEL_SPIN; spin++) {
+        if (asl_channel_try_push(ch, data)) goto pushed;
+        asl_cpu_relax();
+    }
+
+    pthread_mutex_lock(&ch->mutex);
+    __atomic_add_fetch(&ch->n_waiters, 1, __ATOMIC_SEQ_CST);
+    while (!asl_channel_try_push(ch, data)) {
+        pthread_cond_wait(&ch->not_full, &ch->mutex);
+    }
+    __atomic_sub_fetch(&ch->n_waiters, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&ch->mutex);
+
+    pushed:
+    asl_channel_wake(ch, &ch->not_empty);
+}
+
+void *
+asl_channel_pop(asl_channel_t *ch) {
+
+    int spin;
+    void *data;
+
+    for (spin = 0; spin < ASL_CHANNEL_SPIN; spin++) {
+        if ((data = asl_channel_try_pop(ch))) goto popped;
+        asl_cpu_relax();
+    }
+
+    pthread_mutex_lock(&ch->mutex);
+    __atomic_add_fetch(&ch->n_waiters, 1, __ATOMIC_SEQ_CST);
+    while (!(data = asl_channel_try_pop(ch)) && !ch->closed) {
+        pthread_cond_wait(&ch->not_empty, &ch->mutex);
+    }
+    __atomic_sub_fetch(&ch->n_waiters, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&ch->mutex);
+
+    /* Closed, retry once as the last push may have landed just before */
+    if (!data && !(data = asl_channel_try_pop(ch))) return NULL;
+
+    popped:
+    asl_channel_wake(ch, &ch->not_full);
+    return data;
+}
+
+void *
+asl_channel_poll(asl_channel_t *ch) {
+
+    void *data;
+
+    if ((data = asl_channel_try_pop(ch))) {
+        asl_channel_wake(ch, &ch->not_full);
+    }
+    return data;
+}
+
+uint32_t
+asl_channel_count(asl_channel_t *ch) {
+
+    uint64_t tail = __atomic_load_n(&ch->tail, __ATOMIC_RELAXED);
+    uint64_t head = __atomic_load_n(&ch->head, __ATOMIC_RELAXED);
+
+    return tail > head ? (uint32_t)(tail - head) : 0;
+}
@@ -0,0 +1,94 @@
+#ifndef __ASL_CHANNEL__
+#define __ASL_CHANNEL__
+
+#include <stdint.h>
+#include <pthread.h>
+#include <stdbool.h>
+
+/*
+ * Bounded ring channel linking assembly line stages.
+ *
+ * Every cell carries a sequence number : a producer may fill the cell at
+ * position pos once its seq is pos, a consumer may drain it once its seq is
+ * pos + 1, after which it becomes pos + size for the next lap. A side
+ * declared single (one producer thread, or one consumer thread) advances its
+ * index with a plain store, a multi side with a CAS.
+ *
+ * A full channel blocks producers and an empty one blocks consumers, after a
+ * short spin, on a mutex/cv pair which is only touched when some thread is
+ * waiting, so the common case is lock free.
+ *
+ * Producers are counted, the channel closes when the last one closes its
+ * end and consumers then drain what is left before getting NULL. Pushed
+ * data must therefore never be NULL.
+ */
+
+#define ASL_CACHE_LINE      64
+#define ASL_CHANNEL_SPIN    128
+
+typedef struct asl_channel_cell_ {
+
+    uint64_t seq;
+    void *data;
+} asl_channel_cell_t;
+
+typedef struct asl_channel_ {
+
+    /* Next position to fill, written by producers only */
+    uint64_t tail __attribute__((aligned(ASL_CACHE_LINE)));
+    /* Next position to drain, written by consumers only */
+    uint64_t head __attribute__((aligned(ASL_CACHE_LINE)));
+    asl_channel_cell_t *cells __attribute__((aligned(ASL_CACHE_LINE)));
+    /* No of cells, power of 2 */
+    uint32_t size;
+    bool multi_producer;
+    bool multi_consumer;
+    /* Producer ends not closed yet */
+    uint32_t n_producers;
+    bool closed;
+    /* Threads blocked in push or pop */
+    uint32_t n_waiters;
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+} asl_channel_t;
+
+void
+asl_channel_init(asl_channel_t *ch, uint32_t size,
+                 bool multi_producer, bool multi_consumer);
+
+void
+asl_channel_destroy(asl_channel_t *ch);
+
+/* Declare one more producer end, before any push */
+void
+asl_channel_add_producer(asl_channel_t *ch);
+
+/* Close one producer end, the channel is closed with the last one */
+void
+asl_channel_close(asl_channel_t *ch);
+
+bool
+asl_channel_try_push(asl_channel_t *ch, void *data);
+
+void *
+asl_channel_try_pop(asl_channel_t *ch);
+
+/* Blocks while the channel is full */
+void
+asl_channel_push(asl_channel_t *ch, void *data);
+
+/* Blocks while the channel is empty, NULL once closed and drained */
+void *
+asl_channel_pop(asl_channel_t *ch);
+
+/* Never blocks, unlike asl_channel_try_pop( ) wakes up a producer blocked
+   in asl_channel_push( ) */
+void *
+asl_channel_poll(asl_channel_t *ch);
+
+/* Approximate when producers or consumers are running */
+uint32_t
+asl_channel_count(asl_channel_t *ch);
+
+#endif
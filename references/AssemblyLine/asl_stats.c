@@ -0,0 +1,241 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "asl.h"
+
+#ifdef ASL_STATS
+
+static uint64_t
+asl_hist_bucket_low(uint32_t bucket) {
+
+    uint32_t shift;
+
+    if (bucket < 2 * ASL_HIST_SUB_BUCKETS) return bucket;
+
+    shift = bucket / ASL_HIST_SUB_BUCKETS - 1;
+    return (uint64_t)(bucket % ASL_HIST_SUB_BUCKETS + ASL_HIST_SUB_BUCKETS) << shift;
+}
+
+static void
+asl_hist_copy(asl_hist_t *dst, asl_hist_t *src, uint64_t *total) {
+
+    uint32_t i;
+
+    *total = 0;
+    for (i = 0; i < ASL_HIST_N_BUCKETS; i++) {
+        dst->count[i] = __atomic_load_n(&src->count[i], __ATOMIC_RELAXED);
+        *total += dst->count[i];
+    }
+}
+
+/* Highest value of the bucket holding the given fraction of the values */
+static uint64_t
+asl_hist_percentile(asl_hist_t *hist, uint64_t total, double fraction) {
+
+    uint32_t i;
+    uint64_t seen = 0;
+    uint64_t rank = (uint64_t)(fraction * total + 0.5);
+
+    if (!total) return 0;
+    if (rank < 1) rank = 1;
+
+    for (i = 0; i < ASL_HIST_N_BUCKETS - 1; i++) {
+        seen += hist->count[i];
+        if (seen >= rank) break;
+    }
+    return asl_hist_bucket_low(i + 1) - 1;
+}
+
+static void
+asl_hist_summary(asl_hist_t *hist, double ns_per_tick, uint64_t *p50,
+                 uint64_t *p99, uint64_t *p999, uint64_t *max) {
+
+    uint64_t total;
+    /* Too big for the stack of the dump thread */
+    asl_hist_t *copy = (asl_hist_t *)malloc(sizeof(asl_hist_t));
+
+    asl_hist_copy(copy, hist, &total);
+    *p50 = asl_hist_percentile(copy, total, 0.50) * ns_per_tick;
+    *p99 = asl_hist_percentile(copy, total, 0.99) * ns_per_tick;
+    *p999 = asl_hist_percentile(copy, total, 0.999) * ns_per_tick;
+    *max = asl_hist_percentile(copy, total, 1.0) * ns_per_tick;
+    free(copy);
+}
+
+static double
+asl_stats_elapsed_sec(asl_t *asl, double *ns_per_tick) {
+
+    struct timespec now;
+    uint64_t ticks = asl_ticks() - asl->stats_start_ticks;
+    double ns;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ns = (now.tv_sec - asl->stats_start.tv_sec) * 1e9 +
+         (now.tv_nsec - asl->stats_start.tv_nsec);
+    *ns_per_tick = ticks ? ns / ticks : 1.0;
+    return ns / 1e9;
+}
+
+void
+asl_stats_init(asl_t *asl) {
+
+    clock_gettime(CLOCK_MONOTONIC, &asl->stats_start);
+    asl->stats_start_ticks = asl_ticks();
+    pthread_mutex_init(&asl->stats_mutex, NULL);
+    pthread_cond_init(&asl->stats_cv, NULL);
+}
+
+int
+asl_stats_snapshot(asl_t *asl, asl_stage_snapshot_t *snapshots, int max_stages) {
+
+    int i, n_stages = 0;
+    double ns_per_tick, elapsed;
+    asl_stage_t *asl_stage;
+    asl_stage_snapshot_t *snap;
+
+    for (asl_stage = asl->stages; asl_stage; asl_stage = asl_stage->asl_next) {
+        n_stages++;
+    }
+
+    elapsed = asl_stats_elapsed_sec(asl, &ns_per_tick);
+
+    /* asl->stages is newest first, report in creation order */
+    i = n_stages;
+    for (asl_stage = asl->stages; asl_stage; asl_stage = asl_stage->asl_next) {
+
+        if (--i >= max_stages) continue;
+
+        snap = &snapshots[i];
+        memcpy(snap->name, asl_stage->name, sizeof(snap->name));
+        snap->queue_depth = asl_channel_count(&asl_stage->in_channel);
+        snap->n_objects = __atomic_load_n(&asl_stage->stats.n_objects,
+                                          __ATOMIC_RELAXED);
+        snap->objects_per_sec = elapsed > 0 ? snap->n_objects / elapsed : 0;
+        asl_hist_summary(&asl_stage->stats.wait, ns_per_tick,
+                         &snap->wait_p50_ns, &snap->wait_p99_ns,
+                         &snap->wait_p999_ns, &snap->wait_max_ns);
+        asl_hist_summary(&asl_stage->stats.service, ns_per_tick,
+                         &snap->service_p50_ns, &snap->service_p99_ns,
+                         &snap->service_p999_ns, &snap->service_max_ns);
+    }
+    return n_stages;
+}
+
+/* prev, if not NULL, is the snapshot taken interval_sec earlier and the
+   rates are over that interval rather than since the start */
+static void
+asl_stats_print(asl_t *asl, FILE *out, asl_stage_snapshot_t *snaps,
+                asl_stage_snapshot_t *prev, int n_stages, double interval_sec) {
+
+    int i;
+    double rate;
+
+    fprintf(out, "asl %s :\n", asl->name);
+    fprintf(out, "  %-16s %6s %12s %10s   %-30s   %-30s\n",
+            "stage", "depth", "objects", "obj/sec",
+            "wait ns p50/p99/p99.9/max", "service ns p50/p99/p99.9/max");
+
+    for (i = 0; i < n_stages; i++) {
+
+        rate = snaps[i].objects_per_sec;
+        if (prev && interval_sec > 0) {
+            rate = (snaps[i].n_objects - prev[i].n_objects) / interval_sec;
+        }
+        fprintf(out, "  %-16s %6u %12llu %10.0f   %llu/%llu/%llu/%llu   %llu/%llu/%llu/%llu\n",
+                snaps[i].name, snaps[i].queue_depth,
+                (unsigned long long)snaps[i].n_objects, rate,
+                (unsigned long long)snaps[i].wait_p50_ns,
+                (unsigned long long)snaps[i].wait_p99_ns,
+                (unsigned long long)snaps[i].wait_p999_ns,
+                (unsigned long long)snaps[i].wait_max_ns,
+                (unsigned long long)snaps[i].service_p50_ns,
+                (unsigned long long)snaps[i].service_p99_ns,
+                (unsigned long long)snaps[i].service_p999_ns,
+                (unsigned long long)snaps[i].service_max_ns);
+    }
+    fflush(out);
+}
+
+void
+asl_stats_dump(asl_t *asl, FILE *out) {
+
+    int n_stages;
+    asl_stage_snapshot_t *snaps;
+
+    n_stages = asl_stats_snapshot(asl, NULL, 0);
+    snaps = (asl_stage_snapshot_t *)calloc(n_stages, sizeof(*snaps));
+    n_stages = asl_stats_snapshot(asl, snaps, n_stages);
+    asl_stats_print(asl, out, snaps, NULL, n_stages, 0);
+    free(snaps);
+}
+
+static void *
+asl_stats_dump_thread_fn(void *arg) {
+
+    int n_stages;
+    asl_t *asl = (asl_t *)arg;
+    asl_stage_snapshot_t *snaps, *prev, *tmp;
+    struct timespec deadline;
+
+    /* The stage graph is complete by the time a dump is requested */
+    n_stages = asl_stats_snapshot(asl, NULL, 0);
+    snaps = (asl_stage_snapshot_t *)calloc(n_stages, sizeof(*snaps));
+    prev = (asl_stage_snapshot_t *)calloc(n_stages, sizeof(*prev));
+
+    pthread_mutex_lock(&asl->stats_mutex);
+    clock_gettime(CLOCK_REALTIME, &deadline);
+
+    while (asl->stats_dump_running) {
+
+        deadline.tv_nsec += (long)(asl->stats_dump_period_ms % 1000) * 1000000;
+        deadline.tv_sec += asl->stats_dump_period_ms / 1000 +
+                           deadline.tv_nsec / 1000000000;
+        deadline.tv_nsec %= 1000000000;
+
+        while (asl->stats_dump_running &&
+               pthread_cond_timedwait(&asl->stats_cv, &asl->stats_mutex,
+                                      &deadline) == 0);
+        if (!asl->stats_dump_running) break;
+
+        asl_stats_snapshot(asl, snaps, n_stages);
+        asl_stats_print(asl, asl->stats_dump_out, snaps, prev, n_stages,
+                        asl->stats_dump_period_ms / 1000.0);
+        tmp = prev; prev = snaps; snaps = tmp;
+    }
+
+    pthread_mutex_unlock(&asl->stats_mutex);
+    free(snaps);
+    free(prev);
+    return NULL;
+}
+
+void
+asl_stats_start_dump(asl_t *asl, uint32_t period_ms, FILE *out) {
+
+    assert(!asl->stats_dump_running && period_ms);
+
+    asl->stats_dump_period_ms = period_ms;
+    asl->stats_dump_out = out;
+    asl->stats_dump_running = true;
+    pthread_create(&asl->stats_dump_thread, NULL, asl_stats_dump_thread_fn,
+                   (void *)asl);
+}
+
+void
+asl_stats_destroy(asl_t *asl) {
+
+    pthread_mutex_lock(&asl->stats_mutex);
+    if (asl->stats_dump_running) {
+        asl->stats_dump_running = false;
+        pthread_cond_signal(&asl->stats_cv);
+        pthread_mutex_unlock(&asl->stats_mutex);
+        pthread_join(asl->stats_dump_thread, NULL);
+    }
+    else {
+        pthread_mutex_unlock(&asl->stats_mutex);
+    }
+    pthread_mutex_destroy(&asl->stats_mutex);
+    pthread_cond_destroy(&asl->stats_cv);
+}
+
+#endif
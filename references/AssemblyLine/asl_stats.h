@@ -0,0 +1,120 @@
+#ifndef __ASL_STATS__
+#define __ASL_STATS__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * Per stage instrumentation of the assembly line, built with -DASL_STATS.
+ * Without it none of this is compiled and the stages carry no stats.
+ *
+ * Stages count every object, but time only one object in ASL_STATS_SAMPLE :
+ * the wrappers of the object pool are marked once at asl_create_new( ) and
+ * recycled in turn, so the timed objects are spread evenly and the others
+ * pay one test per stage. A timed object is stamped when it is queued to
+ * a stage, the stage worker records its wait (stamp to dequeue) and service
+ * (stage callback) times in two histograms of its own, so recording takes
+ * no lock and no atomic read-modify-write. Times are taken with the TSC
+ * where there is one, and turned into ns only when a snapshot is taken.
+ *
+ * Histograms are log-linear (HDR) : values below 2 * ASL_HIST_SUB_BUCKETS
+ * are exact, above that every power of 2 range is cut into
+ * ASL_HIST_SUB_BUCKETS buckets, i.e. about 3% precision on any value.
+ */
+
+/* 1 to time every object */
+#ifndef ASL_STATS_SAMPLE
+#define ASL_STATS_SAMPLE        64
+#endif
+
+#define ASL_HIST_SUB_BITS       5
+#define ASL_HIST_SUB_BUCKETS    (1 << ASL_HIST_SUB_BITS)
+/* Values of up to 2^ASL_HIST_MAX_BITS ticks, larger ones are clamped */
+#define ASL_HIST_MAX_BITS       42
+#define ASL_HIST_N_BUCKETS      \
+    ((ASL_HIST_MAX_BITS - ASL_HIST_SUB_BITS + 1) * ASL_HIST_SUB_BUCKETS)
+
+typedef struct asl_hist_ {
+
+    uint64_t count[ASL_HIST_N_BUCKETS];
+} asl_hist_t;
+
+/* Written by the stage worker only */
+typedef struct asl_stage_stats_ {
+
+    uint64_t n_objects;
+    asl_hist_t wait;
+    asl_hist_t service;
+} asl_stage_stats_t;
+
+/* Times are in ns, percentiles are the upper bound of their bucket and
+   are taken over the timed objects only */
+typedef struct asl_stage_snapshot_ {
+
+    char name[32];
+    /* Objects in the stage input channel */
+    uint32_t queue_depth;
+    uint64_t n_objects;
+    /* Average since asl_create_new( ) */
+    double objects_per_sec;
+    uint64_t wait_p50_ns;
+    uint64_t wait_p99_ns;
+    uint64_t wait_p999_ns;
+    uint64_t wait_max_ns;
+    uint64_t service_p50_ns;
+    uint64_t service_p99_ns;
+    uint64_t service_p999_ns;
+    uint64_t service_max_ns;
+} asl_stage_snapshot_t;
+
+static inline uint64_t
+asl_ticks(void) {
+
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+static inline uint32_t
+asl_hist_bucket(uint64_t value) {
+
+    uint32_t msb, shift;
+
+    if (value < 2 * ASL_HIST_SUB_BUCKETS) return (uint32_t)value;
+
+    msb = 63 - __builtin_clzll(value);
+    if (msb >= ASL_HIST_MAX_BITS) return ASL_HIST_N_BUCKETS - 1;
+
+    shift = msb - ASL_HIST_SUB_BITS;
+    return shift * ASL_HIST_SUB_BUCKETS + (uint32_t)(value >> shift);
+}
+
+/* Single writer, readers may load the counts concurrently */
+static inline void
+asl_hist_record(asl_hist_t *hist, uint64_t value) {
+
+    uint64_t *count = &hist->count[asl_hist_bucket(value)];
+
+    __atomic_store_n(count, *count + 1, __ATOMIC_RELAXED);
+}
+
+static inline void
+asl_stage_stats_count(asl_stage_stats_t *stats) {
+
+    __atomic_store_n(&stats->n_objects, stats->n_objects + 1, __ATOMIC_RELAXED);
+}
+
+static inline void
+asl_stage_stats_record(asl_stage_stats_t *stats,
+                       uint64_t wait_ticks, uint64_t service_ticks) {
+
+    asl_hist_record(&stats->wait, wait_ticks);
+    asl_hist_record(&stats->service, service_ticks);
+}
+
+#endif
@@ -1,8 +1,10 @@
 gcc -g -c Crud_algo.c -o Crud_algo.o
 gcc -g -c Crud_algo_skeleton.c -o Crud_algo_skeleton.o
 gcc -g -c refcount.c -o refcount.o
+gcc -g -c hazard_ptr.c -o hazard_ptr.o
 gcc -g -c student_list.c -o student_list.o
-gcc -g -c LinkedList/LinkedListApi.c -o LinkedList/LinkedListApi.o
+gcc -g -O2 -c student_list_bench.c -o student_list_bench.o
 
-gcc -g LinkedList/LinkedListApi.o Crud_algo.o refcount.o student_list.o -o Crud_algo.exe -lpthread
-gcc -g LinkedList/LinkedListApi.o Crud_algo_skeleton.o refcount.o student_list.o -o Crud_algo_skeleton.exe -lpthread
\ No newline at end of file
+gcc -g Crud_algo.o refcount.o hazard_ptr.o student_list.o -o Crud_algo.exe -lpthread
+gcc -g Crud_algo_skeleton.o refcount.o hazard_ptr.o student_list.o -o Crud_algo_skeleton.exe -lpthread
+gcc -g student_list_bench.o refcount.o hazard_ptr.o student_list.o -o student_list_bench.exe -lpthread
\ No newline at end of file
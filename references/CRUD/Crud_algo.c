@@ -45,26 +45,18 @@ reader_fn (void *arg) {
 
         roll_no = rand() % MAX_ROLL_NO;
 
-        pthread_rwlock_rdlock (&stud_lst.rw_lock);
-
-        stud = student_lst_lookup (&stud_lst, roll_no);
+        /* Lock free lookup, on success current thread got an access
+        to object */
+        stud = student_lst_lookup_get (&stud_lst, roll_no);
 
         if (!stud) {
             printf ("READ TH  ::  Roll No %u Do not Exist\n", roll_no);
-            pthread_rwlock_unlock (&stud_lst.rw_lock);
             continue;
         }
 
-        /* Current thread got an access to object */
-        thread_using_object(&stud->ref_count);
-
         /* prepare to perform Read Operation on student object */
         pthread_rwlock_rdlock(&stud->rw_lock);
 
-        /* Current thread has done all pre-requisites to perform read
-        opn on student object, unlock the container */
-        pthread_rwlock_unlock(&stud_lst.rw_lock);
-
         /* Now perform Read operation */
         printf ("READ TH  ::  Roll No %u is READ, total marks = %u\n", roll_no, stud->total_marks);
 
@@ -98,26 +90,18 @@ update_fn (void *arg) {
         
         roll_no = rand() % MAX_ROLL_NO;
 
-        pthread_rwlock_rdlock (&stud_lst.rw_lock);
-
-        stud = student_lst_lookup (&stud_lst, roll_no);
+        /* Lock free lookup, on success current thread got an access
+        to object */
+        stud = student_lst_lookup_get (&stud_lst, roll_no);
 
         if (!stud) {
             printf ("UPDATE TH  ::  Roll No %u Do not Exist\n", roll_no);
-            pthread_rwlock_unlock (&stud_lst.rw_lock);
             continue;
         }
 
-        /* Current thread got an access to object */
-        thread_using_object(&stud->ref_count);
-
         /* prepare to perform WRITE Operation on student object */
         pthread_rwlock_wrlock(&stud->rw_lock);
 
-        /* Current thread has done all pre-requisites to perform read
-        opn on student object, unlock the container */
-        pthread_rwlock_unlock(&stud_lst.rw_lock);
-
         /* Now perform UPDATE operation */
         uint32_t old_marks = stud->total_marks;
         stud->total_marks = stud->total_marks + INCR;
@@ -157,24 +141,31 @@ create_fn (void *arg) {
 
         roll_no = rand() % MAX_ROLL_NO;
 
-        pthread_rwlock_wrlock (&stud_lst.rw_lock);
-
+        /* Cheap check first, insert below re-checks under the bucket lock */
         new_stud = student_lst_lookup(&stud_lst, roll_no);
 
         if (new_stud) {
 
             printf ("CREATE TH :: Roll No %u CREATION Failed, Already Exist\n",
                 roll_no);
-            pthread_rwlock_unlock (&stud_lst.rw_lock);
             continue;
         }
 
         new_stud = student_malloc(roll_no);
-        assert(student_lst_insert(&stud_lst, new_stud));
+        /* Reference held by the list, taken before lock-free readers
+        can see the student */
         ref_count_inc(&new_stud->ref_count);
-        printf ("CREATE TH :: Roll No %u CREATION Success\n", new_stud->roll_no);
 
-        pthread_rwlock_unlock (&stud_lst.rw_lock);
+        if (!student_lst_insert(&stud_lst, new_stud)) {
+
+            printf ("CREATE TH :: Roll No %u CREATION Failed, Already Exist\n",
+                roll_no);
+            assert(ref_count_dec(&new_stud->ref_count));
+            student_destroy(new_stud);
+            continue;
+        }
+
+        printf ("CREATE TH :: Roll No %u CREATION Success\n", roll_no);
     }
 
     return NULL;
@@ -192,24 +183,20 @@ delete_fn (void *arg) {
 
         roll_no = rand() % MAX_ROLL_NO;
 
-        pthread_rwlock_wrlock (&stud_lst.rw_lock);
-
        stud = student_lst_remove (&stud_lst, roll_no);
 
        if (!stud) {
 
            printf("DELETE TH :: Roll No %u DELETION Failed, Do not Exist\n",
                   roll_no);
-           pthread_rwlock_unlock(&stud_lst.rw_lock);
            continue;
        }
 
         thread_using_object(&stud->ref_count);
 
+        /* Drop the reference the list handed over to us */
         assert(!ref_count_dec(&stud->ref_count));
 
-        pthread_rwlock_unlock(&stud_lst.rw_lock);
-
         printf("DELETE TH :: Roll No %u Removal Success\n", roll_no);
 
         /* Done using the object */
@@ -229,8 +216,7 @@ delete_fn (void *arg) {
 int
 main (int argc, char **argv) {
 
-    stud_lst.lst = init_singly_ll();
-    pthread_rwlock_init(&stud_lst.rw_lock, NULL);
+    student_lst_init(&stud_lst);
 
     loop_count[READER_TH] = 0;
     loop_count[UPDATE_TH] = 0;
@@ -60,8 +60,7 @@ delete_fn (void *arg) {
 int
 main (int argc, char **argv) {
 
-    stud_lst.lst = init_singly_ll();
-    pthread_rwlock_init(&stud_lst.rw_lock, NULL);
+    student_lst_init(&stud_lst);
 
     loop_count[READER_TH] = 0;
     loop_count[UPDATE_TH] = 0;
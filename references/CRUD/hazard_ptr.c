@@ -0,0 +1,188 @@
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include "hazard_ptr.h"
+
+typedef struct hazard_retired_ {
+
+    void *ptr;
+    hazard_free_fn_t free_fn;
+} hazard_retired_t;
+
+typedef struct hazard_rec_ {
+
+    _Atomic(void *) hp[HAZARD_PTR_PER_THREAD];
+    atomic_bool in_use;
+    struct hazard_rec_ *next;
+    /* Owned by the thread holding the record */
+    hazard_retired_t *retired;
+    uint32_t n_retired;
+    uint32_t max_retired;
+} hazard_rec_t;
+
+/* Records are only ever pushed, never unlinked, so the list can be walked
+   without a lock */
+static _Atomic(hazard_rec_t *) hazard_rec_head = NULL;
+
+static __thread hazard_rec_t *hazard_rec_self = NULL;
+static pthread_key_t hazard_rec_key;
+static pthread_once_t hazard_rec_key_once = PTHREAD_ONCE_INIT;
+
+static void
+hazard_rec_release (void *arg) {
+
+    hazard_rec_t *rec = (hazard_rec_t *)arg;
+
+    hazard_ptr_clear_all();
+    hazard_ptr_scan();
+    /* Whatever is still protected stays on the record, the next thread
+       to pick up the record frees it */
+    hazard_rec_self = NULL;
+    atomic_store_explicit(&rec->in_use, false, memory_order_release);
+}
+
+static void
+hazard_rec_key_init (void) {
+
+    pthread_key_create(&hazard_rec_key, hazard_rec_release);
+}
+
+static hazard_rec_t *
+hazard_rec_get (void) {
+
+    hazard_rec_t *rec;
+    bool expected;
+
+    if (hazard_rec_self) return hazard_rec_self;
+
+    pthread_once(&hazard_rec_key_once, hazard_rec_key_init);
+
+    /* Recycle the record of a thread which is gone */
+    for (rec = atomic_load_explicit(&hazard_rec_head, memory_order_acquire);
+         rec; rec = rec->next) {
+
+        expected = false;
+        if (atomic_load_explicit(&rec->in_use, memory_order_relaxed)) continue;
+        if (atomic_compare_exchange_strong_explicit(&rec->in_use, &expected, true,
+                memory_order_acquire, memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    if (!rec) {
+        rec = (hazard_rec_t *)calloc(1, sizeof(hazard_rec_t));
+        atomic_init(&rec->in_use, true);
+        rec->next = atomic_load_explicit(&hazard_rec_head, memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(&hazard_rec_head, &rec->next, rec,
+                    memory_order_release, memory_order_relaxed));
+    }
+
+    hazard_rec_self = rec;
+    pthread_setspecific(hazard_rec_key, rec);
+    return rec;
+}
+
+void
+hazard_ptr_set (uint32_t index, void *ptr) {
+
+    assert(index < HAZARD_PTR_PER_THREAD);
+    /* seq_cst : the store must be visible before the caller re-reads the
+       link it got ptr from, pairs with the fence in hazard_ptr_scan */
+    atomic_store(&hazard_rec_get()->hp[index], ptr);
+}
+
+void
+hazard_ptr_clear (uint32_t index) {
+
+    assert(index < HAZARD_PTR_PER_THREAD);
+    atomic_store_explicit(&hazard_rec_get()->hp[index], NULL, memory_order_release);
+}
+
+void
+hazard_ptr_clear_all (void) {
+
+    uint32_t i;
+    hazard_rec_t *rec = hazard_rec_get();
+
+    for (i = 0; i < HAZARD_PTR_PER_THREAD; i++) {
+        atomic_store_explicit(&rec->hp[i], NULL, memory_order_release);
+    }
+}
+
+static bool
+hazard_ptr_is_protected (void **protected, uint32_t n_protected, void *ptr) {
+
+    uint32_t i;
+
+    for (i = 0; i < n_protected; i++) {
+        if (protected[i] == ptr) return true;
+    }
+    return false;
+}
+
+void
+hazard_ptr_scan (void) {
+
+    hazard_rec_t *self = hazard_rec_get();
+    hazard_rec_t *head, *rec;
+    void **protected;
+    void *ptr;
+    uint32_t n_protected = 0, max_protected = 0, i, n_kept = 0;
+
+    if (!self->n_retired) return;
+
+    /* Objects were unlinked before being retired, make sure we read the
+       hazard slots after that */
+    atomic_thread_fence(memory_order_seq_cst);
+
+    /* Records are pushed at the head only, so the list hanging off one
+       loaded head never changes. Size the array by walking it, then fill it
+       from the same head. A record pushed since can only protect objects
+       which are still reachable, none of ours is */
+    head = atomic_load_explicit(&hazard_rec_head, memory_order_acquire);
+    for (rec = head; rec; rec = rec->next) {
+        max_protected += HAZARD_PTR_PER_THREAD;
+    }
+    protected = (void **)calloc(max_protected, sizeof(void *));
+
+    for (rec = head; rec; rec = rec->next) {
+
+        for (i = 0; i < HAZARD_PTR_PER_THREAD; i++) {
+            ptr = atomic_load(&rec->hp[i]);
+            if (ptr) protected[n_protected++] = ptr;
+        }
+    }
+
+    for (i = 0; i < self->n_retired; i++) {
+
+        if (hazard_ptr_is_protected(protected, n_protected, self->retired[i].ptr)) {
+            self->retired[n_kept++] = self->retired[i];
+            continue;
+        }
+        self->retired[i].free_fn(self->retired[i].ptr);
+    }
+
+    self->n_retired = n_kept;
+    free(protected);
+}
+
+void
+hazard_ptr_retire (void *ptr, hazard_free_fn_t free_fn) {
+
+    hazard_rec_t *rec = hazard_rec_get();
+
+    if (rec->n_retired == rec->max_retired) {
+        rec->max_retired = rec->max_retired ? rec->max_retired * 2 :
+                           HAZARD_PTR_SCAN_THRESHOLD;
+        rec->retired = (hazard_retired_t *)realloc(rec->retired,
+                            rec->max_retired * sizeof(hazard_retired_t));
+    }
+
+    rec->retired[rec->n_retired].ptr = ptr;
+    rec->retired[rec->n_retired].free_fn = free_fn;
+    rec->n_retired++;
+
+    if (rec->n_retired >= HAZARD_PTR_SCAN_THRESHOLD) {
+        hazard_ptr_scan();
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef __HAZARD_PTR__
+#define __HAZARD_PTR__
+
+/* Hazard pointers : safe memory reclamation for lock-free readers.
+
+    A reader publishes the address of the object it is about to dereference
+    in one of its hazard slots, then re-checks that the object is still
+    reachable. A writer which unlinks an object does not free it, it retires
+    it instead. Retired objects are freed in batches, skipping any object
+    which is still published in some thread's hazard slot.
+
+    Each thread gets its own hazard record the first time it uses the API,
+    records are recycled when threads exit. */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HAZARD_PTR_PER_THREAD   4
+#define HAZARD_PTR_SCAN_THRESHOLD   64  /* Retired objects before a scan */
+
+typedef void (*hazard_free_fn_t)(void *);
+
+/* Publish ptr in slot index of the calling thread. Once this returns, ptr
+   will not be freed as long as the caller re-validates that ptr is still
+   reachable before dereferencing it */
+void
+hazard_ptr_set (uint32_t index, void *ptr);
+
+void
+hazard_ptr_clear (uint32_t index);
+
+void
+hazard_ptr_clear_all (void);
+
+/* Hand over an unlinked object, free_fn(ptr) is called once no thread
+   has ptr published */
+void
+hazard_ptr_retire (void *ptr, hazard_free_fn_t free_fn);
+
+/* Try to free the calling thread's retired objects now */
+void
+hazard_ptr_scan (void);
+
+#endif
@@ -4,35 +4,42 @@
 void
 ref_count_init (ref_count_t *ref_count) {
 
-    ref_count->ref_count = 0;
-    pthread_spin_init(&ref_count->spinlock, PTHREAD_PROCESS_PRIVATE);
+    atomic_init(&ref_count->ref_count, 0);
 }
 
 void
 ref_count_inc (ref_count_t *ref_count) {
 
-    pthread_spin_lock(&ref_count->spinlock);
-    ref_count->ref_count++;
-    pthread_spin_unlock(&ref_count->spinlock);
+    /* Caller already holds a reference or owns the object, no ordering needed */
+    atomic_fetch_add_explicit(&ref_count->ref_count, 1, memory_order_relaxed);
+}
+
+bool
+ref_count_inc_not_zero (ref_count_t *ref_count) {
+
+    uint32_t old = atomic_load_explicit(&ref_count->ref_count, memory_order_relaxed);
+
+    do {
+        if (old == 0) return false;
+    } while (!atomic_compare_exchange_weak_explicit(&ref_count->ref_count, &old, old + 1,
+                memory_order_acquire, memory_order_relaxed));
+    return true;
 }
 
 bool
 ref_count_dec (ref_count_t *ref_count) {
 
-    bool rc;
-    pthread_spin_lock(&ref_count->spinlock);
-    assert(ref_count->ref_count);
-    ref_count->ref_count--;
-    rc = (ref_count->ref_count == 0) ? true : false; 
-    pthread_spin_unlock(&ref_count->spinlock);
-    return rc;
+    /* Release our writes to the object, and if we are the last one, acquire
+       everybody else's before the object is destroyed */
+    uint32_t old = atomic_fetch_sub_explicit(&ref_count->ref_count, 1, memory_order_acq_rel);
+    assert(old);
+    return (old == 1) ? true : false;
 }
 
 void
 ref_count_destroy (ref_count_t *ref_count) {
 
-    assert(ref_count->ref_count == 0);
-    pthread_spin_destroy(&ref_count->spinlock);
+    assert(atomic_load(&ref_count->ref_count) == 0);
 }
 
 void
@@ -45,4 +52,4 @@ bool
 thread_using_object_done (ref_count_t *ref_count) {
 
     return ref_count_dec(ref_count);
-}
\ No newline at end of file
+}
@@ -1,14 +1,13 @@
 #ifndef __REF_COUNT__
 #define __REF_COUNT__
 
-#include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdbool.h>
 
 typedef struct ref_count_ {
 
-    uint32_t ref_count;
-    pthread_spinlock_t spinlock;
+    _Atomic uint32_t ref_count;
 }ref_count_t;
 
 void
@@ -17,6 +16,11 @@ ref_count_init (ref_count_t *ref_count);
 void
 ref_count_inc (ref_count_t *ref_count);
 
+/* Increments only if the ref_count is not already zero, i.e. the object is
+   not being destroyed. Returns true if the reference was taken */
+bool
+ref_count_inc_not_zero (ref_count_t *ref_count);
+
 /* Returns true if the value if ref_count  after dec is zero*/
 bool
 ref_count_dec (ref_count_t *ref_count);
@@ -30,4 +34,4 @@ thread_using_object (ref_count_t *ref_count);
 bool
 thread_using_object_done (ref_count_t *ref_count);
 
-#endif 
\ No newline at end of file
+#endif 
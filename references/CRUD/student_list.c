@@ -2,7 +2,28 @@
 #include <assert.h>
 #include "student_list.h"
 
-static uint32_t student_object_count = 0;
+#define STUD_REMOVED    ((uintptr_t)1)
+/* Value of an old bucket head once its students moved to the new table */
+#define STUD_MOVED      ((uintptr_t)2)
+#define STUD_PTR(link)  ((student_t *)((link) & ~STUD_REMOVED))
+
+/* Hazard slots */
+#define STUD_HP_PREV    0
+#define STUD_HP_CURR    1
+#define STUD_HP_TBL     2
+#define STUD_HP_OLD     3
+
+typedef struct stud_tbl_ {
+
+    uint32_t n_buckets;
+    /* Table whose buckets are being moved into this one, NULL once done */
+    _Atomic(struct stud_tbl_ *) old;
+    atomic_uint migrate_next;
+    atomic_uint n_migrated;
+    _Atomic uintptr_t buckets[];
+} stud_tbl_t;
+
+static atomic_uint student_objects = 0;
 
 student_t *
 student_malloc (uint32_t roll_no) {
@@ -12,59 +33,435 @@ student_malloc (uint32_t roll_no) {
     new_stud->total_marks = 0;
     ref_count_init(&new_stud->ref_count);
     pthread_rwlock_init(&new_stud->rw_lock, NULL);
-    student_object_count++;
+    atomic_init(&new_stud->next, 0);
+    atomic_fetch_add_explicit(&student_objects, 1, memory_order_relaxed);
     return new_stud;
 }
 
+static void
+student_free (void *arg) {
+
+    student_t *stud = (student_t *)arg;
+
+    pthread_rwlock_destroy(&stud->rw_lock);
+    free(stud);
+}
 
 void
 student_destroy (student_t *stud) {
 
-    assert(stud->ref_count.ref_count == 0);
+    assert(atomic_load(&stud->ref_count.ref_count) == 0);
     ref_count_destroy(&stud->ref_count);
-    pthread_rwlock_destroy(&stud->rw_lock);
-    free(stud);
-    student_object_count--;
+    atomic_fetch_sub_explicit(&student_objects, 1, memory_order_relaxed);
+    /* A reader which found stud before it was removed may still be reading
+       its roll_no or trying to take a reference */
+    hazard_ptr_retire(stud, student_free);
 }
 
-student_t *
-student_lst_lookup (stud_lst_t *stud_lst, uint32_t roll_no) {
+uint32_t
+student_object_count (void) {
+
+    return atomic_load_explicit(&student_objects, memory_order_relaxed);
+}
+
+static inline uint32_t
+student_hash (uint32_t roll_no) {
+
+    /* murmur3 finalizer, roll numbers are often sequential */
+    roll_no ^= roll_no >> 16;
+    roll_no *= 0x85ebca6b;
+    roll_no ^= roll_no >> 13;
+    roll_no *= 0xc2b2ae35;
+    roll_no ^= roll_no >> 16;
+    return roll_no;
+}
 
+static stud_tbl_t *
+student_tbl_alloc (uint32_t n_buckets) {
+
+    stud_tbl_t *tbl = (stud_tbl_t *)calloc(1, sizeof(stud_tbl_t) +
+                                            n_buckets * sizeof(_Atomic uintptr_t));
+    tbl->n_buckets = n_buckets;
+    return tbl;
+}
+
+static void
+student_tbl_free (void *arg) {
+
+    free(arg);
+}
+
+void
+student_lst_init_size (stud_lst_t *stud_lst, uint32_t n_buckets) {
+
+    uint32_t i, size = 1;
+
+    while (size < n_buckets) size <<= 1;
+
+    atomic_init(&stud_lst->tbl, student_tbl_alloc(size));
+    atomic_init(&stud_lst->count, 0);
+    /* A stripe must never split a bucket, tables only grow so it is
+       enough to check against the initial size */
+    stud_lst->stripe_mask = (size < STUD_LST_N_STRIPES ? size : STUD_LST_N_STRIPES) - 1;
+    pthread_mutex_init(&stud_lst->resize_mutex, NULL);
+
+    for (i = 0; i < STUD_LST_N_STRIPES; i++) {
+        pthread_mutex_init(&stud_lst->stripes[i].mutex, NULL);
+        atomic_init(&stud_lst->stripes[i].seq, 0);
+    }
+}
+
+void
+student_lst_init (stud_lst_t *stud_lst) {
+
+    student_lst_init_size(stud_lst, STUD_LST_DEFAULT_BUCKETS);
+}
+
+void
+student_lst_destroy (stud_lst_t *stud_lst) {
+
+    uint32_t i;
+    stud_tbl_t *tbl = atomic_load(&stud_lst->tbl);
+
+    assert(atomic_load(&stud_lst->count) == 0);
+    if (atomic_load(&tbl->old)) free(atomic_load(&tbl->old));
+    free(tbl);
+    pthread_mutex_destroy(&stud_lst->resize_mutex);
+
+    for (i = 0; i < STUD_LST_N_STRIPES; i++) {
+        pthread_mutex_destroy(&stud_lst->stripes[i].mutex);
+    }
+}
+
+uint32_t
+student_lst_count (stud_lst_t *stud_lst) {
+
+    return atomic_load_explicit(&stud_lst->count, memory_order_relaxed);
+}
+
+/* Current table, and the one being migrated into it if any, both
+   protected by the calling thread's hazard pointers */
+static stud_tbl_t *
+student_lst_tables (stud_lst_t *stud_lst, stud_tbl_t **old) {
+
+    stud_tbl_t *tbl, *old_tbl;
+
+    do {
+        tbl = atomic_load_explicit(&stud_lst->tbl, memory_order_acquire);
+        hazard_ptr_set(STUD_HP_TBL, tbl);
+    } while (atomic_load(&stud_lst->tbl) != tbl);
+
+    if (!old) return tbl;
+
+    do {
+        old_tbl = atomic_load_explicit(&tbl->old, memory_order_acquire);
+        if (!old_tbl) break;
+        hazard_ptr_set(STUD_HP_OLD, old_tbl);
+    } while (atomic_load(&tbl->old) != old_tbl);
+
+    *old = old_tbl;
+    return tbl;
+}
+
+uint32_t
+student_lst_n_buckets (stud_lst_t *stud_lst) {
+
+    uint32_t n_buckets;
+
+    n_buckets = student_lst_tables(stud_lst, NULL)->n_buckets;
+    hazard_ptr_clear(STUD_HP_TBL);
+    return n_buckets;
+}
+
+/* Move the students of old bucket index into tbl. Caller holds the
+   stripe lock of the bucket */
+static void
+student_tbl_migrate_bucket (stud_lst_t *stud_lst, stud_tbl_t *tbl,
+                            stud_tbl_t *old, uint32_t index) {
+
+    stud_lst_stripe_t *stripe = &stud_lst->stripes[index & stud_lst->stripe_mask];
+    _Atomic uintptr_t *dst;
     student_t *stud;
-    singly_ll_node_t *node1, *node2;
+    uintptr_t next;
+    uint32_t seq;
+
+    if (atomic_load_explicit(&old->buckets[index], memory_order_relaxed) == STUD_MOVED) {
+        return;
+    }
 
-    ITERATE_LIST_BEGIN2(stud_lst->lst, node1, node2) {
+    /* Readers of the stripe which miss a student while seq moved retry,
+       they may have been walking a chain we were relinking */
+    seq = atomic_load_explicit(&stripe->seq, memory_order_relaxed);
+    atomic_store_explicit(&stripe->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
 
-        stud = (student_t *)(node1->data);
-        if (stud->roll_no == roll_no) return stud;
+    /* From now on readers look for these students in the new table */
+    next = atomic_exchange_explicit(&old->buckets[index], STUD_MOVED, memory_order_acq_rel);
 
-    } ITERATE_LIST_END2(stud_lst->lst, node1, node2) ;
+    for (stud = STUD_PTR(next); stud; stud = STUD_PTR(next)) {
 
-    return NULL;
+        next = atomic_load_explicit(&stud->next, memory_order_relaxed);
+        dst = &tbl->buckets[student_hash(stud->roll_no) & (tbl->n_buckets - 1)];
+        atomic_store_explicit(&stud->next,
+            atomic_load_explicit(dst, memory_order_relaxed), memory_order_release);
+        atomic_store_explicit(dst, (uintptr_t)stud, memory_order_release);
+    }
+
+    atomic_store_explicit(&stripe->seq, seq + 2, memory_order_release);
+
+    /* Last bucket moved, nobody can reach the old table from here on */
+    if (atomic_fetch_add(&tbl->n_migrated, 1) + 1 == old->n_buckets) {
+        atomic_store(&tbl->old, NULL);
+        hazard_ptr_retire(old, student_tbl_free);
+    }
+}
+
+/* Help the ongoing resize, if any, along by a few buckets */
+static void
+student_lst_migrate_step (stud_lst_t *stud_lst) {
+
+    stud_tbl_t *tbl, *old = NULL;
+    stud_lst_stripe_t *stripe;
+    uint32_t i, index;
+
+    for (i = 0; i < STUD_LST_MIGRATE_STEP; i++) {
+
+        tbl = student_lst_tables(stud_lst, &old);
+        if (!old) break;
+
+        index = atomic_fetch_add(&tbl->migrate_next, 1);
+        if (index >= old->n_buckets) break;
+
+        stripe = &stud_lst->stripes[index & stud_lst->stripe_mask];
+        pthread_mutex_lock(&stripe->mutex);
+        student_tbl_migrate_bucket(stud_lst, tbl, old, index);
+        pthread_mutex_unlock(&stripe->mutex);
+    }
+}
+
+static void
+student_lst_resize (stud_lst_t *stud_lst) {
+
+    stud_tbl_t *tbl, *new_tbl;
+
+    pthread_mutex_lock(&stud_lst->resize_mutex);
+
+    tbl = student_lst_tables(stud_lst, NULL);
+
+    /* One resize at a time, the previous one must have moved all its
+       buckets first */
+    if (atomic_load(&tbl->old) ||
+        atomic_load(&stud_lst->count) <= tbl->n_buckets * STUD_LST_LOAD_FACTOR) {
+        pthread_mutex_unlock(&stud_lst->resize_mutex);
+        return;
+    }
+
+    new_tbl = student_tbl_alloc(tbl->n_buckets * 2);
+    atomic_init(&new_tbl->old, tbl);
+    atomic_store_explicit(&stud_lst->tbl, new_tbl, memory_order_release);
+
+    pthread_mutex_unlock(&stud_lst->resize_mutex);
+}
+
+/* Locks the stripe of hash and returns the bucket of hash in the current
+   table, with the students of its old bucket moved over if needed */
+static _Atomic uintptr_t *
+student_lst_bucket_lock (stud_lst_t *stud_lst, uint32_t hash) {
+
+    stud_tbl_t *tbl, *old = NULL;
+    _Atomic uintptr_t *bucket;
+
+    pthread_mutex_lock(&stud_lst->stripes[hash & stud_lst->stripe_mask].mutex);
+
+    while (1) {
+
+        tbl = student_lst_tables(stud_lst, &old);
+        if (old) {
+            student_tbl_migrate_bucket(stud_lst, tbl, old, hash & (old->n_buckets - 1));
+        }
+
+        /* A bucket of the current table can only be moved under the stripe
+           lock, if it was moved tbl got replaced before we locked */
+        bucket = &tbl->buckets[hash & (tbl->n_buckets - 1)];
+        if (atomic_load_explicit(bucket, memory_order_relaxed) != STUD_MOVED) {
+            return bucket;
+        }
+    }
+}
+
+static void
+student_lst_bucket_unlock (stud_lst_t *stud_lst, uint32_t hash) {
+
+    pthread_mutex_unlock(&stud_lst->stripes[hash & stud_lst->stripe_mask].mutex);
+    hazard_ptr_clear_all();
+}
+
+static student_t *
+student_lst_find (stud_lst_t *stud_lst, uint32_t roll_no, bool get_ref) {
+
+    uint32_t hash = student_hash(roll_no);
+    stud_lst_stripe_t *stripe = &stud_lst->stripes[hash & stud_lst->stripe_mask];
+    stud_tbl_t *tbl, *old;
+    _Atomic uintptr_t *prev_link;
+    student_t *curr;
+    uintptr_t next;
+    uint32_t seq;
+
+retry:
+    seq = atomic_load_explicit(&stripe->seq, memory_order_acquire);
+    if (seq & 1) goto retry;
+
+    old = NULL;
+    tbl = student_lst_tables(stud_lst, &old);
+
+    prev_link = NULL;
+    if (old) {
+        prev_link = &old->buckets[hash & (old->n_buckets - 1)];
+        if (atomic_load_explicit(prev_link, memory_order_acquire) == STUD_MOVED) {
+            prev_link = NULL;
+        }
+    }
+    if (!prev_link) {
+        prev_link = &tbl->buckets[hash & (tbl->n_buckets - 1)];
+    }
+
+    next = atomic_load_explicit(prev_link, memory_order_acquire);
+    /* tbl got replaced and this bucket already moved to its successor */
+    if (next == STUD_MOVED) goto retry;
+    curr = STUD_PTR(next);
+
+    while (curr) {
+
+        /* Protect curr, then check it is still linked from prev. prev is
+           itself protected, and its link would carry the removed bit had
+           prev been removed in the meantime */
+        hazard_ptr_set(STUD_HP_CURR, curr);
+        if (atomic_load_explicit(prev_link, memory_order_acquire) != (uintptr_t)curr) {
+            goto retry;
+        }
+
+        next = atomic_load_explicit(&curr->next, memory_order_acquire);
+        if (next & STUD_REMOVED) goto retry;
+
+        if (curr->roll_no == roll_no) {
+            break;
+        }
+
+        /* curr becomes prev, swap the hazard slots' roles */
+        hazard_ptr_set(STUD_HP_PREV, curr);
+        prev_link = &curr->next;
+        curr = STUD_PTR(next);
+    }
+
+    if (!curr) {
+        /* The chain may have been relinked into the new table under us */
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&stripe->seq, memory_order_relaxed) != seq) {
+            goto retry;
+        }
+        hazard_ptr_clear_all();
+        return NULL;
+    }
+
+    if (!get_ref) {
+        hazard_ptr_clear_all();
+        return curr;
+    }
+
+    /* A zero ref_count means the student is on its way to destruction */
+    if (!ref_count_inc_not_zero(&curr->ref_count)) {
+        curr = NULL;
+    }
+    /* Removed after we found it, do not hand out a student whose deletion
+       is deferred */
+    else if (atomic_load_explicit(&curr->next, memory_order_acquire) & STUD_REMOVED) {
+        if (thread_using_object_done(&curr->ref_count)) {
+            student_destroy(curr);
+        }
+        curr = NULL;
+    }
+
+    /* Our reference keeps curr alive from here on */
+    hazard_ptr_clear_all();
+    return curr;
+}
+
+student_t *
+student_lst_lookup (stud_lst_t *stud_lst, uint32_t roll_no) {
+
+    return student_lst_find(stud_lst, roll_no, false);
+}
+
+student_t *
+student_lst_lookup_get (stud_lst_t *stud_lst, uint32_t roll_no) {
+
+    return student_lst_find(stud_lst, roll_no, true);
 }
 
 bool
 student_lst_insert (stud_lst_t *stud_lst, student_t *stud) {
 
-    student_t *stud2 = student_lst_lookup(stud_lst, stud->roll_no);
-    if (stud2) {
-        return false;
+    uint32_t hash = student_hash(stud->roll_no);
+    _Atomic uintptr_t *bucket = student_lst_bucket_lock(stud_lst, hash);
+    student_t *stud2;
+    uint32_t count;
+
+    for (stud2 = STUD_PTR(atomic_load_explicit(bucket, memory_order_relaxed));
+         stud2;
+         stud2 = STUD_PTR(atomic_load_explicit(&stud2->next, memory_order_relaxed))) {
+
+        if (stud2->roll_no == stud->roll_no) {
+            student_lst_bucket_unlock(stud_lst, hash);
+            return false;
+        }
     }
 
-    singly_ll_add_node_by_val(stud_lst->lst, stud);
+    atomic_store_explicit(&stud->next,
+        atomic_load_explicit(bucket, memory_order_relaxed), memory_order_relaxed);
+    /* Publish stud fully initialized to lock-free readers */
+    atomic_store_explicit(bucket, (uintptr_t)stud, memory_order_release);
+    count = atomic_fetch_add(&stud_lst->count, 1) + 1;
+
+    student_lst_bucket_unlock(stud_lst, hash);
+
+    if (count > student_lst_n_buckets(stud_lst) * STUD_LST_LOAD_FACTOR) {
+        student_lst_resize(stud_lst);
+    }
+    student_lst_migrate_step(stud_lst);
+    hazard_ptr_clear_all();
     return true;
 }
 
 student_t *
 student_lst_remove (stud_lst_t *stud_lst, uint32_t roll_no) {
 
-    student_t *stud = student_lst_lookup(stud_lst, roll_no);
+    uint32_t hash = student_hash(roll_no);
+    _Atomic uintptr_t *prev_link = student_lst_bucket_lock(stud_lst, hash);
+    student_t *stud;
+    uintptr_t next;
+
+    /* Students reachable under the stripe lock are never marked removed */
+    for (stud = STUD_PTR(atomic_load_explicit(prev_link, memory_order_relaxed));
+         stud;
+         stud = STUD_PTR(atomic_load_explicit(prev_link, memory_order_relaxed))) {
+
+        if (stud->roll_no == roll_no) break;
+        prev_link = &stud->next;
+    }
 
     if (!stud) {
+        student_lst_bucket_unlock(stud_lst, hash);
         return NULL;
     }
 
-    singly_ll_delete_node_by_data_ptr (stud_lst->lst, stud);
+    /* Mark first so that readers standing on stud restart, then unlink */
+    next = atomic_fetch_or_explicit(&stud->next, STUD_REMOVED, memory_order_acq_rel);
+    atomic_store_explicit(prev_link, next, memory_order_release);
+    atomic_fetch_sub(&stud_lst->count, 1);
+
+    student_lst_bucket_unlock(stud_lst, hash);
+
+    student_lst_migrate_step(stud_lst);
+    hazard_ptr_clear_all();
     return stud;
 }
-
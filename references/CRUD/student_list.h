@@ -1,7 +1,7 @@
 #include <stdint.h>
 #include <pthread.h>
 #include "refcount.h"
-#include "LinkedList/LinkedListApi.h"
+#include "hazard_ptr.h"
 
 typedef struct student_ {
 
@@ -9,25 +9,87 @@ typedef struct student_ {
     uint32_t total_marks;
     ref_count_t ref_count;
     pthread_rwlock_t rw_lock;
+    /* Next student in the hash bucket. Low bit set once the student is
+       removed from the table, see student_lst_remove() */
+    _Atomic uintptr_t next;
 }student_t;
 
 student_t *
 student_malloc (uint32_t roll_no);
 
+#define STUD_LST_N_STRIPES          64
+#define STUD_LST_DEFAULT_BUCKETS    64
+#define STUD_LST_LOAD_FACTOR        2   /* Students per bucket before the table grows */
+#define STUD_LST_MIGRATE_STEP       2   /* Buckets moved to the new table per insert/remove */
+
+typedef struct stud_lst_stripe_ {
+
+    pthread_mutex_t mutex;
+    /* Odd while a bucket of the stripe is being moved to a new table */
+    atomic_uint seq;
+} __attribute__((aligned(64))) stud_lst_stripe_t;
+
+/* Hash table of students.
+
+    Readers traverse buckets without any lock, protected by hazard pointers.
+    Writers (insert/remove) lock the stripe of the roll_no's bucket, a
+    stripe covers every STUD_LST_N_STRIPES-th bucket.
+
+    The table doubles once it holds more than STUD_LST_LOAD_FACTOR students
+    per bucket. The resize is incremental : the new table is published at
+    once, then old buckets are moved over a few at a time by subsequent
+    inserts/removes, or on demand by the writer which needs one. */
 typedef struct stud_lst_ {
 
-    ll_t *lst;
-    pthread_rwlock_t rw_lock;
+    _Atomic(struct stud_tbl_ *) tbl;
+    atomic_uint count;
+    uint32_t stripe_mask;
+    pthread_mutex_t resize_mutex;
+    stud_lst_stripe_t stripes[STUD_LST_N_STRIPES];
 } stud_lst_t;
 
+void
+student_lst_init (stud_lst_t *stud_lst);
+
+/* n_buckets is rounded up to a power of 2 */
+void
+student_lst_init_size (stud_lst_t *stud_lst, uint32_t n_buckets);
+
+/* The list must be empty and no longer in use */
+void
+student_lst_destroy (stud_lst_t *stud_lst);
+
+uint32_t
+student_lst_count (stud_lst_t *stud_lst);
+
+uint32_t
+student_lst_n_buckets (stud_lst_t *stud_lst);
+
+/* Drops the student, the memory is reclaimed once no lock-free reader
+   can be looking at it anymore */
 void
 student_destroy (student_t *stud) ;
 
+uint32_t
+student_object_count (void);
+
+/* Lock free existence check. No reference is taken, the student returned
+   must not be dereferenced unless the caller otherwise keeps it alive */
 student_t *
 student_lst_lookup (stud_lst_t *stud_lst, uint32_t roll_no) ;
 
+/* Lock free lookup. Returns the student with a reference taken on behalf
+   of the caller, who must release it with thread_using_object_done().
+   Returns NULL if the student does not exist or is being deleted */
+student_t *
+student_lst_lookup_get (stud_lst_t *stud_lst, uint32_t roll_no) ;
+
+/* Returns false if a student with the same roll_no is already present.
+   The caller's reference on stud is handed over to the list */
 bool
 student_lst_insert (stud_lst_t *stud_lst, student_t *stud) ;
 
+/* Returns the removed student, the list's reference is handed over to
+   the caller */
 student_t *
 student_lst_remove (stud_lst_t *stud_lst, uint32_t roll_no);
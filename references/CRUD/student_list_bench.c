@@ -0,0 +1,170 @@
+/* Benchmark for the student hash table.
+    Threads pick random roll numbers among 2 x n_students and do lookups
+    (80%), inserts (10%) or removes (10%), so the table stays around
+    n_students. We report operations per second for a table created with
+    a single bucket, hence a single lock stripe, and for one created with
+    STUD_LST_N_STRIPES buckets. Both grow to the same size.
+    Usage : ./student_list_bench.exe [max_threads] [run_ms] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include "student_list.h"
+
+#define BENCH_MAX_THREADS   64
+#define BENCH_LOOKUP_PCT    80
+#define BENCH_INSERT_PCT    10
+
+typedef struct bench_thread_ {
+
+    pthread_t thread;
+    unsigned int seed;
+    uint64_t n_ops;
+    uint64_t checksum;
+} bench_thread_t;
+
+static stud_lst_t stud_lst;
+static uint32_t n_keys;
+static atomic_bool bench_stop;
+
+static void
+bench_drop (student_t *stud) {
+
+    if (thread_using_object_done(&stud->ref_count)) {
+        student_destroy(stud);
+    }
+}
+
+static bool
+bench_insert (uint32_t roll_no) {
+
+    student_t *stud = student_malloc(roll_no);
+
+    ref_count_inc(&stud->ref_count);
+    if (student_lst_insert(&stud_lst, stud)) return true;
+    bench_drop(stud);
+    return false;
+}
+
+static void *
+bench_thread_fn (void *arg) {
+
+    bench_thread_t *bt = (bench_thread_t *)arg;
+    student_t *stud;
+    uint32_t roll_no, op;
+
+    while (!atomic_load_explicit(&bench_stop, memory_order_relaxed)) {
+
+        roll_no = rand_r(&bt->seed) % n_keys;
+        op = rand_r(&bt->seed) % 100;
+
+        if (op < BENCH_LOOKUP_PCT) {
+            stud = student_lst_lookup_get(&stud_lst, roll_no);
+            if (stud) {
+                pthread_rwlock_rdlock(&stud->rw_lock);
+                bt->checksum += stud->total_marks;
+                pthread_rwlock_unlock(&stud->rw_lock);
+                bench_drop(stud);
+            }
+        }
+        else if (op < BENCH_LOOKUP_PCT + BENCH_INSERT_PCT) {
+            bench_insert(roll_no);
+        }
+        else {
+            stud = student_lst_remove(&stud_lst, roll_no);
+            if (stud) bench_drop(stud);
+        }
+        bt->n_ops++;
+    }
+
+    /* Free what this thread retired */
+    hazard_ptr_scan();
+    return NULL;
+}
+
+static double
+bench_now_sec (void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double
+bench_run (uint32_t n_buckets, uint32_t n_students, int n_threads, int run_ms,
+           uint32_t *final_buckets) {
+
+    bench_thread_t bt[BENCH_MAX_THREADS];
+    student_t *stud;
+    uint64_t n_ops = 0;
+    double start, elapsed;
+    uint32_t i;
+    int t;
+
+    student_lst_init_size(&stud_lst, n_buckets);
+    n_keys = n_students * 2;
+    for (i = 0; i < n_students; i++) {
+        bench_insert(i * 2);
+    }
+
+    atomic_store(&bench_stop, false);
+    start = bench_now_sec();
+    for (t = 0; t < n_threads; t++) {
+        bt[t].seed = t + 1;
+        bt[t].n_ops = 0;
+        bt[t].checksum = 0;
+        pthread_create(&bt[t].thread, NULL, bench_thread_fn, &bt[t]);
+    }
+    usleep(run_ms * 1000);
+    atomic_store(&bench_stop, true);
+
+    for (t = 0; t < n_threads; t++) {
+        pthread_join(bt[t].thread, NULL);
+        n_ops += bt[t].n_ops;
+    }
+    elapsed = bench_now_sec() - start;
+
+    *final_buckets = student_lst_n_buckets(&stud_lst);
+    for (i = 0; i < n_keys; i++) {
+        stud = student_lst_remove(&stud_lst, i);
+        if (stud) bench_drop(stud);
+    }
+    hazard_ptr_scan();
+    student_lst_destroy(&stud_lst);
+    return n_ops / elapsed;
+}
+
+int
+main (int argc, char **argv) {
+
+    int max_threads = (argc > 1) ? atoi(argv[1]) : 8;
+    int run_ms = (argc > 2) ? atoi(argv[2]) : 300;
+    uint32_t students[] = {64, 4096, 262144};
+    uint32_t final_buckets;
+    size_t s;
+    int n_threads;
+    double single, striped;
+
+    if (max_threads < 1 || max_threads > BENCH_MAX_THREADS) max_threads = 8;
+
+    printf("%9s %8s %16s %16s %9s\n", "students", "threads",
+           "1 stripe ops/s", "striped ops/s", "buckets");
+
+    for (s = 0; s < sizeof(students) / sizeof(students[0]); s++) {
+
+        for (n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+
+            single = bench_run(1, students[s], n_threads, run_ms, &final_buckets);
+            striped = bench_run(STUD_LST_N_STRIPES, students[s], n_threads, run_ms,
+                                &final_buckets);
+            printf("%9u %8d %16.0f %16.0f %9u\n", students[s], n_threads,
+                   single, striped, final_buckets);
+            fflush(stdout);
+        }
+    }
+
+    assert(student_object_count() == 0);
+    return 0;
+}
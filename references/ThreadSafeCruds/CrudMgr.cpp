@@ -7,6 +7,7 @@
 #include "CrudMgr.h"
 
 static bool logging = true;
+#define crud_log(...) do { if (logging) printf (__VA_ARGS__); } while (0)
 #define IMPOSSIBLE_CASE assert(0)
 
 /*
@@ -34,7 +35,42 @@ static uint16_t crud_node_id = 1;
 static uint16_t
 crud_node_get_unique_id () {
 
-    return crud_node_id++;
+    return __atomic_fetch_add (&crud_node_id, 1, __ATOMIC_RELAXED);
+}
+
+/* Locks the mutex which guards the manager level list of this state and returns it.
+    lock is false when the caller already holds the crud mgr state_mutex. Shard
+    mutexes are always taken after the crud mgr state_mutex, never before */
+static pthread_mutex_t *
+crud_mgr_state_lock (crud_node_t *crud_node, crud_node_state_t state, bool lock) {
+
+    pthread_mutex_t *mutex = NULL;
+
+    if (crud_node->shard && !crud_node_state_is_global (state)) {
+        mutex = &crud_node->shard->state_mutex;
+    }
+    else if (lock) {
+        mutex = &crud_node->crud_mgr->state_mutex;
+    }
+
+    if (mutex) pthread_mutex_lock (mutex);
+    return mutex;
+}
+
+static inline void
+crud_mgr_state_unlock (pthread_mutex_t *mutex) {
+
+    if (mutex) pthread_mutex_unlock (mutex);
+}
+
+/* Manager level list of the nodes in this state */
+static inline glthread_t *
+crud_mgr_state_list (crud_node_t *crud_node, crud_node_state_t state) {
+
+    if (crud_node->shard && !crud_node_state_is_global (state)) {
+        return &crud_node->shard->crud_nodes_list[crud_node_state_to_index(state)];
+    }
+    return &crud_node->crud_mgr->crud_nodes_list[crud_node_state_to_index(state)];
 }
 
 static inline void
@@ -114,12 +150,104 @@ crud_node_state_verify (crud_node_t *crud_node, crud_node_state_t state, bool is
 }
 
 
+/* Fast path : grant an uncontended Read with one CAS on the fast word. Fails if
+    a writer holds the node or the node is handed over to the slow path */
+static inline bool
+crud_node_fast_read (crud_node_t *crud_node) {
+
+    uint64_t word = __atomic_load_n (&crud_node->fast_word, __ATOMIC_RELAXED);
+
+    do {
+        if (word & (CRUD_FAST_SLOW | CRUD_FAST_WRITER)) return false;
+    } while (!__atomic_compare_exchange_n (&crud_node->fast_word, &word, word + 1,
+                true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+    __atomic_store_n (&crud_node->curr_op, CRUD_READ, __ATOMIC_RELAXED);
+    return true;
+}
+
+/* Fast path : grant a Write only if nobody holds the node in any way */
+static inline bool
+crud_node_fast_write (crud_node_t *crud_node) {
+
+    uint64_t word = 0;
+
+    if (!__atomic_compare_exchange_n (&crud_node->fast_word, &word, CRUD_FAST_WRITER,
+                false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return false;
+    }
+    crud_node->curr_op = CRUD_WRITE;
+    return true;
+}
+
+/* Fast and slow grants never coexist on a node, so a held fast word means
+    the caller's grant came from the fast path */
+static inline bool
+crud_node_fast_release (crud_node_t *crud_node) {
+
+    uint64_t word, dec;
+
+    word = __atomic_load_n (&crud_node->fast_word, __ATOMIC_RELAXED);
+    if (!(word & CRUD_FAST_HOLDERS_MASK)) return false;
+
+    dec = (word & CRUD_FAST_WRITER) ? CRUD_FAST_WRITER : 1;
+    word = __atomic_fetch_sub (&crud_node->fast_word, dec, __ATOMIC_RELEASE) - dec;
+
+    /* Last fast holder is gone, let the slow path in */
+    if (!(word & CRUD_FAST_HOLDERS_MASK) && (word & CRUD_FAST_SLOW)) {
+        pthread_mutex_lock (&crud_node->state_mutex);
+        pthread_cond_broadcast (&crud_node->fast_drain_cv);
+        pthread_mutex_unlock (&crud_node->state_mutex);
+    }
+    return true;
+}
+
+/* Hand the node over to the slow path : stop new fast grants and wait for the
+    current ones to be released. The state machine then sees the node as if
+    there was no fast path */
+static void
+crud_node_slow_path_enter (crud_node_t *crud_node) {
+
+    pthread_mutex_lock (&crud_node->state_mutex);
+
+    crud_node->n_slow_path_users++;
+    __atomic_fetch_or (&crud_node->fast_word, CRUD_FAST_SLOW, __ATOMIC_ACQ_REL);
+
+    while (__atomic_load_n (&crud_node->fast_word, __ATOMIC_ACQUIRE) & CRUD_FAST_HOLDERS_MASK) {
+        pthread_cond_wait (&crud_node->fast_drain_cv, &crud_node->state_mutex);
+    }
+
+    /* curr_op is left over from the last fast grant */
+    if (!crud_node_in_use (crud_node)) {
+        crud_node->curr_op = CRUD_OP_NONE;
+    }
+    pthread_mutex_unlock (&crud_node->state_mutex);
+}
+
+/* Give the node back to the fast path once no thread is granted, pending or
+    about to enter the slow path on it */
+static void
+crud_node_slow_path_exit (crud_node_t *crud_node) {
+
+    pthread_mutex_lock (&crud_node->state_mutex);
+
+    crud_node->n_slow_path_users--;
+    if (crud_node->crud_mgr->fast_path &&
+        crud_node->n_slow_path_users == 0 &&
+        !crud_node_in_use (crud_node)) {
+
+        __atomic_fetch_and (&crud_node->fast_word, ~CRUD_FAST_SLOW, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock (&crud_node->state_mutex);
+}
+
 void
 crud_node_enter_state (crud_node_t *crud_node, crud_node_state_t state, bool lock) {
 
     uint8_t index = crud_node_state_to_index(state);
+    pthread_mutex_t *mgr_mutex;
   
-    printf ("%s(%d) : Crud Node : %d, Entering State : %s\n",
+    crud_log ("%s(%d) : Crud Node : %d, Entering State : %s\n",
         __FUNCTION__, __LINE__,
         crud_node->id, crud_node_state_str(state));
 
@@ -142,7 +270,7 @@ crud_node_enter_state (crud_node_t *crud_node, crud_node_state_t state, bool loc
 
         crud_node->counter[index]++;
         
-        printf ("%s(%d) : Crud Node : %d, Already in %s State, Counter : %d\n", 
+        crud_log ("%s(%d) : Crud Node : %d, Already in %s State, Counter : %d\n", 
             __FUNCTION__, __LINE__,
             crud_node->id, crud_node_state_str(state), crud_node->counter[index]);
 
@@ -183,12 +311,11 @@ crud_node_enter_state (crud_node_t *crud_node, crud_node_state_t state, bool loc
     /* Now enter the state */
     crud_node_status_set_flag (crud_node, state);
 
-    if (lock)
-    pthread_mutex_lock (&crud_node->crud_mgr->state_mutex);
+    mgr_mutex = crud_mgr_state_lock (crud_node, state, lock);
     
     crud_node->counter[index] = 1;
 
-    glthread_add_next (&crud_node->crud_mgr->crud_nodes_list[index],
+    glthread_add_next (crud_mgr_state_list (crud_node, state),
                                      &crud_node->crud_node_glue[index]);
 
     if (state != crud_node_no_op &&
@@ -197,22 +324,22 @@ crud_node_enter_state (crud_node_t *crud_node, crud_node_state_t state, bool loc
         crud_node_exit_state(crud_node, crud_node_no_op, lock);
     }
 
-    printf ("%s(%d) : Crud Node : %d, Entered State : %s\n",
+    crud_log ("%s(%d) : Crud Node : %d, Entered State : %s\n",
          __FUNCTION__, __LINE__,
         crud_node->id, crud_node_state_str(state));    
 
-    if (lock)
-    pthread_mutex_unlock (&crud_node->crud_mgr->state_mutex);
+    crud_mgr_state_unlock (mgr_mutex);
 }
 
 void
 crud_node_exit_state (crud_node_t *crud_node, crud_node_state_t state, bool lock) {
 
     uint8_t index;
+    pthread_mutex_t *mgr_mutex;
 
     index = crud_node_state_to_index(state);
 
-    printf ("%s(%d) : Crud Node : %d, Exiting State : %s\n",
+    crud_log ("%s(%d) : Crud Node : %d, Exiting State : %s\n",
          __FUNCTION__, __LINE__,
         crud_node->id, crud_node_state_str(state));
 
@@ -224,7 +351,7 @@ crud_node_exit_state (crud_node_t *crud_node, crud_node_state_t state, bool lock
 
     if (crud_node->counter[index]) {
         
-         printf ("%s(%d) : Crud Node : %d, Exited State : %s, Ref Count Dec to : %d\n",
+         crud_log ("%s(%d) : Crud Node : %d, Exited State : %s, Ref Count Dec to : %d\n",
          __FUNCTION__, __LINE__,
         crud_node->id, crud_node_state_str(state), crud_node->counter[index]);
         return;
@@ -259,12 +386,11 @@ crud_node_exit_state (crud_node_t *crud_node, crud_node_state_t state, bool lock
         assert(0);
     }
 
-    if (lock)
-    pthread_mutex_lock (&crud_node->crud_mgr->state_mutex);
+    mgr_mutex = crud_mgr_state_lock (crud_node, state, lock);
 
     remove_glthread (&crud_node->crud_node_glue[index]);
 
-    printf ("%s(%d) : Crud Node : %d, Exited State : %s\n",
+    crud_log ("%s(%d) : Crud Node : %d, Exited State : %s\n",
         __FUNCTION__, __LINE__,
         crud_node->id, crud_node_state_str(state));  
 
@@ -273,15 +399,14 @@ crud_node_exit_state (crud_node_t *crud_node, crud_node_state_t state, bool lock
         crud_node->curr_op = CRUD_OP_NONE;   
     }
 
-    if (lock)
-    pthread_mutex_unlock (&crud_node->crud_mgr->state_mutex);
+    crud_mgr_state_unlock (mgr_mutex);
 }
 
 
-bool
-crud_request_read (crud_node_t *crud_node) {
+static bool
+crud_request_read_slow (crud_node_t *crud_node) {
 
-    printf ("%s(%d) : Crud Node : %d, Entered ... \n", 
+    crud_log ("%s(%d) : Crud Node : %d, Entered ... \n", 
      __FUNCTION__, __LINE__, crud_node->id);
 
     crud_mgr_t *crud_mgr = crud_node->crud_mgr;
@@ -294,7 +419,7 @@ crud_request_read (crud_node_t *crud_node) {
             for this node, and exit. */
         if (crud_node_is_status_set (crud_node, crud_node_pending_delete)) {
 
-            printf ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n", 
+            crud_log ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n", 
              __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_delete));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
@@ -304,7 +429,7 @@ crud_request_read (crud_node_t *crud_node) {
         /* why to wait to read something which dont even exist yet*/
         if (crud_node_is_status_set (crud_node, crud_node_pending_create)) {
 
-            printf ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  
+            crud_log ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  
             __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_create));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
@@ -314,7 +439,7 @@ crud_request_read (crud_node_t *crud_node) {
         /* Why to read the data of the Dying node */
         if (crud_node_is_status_set (crud_node, crud_node_delete_in_progress)) {
 
-            printf ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_delete_in_progress));
+            crud_log ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_delete_in_progress));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
             return false;
@@ -323,7 +448,7 @@ crud_request_read (crud_node_t *crud_node) {
         /* Why to read the data of the node which is in the process of taking birth*/
         if (crud_node_is_status_set (crud_node, crud_node_create_in_progress)) {
 
-            printf ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_create_in_progress));
+            crud_log ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_create_in_progress));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
             return false;
@@ -340,7 +465,7 @@ crud_request_read (crud_node_t *crud_node) {
         readers/writers will eventually delete the node*/
         if (crud_node_is_status_set (crud_node, crud_node_pending_delete)) {
 
-            printf ("%s(%d) : Crud Node : %d, Reader Quits. Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_delete));
+            crud_log ("%s(%d) : Crud Node : %d, Reader Quits. Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_delete));
 
             pthread_cond_broadcast (&crud_node->rdrs_cv);
             pthread_cond_broadcast (&crud_node->writers_cv);
@@ -352,7 +477,7 @@ crud_request_read (crud_node_t *crud_node) {
         /* why to wait to read something which dont even exist yet*/
         if (crud_node_is_status_set (crud_node, crud_node_pending_create)) {
 
-            printf ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_create));
+            crud_log ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_create));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
             IMPOSSIBLE_CASE;
@@ -362,7 +487,7 @@ crud_request_read (crud_node_t *crud_node) {
         /* Why to read the data of the Dying node */
         if (crud_node_is_status_set (crud_node, crud_node_delete_in_progress)) {
 
-            printf ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_delete_in_progress));
+            crud_log ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_delete_in_progress));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
             IMPOSSIBLE_CASE;
@@ -372,7 +497,7 @@ crud_request_read (crud_node_t *crud_node) {
         /* Why to read the data of the node which is in the process of taking birth*/
         if (crud_node_is_status_set (crud_node, crud_node_create_in_progress)) {
 
-            printf ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_create_in_progress));
+            crud_log ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_create_in_progress));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
             IMPOSSIBLE_CASE;
@@ -384,14 +509,14 @@ crud_request_read (crud_node_t *crud_node) {
         /* If some writer thread is already working on node */
         if (crud_node_is_status_set (crud_node, crud_node_write_in_progress)) {
 
-            printf ("%s(%d) : Crud Node : %d, Read Request blocked, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_write_in_progress));
+            crud_log ("%s(%d) : Crud Node : %d, Read Request blocked, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_write_in_progress));
 
              /* Transition the state */
              crud_node_enter_state(crud_node, crud_node_pending_read, true);
 
              pthread_cond_wait(&crud_node->rdrs_cv, &crud_node->state_mutex);
 
-            printf ("%s(%d) : Crud Node : %d, Read Request Unblocked\n", 
+            crud_log ("%s(%d) : Crud Node : %d, Read Request Unblocked\n", 
             __FUNCTION__, __LINE__, crud_node->id);
 
              crud_node_exit_state(crud_node, crud_node_pending_read, true);
@@ -402,7 +527,7 @@ crud_request_read (crud_node_t *crud_node) {
             node at this point of time, then go on with READ operation on it*/
          if (crud_node_is_status_set (crud_node, crud_node_no_op)) {  
             /* Transition the state */
-            printf ("%s(%d) : Crud Node : %d, Read Request Accepted, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_no_op));
+            crud_log ("%s(%d) : Crud Node : %d, Read Request Accepted, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_no_op));
             
             assert (!crud_node_in_use(crud_node));
 
@@ -415,7 +540,7 @@ crud_request_read (crud_node_t *crud_node) {
              read-read is non-conflicting operations  */
         if (crud_node_is_status_set (crud_node, crud_node_read_in_progress)) {
             /* Transition the state */
-            printf ("%s(%d) : Crud Node : %d, Read Request Accepted, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_read_in_progress));
+            crud_log ("%s(%d) : Crud Node : %d, Read Request Accepted, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_read_in_progress));
 
             crud_node_enter_state(crud_node, crud_node_read_in_progress, true);
             pthread_mutex_unlock(&crud_node->state_mutex);
@@ -430,7 +555,7 @@ crud_request_read (crud_node_t *crud_node) {
          */
         if (crud_node_is_status_set (crud_node, crud_node_pending_read)) {
 
-            printf ("%s(%d) : Crud Node : %d already has pending readers, and there is no writer in progress, Accept Read Request\n", 
+            crud_log ("%s(%d) : Crud Node : %d already has pending readers, and there is no writer in progress, Accept Read Request\n", 
                 __FUNCTION__, __LINE__, crud_node->id);
 
                 crud_node_enter_state(crud_node, crud_node_read_in_progress, true);
@@ -446,7 +571,7 @@ crud_request_read (crud_node_t *crud_node) {
         */
         if (crud_node_is_status_set (crud_node, crud_node_pending_write)) {
 
-            printf ("%s(%d) : Crud Node : %d already has pending writers, and there is no writer in progress, Block Read Request\n", 
+            crud_log ("%s(%d) : Crud Node : %d already has pending writers, and there is no writer in progress, Block Read Request\n", 
                 __FUNCTION__, __LINE__, crud_node->id);            
 
             crud_node_enter_state(crud_node, crud_node_pending_read, true);
@@ -460,10 +585,10 @@ crud_request_read (crud_node_t *crud_node) {
 }
 
 
-bool
-crud_request_write (crud_node_t *crud_node) {
+static bool
+crud_request_write_slow (crud_node_t *crud_node) {
 
-    printf ("%s(%d) : Crud Node : %d, Entered ... \n", 
+    crud_log ("%s(%d) : Crud Node : %d, Entered ... \n", 
      __FUNCTION__, __LINE__, crud_node->id);
 
     crud_mgr_t *crud_mgr = crud_node->crud_mgr;
@@ -476,7 +601,7 @@ crud_request_write (crud_node_t *crud_node) {
             for this node, and exit. */
         if (crud_node_is_status_set (crud_node, crud_node_pending_delete)) {
 
-            printf ("%s(%d) : Crud Node : %d, Write Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_delete));
+            crud_log ("%s(%d) : Crud Node : %d, Write Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_delete));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
             return false;
@@ -485,7 +610,7 @@ crud_request_write (crud_node_t *crud_node) {
         /* why to wait to write something which dont even exist yet*/
         if (crud_node_is_status_set (crud_node, crud_node_pending_create)) {
 
-            printf ("%s(%d) : Crud Node : %d, Write Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_create));
+            crud_log ("%s(%d) : Crud Node : %d, Write Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_create));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
             return false;
@@ -494,7 +619,7 @@ crud_request_write (crud_node_t *crud_node) {
         /* Why to write the data of the Dying node */
         if (crud_node_is_status_set (crud_node, crud_node_delete_in_progress)) {
 
-            printf("%s(%d) : Crud Node : %d, Write Request Rejected, Reason : Current Status is %s\n", __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_delete_in_progress));
+            crud_log ("%s(%d) : Crud Node : %d, Write Request Rejected, Reason : Current Status is %s\n", __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_delete_in_progress));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
             return false;
@@ -503,7 +628,7 @@ crud_request_write (crud_node_t *crud_node) {
         /* Why to write the data of the  node which has not finished taking birth*/
         if (crud_node_is_status_set (crud_node, crud_node_create_in_progress)) {
 
-            printf ("%s(%d) : Crud Node : %d, Write Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_create_in_progress));
+            crud_log ("%s(%d) : Crud Node : %d, Write Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_create_in_progress));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
             return false;
@@ -516,7 +641,7 @@ crud_request_write (crud_node_t *crud_node) {
        /* Writer thread has just woken up and finds the node is marked for deletion. In this case, We plan that all readers/writers who have not got the chance to perform their respective operation quits. So, lets allow all pending readers and writers leave the arena on by one, and then in the end, delete thread when see no more pending   readers/writers will eventually delete the node*/
         if (crud_node_is_status_set (crud_node, crud_node_pending_delete)) {
 
-            printf ("%s(%d) : Crud Node : %d, Writer Quits. Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_delete));
+            crud_log ("%s(%d) : Crud Node : %d, Writer Quits. Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_delete));
 
             pthread_cond_broadcast (&crud_node->rdrs_cv);
             pthread_cond_broadcast (&crud_node->writers_cv);
@@ -528,7 +653,7 @@ crud_request_write (crud_node_t *crud_node) {
         /* why to wait to read something which dont even exist yet*/
         if (crud_node_is_status_set (crud_node, crud_node_pending_create)) {
 
-            printf ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_create));
+            crud_log ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_create));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
             IMPOSSIBLE_CASE;
@@ -538,7 +663,7 @@ crud_request_write (crud_node_t *crud_node) {
         /* Why to read the data of the Dying node */
         if (crud_node_is_status_set (crud_node, crud_node_delete_in_progress)) {
 
-            printf ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_delete_in_progress));
+            crud_log ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_delete_in_progress));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
             IMPOSSIBLE_CASE;
@@ -548,7 +673,7 @@ crud_request_write (crud_node_t *crud_node) {
         /* Why to read the data of the node which is in the process of taking birth*/
         if (crud_node_is_status_set (crud_node, crud_node_create_in_progress)) {
 
-            printf ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_create_in_progress));
+            crud_log ("%s(%d) : Crud Node : %d, Read Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_create_in_progress));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
             IMPOSSIBLE_CASE;
@@ -561,13 +686,13 @@ crud_request_write (crud_node_t *crud_node) {
              write-write is a conflicting operations */
         if (crud_node_is_status_set (crud_node, crud_node_write_in_progress)) {
 
-            printf ("%s(%d) : Crud Node : %d, Write Request blocked, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_write_in_progress));
+            crud_log ("%s(%d) : Crud Node : %d, Write Request blocked, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_write_in_progress));
 
              /* Transition the state */
              crud_node_enter_state(crud_node, crud_node_pending_write, true);
              pthread_cond_wait(&crud_node->writers_cv, &crud_node->state_mutex);
 
-             printf ("%s(%d) : Crud Node : %d, Write Request Unblocked\n", 
+             crud_log ("%s(%d) : Crud Node : %d, Write Request Unblocked\n", 
             __FUNCTION__, __LINE__, crud_node->id);
 
              crud_node_exit_state(crud_node, crud_node_pending_write, true);
@@ -578,7 +703,7 @@ crud_request_write (crud_node_t *crud_node) {
             node at this point of time, then go on with WRITE operation on it*/
          if (crud_node_is_status_set (crud_node, crud_node_no_op)) {  
             /* Transition the state */
-            printf ("%s(%d) : Crud Node : %d, Write Request Accepted, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_no_op));
+            crud_log ("%s(%d) : Crud Node : %d, Write Request Accepted, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_no_op));
             
             assert (!crud_node_in_use(crud_node));
 
@@ -591,12 +716,12 @@ crud_request_write (crud_node_t *crud_node) {
              read-write is a conflicting operations  */
         if (crud_node_is_status_set (crud_node, crud_node_read_in_progress)) {
             /* Transition the state */
-            printf ("%s(%d) : Crud Node : %d, Write Request blocked, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_read_in_progress));
+            crud_log ("%s(%d) : Crud Node : %d, Write Request blocked, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_read_in_progress));
 
              crud_node_enter_state(crud_node, crud_node_pending_write, true);
              pthread_cond_wait(&crud_node->writers_cv, &crud_node->state_mutex);
 
-             printf ("%s(%d) : Crud Node : %d, Write Request Unblocked\n", 
+             crud_log ("%s(%d) : Crud Node : %d, Write Request Unblocked\n", 
             __FUNCTION__, __LINE__, crud_node->id);
 
              crud_node_exit_state(crud_node, crud_node_pending_write, true);
@@ -610,7 +735,7 @@ crud_request_write (crud_node_t *crud_node) {
         */
         if (crud_node_is_status_set (crud_node, crud_node_pending_read)) {
            
-            printf ("%s(%d) : Crud Node : %d already has pending readers and there is no   Writer in progress, Accept Write Request\n", 
+            crud_log ("%s(%d) : Crud Node : %d already has pending readers and there is no   Writer in progress, Accept Write Request\n", 
                 __FUNCTION__, __LINE__, crud_node->id);
 
                 crud_node_enter_state(crud_node, crud_node_write_in_progress, true);
@@ -634,10 +759,10 @@ crud_request_write (crud_node_t *crud_node) {
     return false;
 }
 
-bool
-crud_request_create (crud_node_t *crud_node) {
+static bool
+crud_request_create_slow (crud_node_t *crud_node) {
 
-    printf ("%s(%d) : Crud Node : %d, Entered ... \n", 
+    crud_log ("%s(%d) : Crud Node : %d, Entered ... \n", 
      __FUNCTION__, __LINE__, crud_node->id);
 
     crud_mgr_t *crud_mgr = crud_node->crud_mgr;
@@ -651,13 +776,13 @@ crud_request_create (crud_node_t *crud_node) {
               !IS_GLTHREAD_LIST_EMPTY (&crud_mgr->crud_nodes_list
                                 [crud_node_state_to_index(crud_node_delete_in_progress)]) ) {
 
-            printf ("%s(%d) : Crud Node : %d, Create Request blocked, Reason : Either      Create Or Delete operation is in progress somewhere \n",
+            crud_log ("%s(%d) : Crud Node : %d, Create Request blocked, Reason : Either      Create Or Delete operation is in progress somewhere \n",
                    __FUNCTION__, __LINE__, crud_node->id);
 
             crud_node_enter_state(crud_node, crud_node_pending_create, false);
             pthread_cond_wait(&crud_node->create_thread_cv, &crud_mgr->state_mutex);
 
-            printf ("%s(%d) : Crud Node : %d, Create Request Unblocked\n", 
+            crud_log ("%s(%d) : Crud Node : %d, Create Request Unblocked\n", 
             __FUNCTION__, __LINE__, crud_node->id);            
 
             crud_node_exit_state(crud_node, crud_node_pending_create, false);
@@ -689,10 +814,10 @@ crud_request_create (crud_node_t *crud_node) {
     return false;
 }
 
-bool
-crud_request_delete (crud_node_t *crud_node) {
+static bool
+crud_request_delete_slow (crud_node_t *crud_node) {
 
-    printf ("%s(%d) : Crud Node : %d, Entered ... \n", 
+    crud_log ("%s(%d) : Crud Node : %d, Entered ... \n", 
      __FUNCTION__, __LINE__, crud_node->id);
 
     crud_mgr_t *crud_mgr = crud_node->crud_mgr;
@@ -705,7 +830,7 @@ crud_request_delete (crud_node_t *crud_node) {
             action, reject appln request */
         if (crud_node_is_status_set (crud_node, crud_node_pending_delete)) {
 
-            printf("%s(%d) : Crud Node : %d, Delete Request Rejected, Reason : Current Status is %s\n", __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_delete));
+            crud_log ("%s(%d) : Crud Node : %d, Delete Request Rejected, Reason : Current Status is %s\n", __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_delete));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
             return false;
@@ -713,21 +838,21 @@ crud_request_delete (crud_node_t *crud_node) {
 
         /* You cant delete something which dont event exist yet */
         if (crud_node_is_status_set (crud_node, crud_node_pending_create)) {
-            printf ("%s(%d) : Crud Node : %d, Delete Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_create));            
+            crud_log ("%s(%d) : Crud Node : %d, Delete Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_create));            
             pthread_mutex_unlock(&crud_node->state_mutex);
             return false;
         }
 
         /* Why to delete the already Dying node */
         if (crud_node_is_status_set (crud_node, crud_node_delete_in_progress)) {
-            printf ("%s(%d) : Crud Node : %d, Delete Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_delete_in_progress));                    
+            crud_log ("%s(%d) : Crud Node : %d, Delete Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_delete_in_progress));                    
             pthread_mutex_unlock(&crud_node->state_mutex);
             return false;
          }
 
         /* Why to delete the the node which is in the process of creation*/
         if (crud_node_is_status_set (crud_node, crud_node_create_in_progress)) {
-            printf ("%s(%d) : Crud Node : %d, Delete Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_create_in_progress));                  
+            crud_log ("%s(%d) : Crud Node : %d, Delete Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_create_in_progress));                  
             pthread_mutex_unlock(&crud_node->state_mutex);
             return false;
          }
@@ -741,12 +866,12 @@ crud_request_delete (crud_node_t *crud_node) {
         /* If some writer thread is already working on node, defer the delete operation */
         if (crud_node_is_status_set (crud_node, crud_node_write_in_progress)) {
              /* Transition the state */
-            printf ("%s(%d) : Crud Node : %d, Delete Request blocked, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_write_in_progress));
+            crud_log ("%s(%d) : Crud Node : %d, Delete Request blocked, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_write_in_progress));
 
              crud_node_enter_state(crud_node, crud_node_pending_delete, true);
              pthread_cond_wait(&crud_node->delete_thread_cv, &crud_node->state_mutex);
             
-            printf ("%s(%d) : Crud Node : %d, Delete Request Unblocked\n", 
+            crud_log ("%s(%d) : Crud Node : %d, Delete Request Unblocked\n", 
             __FUNCTION__, __LINE__, crud_node->id);
 
              crud_node_exit_state(crud_node, crud_node_pending_delete, true);
@@ -756,11 +881,11 @@ crud_request_delete (crud_node_t *crud_node) {
         /* If some reader  thread is already reading on node, defer the delete operation */
         if (crud_node_is_status_set (crud_node, crud_node_read_in_progress)) {
              /* Transition the state */
-            printf ("%s(%d) : Crud Node : %d, Delete Request blocked, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_read_in_progress));
+            crud_log ("%s(%d) : Crud Node : %d, Delete Request blocked, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_read_in_progress));
 
              crud_node_enter_state(crud_node, crud_node_pending_delete, true);
-             pthread_cond_wait(&crud_node->rdrs_cv, &crud_node->state_mutex);
-             printf ("%s(%d) : Crud Node : %d, Delete Request Unblocked\n", 
+             pthread_cond_wait(&crud_node->delete_thread_cv, &crud_node->state_mutex);
+             crud_log ("%s(%d) : Crud Node : %d, Delete Request Unblocked\n", 
             __FUNCTION__, __LINE__, crud_node->id);             
              crud_node_exit_state(crud_node, crud_node_pending_delete, true);
              continue;
@@ -770,11 +895,11 @@ crud_request_delete (crud_node_t *crud_node) {
             the threads to complete their respective read operation */
         if (crud_node_is_status_set (crud_node, crud_node_pending_read)) {
             /* Transition the state */
-            printf ("%s(%d) : Crud Node : %d, Delete Request blocked, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_read));
+            crud_log ("%s(%d) : Crud Node : %d, Delete Request blocked, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_read));
 
             crud_node_enter_state(crud_node, crud_node_pending_delete, true);
             pthread_cond_wait (&crud_node->delete_thread_cv, &crud_node->state_mutex);
-            printf ("%s(%d) : Crud Node : %d, Delete Request Unblocked\n", 
+            crud_log ("%s(%d) : Crud Node : %d, Delete Request Unblocked\n", 
             __FUNCTION__, __LINE__, crud_node->id);               
             crud_node_exit_state(crud_node, crud_node_pending_delete, true);
             continue;
@@ -784,10 +909,10 @@ crud_request_delete (crud_node_t *crud_node) {
             the threads to complete their respective write operation */
         if (crud_node_is_status_set (crud_node, crud_node_pending_write)) {
             /* Transition the state */
-            printf ("%s(%d) : Crud Node : %d, Delete Request blocked, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_write));            
+            crud_log ("%s(%d) : Crud Node : %d, Delete Request blocked, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_write));            
             crud_node_enter_state(crud_node, crud_node_pending_delete, true);
             pthread_cond_wait (&crud_node->delete_thread_cv, &crud_node->state_mutex);
-            printf ("%s(%d) : Crud Node : %d, Delete Request Unblocked\n", 
+            crud_log ("%s(%d) : Crud Node : %d, Delete Request Unblocked\n", 
             __FUNCTION__, __LINE__, crud_node->id);                
             crud_node_exit_state(crud_node, crud_node_pending_delete, true);
             continue;
@@ -795,7 +920,7 @@ crud_request_delete (crud_node_t *crud_node) {
 
        if (crud_node_is_status_set (crud_node, crud_node_pending_delete)) {
 
-            printf ("%s(%d) : Crud Node : %d, Write Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_delete));
+            crud_log ("%s(%d) : Crud Node : %d, Write Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_delete));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
             return false;
@@ -804,7 +929,7 @@ crud_request_delete (crud_node_t *crud_node) {
         /* why to wait to write something which dont even exist yet*/
         if (crud_node_is_status_set (crud_node, crud_node_pending_create)) {
 
-            printf ("%s(%d) : Crud Node : %d, Write Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_create));
+            crud_log ("%s(%d) : Crud Node : %d, Write Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_create));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
             return false;
@@ -813,7 +938,7 @@ crud_request_delete (crud_node_t *crud_node) {
         /* Why to write the data of the Dying node */
         if (crud_node_is_status_set (crud_node, crud_node_delete_in_progress)) {
 
-            printf("%s(%d) : Crud Node : %d, Write Request Rejected, Reason : Current Status is %s\n", __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_delete_in_progress));
+            crud_log ("%s(%d) : Crud Node : %d, Write Request Rejected, Reason : Current Status is %s\n", __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_delete_in_progress));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
             return false;
@@ -822,7 +947,7 @@ crud_request_delete (crud_node_t *crud_node) {
         /* Why to write the data of the  node which has not finished taking birth*/
         if (crud_node_is_status_set (crud_node, crud_node_create_in_progress)) {
 
-            printf ("%s(%d) : Crud Node : %d, Write Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_create_in_progress));
+            crud_log ("%s(%d) : Crud Node : %d, Write Request Rejected, Reason : Current Status is %s\n",  __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_create_in_progress));
 
             pthread_mutex_unlock(&crud_node->state_mutex);
             return false;
@@ -838,7 +963,7 @@ crud_request_delete (crud_node_t *crud_node) {
        all application requested shall be rejected for this node. Here entering in this
        state now acts as a flag that this node should no more entertain any CRUD request
        submissions from application */
-    printf ("%s(%d) : Crud Node : %d, Forced to Enter in %s state\n",
+    crud_log ("%s(%d) : Crud Node : %d, Forced to Enter in %s state\n",
     __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_delete));
 
     crud_node_enter_state(crud_node, crud_node_pending_delete, true);
@@ -858,13 +983,13 @@ crud_request_delete (crud_node_t *crud_node) {
                   !IS_GLTHREAD_LIST_EMPTY (&crud_mgr->crud_nodes_list
                         [crud_node_state_to_index(crud_node_delete_in_progress)]) ) {
 
-                printf("%s(%d) : Crud Node : %d, Delete Request blocked, Reason : Either Create Or Delete operation is in progress somewhere \n",
+                crud_log ("%s(%d) : Crud Node : %d, Delete Request blocked, Reason : Either Create Or Delete operation is in progress somewhere \n",
                        __FUNCTION__, __LINE__, crud_node->id);
 
                 crud_node_enter_state(crud_node, crud_node_pending_delete, false);
                 pthread_cond_wait(&crud_node->delete_thread_cv, &crud_mgr->state_mutex);
 
-                printf ("%s(%d) : Crud Node : %d, Delete Request Unblocked\n", 
+                crud_log ("%s(%d) : Crud Node : %d, Delete Request Unblocked\n", 
             __FUNCTION__, __LINE__, crud_node->id);     
 
                 crud_node_exit_state(crud_node, crud_node_pending_delete, false);
@@ -880,15 +1005,15 @@ crud_request_delete (crud_node_t *crud_node) {
     return false;
 }
 
-void
-crud_request_release (crud_node_t *crud_node) {
+static void
+crud_request_release_slow (crud_node_t *crud_node) {
 
     crud_node_t *crud_node2;
     glthread_t *crud_node_glue;
 
     crud_mgr_t *crud_mgr = crud_node->crud_mgr;
 
-    printf ("%s(%d) : Crud Node : %d, Op Code %d Entered ... \n", 
+    crud_log ("%s(%d) : Crud Node : %d, Op Code %d Entered ... \n", 
      __FUNCTION__, __LINE__, crud_node->id, crud_node->curr_op);
 
     switch (crud_node->curr_op) {
@@ -924,7 +1049,7 @@ crud_request_release (crud_node_t *crud_node) {
                     crud_node2 = crud_node_get_from_crud_node_glue(
                             crud_node_glue, crud_node_pending_create_index);
 
-                    printf ("%s(%d) : Crud Node : %d, Signal to some thread in state %s\n",
+                    crud_log ("%s(%d) : Crud Node : %d, Signal to some thread in state %s\n",
                         __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_create));
 
                     //pthread_mutex_lock (&crud_node2->state_mutex);
@@ -944,7 +1069,7 @@ crud_request_release (crud_node_t *crud_node) {
                     crud_node2 = crud_node_get_from_crud_node_glue(
                             crud_node_glue, crud_node_pending_delete_index);
 
-                    printf ("%s(%d) : Crud Node : %d, Signal to some thread in state %s\n",
+                    crud_log ("%s(%d) : Crud Node : %d, Signal to some thread in state %s\n",
                         __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_delete));
 
                     //pthread_mutex_lock (&crud_node2->state_mutex);
@@ -985,7 +1110,7 @@ crud_request_release (crud_node_t *crud_node) {
                     crud_node2 = crud_node_get_from_crud_node_glue(
                             crud_node_glue, crud_node_pending_create_index);
 
-                    printf ("%s(%d) : Crud Node : %d, Signal to some thread in state %s\n",
+                    crud_log ("%s(%d) : Crud Node : %d, Signal to some thread in state %s\n",
                         __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_create));
 
                     //pthread_mutex_lock (&crud_node2->state_mutex);
@@ -1005,7 +1130,7 @@ crud_request_release (crud_node_t *crud_node) {
                     crud_node2 = crud_node_get_from_crud_node_glue(
                             crud_node_glue, crud_node_pending_delete_index);
 
-                    printf ("%s(%d) : Crud Node : %d, Signal to some thread in state %s\n",
+                    crud_log ("%s(%d) : Crud Node : %d, Signal to some thread in state %s\n",
                         __FUNCTION__, __LINE__, crud_node->id, crud_node_state_str(crud_node_pending_delete));
 
                     //pthread_mutex_lock (&crud_node2->state_mutex);
@@ -1027,42 +1152,40 @@ crud_request_release (crud_node_t *crud_node) {
             /* Still some Readers reading the node*/
             if (crud_node_is_status_set (crud_node, crud_node_read_in_progress)) {
                 
-                printf ("%s(%d) : Crud Node : %d, Silent exit because Crud node is being read\n", __FUNCTION__, __LINE__, crud_node->id);
+                crud_log ("%s(%d) : Crud Node : %d, Silent exit because Crud node is being read\n", __FUNCTION__, __LINE__, crud_node->id);
 
                 pthread_mutex_unlock (&crud_node->state_mutex);
                 break;
             }
 
+            /* Wake every class of pending thread, each re-evaluates the node state and
+                waits again if it still conflicts. Waking only the readers could leave
+                them blocked behind a pending writer that nobody signals */
+
             /* Check if any reader(s) is pending */
             if (crud_node_is_status_set (crud_node, crud_node_pending_read)) {
 
-                printf ("%s(%d) : Crud Node : %d, Broadcasting Local Pending Readers\n", __FUNCTION__, __LINE__, crud_node->id);
+                crud_log ("%s(%d) : Crud Node : %d, Broadcasting Local Pending Readers\n", __FUNCTION__, __LINE__, crud_node->id);
 
                 pthread_cond_broadcast(&crud_node->rdrs_cv);
-                pthread_mutex_unlock (&crud_node->state_mutex);
-                break;
             }
             
-            /* No More reader threads, check if any writer threads is pending*/
+            /* Check if any writer threads is pending*/
             if (crud_node_is_status_set (crud_node, crud_node_pending_write)) {
 
-                printf("%s(%d) : Crud Node : %d, Signaling  Local Writer\n", 
+                crud_log ("%s(%d) : Crud Node : %d, Signaling  Local Writer\n", 
                 __FUNCTION__, __LINE__, crud_node->id);
 
                 pthread_cond_signal(&crud_node->writers_cv);
-                pthread_mutex_unlock (&crud_node->state_mutex);
-                break;
             }
 
             /* Check if delete thread is pending */
             if (crud_node_is_status_set (crud_node, crud_node_pending_delete)) {
 
-                printf("%s(%d) : Crud Node : %d, Signaling  Local Delete thread\n",
+                crud_log ("%s(%d) : Crud Node : %d, Signaling  Local Delete thread\n",
                        __FUNCTION__, __LINE__, crud_node->id);
 
                 pthread_cond_signal(&crud_node->delete_thread_cv);
-                pthread_mutex_unlock (&crud_node->state_mutex);
-                break;
             }
             pthread_mutex_unlock (&crud_node->state_mutex);
             break;
@@ -1073,32 +1196,30 @@ crud_request_release (crud_node_t *crud_node) {
 
             crud_node_exit_state (crud_node,  crud_node_write_in_progress, true);
 
+            /* Wake every class of pending thread, each re-evaluates the node state and
+                waits again if it still conflicts. Waking only the readers could leave
+                them blocked behind a pending writer that nobody signals */
+
             /* Check if any reader(s) is pending */
             if (crud_node_is_status_set (crud_node, crud_node_pending_read)) {
 
-                printf ("%s(%d) : Crud Node : %d, Broadcasting Local Pending Readers\n", __FUNCTION__, __LINE__, crud_node->id);
+                crud_log ("%s(%d) : Crud Node : %d, Broadcasting Local Pending Readers\n", __FUNCTION__, __LINE__, crud_node->id);
 
                 pthread_cond_broadcast(&crud_node->rdrs_cv);
-                pthread_mutex_unlock (&crud_node->state_mutex);
-                break;
             }
             
-            /* No More reader threads, check if any writer threads is pending*/
+            /* Check if any writer threads is pending*/
             if (crud_node_is_status_set (crud_node, crud_node_pending_write)) {
-                printf("%s(%d) : Crud Node : %d, Signaling  Local Writer\n",
+                crud_log ("%s(%d) : Crud Node : %d, Signaling  Local Writer\n",
                        __FUNCTION__, __LINE__, crud_node->id);
                 pthread_cond_signal(&crud_node->writers_cv);
-                pthread_mutex_unlock (&crud_node->state_mutex);
-                break;
             }
 
             /* Check if delete thread is pending */
             if (crud_node_is_status_set (crud_node, crud_node_pending_delete)) {
-                printf("%s(%d) : Crud Node : %d, Signaling  Local Delete thread\n",
+                crud_log ("%s(%d) : Crud Node : %d, Signaling  Local Delete thread\n",
                        __FUNCTION__, __LINE__, crud_node->id);                
                 pthread_cond_signal(&crud_node->delete_thread_cv);
-                pthread_mutex_unlock (&crud_node->state_mutex);
-                break;
             }
             pthread_mutex_unlock (&crud_node->state_mutex);
         break;
@@ -1107,6 +1228,65 @@ crud_request_release (crud_node_t *crud_node) {
 }
 
 
+bool
+crud_request_read (crud_node_t *crud_node) {
+
+    bool rc;
+
+    if (crud_node_fast_read (crud_node)) return true;
+
+    crud_node_slow_path_enter (crud_node);
+    rc = crud_request_read_slow (crud_node);
+    crud_node_slow_path_exit (crud_node);
+    return rc;
+}
+
+bool
+crud_request_write (crud_node_t *crud_node) {
+
+    bool rc;
+
+    if (crud_node_fast_write (crud_node)) return true;
+
+    crud_node_slow_path_enter (crud_node);
+    rc = crud_request_write_slow (crud_node);
+    crud_node_slow_path_exit (crud_node);
+    return rc;
+}
+
+/* Create and Delete always run on the slow path */
+bool
+crud_request_create (crud_node_t *crud_node) {
+
+    bool rc;
+
+    crud_node_slow_path_enter (crud_node);
+    rc = crud_request_create_slow (crud_node);
+    crud_node_slow_path_exit (crud_node);
+    return rc;
+}
+
+bool
+crud_request_delete (crud_node_t *crud_node) {
+
+    bool rc;
+
+    crud_node_slow_path_enter (crud_node);
+    rc = crud_request_delete_slow (crud_node);
+    crud_node_slow_path_exit (crud_node);
+    return rc;
+}
+
+void
+crud_request_release (crud_node_t *crud_node) {
+
+    if (crud_node_fast_release (crud_node)) return;
+
+    crud_node_slow_path_enter (crud_node);
+    crud_request_release_slow (crud_node);
+    crud_node_slow_path_exit (crud_node);
+}
+
 void
 crud_mgr_init (crud_mgr_t *crud_mgr) {
 
@@ -1115,6 +1295,57 @@ crud_mgr_init (crud_mgr_t *crud_mgr) {
     pthread_mutexattr_init(&Attr);
     pthread_mutexattr_settype(&Attr, PTHREAD_MUTEX_RECURSIVE);
     pthread_mutex_init(&crud_mgr->state_mutex, &Attr);
+    pthread_mutexattr_destroy(&Attr);
+    crud_mgr->fast_path = true;
+}
+
+void
+crud_mgr_set_fast_path (crud_mgr_t *crud_mgr, bool enable) {
+
+    crud_mgr->fast_path = enable;
+}
+
+void
+crud_mgr_set_logging (bool enable) {
+
+    logging = enable;
+}
+
+void
+crud_mgr_init_sharded (crud_mgr_t *crud_mgr) {
+
+    int shard;
+
+    crud_mgr_init (crud_mgr);
+    crud_mgr->sharded = true;
+
+    pthread_mutexattr_t Attr;
+    pthread_mutexattr_init(&Attr);
+    pthread_mutexattr_settype(&Attr, PTHREAD_MUTEX_RECURSIVE);
+    for (shard = 0; shard < CRUD_MGR_N_SHARDS; shard++) {
+        pthread_mutex_init(&crud_mgr->shards[shard].state_mutex, &Attr);
+    }
+    pthread_mutexattr_destroy(&Attr);
+}
+
+uint64_t
+crud_mgr_get_n_crud_nodes (crud_mgr_t *crud_mgr) {
+
+    int shard;
+    uint64_t n_crud_nodes;
+
+    pthread_mutex_lock (&crud_mgr->state_mutex);
+    n_crud_nodes = crud_mgr->n_crud_nodes;
+    pthread_mutex_unlock (&crud_mgr->state_mutex);
+
+    if (!crud_mgr->sharded) return n_crud_nodes;
+
+    for (shard = 0; shard < CRUD_MGR_N_SHARDS; shard++) {
+        pthread_mutex_lock (&crud_mgr->shards[shard].state_mutex);
+        n_crud_nodes += crud_mgr->shards[shard].n_crud_nodes;
+        pthread_mutex_unlock (&crud_mgr->shards[shard].state_mutex);
+    }
+    return n_crud_nodes;
 }
 
 void
@@ -1123,9 +1354,22 @@ crud_node_init (crud_node_t *crud_node, crud_mgr_t *crud_mgr) {
     memset (crud_node, 0, sizeof(*crud_node));
     pthread_mutex_init (&crud_node->state_mutex, NULL);
     crud_node->crud_mgr = crud_mgr;
-    crud_mgr->n_crud_nodes++;
-    crud_node_enter_state(crud_node, crud_node_no_op, true);
     crud_node->id = crud_node_get_unique_id ();
+
+    if (crud_mgr->sharded) {
+        crud_node->shard = &crud_mgr->shards[crud_node->id % CRUD_MGR_N_SHARDS];
+        pthread_mutex_lock (&crud_node->shard->state_mutex);
+        crud_node->shard->n_crud_nodes++;
+        pthread_mutex_unlock (&crud_node->shard->state_mutex);
+    }
+    else {
+        pthread_mutex_lock (&crud_mgr->state_mutex);
+        crud_mgr->n_crud_nodes++;
+        pthread_mutex_unlock (&crud_mgr->state_mutex);
+    }
+    crud_node_enter_state(crud_node, crud_node_no_op, true);
+    crud_node->fast_word = crud_mgr->fast_path ? 0 : CRUD_FAST_SLOW;
+    pthread_cond_init (&crud_node->fast_drain_cv, NULL);
     pthread_cond_init (&crud_node->rdrs_cv, NULL);
     pthread_cond_init (&crud_node->writers_cv, NULL);
     pthread_cond_init (&crud_node->delete_thread_cv, NULL);
@@ -1135,9 +1379,9 @@ crud_node_init (crud_node_t *crud_node, crud_mgr_t *crud_mgr) {
 void
 crud_mgr_destroy (crud_mgr_t *crud_mgr) {
 
-    int index;
+    int index, shard;
     
-    assert(crud_mgr->n_crud_nodes == 0);
+    assert(crud_mgr_get_n_crud_nodes (crud_mgr) == 0);
     pthread_mutex_destroy(&crud_mgr->state_mutex);
 
     for (index = crud_node_pending_read_index; 
@@ -1146,6 +1390,20 @@ crud_mgr_destroy (crud_mgr_t *crud_mgr) {
 
             assert(IS_GLTHREAD_LIST_EMPTY (&crud_mgr->crud_nodes_list[index]));
     }
+
+    if (!crud_mgr->sharded) return;
+
+    for (shard = 0; shard < CRUD_MGR_N_SHARDS; shard++) {
+
+        pthread_mutex_destroy(&crud_mgr->shards[shard].state_mutex);
+
+        for (index = crud_node_pending_read_index; 
+                index <= crud_node_no_op_index;
+                index++ ) {
+
+            assert(IS_GLTHREAD_LIST_EMPTY (&crud_mgr->shards[shard].crud_nodes_list[index]));
+        }
+    }
 }
 
 void
@@ -1153,9 +1411,18 @@ crud_node_destroy (crud_node_t *crud_node) {
 
      int index;
 
+    assert(!(crud_node->fast_word & CRUD_FAST_HOLDERS_MASK));
+    assert(crud_node->n_slow_path_users == 0);
+
+    /* curr_op is left over from the last fast grant */
+    if (!(crud_node->fast_word & CRUD_FAST_SLOW)) {
+        crud_node->curr_op = CRUD_OP_NONE;
+    }
+
     assert(crud_node->curr_op == CRUD_OP_NONE);
     assert(!crud_node_in_use(crud_node));
     pthread_mutex_destroy (&crud_node->state_mutex);
+    pthread_cond_destroy (&crud_node->fast_drain_cv);
     pthread_cond_destroy (&crud_node->rdrs_cv);
     pthread_cond_destroy (&crud_node->writers_cv);
     pthread_cond_destroy (&crud_node->delete_thread_cv);
@@ -1170,11 +1437,20 @@ crud_node_destroy (crud_node_t *crud_node) {
     }
 
     assert(!IS_GLTHREAD_LIST_EMPTY(&crud_node->crud_node_glue[crud_node_no_op_index]));
-    pthread_mutex_lock (&crud_node->crud_mgr->state_mutex);
-    remove_glthread(&crud_node->crud_node_glue[crud_node_no_op_index]);
-    crud_node->crud_mgr->n_crud_nodes--;
-    pthread_mutex_unlock (&crud_node->crud_mgr->state_mutex);
+    if (crud_node->shard) {
+        pthread_mutex_lock (&crud_node->shard->state_mutex);
+        remove_glthread(&crud_node->crud_node_glue[crud_node_no_op_index]);
+        crud_node->shard->n_crud_nodes--;
+        pthread_mutex_unlock (&crud_node->shard->state_mutex);
+    }
+    else {
+        pthread_mutex_lock (&crud_node->crud_mgr->state_mutex);
+        remove_glthread(&crud_node->crud_node_glue[crud_node_no_op_index]);
+        crud_node->crud_mgr->n_crud_nodes--;
+        pthread_mutex_unlock (&crud_node->crud_mgr->state_mutex);
+    }
     crud_node->crud_mgr = NULL;
+    crud_node->shard = NULL;
 }
 
 /* Printing */
@@ -1212,31 +1488,40 @@ crud_node_print_states (crud_node_t *crud_node) {
 void
 crud_mgr_print (crud_mgr_t *crud_mgr) {
 
-    int index;
+    int index, shard, n_lists;
     glthread_t *curr;
     crud_node_t *crud_node;
     glthread_t *crud_node_lst;
 
-    printf ("crud_mgr->n_crud_nodes = %lu\n", crud_mgr->n_crud_nodes);
+    printf ("crud_mgr->n_crud_nodes = %lu\n", crud_mgr_get_n_crud_nodes (crud_mgr));
 
     for (index = crud_node_pending_read_index; 
             index <= crud_node_no_op_index;
             index++ ) {
 
-        crud_node_lst = &crud_mgr->crud_nodes_list[index];
-
         printf ("Printing Crud Nodes in State : %d\n", crud_node_index_to_crud_node_state(index));
 
-        ITERATE_GLTHREAD_BEGIN(crud_node_lst, curr) {
+        /* Per shard lists of Read/Write/No-op states */
+        n_lists = (crud_mgr->sharded &&
+                   !crud_node_state_is_global (crud_node_index_to_crud_node_state(index))) ?
+                        CRUD_MGR_N_SHARDS : 1;
+
+        for (shard = 0; shard < n_lists; shard++) {
+
+            crud_node_lst = (n_lists > 1) ? &crud_mgr->shards[shard].crud_nodes_list[index] :
+                                            &crud_mgr->crud_nodes_list[index];
 
-           crud_node = crud_node_get_from_crud_node_glue(curr, index);
+            ITERATE_GLTHREAD_BEGIN(crud_node_lst, curr) {
 
-           printf ("  Crud Node id : %d, count = %d\n", crud_node->id, crud_node->counter[index]);
+               crud_node = crud_node_get_from_crud_node_glue(curr, index);
 
-           printf ("printing Complete Crud Node States : \n");
+               printf ("  Crud Node id : %d, count = %d\n", crud_node->id, crud_node->counter[index]);
 
-           crud_node_print_states(crud_node);
+               printf ("printing Complete Crud Node States : \n");
 
-        } ITERATE_GLTHREAD_END(crud_node_lst, curr);
+               crud_node_print_states(crud_node);
+
+            } ITERATE_GLTHREAD_END(crud_node_lst, curr);
+        }
     }    
 }
\ No newline at end of file
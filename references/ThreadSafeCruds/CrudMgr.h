@@ -135,6 +135,38 @@ crud_node_state_str (crud_node_state_t state) {
 
 
 
+/* Read, Write and No-op states only matter to the node itself, Create and Delete
+    states are checked against the whole container */
+static inline bool
+crud_node_state_is_global (crud_node_state_t state) {
+
+    switch(state) {
+        case crud_node_pending_delete:
+        case crud_node_delete_in_progress:
+        case crud_node_pending_create:
+        case crud_node_create_in_progress:
+            return true;
+        default:
+            return false;
+    }
+}
+
+#define CRUD_MGR_N_SHARDS   16
+
+/* Manager level bookkeeping of the nodes hashed to this shard, used for
+    the Read, Write and No-op states when the crud mgr is sharded */
+typedef struct crud_mgr_shard_ {
+
+    /* Mutex to update the shard state in a mutually exclusive way */
+    pthread_mutex_t state_mutex; // It must be recursive mutex
+
+    /* Number of Crud Nodes hashed to this shard */
+    uint64_t n_crud_nodes;
+
+    glthread_t crud_nodes_list[crud_node_no_op_index + 1];
+
+} crud_mgr_shard_t;
+
 /* This Data Structure has aggregate view of all thread activities going on 
     all nodes of the container object */
 typedef struct crud_mgr_ {
@@ -142,11 +174,22 @@ typedef struct crud_mgr_ {
     /* Mutex to update the crud mgr state in a mutually exclusive way */
     pthread_mutex_t state_mutex; // It must be recursive mutex
 
-    /* Total number of Crud Nodes Pointing to Mgr */
+    /* Total number of Crud Nodes Pointing to Mgr, per shard counts when sharded */
     uint64_t n_crud_nodes;
 
     glthread_t crud_nodes_list[crud_node_no_op_index + 1];
 
+    /* If set, uncontended Read/Write requests are granted by a CAS on the
+        fast_word of the node, see crud_mgr_set_fast_path() */
+    bool fast_path;
+
+    /* If set, Read/Write/No-op transitions only lock the shard of the node, so
+        operations on nodes of different shards never contend. Create and Delete
+        states stay in crud_nodes_list above under state_mutex */
+    bool sharded;
+
+    crud_mgr_shard_t shards[CRUD_MGR_N_SHARDS];
+
 } crud_mgr_t;
 
 typedef enum crud_op_type_ {
@@ -158,6 +201,15 @@ typedef enum crud_op_type_ {
     CRUD_OP_NONE
 } crud_op_type_t;
 
+/* crud_node_t::fast_word layout. Fast path grants are counted here only, the
+    node stays in crud_node_no_op state and on no other list meanwhile. Slow bit
+    hands the node over to the mutex/CV state machine, which starts only once
+    all fast grants are released */
+#define CRUD_FAST_READERS_MASK  0xffffffffULL
+#define CRUD_FAST_WRITER        (1ULL << 32)
+#define CRUD_FAST_SLOW          (1ULL << 33)
+#define CRUD_FAST_HOLDERS_MASK  (CRUD_FAST_READERS_MASK | CRUD_FAST_WRITER)
+
 typedef struct crud_node_ {
 
     /* Mutex to update the crud node state in a mutually exclusive way */
@@ -168,6 +220,9 @@ typedef struct crud_node_ {
     /* back pointer to Crud Mgr for convenience */
     crud_mgr_t *crud_mgr;
 
+    /* Shard of the Crud Mgr this node is accounted in, NULL if not sharded */
+    crud_mgr_shard_t *shard;
+
     uint32_t crud_node_status;
 
     crud_op_type_t curr_op;
@@ -180,6 +235,15 @@ typedef struct crud_node_ {
 
     pthread_cond_t create_thread_cv;
 
+    /* Readers count, writer and slow bits, updated with CAS only */
+    uint64_t fast_word;
+
+    /* Threads inside the slow path of this node, protected by state_mutex */
+    uint32_t n_slow_path_users;
+
+    /* Slow path waits here for fast path grants to be released */
+    pthread_cond_t fast_drain_cv;
+
     uint8_t counter [crud_node_no_op_index + 1];
    glthread_t crud_node_glue[crud_node_no_op_index + 1];
 
@@ -203,6 +267,24 @@ crud_node_get_from_crud_node_glue (
 void
 crud_mgr_init (crud_mgr_t *crud_mgr);
 
+/* Same as crud_mgr_init(), but Read/Write bookkeeping is split over
+    CRUD_MGR_N_SHARDS shards, use it for containers with many independent nodes */
+void
+crud_mgr_init_sharded (crud_mgr_t *crud_mgr);
+
+/* Enable/Disable the lock free fast path for uncontended Read/Write requests,
+    enabled by default. Set it before any crud node is initialized */
+void
+crud_mgr_set_fast_path (crud_mgr_t *crud_mgr, bool enable);
+
+/* Enable/Disable per state transition logs, enabled by default */
+void
+crud_mgr_set_logging (bool enable);
+
+/* Total number of Crud Nodes, aggregated over the shards */
+uint64_t
+crud_mgr_get_n_crud_nodes (crud_mgr_t *crud_mgr);
+
 void
 crud_node_init (crud_node_t *crud_node, crud_mgr_t *crud_mgr);
 
@@ -4,4 +4,8 @@ rm -f exe
 g++ -g -c CrudMgr.cpp -o CrudMgr.o
 g++ -g -c gluethread/glthread.c -o  gluethread/glthread.o
 g++ -g -c testapp.cpp -o testapp.o
-g++ -g CrudMgr.o gluethread/glthread.o testapp.o -o exe -lpthread
\ No newline at end of file
+g++ -g CrudMgr.o gluethread/glthread.o testapp.o -o exe -lpthread
+rm -f crud_bench
+g++ -g -O2 -c CrudMgr.cpp -o CrudMgr_bench.o
+g++ -g -O2 -c crud_bench.cpp -o crud_bench.o
+g++ -g CrudMgr_bench.o gluethread/glthread.o crud_bench.o -o crud_bench -lpthread
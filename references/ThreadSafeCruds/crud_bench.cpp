@@ -0,0 +1,176 @@
+/* Contention benchmark for the Crud Mgr, built on the student list of testapp.cpp.
+    Threads do random Read (90%) / Write (10%) requests on students and we report
+    granted requests per second for each Crud Mgr mode :
+        locked  : mutex/CV state machine, one manager wide mutex
+        sharded : mutex/CV state machine, manager bookkeeping split in shards
+        fast    : CAS fast path for uncontended requests, mutex/CV otherwise
+    Usage : ./crud_bench [n_threads] [n_students] [run_ms] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <memory.h>
+#include <cstddef>
+#include <time.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "gluethread/glthread.h"
+#include "CrudMgr.h"
+
+#define BENCH_MAX_THREADS   64
+#define BENCH_WRITE_PCT     10
+
+typedef struct stud_ {
+
+    int rollno;
+    uint32_t ip_addr;
+    glthread_t glue;
+    crud_node_t crud_node;
+} stud_t ;
+
+typedef struct bench_thread_ {
+
+    pthread_t thread;
+    unsigned int seed;
+    uint64_t n_ops;
+    uint64_t n_rejected;
+    uint64_t checksum;
+} bench_thread_t;
+
+static stud_t **studs;
+static int n_studs;
+static volatile bool bench_stop;
+
+static void *
+bench_thread_fn (void *arg) {
+
+    bench_thread_t *bt = (bench_thread_t *)arg;
+    stud_t *stud;
+    bool write;
+
+    while (!__atomic_load_n (&bench_stop, __ATOMIC_RELAXED)) {
+
+        stud = studs[rand_r(&bt->seed) % n_studs];
+        write = (rand_r(&bt->seed) % 100) < BENCH_WRITE_PCT;
+
+        if (write ? !crud_request_write(&stud->crud_node) :
+                    !crud_request_read(&stud->crud_node)) {
+            bt->n_rejected++;
+            continue;
+        }
+
+        if (write) {
+            stud->ip_addr++;
+        }
+        else {
+            bt->checksum += stud->ip_addr;
+        }
+
+        crud_request_release(&stud->crud_node);
+        bt->n_ops++;
+    }
+    return NULL;
+}
+
+static double
+bench_now_sec (void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double
+bench_run (const char *mode, int n_threads, int run_ms) {
+
+    crud_mgr_t *crud_mgr = (crud_mgr_t *)calloc (1, sizeof (crud_mgr_t));
+    bench_thread_t bt[BENCH_MAX_THREADS];
+    uint64_t n_ops = 0, n_rejected = 0;
+    double start, elapsed;
+    int i;
+
+    if (strcmp (mode, "locked") == 0) {
+        crud_mgr_init (crud_mgr);
+        crud_mgr_set_fast_path (crud_mgr, false);
+    }
+    else if (strcmp (mode, "sharded") == 0) {
+        crud_mgr_init_sharded (crud_mgr);
+        crud_mgr_set_fast_path (crud_mgr, false);
+    }
+    else {
+        crud_mgr_init (crud_mgr);
+    }
+
+    studs = (stud_t **)calloc (n_studs, sizeof (stud_t *));
+    for (i = 0; i < n_studs; i++) {
+        studs[i] = (stud_t *)calloc (1, sizeof (stud_t));
+        studs[i]->rollno = i + 1;
+        studs[i]->ip_addr = i + 1;
+        crud_node_init (&studs[i]->crud_node, crud_mgr);
+    }
+
+    bench_stop = false;
+    start = bench_now_sec ();
+    for (i = 0; i < n_threads; i++) {
+        memset (&bt[i], 0, sizeof (bt[i]));
+        bt[i].seed = i + 1;
+        pthread_create (&bt[i].thread, NULL, bench_thread_fn, &bt[i]);
+    }
+    usleep (run_ms * 1000);
+    __atomic_store_n (&bench_stop, true, __ATOMIC_RELAXED);
+
+    for (i = 0; i < n_threads; i++) {
+        pthread_join (bt[i].thread, NULL);
+        n_ops += bt[i].n_ops;
+        n_rejected += bt[i].n_rejected;
+    }
+    elapsed = bench_now_sec () - start;
+    assert (n_rejected == 0);
+
+    for (i = 0; i < n_studs; i++) {
+        crud_node_destroy (&studs[i]->crud_node);
+        free (studs[i]);
+    }
+    free (studs);
+    crud_mgr_destroy (crud_mgr);
+    free (crud_mgr);
+    return n_ops / elapsed;
+}
+
+int
+main (int argc, char **argv) {
+
+    int max_threads = (argc > 1) ? atoi (argv[1]) : 8;
+    int max_studs = (argc > 2) ? atoi (argv[2]) : 4096;
+    int run_ms = (argc > 3) ? atoi (argv[3]) : 300;
+    const char *modes[] = {"locked", "sharded", "fast"};
+    int n_threads, m, r;
+
+    if (max_threads < 1 || max_threads > BENCH_MAX_THREADS) max_threads = 8;
+    if (max_studs < 1) max_studs = 4096;
+
+    int studs_per_run[] = {1, max_studs};
+
+    crud_mgr_set_logging (false);
+
+    printf ("%8s %8s %14s %14s %14s\n", "students", "threads",
+            "locked ops/s", "sharded ops/s", "fast ops/s");
+
+    /* One hot student, then requests spread over many students */
+    for (r = 0; r < 2; r++) {
+
+        n_studs = studs_per_run[r];
+
+        for (n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+
+            printf ("%8d %8d", n_studs, n_threads);
+            for (m = 0; m < 3; m++) {
+                printf (" %14.0f", bench_run (modes[m], n_threads, run_ms));
+                fflush (stdout);
+            }
+            printf ("\n");
+        }
+    }
+    return 0;
+}
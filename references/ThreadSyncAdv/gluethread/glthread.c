@@ -203,6 +203,118 @@ glthread_get_first_node(glthread_t *base_glthread) {
 	return base_glthread->right;
 }
 
+void
+init_glthread_skip_node(glthread_skip_node_t *skip_node){
+
+    unsigned int i;
+
+    for(i = 0; i < GLTHREAD_SKIPLIST_MAX_LEVEL; i++)
+        init_glthread(&skip_node->levels[i]);
+    skip_node->n_levels = 0;
+}
+
+void
+glthread_skiplist_init(glthread_skiplist_t *skiplist,
+                       int (*comp_fn)(void *, void *),
+                       int offset){
+
+    init_glthread_skip_node(&skiplist->head);
+    skiplist->head.n_levels = GLTHREAD_SKIPLIST_MAX_LEVEL;
+    skiplist->comp_fn = comp_fn;
+    skiplist->offset = offset;
+    skiplist->count = 0;
+    skiplist->seed = 0x9E3779B9;
+}
+
+static unsigned int
+glthread_skiplist_random_level(glthread_skiplist_t *skiplist){
+
+    unsigned int level = 1;
+    unsigned int x = skiplist->seed;
+
+    /* xorshift32 */
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    skiplist->seed = x;
+
+    /* Two bits per level, p = 1/4 */
+    while(level < GLTHREAD_SKIPLIST_MAX_LEVEL && (x & 3) == 0){
+        level++;
+        x >>= 2;
+    }
+    return level;
+}
+
+/* glthread of a node at level 'level' back to its skip node */
+#define GLTHREAD_TO_SKIP_NODE(glthreadptr, level)  \
+    ((glthread_skip_node_t *)((glthreadptr) - (level)))
+
+void
+glthread_skiplist_insert(glthread_skiplist_t *skiplist,
+                         glthread_skip_node_t *skip_node){
+
+    glthread_t *prev[GLTHREAD_SKIPLIST_MAX_LEVEL];
+    glthread_t *curr;
+    void *new_data;
+    int level;
+
+    new_data = GLTHREAD_GET_USER_DATA_FROM_OFFSET(skip_node, skiplist->offset);
+    init_glthread_skip_node(skip_node);
+
+    /* On every level, find the last node which stays before the new one */
+    curr = &skiplist->head.levels[GLTHREAD_SKIPLIST_MAX_LEVEL - 1];
+    for(level = GLTHREAD_SKIPLIST_MAX_LEVEL - 1; level >= 0; level--){
+
+        while(curr->right &&
+              skiplist->comp_fn(new_data,
+                GLTHREAD_GET_USER_DATA_FROM_OFFSET(
+                    GLTHREAD_TO_SKIP_NODE(curr->right, level), skiplist->offset)) != -1){
+            curr = curr->right;
+        }
+        prev[level] = curr;
+        /* Same node, one level down */
+        if(level) curr = curr - 1;
+    }
+
+    skip_node->n_levels = glthread_skiplist_random_level(skiplist);
+    for(level = 0; level < (int)skip_node->n_levels; level++){
+        glthread_add_next(prev[level], &skip_node->levels[level]);
+    }
+    skiplist->count++;
+}
+
+void
+glthread_skiplist_remove(glthread_skiplist_t *skiplist,
+                         glthread_skip_node_t *skip_node){
+
+    unsigned int level;
+
+    if(!skip_node->n_levels) return;
+
+    for(level = 0; level < skip_node->n_levels; level++){
+        remove_glthread(&skip_node->levels[level]);
+    }
+    skip_node->n_levels = 0;
+    skiplist->count--;
+}
+
+glthread_skip_node_t *
+glthread_skiplist_first(glthread_skiplist_t *skiplist){
+
+    return (glthread_skip_node_t *)skiplist->head.levels[0].right;
+}
+
+glthread_skip_node_t *
+glthread_skiplist_dequeue_first(glthread_skiplist_t *skiplist){
+
+    glthread_skip_node_t *skip_node = glthread_skiplist_first(skiplist);
+
+    if(skip_node)
+        glthread_skiplist_remove(skiplist, skip_node);
+    return skip_node;
+}
+
 #if 0
 void *
 gl_thread_search(glthread_t *glthread_head, 
@@ -98,6 +98,68 @@ dequeue_glthread_first(glthread_t *base_glthread);
 glthread_t *
 glthread_get_first_node(glthread_t *base_glthread);
 
+/* Skip list of glthreads, an ordered alternative to glthread_priority_insert( ).
+
+   Embed a glthread_skip_node_t in the structure instead of a glthread_t.
+   Each node sits on level 0 and, with probability 1/4 per level, on the
+   levels above it, every level being a plain glthread list. Insert is
+   O(log n) expected, first and dequeue_first are O(1), remove of any node
+   is O(number of its levels). Level 0 holds every node in order and can be
+   walked with ITERATE_GLTHREAD_BEGIN(GLTHREAD_SKIPLIST_BASE(sl), curr), curr
+   then points to the glthread_skip_node_t, so GLTHREAD_TO_STRUCT works on
+   the embedded skip node field.
+
+   comp_fn has the glthread_priority_insert( ) contract : a new node goes
+   before the first node for which comp_fn(new, node) returns -1, i.e. after
+   all its equals. The list is not thread safe. */
+
+#define GLTHREAD_SKIPLIST_MAX_LEVEL 8
+
+typedef struct _glthread_skip_node{
+
+    glthread_t levels[GLTHREAD_SKIPLIST_MAX_LEVEL];
+    unsigned int n_levels;  /* 0 when not in a list */
+} glthread_skip_node_t;
+
+typedef struct _glthread_skiplist{
+
+    glthread_skip_node_t head;
+    int (*comp_fn)(void *, void *);
+    int offset;     /* of the glthread_skip_node_t in the user structure */
+    unsigned int count;
+    unsigned int seed;
+} glthread_skiplist_t;
+
+#define GLTHREAD_SKIPLIST_BASE(skiplistptr)   (&(skiplistptr)->head.levels[0])
+
+#define IS_GLTHREAD_SKIPLIST_EMPTY(skiplistptr)  \
+    ((skiplistptr)->head.levels[0].right == 0)
+
+#define IS_GLTHREAD_SKIP_NODE_LINKED(skipnodeptr)  \
+    ((skipnodeptr)->n_levels != 0)
+
+void
+init_glthread_skip_node(glthread_skip_node_t *skip_node);
+
+void
+glthread_skiplist_init(glthread_skiplist_t *skiplist,
+                       int (*comp_fn)(void *, void *),
+                       int offset);
+
+void
+glthread_skiplist_insert(glthread_skiplist_t *skiplist,
+                         glthread_skip_node_t *skip_node);
+
+void
+glthread_skiplist_remove(glthread_skiplist_t *skiplist,
+                         glthread_skip_node_t *skip_node);
+
+glthread_skip_node_t *
+glthread_skiplist_first(glthread_skiplist_t *skiplist);
+
+glthread_skip_node_t *
+glthread_skiplist_dequeue_first(glthread_skiplist_t *skiplist);
+
 #if 0
 void *
 gl_thread_search(glthread_t *base_glthread,
@@ -34,6 +34,8 @@
 #include <memory.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
 
 typedef struct _person{
 
@@ -55,6 +57,86 @@ senior_citizen(person_t *p1, person_t *p2){
 
 GLTHREAD_TO_STRUCT(thread_to_person, person_t, glthread);
 
+/* Priority queue of N random priorities, filled then drained, with
+   glthread_priority_insert( ) vs the skip list */
+typedef struct _job{
+
+    int priority;
+    glthread_t glthread;
+    glthread_skip_node_t skip_node;
+} job_t;
+
+static int
+job_priority_cmp(void *j1, void *j2){
+
+    if(((job_t *)j1)->priority < ((job_t *)j2)->priority) return -1;
+    return 1;
+}
+
+static double
+now_sec(void){
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* The list baseline is O(n^2), 64000 jobs take minutes. Returns -1 if
+   the skip list dequeues out of order */
+#define BENCH_DEFAULT_MAX_JOBS  4000
+#define BENCH_FULL_MAX_JOBS     64000
+
+static int
+priority_queue_bench(int max_jobs){
+
+    int n, i, prev;
+    job_t *jobs;
+    glthread_t base_glthread;
+    glthread_skiplist_t skiplist;
+    glthread_skip_node_t *skip_node;
+    double start, list_sec, skip_sec;
+
+    printf("%8s %16s %16s\n", "jobs", "list ns/job", "skiplist ns/job");
+
+    for(n = 1000; n <= max_jobs; n *= 4){
+
+        jobs = calloc(n, sizeof(job_t));
+        srand(n);
+        for(i = 0; i < n; i++) jobs[i].priority = rand();
+
+        init_glthread(&base_glthread);
+        start = now_sec();
+        for(i = 0; i < n; i++)
+            glthread_priority_insert(&base_glthread, &jobs[i].glthread,
+                job_priority_cmp, offset(job_t, glthread));
+        for(i = 0; i < n; i++)
+            dequeue_glthread_first(&base_glthread);
+        list_sec = now_sec() - start;
+
+        glthread_skiplist_init(&skiplist, job_priority_cmp, offset(job_t, skip_node));
+        start = now_sec();
+        for(i = 0; i < n; i++)
+            glthread_skiplist_insert(&skiplist, &jobs[i].skip_node);
+        prev = -1;
+        for(i = 0; i < n; i++){
+            skip_node = glthread_skiplist_dequeue_first(&skiplist);
+            job_t *job = (job_t *)GLTHREAD_GET_USER_DATA_FROM_OFFSET(skip_node,
+                            offset(job_t, skip_node));
+            if(job->priority < prev){
+                printf("skiplist out of order !\n");
+                free(jobs);
+                return -1;
+            }
+            prev = job->priority;
+        }
+        skip_sec = now_sec() - start;
+
+        printf("%8d %16.1f %16.1f\n", n, list_sec * 1e9 / n, skip_sec * 1e9 / n);
+        free(jobs);
+    }
+    return 0;
+}
+
 int main(int argc, char **argv){
 
     person_t person[5];
@@ -85,6 +167,10 @@ int main(int argc, char **argv){
         person_t *p = thread_to_person(curr);
         printf("Age = %d\n", p->age);
     } ITERATE_GLTHREAD_END(&base_glthread, curr);
-    
+
+    /* ./test bench runs the full size bench */
+    if(priority_queue_bench(argc > 1 && strcmp(argv[1], "bench") == 0 ?
+                BENCH_FULL_MAX_JOBS : BENCH_DEFAULT_MAX_JOBS) < 0)
+        return 1;
     return 0;
 }
@@ -13,44 +13,136 @@
   gcc -g -c mr_demo.c -o mr_demo.o
   gcc -g threadlib.o mr_demo.o gluethread/glthread.o -o exe -lpthread
   */
+
+/* Counts the words of a text, first split in one piece per mapper, then
+   streamed to the mappers line by line. Mapper results and the reducer
+   result are a malloc'd word count */
+
+#define DEMO_LINES  1000
+
+static const char *demo_line = "the quick brown fox jumps over the lazy dog\n";
+
+static mr_iovec_t *
+iovec_new(void *base, uint32_t data_len) {
+
+    mr_iovec_t *iovec = calloc(1, sizeof(mr_iovec_t));
+    iovec->base = base;
+    iovec->data_len = data_len;
+    return iovec;
+}
+
 void
 app_mapper_fn(thread_t *thread, mr_iovec_t *input, mr_iovec_t **output) {
 
-    printf("mapper %s running \n", thread->name);
-    
+    uint32_t i;
+    uint64_t *words = calloc(1, sizeof(uint64_t));
+    char *text = input ? (char *)input->base : NULL;
+
+    for (i = 0; text && i < input->data_len; i++) {
+        if (text[i] != ' ' && text[i] != '\n' &&
+                (i == 0 || text[i - 1] == ' ' || text[i - 1] == '\n')) {
+            (*words)++;
+        }
+    }
+    *output = iovec_new(words, sizeof(uint64_t));
 }
 
+/* Merges a batch of mapper results into the running total */
 void
 app_reducer_fn(thread_t *thread, 
                           mr_iovec_t **input_arr,
                           int arr_size,
                           mr_iovec_t *output) {
 
-    printf("Reducer %s running \n", thread->name);
+    int i;
+
+    if (!output->base) {
+        output->base = calloc(1, sizeof(uint64_t));
+        output->data_len = sizeof(uint64_t);
+    }
+
+    for (i = 0; i < arr_size; i++) {
+        *(uint64_t *)output->base += *(uint64_t *)input_arr[i]->base;
+    }
 }
 
 void
 app_reducer_output_reader (mr_iovec_t *data) {
 
-    printf("%s() called \n", __FUNCTION__);
+    printf("%s() : %llu words\n", __FUNCTION__,
+            (unsigned long long)*(uint64_t *)data->base);
 }
 
+/* Cuts the text on line boundaries, one piece per mapper */
 void
 file_splitter(mr_iovec_t *app_data, mr_iovec_t **output, int arr_size) {
 
+    int i;
+    char *text = (char *)app_data->base;
+    uint32_t start = 0, end;
+
+    for (i = 0; i < arr_size; i++) {
+
+        end = (uint64_t)app_data->data_len * (i + 1) / arr_size;
+        while (end > 0 && end < app_data->data_len && text[end - 1] != '\n') end++;
+        if (end < start) end = start;
+        output[i] = iovec_new(text + start, end - start);
+        start = end;
+    }
+}
+
+static void
+iovec_free(mr_iovec_t *iovec) {
+
+    free(iovec);
+}
+
+static void
+iovec_and_data_free(mr_iovec_t *iovec) {
+
+    free(iovec->base);
+    free(iovec);
+}
+
+static void
+reducer_output_free(mr_iovec_t *iovec) {
 
+    free(iovec->base);
 }
 
 int 
-main(int argc, char *argv) {
+main(int argc, char **argv) {
 
-    map_reduce_t *mr = map_reduce_init(4);
-    map_reduce_set_app_data(mr, 0);
+    int i;
+    size_t line_len = strlen(demo_line);
+    char *text = malloc(line_len * DEMO_LINES);
+    mr_iovec_t app_data = { text, line_len * DEMO_LINES };
+
+    for (i = 0; i < DEMO_LINES; i++) {
+        memcpy(text + i * line_len, demo_line, line_len);
+    }
+
+    /* 0 : one mapper per CPU */
+    map_reduce_t *mr = map_reduce_init(0);
+    map_reduce_set_app_data(mr, &app_data);
     map_reduce_set_data_splitter(mr, file_splitter);
     map_reduce_set_mapper_fn(mr, app_mapper_fn);
     map_reduce_set_reducer_fn(mr, app_reducer_fn);
     map_reduce_set_reducer_output_reader (mr, app_reducer_output_reader);
-    map_reduce_register_cleanup_fns(mr, 0, 0, 0);
+    map_reduce_register_cleanup_fns(mr, iovec_free, iovec_and_data_free,
+                                                    reducer_output_free);
+
+    printf("%u mappers, expecting %d words\n", mr->n_mappers, DEMO_LINES * 9);
     map_reduce_start(mr);
+
+    /* Same mappers, fed line by line */
+    map_reduce_stream_begin(mr);
+    for (i = 0; i < DEMO_LINES; i++) {
+        map_reduce_stream_feed(mr, iovec_new(text + i * line_len, line_len));
+    }
+    map_reduce_stream_end(mr);
+
+    map_reduce_destroy(mr);
+    free(text);
     return 0;
-}
\ No newline at end of file
+}
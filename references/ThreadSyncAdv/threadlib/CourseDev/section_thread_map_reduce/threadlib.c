@@ -20,6 +20,7 @@
 #include <stdlib.h>
 #include <memory.h>
 #include <assert.h>
+#include <unistd.h>
 #include "gluethread/glthread.h"
 #include "threadlib.h"
 #include "bitsop.h"
@@ -375,13 +376,27 @@ wait_queue_destroy (wait_queue_t *wq) {
 */
 
 map_reduce_t *
-map_reduce_init(uint8_t n_mappers) {
+map_reduce_init(uint32_t n_mappers) {
 
     map_reduce_t *mr = calloc(1, sizeof(map_reduce_t) );
+    long n_cpus;
+
+    if (!n_mappers) {
+        n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        n_mappers = n_cpus > 0 ? n_cpus : 1;
+    }
+
     mr->n_mappers = n_mappers;
-    mr->mappers_in_progress = n_mappers;
+    mr->mapper_input_array = calloc(n_mappers, sizeof(mr_iovec_t *));
+    mr->mapper_thread_array = calloc(n_mappers, sizeof(thread_t *));
+    mr->reducer_input_array = calloc(n_mappers * MAP_REDUCE_CHUNKS_PER_MAPPER,
+                                                    sizeof(mr_iovec_t *));
     pthread_mutex_init(&mr->mr_mutex, NULL);
-    wait_queue_init(&mr->wq_until_all_mappers_finish);
+    init_glthread(&mr->input_queue);
+    init_glthread(&mr->result_queue);
+    wait_queue_init(&mr->wq_mappers_idle);
+    wait_queue_init(&mr->wq_input_full);
+    wait_queue_init(&mr->wq_reducer_idle);
     sem_init(&mr->reducer_finished_semaphore, 0, 0);
     return mr;
 }
@@ -428,8 +443,10 @@ map_reduce_set_reducer_output_reader (map_reduce_t *mr,
     mr->reducer_output_reader = reducer_output_reader;
 }
 
+/* Wait queue predicates, true when the caller has to block */
+
 static bool
- wq_is_any_mapper_in_progress(void *arg, pthread_mutex_t **mutex)  {
+ wq_mapper_has_no_input(void *arg, pthread_mutex_t **mutex)  {
 
      map_reduce_t *mr = (map_reduce_t *)arg;
 
@@ -438,50 +455,47 @@ static bool
         *mutex = &mr->mr_mutex;
     }
 
-    return mr->mappers_in_progress ? true : false;
+    return IS_GLTHREAD_LIST_EMPTY(&mr->input_queue) && !mr->shutdown;
  }
 
- static void
- map_reduce_cleanup(map_reduce_t *mr) {
+static bool
+ wq_input_is_full(void *arg, pthread_mutex_t **mutex)  {
 
-    int i = 0;
+     map_reduce_t *mr = (map_reduce_t *)arg;
 
-     for (i = 0; i < mr->n_mappers; i++) {
+    if (mutex) {
+        pthread_mutex_lock(&mr->mr_mutex);
+        *mutex = &mr->mr_mutex;
+    }
 
-         if (mr->mapper_input_array [i] &&
-                mr->mapper_input_array_cleanup ) {
-             mr->mapper_input_array_cleanup(mr->mapper_input_array[i]);
-             mr->mapper_input_array[i] = NULL;
-         }
-     }
+    return mr->chunks_in_progress >= mr->n_mappers * MAP_REDUCE_CHUNKS_PER_MAPPER;
+ }
 
-    for (i = 0; i < mr->n_mappers; i++) {
+static bool
+ wq_reducer_has_no_work(void *arg, pthread_mutex_t **mutex)  {
 
-         if (mr->mapper_result_array[i] &&
-                mr->mapper_output_array_cleanup ) {
-             mr->mapper_output_array_cleanup(mr->mapper_result_array[i]);
-             mr->mapper_result_array[i] = NULL;
-         }
-     }
+     map_reduce_t *mr = (map_reduce_t *)arg;
 
-     for (i = 0; i < mr->n_mappers; i++){
+    if (mutex) {
+        pthread_mutex_lock(&mr->mr_mutex);
+        *mutex = &mr->mr_mutex;
+    }
 
-         if (mr->mapper_thread_array[i] ) { 
-             thread_free(mr->mapper_thread_array[i]);
-             mr->mapper_thread_array[i] = NULL;
-         }
-     }
+    /* Work is either mapped chunks to merge, or the end of the run
+       to report once the last chunk is merged */
+    return IS_GLTHREAD_LIST_EMPTY(&mr->result_queue) &&
+                !(mr->is_streaming && mr->input_done && !mr->chunks_in_progress) &&
+                !mr->shutdown;
+ }
+
+ static void
+ map_reduce_cleanup(map_reduce_t *mr) {
 
      if (mr->reducer_result.data_len && mr->reducer_output_cleanup) {
          mr->reducer_output_cleanup(&mr->reducer_result);
-         mr->reducer_result.base = NULL;
-         mr->reducer_result.data_len = 0;
-     }
-
-     if (mr->reducer_thread) {
-         thread_free(mr->reducer_thread);
-         mr->reducer_thread = NULL;
      }
+     mr->reducer_result.base = NULL;
+     mr->reducer_result.data_len = 0;
  }
 
 
@@ -504,68 +518,127 @@ typedef struct mapper_data_ {
     map_reduce_t *mr;
 } mapper_data_t;
 
+/* Mappers live as long as mr, taking chunks off the input queue and
+   handing their results to the reducer one chunk at a time */
 static void *
 mapper_wrapper(void *arg) {
 
     thread_t *thread;
     map_reduce_t *mr;
+    mr_chunk_t *chunk;
     mapper_data_t *map_data = (mapper_data_t *)arg;
     thread = map_data->mapper_thread;
     mr = map_data->mr;
-    printf("Mapper %s Start\n", thread->name);
-    map_data->mr->mapper_fn(
-                thread, mr->mapper_input_array[map_data->mapper_index],
-                &mr->mapper_result_array[map_data->mapper_index] );
-    pthread_mutex_lock(&mr->mr_mutex);
-    mr->mappers_in_progress--;
-    printf("Mapper %s Done\n", thread->name);
-    wait_queue_broadcast(&mr->wq_until_all_mappers_finish, false);
-    pthread_mutex_unlock(&mr->mr_mutex);
+
+    while (1) {
+
+        /* Returns with mr_mutex locked */
+        wait_queue_test_and_wait(&mr->wq_mappers_idle,
+                                                wq_mapper_has_no_input, (void *)mr);
+        if (mr->shutdown) {
+            pthread_mutex_unlock(&mr->mr_mutex);
+            break;
+        }
+        chunk = glue_to_mr_chunk(dequeue_glthread_first(&mr->input_queue));
+        pthread_mutex_unlock(&mr->mr_mutex);
+
+        mr->mapper_fn(thread, chunk->input, &chunk->result);
+
+        pthread_mutex_lock(&mr->mr_mutex);
+        glthread_add_last(&mr->result_queue, &chunk->glue);
+        wait_queue_signal(&mr->wq_reducer_idle, false);
+        pthread_mutex_unlock(&mr->mr_mutex);
+    }
+
     free(map_data);
+    return NULL;
 }
 
+/* The reducer merges whatever the mappers have finished so far, and
+   reports the end of a run once the last fed chunk is merged */
 static void *
 reducer_wrapper(void *arg) {
 
     map_reduce_t *mr = (map_reduce_t *)arg;
-    
-    pthread_mutex_lock(&mr->mr_mutex);
-    mr->is_reducer_in_progress = true;
-    pthread_mutex_unlock(&mr->mr_mutex);  
-    printf("Reducer Started\n");
+    glthread_t *curr;
+    mr_chunk_t *chunk;
+    int i, n;
+
+    while (1) {
+
+        /* Returns with mr_mutex locked */
+        wait_queue_test_and_wait(&mr->wq_reducer_idle,
+                                                wq_reducer_has_no_work, (void *)mr);
+        if (mr->shutdown) {
+            pthread_mutex_unlock(&mr->mr_mutex);
+            break;
+        }
+
+        if (IS_GLTHREAD_LIST_EMPTY(&mr->result_queue)) {
+            mr->is_streaming = false;
+            pthread_mutex_unlock(&mr->mr_mutex);
+            sem_post(&mr->reducer_finished_semaphore);
+            continue;
+        }
+
+        /* Mappers only append to the result queue, so the first n chunks
+           are still the batch once the reducer fn returns */
+        n = 0;
+        ITERATE_GLTHREAD_BEGIN(&mr->result_queue, curr) {
+            mr->reducer_input_array[n++] = glue_to_mr_chunk(curr)->result;
+        } ITERATE_GLTHREAD_END(&mr->result_queue, curr);
+        mr->is_reducer_in_progress = true;
+        pthread_mutex_unlock(&mr->mr_mutex);
+
+        mr->reducer_fn( mr->reducer_thread, 
+                                    mr->reducer_input_array, 
+                                    n, 
+                                    &mr->reducer_result);
 
-    mr->reducer_fn( mr->reducer_thread, 
-                                (void *)mr->mapper_result_array, 
-                                mr->n_mappers, 
-                                &mr->reducer_result);
+        pthread_mutex_lock(&mr->mr_mutex);
+        for (i = 0; i < n; i++) {
+
+            chunk = glue_to_mr_chunk(dequeue_glthread_first(&mr->result_queue));
+            if (chunk->input && mr->mapper_input_array_cleanup) {
+                mr->mapper_input_array_cleanup(chunk->input);
+            }
+            if (chunk->result && mr->mapper_output_array_cleanup) {
+                mr->mapper_output_array_cleanup(chunk->result);
+            }
+            free(chunk);
+        }
+        mr->chunks_in_progress -= n;
+        mr->is_reducer_in_progress = false;
+        wait_queue_broadcast(&mr->wq_input_full, false);
+        pthread_mutex_unlock(&mr->mr_mutex);
+    }
 
-    printf("Reducer Done\n");
-    pthread_mutex_lock(&mr->mr_mutex);
-    mr->is_reducer_in_progress = false;
-    pthread_mutex_unlock(&mr->mr_mutex);  
-    sem_post(&mr->reducer_finished_semaphore);
+    return NULL;
 }
 
 void
-map_reduce_start (map_reduce_t *mr) {
+map_reduce_stream_begin(map_reduce_t *mr) {
 
-    int i;
+    uint32_t i;
     mapper_data_t *map_data;
     char thread_name[32];
 
-    assert(mr->mappers_in_progress == mr->n_mappers);
     assert(mr->mapper_fn);
+    assert(mr->reducer_fn);
 
-    mr->input_data_splitter(mr->app_data,
-                                            mr->mapper_input_array,
-                                            mr->n_mappers);
+    pthread_mutex_lock(&mr->mr_mutex);
+    assert(!mr->is_streaming);
+    assert(!mr->chunks_in_progress);
+    mr->is_streaming = true;
+    mr->input_done = false;
+    pthread_mutex_unlock(&mr->mr_mutex);
 
-    mr->mappers_in_progress = mr->n_mappers;
+    /* Threads of the previous runs are waiting for input */
+    if (mr->reducer_thread) return;
 
     for (i = 0; i < mr->n_mappers; i++) {
 
-        assert(!mr->mapper_thread_array[i]);
-        sprintf(thread_name, "Mapper_%d", i);
+        sprintf(thread_name, "Mapper_%u", i);
         mr->mapper_thread_array[i] = thread_create(0, thread_name);
         map_data = calloc(1, sizeof (mapper_data_t));
         map_data->mapper_index = i;
@@ -576,18 +649,40 @@ map_reduce_start (map_reduce_t *mr) {
                             (void *)map_data);
     }
 
-    wait_queue_test_and_wait(&mr->wq_until_all_mappers_finish,
-                                                wq_is_any_mapper_in_progress,  (void *)mr);
-
-    printf("Mapper Signalled, Mappers in progress = %d\n", mr->mappers_in_progress);
-    assert(!mr->mappers_in_progress);
-    pthread_mutex_unlock(mr->wq_until_all_mappers_finish.appln_mutex);
-    
-    /* Now launch Reducer fn */
     mr->reducer_thread = thread_create(0, "Reducer");
     thread_run(mr->reducer_thread,
                             reducer_wrapper, 
                             (void *) mr );
+}
+
+void
+map_reduce_stream_feed(map_reduce_t *mr, mr_iovec_t *input) {
+
+    mr_chunk_t *chunk = calloc(1, sizeof(mr_chunk_t));
+
+    chunk->input = input;
+    init_glthread(&chunk->glue);
+
+    /* Block while enough chunks are queued or being mapped and reduced,
+       returns with mr_mutex locked */
+    wait_queue_test_and_wait(&mr->wq_input_full,
+                                            wq_input_is_full, (void *)mr);
+
+    assert(mr->is_streaming && !mr->input_done);
+    mr->chunks_in_progress++;
+    glthread_add_last(&mr->input_queue, &chunk->glue);
+    wait_queue_signal(&mr->wq_mappers_idle, false);
+    pthread_mutex_unlock(&mr->mr_mutex);
+}
+
+void
+map_reduce_stream_end(map_reduce_t *mr) {
+
+    pthread_mutex_lock(&mr->mr_mutex);
+    assert(mr->is_streaming);
+    mr->input_done = true;
+    wait_queue_signal(&mr->wq_reducer_idle, false);
+    pthread_mutex_unlock(&mr->mr_mutex);
 
     sem_wait(&mr->reducer_finished_semaphore);
 
@@ -598,6 +693,28 @@ map_reduce_start (map_reduce_t *mr) {
     map_reduce_cleanup(mr);
 }
 
+void
+map_reduce_start (map_reduce_t *mr) {
+
+    uint32_t i;
+
+    assert(mr->input_data_splitter);
+
+    mr->input_data_splitter(mr->app_data,
+                                            mr->mapper_input_array,
+                                            mr->n_mappers);
+
+    map_reduce_stream_begin(mr);
+
+    for (i = 0; i < mr->n_mappers; i++) {
+
+        map_reduce_stream_feed(mr, mr->mapper_input_array[i]);
+        mr->mapper_input_array[i] = NULL;
+    }
+
+    map_reduce_stream_end(mr);
+}
+
 bool
 map_reduce_is_in_progress(map_reduce_t *mr) {
 
@@ -605,15 +722,46 @@ map_reduce_is_in_progress(map_reduce_t *mr) {
 
     pthread_mutex_lock(&mr->mr_mutex);
     
-    is_in_progress = mr->mappers_in_progress == 0 ? false : true;
-    if (is_in_progress) goto done;
-    is_in_progress = mr->is_reducer_in_progress ? true : false;
-    
-    done:
+    is_in_progress = mr->is_streaming || mr->chunks_in_progress ||
+                                    mr->is_reducer_in_progress;
+
     pthread_mutex_unlock(&mr->mr_mutex);
     return is_in_progress;
 }
 
+void
+map_reduce_destroy(map_reduce_t *mr) {
+
+    uint32_t i;
+
+    pthread_mutex_lock(&mr->mr_mutex);
+    assert(!mr->is_streaming);
+    mr->shutdown = true;
+    wait_queue_broadcast(&mr->wq_mappers_idle, false);
+    wait_queue_broadcast(&mr->wq_reducer_idle, false);
+    pthread_mutex_unlock(&mr->mr_mutex);
+
+    if (mr->reducer_thread) {
+
+        for (i = 0; i < mr->n_mappers; i++) {
+            pthread_join(mr->mapper_thread_array[i]->thread, NULL);
+            free(mr->mapper_thread_array[i]);
+        }
+        pthread_join(mr->reducer_thread->thread, NULL);
+        free(mr->reducer_thread);
+    }
+
+    wait_queue_destroy(&mr->wq_mappers_idle);
+    wait_queue_destroy(&mr->wq_input_full);
+    wait_queue_destroy(&mr->wq_reducer_idle);
+    sem_destroy(&mr->reducer_finished_semaphore);
+    pthread_mutex_destroy(&mr->mr_mutex);
+    free(mr->mapper_input_array);
+    free(mr->mapper_thread_array);
+    free(mr->reducer_input_array);
+    free(mr);
+}
+
 /* 
  ********************************************
    Map-Reduce Implementation Ends Here 
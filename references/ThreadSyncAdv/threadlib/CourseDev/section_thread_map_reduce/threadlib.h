@@ -191,12 +191,22 @@ typedef struct mr_iovec_ {
     uint32_t data_len;
 } mr_iovec_t;
 
-#define MAP_REDUCE_MAX_MAPPER   8
+/* Chunks fed and not yet reduced, per mapper. Feeding blocks beyond it */
+#define MAP_REDUCE_CHUNKS_PER_MAPPER    4
+
+/* A unit of input on its way through a mapper then the reducer */
+typedef struct mr_chunk_ {
+
+    mr_iovec_t *input;
+    mr_iovec_t *result;
+    glthread_t glue;
+} mr_chunk_t;
+GLTHREAD_TO_STRUCT(glue_to_mr_chunk, mr_chunk_t, glue);
 
 typedef struct map_reduce_ {
 
-    /* No of mappers */
-    uint8_t n_mappers;
+    /* No of mappers, one per online CPU if 0 is given to map_reduce_init */
+    uint32_t n_mappers;
     
     /* Application Data */
     mr_iovec_t *app_data;
@@ -208,18 +218,30 @@ typedef struct map_reduce_ {
 
     /* Mapper function */
     void  (*mapper_fn)(thread_t *, mr_iovec_t *, mr_iovec_t **);
-    /* No of mappers in progress */
-    uint8_t mappers_in_progress;
+    /* No of chunks fed and not yet reduced */
+    uint32_t chunks_in_progress;
     /* Mutex to update map-reduce state*/
     pthread_mutex_t mr_mutex;
-    /* Wait Queue until all mapers have finished */
-    wait_queue_t wq_until_all_mappers_finish;
-    /* Mapper input input array */
-    mr_iovec_t *mapper_input_array[MAP_REDUCE_MAX_MAPPER];
-    /* Mapper result array */
-    mr_iovec_t *mapper_result_array[MAP_REDUCE_MAX_MAPPER];
-    /* Mapper fn array */
-    thread_t *mapper_thread_array[MAP_REDUCE_MAX_MAPPER];
+    /* Chunks waiting for a mapper */
+    glthread_t input_queue;
+    /* Mapped chunks waiting for the reducer */
+    glthread_t result_queue;
+    /* Idle mappers wait here for input */
+    wait_queue_t wq_mappers_idle;
+    /* Feeders wait here while too many chunks are in progress */
+    wait_queue_t wq_input_full;
+    /* Reducer waits here for mapped chunks */
+    wait_queue_t wq_reducer_idle;
+    /* True between map_reduce_stream_begin( ) and the last chunk reduced */
+    bool is_streaming;
+    /* map_reduce_stream_end( ) called, no more chunks will be fed */
+    bool input_done;
+    /* map_reduce_destroy( ) called, mappers and reducer exit */
+    bool shutdown;
+    /* Mapper input input array, n_mappers entries */
+    mr_iovec_t **mapper_input_array;
+    /* Mapper threads, created on the first run and kept for the next ones */
+    thread_t **mapper_thread_array;
 
     /* Reducer Specific Attributes */
 
@@ -227,8 +249,11 @@ typedef struct map_reduce_ {
     thread_t *reducer_thread;
     /* Final reducer result */
     mr_iovec_t reducer_result;
-        /* Reducer function */
+    /* Reducer function, merges a batch of mapper results into the
+       reducer result, empty before the first batch of a run */
     void (*reducer_fn)(thread_t *, mr_iovec_t **, int, mr_iovec_t *);
+    /* Batch of mapper results handed to reducer_fn */
+    mr_iovec_t **reducer_input_array;
     /* Zero semaphore to wait until reducer is finished */
     sem_t reducer_finished_semaphore;
     /* True if reducer is in progress */
@@ -245,7 +270,7 @@ typedef struct map_reduce_ {
 /* Map-Reduce Implementation Ends Here */
 
 map_reduce_t *
-map_reduce_init(uint8_t n_mappers);
+map_reduce_init(uint32_t n_mappers);
 
 void
 map_reduce_set_data_splitter(map_reduce_t *mr, 
@@ -269,9 +294,22 @@ void
 map_reduce_set_reducer_output_reader (map_reduce_t *mr,
                                     void (*reducer_output_reader)(mr_iovec_t *iovec));
 
+/* Split app_data in n_mappers inputs and map-reduce them */
 void
 map_reduce_start(map_reduce_t *mr);
 
+/* Streaming mode : inputs are fed one by one to the mappers as they come,
+   and the reducer merges results as mappers finish them.
+   map_reduce_stream_end( ) waits for the last chunk to be reduced */
+void
+map_reduce_stream_begin(map_reduce_t *mr);
+
+void
+map_reduce_stream_feed(map_reduce_t *mr, mr_iovec_t *input);
+
+void
+map_reduce_stream_end(map_reduce_t *mr);
+
 bool
 map_reduce_is_in_progress(map_reduce_t *mr);
 
@@ -281,6 +319,10 @@ map_reduce_register_cleanup_fns(map_reduce_t *mr,
                 void (*mapper_output_array_cleanup)(mr_iovec_t *),
                 void (*reducer_output_cleanup)(mr_iovec_t *));
 
+/* Stop and join the mapper and reducer threads, free mr */
+void
+map_reduce_destroy(map_reduce_t *mr);
+
 #endif /* __THREAD_LIB__  */
 
 /*
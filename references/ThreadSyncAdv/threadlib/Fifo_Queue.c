@@ -2,6 +2,8 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <assert.h>
+#include <string.h>
+#include <sched.h>
 #include "Fifo_Queue.h"
 
 Fifo_Queue_t*
@@ -137,9 +139,303 @@ Fifo_insert_or_replace_at_index(
 
 
 
+
+/* Lock-free MPMC Queue Implementation Starts here */
+
+/* No of times blocking variants retry before going to sleep */
+#define FIFO_MPMC_SPIN_COUNT    128
+
+Fifo_Mpmc_Queue_t*
+Fifo_mpmc_initQ(uint32_t size){
+
+        uint32_t i, pow2 = 1;
+
+        assert(size);
+        while (pow2 < size) pow2 <<= 1;
+
+        Fifo_Mpmc_Queue_t *q = aligned_alloc(CACHE_LINE_SIZE,
+                                sizeof(Fifo_Mpmc_Queue_t));
+        memset(q, 0, sizeof(Fifo_Mpmc_Queue_t));
+        q->size = pow2;
+        q->mask = pow2 - 1;
+        q->cells = aligned_alloc(CACHE_LINE_SIZE,
+                        ((pow2 * sizeof(Fifo_mpmc_cell_t) + CACHE_LINE_SIZE - 1) /
+                        CACHE_LINE_SIZE) * CACHE_LINE_SIZE);
+
+        /* Slot i is free for the producer holding ticket i */
+        for (i = 0; i < pow2; i++) {
+                atomic_init(&q->cells[i].seq, i);
+                q->cells[i].elem = NULL;
+        }
+        atomic_init(&q->enqueue_pos, 0);
+        atomic_init(&q->dequeue_pos, 0);
+        atomic_init(&q->n_waiting_producers, 0);
+        atomic_init(&q->n_waiting_consumers, 0);
+        pthread_mutex_init(&q->mutex, NULL);
+        pthread_cond_init(&q->not_empty_cv, NULL);
+        pthread_cond_init(&q->not_full_cv, NULL);
+        return q;
+}
+
+void
+Fifo_mpmc_destroyQ(Fifo_Mpmc_Queue_t *q){
+
+        pthread_mutex_destroy(&q->mutex);
+        pthread_cond_destroy(&q->not_empty_cv);
+        pthread_cond_destroy(&q->not_full_cv);
+        free(q->cells);
+        free(q);
+}
+
+static bool
+Fifo_mpmc_try_enqueue(Fifo_Mpmc_Queue_t *q, void *ptr, uint64_t stamp){
+
+        Fifo_mpmc_cell_t *cell;
+        size_t seq;
+        intptr_t dif;
+        size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+
+        while (1) {
+                cell = &q->cells[pos & q->mask];
+                seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+                dif = (intptr_t)seq - (intptr_t)pos;
+
+                if (dif == 0) {
+                        /* Slot is free, claim the ticket */
+                        if (atomic_compare_exchange_weak_explicit(&q->enqueue_pos,
+                                &pos, pos + 1,
+                                memory_order_relaxed, memory_order_relaxed)) {
+                                break;
+                        }
+                }
+                else if (dif < 0) {
+                        /* Slot still holds the element from previous lap */
+                        return false;
+                }
+                else {
+                        pos = atomic_load_explicit(&q->enqueue_pos,
+                                memory_order_relaxed);
+                }
+        }
+
+        cell->elem = ptr;
+        cell->stamp = stamp;
+        /* Hand over the slot to the consumer holding ticket pos */
+        atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+        return true;
+}
+
+/* ticket, if not NULL, gets the position of the element in the enqueue
+   order, and stamp the stamp it was enqueued with */
+static void*
+Fifo_mpmc_try_deque(Fifo_Mpmc_Queue_t *q, size_t *ticket, uint64_t *stamp){
+
+        Fifo_mpmc_cell_t *cell;
+        size_t seq;
+        intptr_t dif;
+        void *elem;
+        size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+
+        while (1) {
+                cell = &q->cells[pos & q->mask];
+                seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+                dif = (intptr_t)seq - (intptr_t)(pos + 1);
+
+                if (dif == 0) {
+                        if (atomic_compare_exchange_weak_explicit(&q->dequeue_pos,
+                                &pos, pos + 1,
+                                memory_order_relaxed, memory_order_relaxed)) {
+                                break;
+                        }
+                }
+                else if (dif < 0) {
+                        /* Producer has not filled this slot yet */
+                        return NULL;
+                }
+                else {
+                        pos = atomic_load_explicit(&q->dequeue_pos,
+                                memory_order_relaxed);
+                }
+        }
+
+        elem = cell->elem;
+        if (ticket) *ticket = pos;
+        if (stamp) *stamp = cell->stamp;
+        /* Hand over the slot to the producer of next lap */
+        atomic_store_explicit(&cell->seq, pos + q->mask + 1, memory_order_release);
+        return elem;
+}
+
+/* Wake up the sleepers of the blocking variants, if any. This costs only
+   an atomic load when no thread is sleeping */
+static void
+Fifo_mpmc_wakeup(Fifo_Mpmc_Queue_t *q, _Atomic uint32_t *n_waiting,
+                 pthread_cond_t *cv){
+
+        atomic_thread_fence(memory_order_seq_cst);
+        if (!atomic_load_explicit(n_waiting, memory_order_relaxed))
+                return;
+        pthread_mutex_lock(&q->mutex);
+        pthread_cond_broadcast(cv);
+        pthread_mutex_unlock(&q->mutex);
+}
+
+bool
+Fifo_mpmc_enqueue(Fifo_Mpmc_Queue_t *q, void *ptr){
+
+        if(!q || !ptr) return false;
+        if (!Fifo_mpmc_try_enqueue(q, ptr, 0))
+                return false;
+        Fifo_mpmc_wakeup(q, &q->n_waiting_consumers, &q->not_empty_cv);
+        return true;
+}
+
+void*
+Fifo_mpmc_deque(Fifo_Mpmc_Queue_t *q){
+
+        void *elem;
+
+        if(!q) return NULL;
+        elem = Fifo_mpmc_try_deque(q, NULL, NULL);
+        if (elem)
+                Fifo_mpmc_wakeup(q, &q->n_waiting_producers, &q->not_full_cv);
+        return elem;
+}
+
+void
+Fifo_mpmc_enqueue_blocking_stamped(Fifo_Mpmc_Queue_t *q, void *ptr,
+                                   uint64_t stamp){
+
+        uint32_t spin;
+
+        assert(q && ptr);
+
+        for (spin = 0; spin < FIFO_MPMC_SPIN_COUNT; spin++) {
+                if (Fifo_mpmc_try_enqueue(q, ptr, stamp)) goto enqueued;
+                sched_yield();
+        }
+
+        pthread_mutex_lock(&q->mutex);
+        /* Announce ourself before re-trying, a consumer which frees a slot
+           after this point is guaranteed to see us and signal */
+        atomic_fetch_add(&q->n_waiting_producers, 1);
+        while (!Fifo_mpmc_try_enqueue(q, ptr, stamp)) {
+                pthread_cond_wait(&q->not_full_cv, &q->mutex);
+        }
+        atomic_fetch_sub(&q->n_waiting_producers, 1);
+        pthread_mutex_unlock(&q->mutex);
+
+        enqueued:
+        Fifo_mpmc_wakeup(q, &q->n_waiting_consumers, &q->not_empty_cv);
+}
+
+void
+Fifo_mpmc_enqueue_blocking(Fifo_Mpmc_Queue_t *q, void *ptr){
+
+        Fifo_mpmc_enqueue_blocking_stamped(q, ptr, 0);
+}
+
+void*
+Fifo_mpmc_deque_blocking_stamped(Fifo_Mpmc_Queue_t *q, size_t *ticket,
+                                 uint64_t *stamp){
+
+        uint32_t spin;
+        void *elem;
+
+        assert(q);
+
+        for (spin = 0; spin < FIFO_MPMC_SPIN_COUNT; spin++) {
+                elem = Fifo_mpmc_try_deque(q, ticket, stamp);
+                if (elem) goto dequed;
+                sched_yield();
+        }
+
+        pthread_mutex_lock(&q->mutex);
+        atomic_fetch_add(&q->n_waiting_consumers, 1);
+        while (!(elem = Fifo_mpmc_try_deque(q, ticket, stamp))) {
+                pthread_cond_wait(&q->not_empty_cv, &q->mutex);
+        }
+        atomic_fetch_sub(&q->n_waiting_consumers, 1);
+        pthread_mutex_unlock(&q->mutex);
+
+        dequed:
+        Fifo_mpmc_wakeup(q, &q->n_waiting_producers, &q->not_full_cv);
+        return elem;
+}
+
+void*
+Fifo_mpmc_deque_blocking_ticket(Fifo_Mpmc_Queue_t *q, size_t *ticket){
+
+        return Fifo_mpmc_deque_blocking_stamped(q, ticket, NULL);
+}
+
+void*
+Fifo_mpmc_deque_blocking(Fifo_Mpmc_Queue_t *q){
+
+        return Fifo_mpmc_deque_blocking_stamped(q, NULL, NULL);
+}
+
+uint32_t
+Fifo_mpmc_count(Fifo_Mpmc_Queue_t *q){
+
+        size_t enq = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+        size_t deq = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+
+        return enq > deq ? (uint32_t)(enq - deq) : 0;
+}
+
+/* Lock-free MPMC Queue Implementation Ends here */
+
+
+
 #if 0
+#define N_PRODUCERS     4
+#define N_CONSUMERS     4
+#define N_ITEMS         1000000
+
+static Fifo_Mpmc_Queue_t *mpmc_q;
+static _Atomic uint64_t consumed_sum;
+
+static void *
+producer_fn(void *arg){
+
+        uintptr_t i;
+        for (i = 1; i <= N_ITEMS; i++)
+                Fifo_mpmc_enqueue_blocking(mpmc_q, (void *)i);
+        return NULL;
+}
+
+static void *
+consumer_fn(void *arg){
+
+        uint32_t i;
+        for (i = 0; i < N_ITEMS; i++)
+                atomic_fetch_add(&consumed_sum,
+                        (uintptr_t)Fifo_mpmc_deque_blocking(mpmc_q));
+        return NULL;
+}
+
 int 
 main(int argc, char **argv){
-return 0;	
+
+        int i;
+        pthread_t producers[N_PRODUCERS], consumers[N_CONSUMERS];
+
+        mpmc_q = Fifo_mpmc_initQ(1000);
+
+        for (i = 0; i < N_CONSUMERS; i++)
+                pthread_create(&consumers[i], NULL, consumer_fn, NULL);
+        for (i = 0; i < N_PRODUCERS; i++)
+                pthread_create(&producers[i], NULL, producer_fn, NULL);
+        for (i = 0; i < N_PRODUCERS; i++)
+                pthread_join(producers[i], NULL);
+        for (i = 0; i < N_CONSUMERS; i++)
+                pthread_join(consumers[i], NULL);
+
+        printf("consumed_sum = %lu, expected = %lu\n",
+                (unsigned long)consumed_sum,
+                (unsigned long)N_PRODUCERS * N_ITEMS * (N_ITEMS + 1) / 2);
+        Fifo_mpmc_destroyQ(mpmc_q);
+        return 0;
 }
 #endif
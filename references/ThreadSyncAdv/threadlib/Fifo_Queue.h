@@ -3,6 +3,9 @@
 #define __QUEUE__
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
 
 typedef struct _Fifo_Queue{
         uint32_t front;
@@ -34,5 +37,79 @@ print_Fifo_Queue(Fifo_Queue_t *q);
 void *
 Fifo_insert_or_replace_at_index(
         Fifo_Queue_t *q, void *ptr, uint32_t index);
+
+/* Lock-free Multi-Producer Multi-Consumer variant of Fifo_Queue_t.
+   Bounded ring of power of 2 size, each slot carries a sequence number
+   which tells producers and consumers whose turn it is on that slot.
+   Safe to use from any no of threads without an external mutex */
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+typedef struct _Fifo_mpmc_cell{
+        _Atomic size_t seq;
+        void *elem;
+        /* Opaque word travelling with elem, see the _stamped variants */
+        uint64_t stamp;
+} Fifo_mpmc_cell_t;
+
+typedef struct _Fifo_Mpmc_Queue{
+        /* Producers and consumers touch separate cache lines */
+        _Alignas(CACHE_LINE_SIZE) _Atomic size_t enqueue_pos;
+        _Alignas(CACHE_LINE_SIZE) _Atomic size_t dequeue_pos;
+        _Alignas(CACHE_LINE_SIZE) Fifo_mpmc_cell_t *cells;
+        uint32_t size;
+        uint32_t mask;
+        /* Used by blocking variants only, when ring is empty/full */
+        _Alignas(CACHE_LINE_SIZE) _Atomic uint32_t n_waiting_producers;
+        _Atomic uint32_t n_waiting_consumers;
+        pthread_mutex_t mutex;
+        pthread_cond_t not_empty_cv;
+        pthread_cond_t not_full_cv;
+} Fifo_Mpmc_Queue_t;
+
+/* size is rounded up to next power of 2 */
+Fifo_Mpmc_Queue_t* Fifo_mpmc_initQ(uint32_t size);
+
+void
+Fifo_mpmc_destroyQ(Fifo_Mpmc_Queue_t *q);
+
+/* Non-blocking, returns false if queue is full */
+bool
+Fifo_mpmc_enqueue(Fifo_Mpmc_Queue_t *q, void *ptr);
+
+/* Non-blocking, returns NULL if queue is empty */
+void*
+Fifo_mpmc_deque(Fifo_Mpmc_Queue_t *q);
+
+/* Blocks the caller while queue is full */
+void
+Fifo_mpmc_enqueue_blocking(Fifo_Mpmc_Queue_t *q, void *ptr);
+
+/* Blocks the caller while queue is empty */
+void*
+Fifo_mpmc_deque_blocking(Fifo_Mpmc_Queue_t *q);
+
+/* Same, ticket gets the position of the element in the enqueue order.
+   Tickets are consecutive across all consumers of the queue, which lets
+   them put back in order what they dequeued concurrently */
+void*
+Fifo_mpmc_deque_blocking_ticket(Fifo_Mpmc_Queue_t *q, size_t *ticket);
+
+/* Same as the blocking variants, the element carries a 64 bit stamp, e.g.
+   its enqueue time, which is handed back to the consumer which dequeues it */
+void
+Fifo_mpmc_enqueue_blocking_stamped(Fifo_Mpmc_Queue_t *q, void *ptr,
+                                   uint64_t stamp);
+
+void*
+Fifo_mpmc_deque_blocking_stamped(Fifo_Mpmc_Queue_t *q, size_t *ticket,
+                                 uint64_t *stamp);
+
+/* Approximate when queue is being updated concurrently */
+uint32_t
+Fifo_mpmc_count(Fifo_Mpmc_Queue_t *q);
+
 #endif /* __QUEUE__ */
 
@@ -30,6 +30,12 @@ Join Telegram Grp : telecsepracticals
 #include <assert.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <sched.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
 #include "threadlib.h"
 
 /* Fn to create and initialize a new thread Data structure
@@ -56,6 +62,7 @@ create_thread(thread_t *thread,
     pthread_attr_init(&thread->attributes);
     thread->thread_op = thread_op;
     init_glthread(&thread->wait_glue);
+    init_glthread_skip_node(&thread->wait_skip_node);
     return thread;
 }
 
@@ -106,7 +113,7 @@ thread_pool_run_thread (thread_t *thread) {
        This fn assumes that thread has already been removed from
        thread pool
        */
-    assert (IS_GLTHREAD_LIST_EMPTY(&thread->wait_glue));
+    assert (!IS_GLTHREAD_SKIP_NODE_LINKED(&thread->wait_skip_node));
 
     if (!thread->thread_created) {
         run_thread(thread, thread->thread_fn, thread->arg);
@@ -126,10 +133,8 @@ thread_pool_thread_stage3_fn(thread_pool_t *th_pool,
 
     pthread_mutex_lock(&th_pool->mutex);
 
-    glthread_priority_insert (&th_pool->pool_head,
-            &thread->wait_glue,
-            th_pool->comp_fn,
-            (size_t)&(((thread_t *)0)->wait_glue));
+    glthread_skiplist_insert (&th_pool->pool_skiplist,
+            &thread->wait_skip_node);
 
     /* Tell the caller thread (which dispatched me from pool) that in
        am done */
@@ -169,7 +174,7 @@ thread_fn_execute_stage2_and_stage3(void *arg) {
    thread_execution_data_t is a data structure which stores the functions (unit of work) along
    with the data (arguments) to be processed by worker thread in stage 2 and stage 3
    */
-static void
+static bool
 thread_pool_thread_stage1_fn (thread_pool_t *th_pool,
         void *(*thread_fn)(void *),
         void *arg,
@@ -181,7 +186,7 @@ thread_pool_thread_stage1_fn (thread_pool_t *th_pool,
     thread_t *thread = thread_pool_get_thread (th_pool);
 
     if (!thread) {
-        return;
+        return false;
     }
 
     if (block_caller) {
@@ -230,57 +235,82 @@ thread_pool_thread_stage1_fn (thread_pool_t *th_pool,
         sem0_1 = NULL;
         thread->semaphore = NULL;
     }
+    return true;
 }
 
-void
+bool
 thread_pool_dispatch_thread (thread_pool_t *th_pool,
         void *(*thread_fn)(void *),
         void *arg,
         bool block_caller) {
 
-    thread_pool_thread_stage1_fn (th_pool, thread_fn, arg, block_caller);
+    /* In task-queue mode, work is queued to the scheduler and picked up
+       by whichever worker thread gets to it first */
+    if (th_pool->task_sched) {
+        return task_scheduler_submit(th_pool->task_sched, thread_fn, arg,
+                                     block_caller);
+    }
+
+    return thread_pool_thread_stage1_fn (th_pool, thread_fn, arg, block_caller);
 }
 
 void
 thread_pool_init(thread_pool_t *th_pool,
         int (*comp_fn)(void *, void *)) {
 
-    init_glthread(&th_pool->pool_head);
+    glthread_skiplist_init(&th_pool->pool_skiplist, comp_fn,
+            (size_t)&(((thread_t *)0)->wait_skip_node));
     th_pool->comp_fn = comp_fn;
     pthread_mutex_init(&th_pool->mutex, NULL);
+    th_pool->task_sched = NULL;
 }
 
 void
+thread_pool_enable_task_queue_mode(thread_pool_t *th_pool,
+        uint32_t max_threads,
+        uint32_t deque_size) {
+
+    assert(!th_pool->task_sched);
+    assert(IS_GLTHREAD_SKIPLIST_EMPTY(&th_pool->pool_skiplist));
+    th_pool->task_sched = task_scheduler_create(max_threads, deque_size);
+}
+
+bool
 thread_pool_insert_new_thread(thread_pool_t *th_pool,
         thread_t *thread) {
 
+    /* In task-queue mode threads are never parked in the pool, they
+       become scheduler workers and keep looking for work */
+    if (th_pool->task_sched) {
+        assert(thread->thread_fn == NULL);
+        return task_scheduler_add_worker(th_pool->task_sched, thread);
+    }
 
     pthread_mutex_lock(&th_pool->mutex);
 
-    assert (IS_GLTHREAD_LIST_EMPTY(&thread->wait_glue));
+    assert (!IS_GLTHREAD_SKIP_NODE_LINKED(&thread->wait_skip_node));
     assert(thread->thread_fn == NULL);
 
-    glthread_priority_insert (&th_pool->pool_head,
-            &thread->wait_glue,
-            th_pool->comp_fn,
-            (size_t)&(((thread_t *)0)->wait_glue));
+    glthread_skiplist_insert (&th_pool->pool_skiplist,
+            &thread->wait_skip_node);
 
     pthread_mutex_unlock(&th_pool->mutex);
+    return true;
 }
 
 thread_t *
 thread_pool_get_thread(thread_pool_t *th_pool) {
 
     thread_t *thread = NULL;
-    glthread_t *glthread = NULL;
+    glthread_skip_node_t *skip_node = NULL;
 
     pthread_mutex_lock(&th_pool->mutex);
-    glthread = dequeue_glthread_first(&th_pool->pool_head);
-    if (!glthread) {
+    skip_node = glthread_skiplist_dequeue_first(&th_pool->pool_skiplist);
+    if (!skip_node) {
         pthread_mutex_unlock(&th_pool->mutex);
         return NULL;
     }
-    thread = wait_glue_to_thread(glthread);
+    thread = wait_skip_node_to_thread(&skip_node->levels[0]);
     pthread_mutex_unlock(&th_pool->mutex);
     return thread;
 }
@@ -342,6 +372,538 @@ main(int argc, char **argv) {
 #endif
 
 
+/* Thread Pool Implementation Ends here */
+
+
+
+
+
+
+/* Work Stealing Task Scheduler Implementation Starts here */
+
+/* Each worker thread caches its worker in TLS, so that tasks submitted
+   from within a task are pushed to the worker's own deque */
+static __thread ws_worker_t *ws_curr_worker = NULL;
+
+/* No of times an idle worker retries stealing before going to sleep */
+#define WS_IDLE_SPIN_COUNT  64
+
+static void
+ws_deque_init(ws_deque_t *dq, uint32_t size) {
+
+    /* size must be power of 2 */
+    assert(size && !(size & (size - 1)));
+    atomic_init(&dq->top, 0);
+    atomic_init(&dq->bottom, 0);
+    dq->buffer = calloc(size, sizeof(*dq->buffer));
+    dq->mask = size - 1;
+}
+
+/* Called by the owner only. Returns false if deque is full */
+static bool
+ws_deque_push(ws_deque_t *dq, ws_task_t *task) {
+
+    int64_t b = atomic_load_explicit(&dq->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&dq->top, memory_order_acquire);
+
+    if (b - t > (int64_t)dq->mask) {
+        return false;
+    }
+
+    atomic_store_explicit(&dq->buffer[b & dq->mask], task, memory_order_relaxed);
+    /* Publish the task to thieves */
+    atomic_store_explicit(&dq->bottom, b + 1, memory_order_release);
+    return true;
+}
+
+/* Called by the owner only, pops the most recently pushed task */
+static ws_task_t *
+ws_deque_pop(ws_deque_t *dq) {
+
+    ws_task_t *task;
+    int64_t b = atomic_load_explicit(&dq->bottom, memory_order_relaxed) - 1;
+    int64_t t;
+
+    atomic_store_explicit(&dq->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    t = atomic_load_explicit(&dq->top, memory_order_relaxed);
+
+    if (t > b) {
+        /* Deque was empty */
+        atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    task = atomic_load_explicit(&dq->buffer[b & dq->mask], memory_order_relaxed);
+
+    if (t == b) {
+        /* Last task, race against thieves for it */
+        if (!atomic_compare_exchange_strong_explicit(&dq->top, &t, t + 1,
+                    memory_order_seq_cst, memory_order_relaxed)) {
+            task = NULL;
+        }
+        atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+/* Called by any thread, steals the oldest task */
+static ws_task_t *
+ws_deque_steal(ws_deque_t *dq) {
+
+    ws_task_t *task;
+    int64_t t = atomic_load_explicit(&dq->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&dq->bottom, memory_order_acquire);
+
+    if (t >= b) return NULL;
+
+    task = atomic_load_explicit(&dq->buffer[t & dq->mask], memory_order_relaxed);
+
+    if (!atomic_compare_exchange_strong_explicit(&dq->top, &t, t + 1,
+                memory_order_seq_cst, memory_order_relaxed)) {
+        /* Lost the race against owner or other thief */
+        return NULL;
+    }
+    return task;
+}
+
+static bool
+ws_deque_is_empty(ws_deque_t *dq) {
+
+    return atomic_load_explicit(&dq->top, memory_order_acquire) >=
+           atomic_load_explicit(&dq->bottom, memory_order_acquire);
+}
+
+static inline uint32_t
+ws_worker_next_rand(ws_worker_t *worker) {
+
+    /* xorshift32 */
+    uint32_t x = worker->rand_seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    worker->rand_seed = x;
+    return x;
+}
+
+/* Push a chain of tasks [first .. last] to the injection list */
+static void
+task_scheduler_inject_chain(task_scheduler_t *sched,
+        ws_task_t *first, ws_task_t *last) {
+
+    ws_task_t *head = atomic_load_explicit(&sched->inject_head,
+                        memory_order_relaxed);
+    do {
+        last->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&sched->inject_head,
+                &head, first, memory_order_release, memory_order_relaxed));
+}
+
+static void
+task_scheduler_wake_idle_worker(task_scheduler_t *sched) {
+
+    if (atomic_load(&sched->n_idle)) {
+        sem_post(&sched->idle_sem);
+    }
+}
+
+/* Take the whole injection list at once, keep the oldest task for
+   execution and move the rest to worker's own deque where other
+   workers can steal them */
+static ws_task_t *
+task_scheduler_grab_injected(task_scheduler_t *sched, ws_worker_t *worker) {
+
+    ws_task_t *list, *prev, *next, *task;
+
+    if (!atomic_load_explicit(&sched->inject_head, memory_order_relaxed)) {
+        return NULL;
+    }
+
+    list = atomic_exchange_explicit(&sched->inject_head, NULL,
+                memory_order_acquire);
+    if (!list) return NULL;
+
+    /* Injection list is LIFO, reverse it to preserve submission order */
+    prev = NULL;
+    while (list) {
+        next = list->next;
+        list->next = prev;
+        prev = list;
+        list = next;
+    }
+
+    task = prev;
+    list = task->next;
+    task->next = NULL;
+
+    while (list) {
+        next = list->next;
+        if (!ws_deque_push(&worker->deque, list)) {
+            /* Own deque is full, return the remaining chain */
+            ws_task_t *last = list;
+            while (last->next) last = last->next;
+            task_scheduler_inject_chain(sched, list, last);
+            break;
+        }
+        list = next;
+    }
+
+    if (!ws_deque_is_empty(&worker->deque)) {
+        task_scheduler_wake_idle_worker(sched);
+    }
+    return task;
+}
+
+static ws_task_t *
+task_scheduler_steal(task_scheduler_t *sched, ws_worker_t *worker) {
+
+    uint32_t i, victim;
+    ws_task_t *task;
+    uint32_t n_workers = atomic_load(&sched->n_workers);
+
+    if (n_workers < 2) return NULL;
+
+    /* Start at a random victim and go round once */
+    victim = ws_worker_next_rand(worker) % n_workers;
+
+    for (i = 0; i < n_workers; i++, victim = (victim + 1) % n_workers) {
+
+        if (victim == worker->worker_id) continue;
+
+        task = ws_deque_steal(&sched->workers[victim].deque);
+        if (task) {
+            atomic_fetch_add_explicit(&sched->n_stolen, 1,
+                memory_order_relaxed);
+            return task;
+        }
+    }
+    return NULL;
+}
+
+static ws_task_t *
+task_scheduler_find_task(task_scheduler_t *sched, ws_worker_t *worker) {
+
+    ws_task_t *task;
+
+    task = ws_deque_pop(&worker->deque);
+    if (task) return task;
+
+    task = task_scheduler_grab_injected(sched, worker);
+    if (task) return task;
+
+    return task_scheduler_steal(sched, worker);
+}
+
+static bool
+task_scheduler_has_work(task_scheduler_t *sched) {
+
+    uint32_t i;
+    uint32_t n_workers = atomic_load(&sched->n_workers);
+
+    if (atomic_load(&sched->inject_head)) return true;
+
+    for (i = 0; i < n_workers; i++) {
+        if (!ws_deque_is_empty(&sched->workers[i].deque)) return true;
+    }
+    return false;
+}
+
+static void
+task_scheduler_execute_task(task_scheduler_t *sched, ws_task_t *task) {
+
+    task->task_fn(task->arg);
+    atomic_fetch_add_explicit(&sched->n_executed, 1, memory_order_relaxed);
+
+    /* Tell the submitter (if it is waiting) that task is done */
+    if (task->semaphore) {
+        sem_post(task->semaphore);
+    }
+    free(task);
+}
+
+static void *
+ws_worker_fn(void *arg) {
+
+    uint32_t spin;
+    ws_task_t *task;
+    ws_worker_t *worker = (ws_worker_t *)arg;
+    task_scheduler_t *sched = worker->sched;
+
+    ws_curr_worker = worker;
+
+    while (true) {
+
+        for (spin = 0; spin < WS_IDLE_SPIN_COUNT; spin++) {
+            task = task_scheduler_find_task(sched, worker);
+            if (task) break;
+            sched_yield();
+        }
+
+        if (task) {
+            task_scheduler_execute_task(sched, task);
+            continue;
+        }
+
+        /* Announce we are going idle, then re-check. A submitter first
+           publishes the task then checks n_idle, so either we see the
+           task here or the submitter sees us idle and posts idle_sem */
+        atomic_fetch_add(&sched->n_idle, 1);
+
+        if (task_scheduler_has_work(sched)) {
+            atomic_fetch_sub(&sched->n_idle, 1);
+            continue;
+        }
+
+        if (atomic_load(&sched->shutdown)) {
+            atomic_fetch_sub(&sched->n_idle, 1);
+            break;
+        }
+
+        sem_wait(&sched->idle_sem);
+        atomic_fetch_sub(&sched->n_idle, 1);
+    }
+
+    ws_curr_worker = NULL;
+    return NULL;
+}
+
+task_scheduler_t *
+task_scheduler_create(uint32_t max_workers, uint32_t deque_size) {
+
+    uint32_t i;
+    task_scheduler_t *sched;
+
+    assert(max_workers);
+
+    if (!deque_size) deque_size = WS_DEQUE_DEF_SIZE;
+
+    sched = aligned_alloc(CACHE_LINE_SIZE, sizeof(task_scheduler_t));
+    memset(sched, 0, sizeof(task_scheduler_t));
+
+    sched->workers = aligned_alloc(CACHE_LINE_SIZE,
+                        max_workers * sizeof(ws_worker_t));
+    memset(sched->workers, 0, max_workers * sizeof(ws_worker_t));
+    sched->max_workers = max_workers;
+
+    /* All deques are initialized upfront, thieves may look at any of them */
+    for (i = 0; i < max_workers; i++) {
+        ws_deque_init(&sched->workers[i].deque, deque_size);
+        sched->workers[i].sched = sched;
+        sched->workers[i].worker_id = i;
+        sched->workers[i].rand_seed = 2654435761u * (i + 1);
+    }
+
+    atomic_init(&sched->n_workers, 0);
+    pthread_mutex_init(&sched->workers_mutex, NULL);
+    atomic_init(&sched->inject_head, NULL);
+    atomic_init(&sched->n_idle, 0);
+    sem_init(&sched->idle_sem, 0, 0);
+    atomic_init(&sched->shutdown, false);
+    return sched;
+}
+
+bool
+task_scheduler_add_worker(task_scheduler_t *sched, thread_t *thread) {
+
+    char th_name[32];
+    ws_worker_t *worker;
+    uint32_t worker_id;
+
+    /* Two adders must not pick the same slot */
+    pthread_mutex_lock(&sched->workers_mutex);
+
+    worker_id = atomic_load_explicit(&sched->n_workers, memory_order_relaxed);
+
+    if (worker_id >= sched->max_workers || atomic_load(&sched->shutdown)) {
+        pthread_mutex_unlock(&sched->workers_mutex);
+        return false;
+    }
+
+    worker = &sched->workers[worker_id];
+
+    if (!thread) {
+        snprintf(th_name, sizeof(th_name), "ws_worker_%u", worker_id);
+        thread = create_thread(0, th_name, THREAD_ANY);
+        worker->own_thread = true;
+    }
+
+    worker->thread = thread;
+    run_thread(thread, ws_worker_fn, (void *)worker);
+
+    /* Only now may thieves and the shutdown see the worker */
+    atomic_store_explicit(&sched->n_workers, worker_id + 1,
+        memory_order_release);
+
+    pthread_mutex_unlock(&sched->workers_mutex);
+    return true;
+}
+
+bool
+task_scheduler_submit(task_scheduler_t *sched,
+        void *(*task_fn)(void *),
+        void *arg,
+        bool block_caller) {
+
+    sem_t sem0;
+    ws_task_t *task;
+    ws_worker_t *worker = ws_curr_worker;
+
+    if (atomic_load(&sched->shutdown)) return false;
+
+    /* A worker blocking on its own task may dead-lock the pool, run it
+       inline instead */
+    if (block_caller && worker && worker->sched == sched) {
+        task_fn(arg);
+        atomic_fetch_add_explicit(&sched->n_submitted, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&sched->n_executed, 1, memory_order_relaxed);
+        return true;
+    }
+
+    task = calloc(1, sizeof(ws_task_t));
+    task->task_fn = task_fn;
+    task->arg = arg;
+
+    if (block_caller) {
+        sem_init(&sem0, 0, 0);
+        task->semaphore = &sem0;
+    }
+
+    atomic_fetch_add_explicit(&sched->n_submitted, 1, memory_order_relaxed);
+
+    if (worker && worker->sched == sched) {
+        if (!ws_deque_push(&worker->deque, task)) {
+            /* Own deque is full, never block, just run it now */
+            task_scheduler_execute_task(sched, task);
+            return true;
+        }
+    }
+    else {
+        task_scheduler_inject_chain(sched, task, task);
+    }
+
+    atomic_thread_fence(memory_order_seq_cst);
+    task_scheduler_wake_idle_worker(sched);
+
+    if (block_caller) {
+        sem_wait(&sem0);
+        sem_destroy(&sem0);
+    }
+    return true;
+}
+
+void
+task_scheduler_shutdown(task_scheduler_t *sched) {
+
+    uint32_t i, n_workers;
+
+    /* No worker can be added past this point */
+    pthread_mutex_lock(&sched->workers_mutex);
+
+    if (atomic_exchange(&sched->shutdown, true)) {
+        pthread_mutex_unlock(&sched->workers_mutex);
+        return;
+    }
+    n_workers = atomic_load(&sched->n_workers);
+
+    pthread_mutex_unlock(&sched->workers_mutex);
+
+    /* Wake up every sleeping worker, they exit once no work is left */
+    for (i = 0; i < n_workers; i++) {
+        sem_post(&sched->idle_sem);
+    }
+
+    for (i = 0; i < n_workers; i++) {
+        pthread_join(sched->workers[i].thread->thread, NULL);
+    }
+}
+
+void
+task_scheduler_destroy(task_scheduler_t *sched) {
+
+    uint32_t i;
+    thread_t *thread;
+
+    task_scheduler_shutdown(sched);
+
+    for (i = 0; i < sched->max_workers; i++) {
+
+        free(sched->workers[i].deque.buffer);
+
+        if (!sched->workers[i].own_thread) continue;
+
+        thread = sched->workers[i].thread;
+        pthread_attr_destroy(&thread->attributes);
+        pthread_cond_destroy(&thread->cv);
+        free(thread);
+    }
+
+    sem_destroy(&sched->idle_sem);
+    pthread_mutex_destroy(&sched->workers_mutex);
+    free(sched->workers);
+    free(sched);
+}
+
+void
+task_scheduler_print_stats(task_scheduler_t *sched) {
+
+    printf("sched->n_workers = %u\n", atomic_load(&sched->n_workers));
+    printf("sched->n_idle = %u\n", atomic_load(&sched->n_idle));
+    printf("sched->n_submitted = %lu\n", (unsigned long)atomic_load(&sched->n_submitted));
+    printf("sched->n_executed = %lu\n", (unsigned long)atomic_load(&sched->n_executed));
+    printf("sched->n_stolen = %lu\n", (unsigned long)atomic_load(&sched->n_stolen));
+}
+
+#if 0
+/* Main application using work stealing task scheduler starts here */
+
+static _Atomic uint64_t counter = 0;
+
+void *
+short_task(void *arg) {
+
+    atomic_fetch_add_explicit(&counter, (uintptr_t)arg, memory_order_relaxed);
+    return NULL;
+}
+
+int
+main(int argc, char **argv) {
+
+    int i;
+
+    /* The old thread pool API, now backed by the task scheduler */
+    thread_pool_t *th_pool = calloc(1, sizeof(thread_pool_t));
+    thread_pool_init(th_pool, NULL);
+    thread_pool_enable_task_queue_mode(th_pool, 4, WS_DEQUE_DEF_SIZE);
+
+    for (i = 0; i < 4; i++) {
+        thread_t *thread = create_thread(0, "pool_thread", THREAD_ANY);
+        if (!thread_pool_insert_new_thread(th_pool, thread)) {
+            free(thread);
+        }
+    }
+
+    for (i = 0; i < 100000; i++) {
+        if (!thread_pool_dispatch_thread(th_pool, short_task, (void *)1, false)) {
+            printf("task %d not dispatched\n", i);
+        }
+    }
+
+    if (!thread_pool_dispatch_thread(th_pool, short_task, (void *)1, true)) {
+        printf("blocking task not dispatched\n");
+    }
+    task_scheduler_shutdown(th_pool->task_sched);
+    task_scheduler_print_stats(th_pool->task_sched);
+    printf("counter = %lu\n", (unsigned long)atomic_load(&counter));
+    task_scheduler_destroy(th_pool->task_sched);
+    return 0;
+}
+
+#endif
+
+/* Work Stealing Task Scheduler Implementation Ends here */
+
+
 
 
 
@@ -566,7 +1128,8 @@ wait_queue_init (wait_queue_t * wq, bool priority_flag,
     wq->thread_wait_count = 0;
     pthread_cond_init (&wq->cv, NULL);
     wq->appln_mutex = NULL;
-    init_glthread(&wq->priority_wait_queue_head);
+    glthread_skiplist_init(&wq->priority_wait_queue, insert_cmp_fn,
+            (size_t)&(((thread_t *)0)->wait_skip_node));
     wq->insert_cmp_fn = insert_cmp_fn;
     if (wq->priority_flag) {
         assert(wq->insert_cmp_fn);
@@ -654,10 +1217,8 @@ wait_queue_test_and_wait (wait_queue_t * wq,
         else {
             /* If it is a Priority Wait Queue, then block all threads on their
                respective CV owned by the thread it-self */
-            glthread_priority_insert (&wq->priority_wait_queue_head,
-                    &curr_thread->wait_glue,
-                    wq->insert_cmp_fn,
-                    (size_t)&(((thread_t *)0)->wait_glue));
+            glthread_skiplist_insert (&wq->priority_wait_queue,
+                    &curr_thread->wait_skip_node);
             printf("Thread %s blocked on wait Queue, wq->thread_wait_count = %u\n",
                     curr_thread->name, wq->thread_wait_count);
             pthread_cond_wait (&curr_thread->cv, wq->appln_mutex);
@@ -670,7 +1231,8 @@ wait_queue_test_and_wait (wait_queue_t * wq,
         }
 
         if (wq->priority_flag) {
-            remove_glthread(&curr_thread->wait_glue);
+            glthread_skiplist_remove(&wq->priority_wait_queue,
+                    &curr_thread->wait_skip_node);
             /*
                node = dequeue_glthread_first(
                &wq->priority_wait_queue_head);
@@ -702,7 +1264,7 @@ void
 wait_queue_signal (wait_queue_t * wq, bool lock_mutex)
 {
 
-    glthread_t *first_node;
+    glthread_skip_node_t *first_node;
     thread_t *thread;
 
     if (lock_mutex && !wq->appln_mutex) return;
@@ -721,14 +1283,14 @@ wait_queue_signal (wait_queue_t * wq, bool lock_mutex)
     }
     else {
 
-        first_node = glthread_get_first_node (&wq->priority_wait_queue_head);
+        first_node = glthread_skiplist_first (&wq->priority_wait_queue);
 
         if (!first_node) {
             if (lock_mutex) pthread_mutex_unlock(wq->appln_mutex);
             return;
         }
 
-        thread = wait_glue_to_thread(first_node);
+        thread = wait_skip_node_to_thread(&first_node->levels[0]);
         pthread_cond_signal(&thread->cv);
     }
     if (lock_mutex) pthread_mutex_unlock(wq->appln_mutex);
@@ -754,11 +1316,11 @@ wait_queue_broadcast (wait_queue_t * wq, bool lock_mutex) {
     }
     else {
 
-        ITERATE_GLTHREAD_BEGIN(&wq->priority_wait_queue_head, curr) {
+        ITERATE_GLTHREAD_BEGIN(GLTHREAD_SKIPLIST_BASE(&wq->priority_wait_queue), curr) {
 
-            thread = wait_glue_to_thread(curr);
+            thread = wait_skip_node_to_thread(curr);
             pthread_cond_signal(&thread->cv);
-        } ITERATE_GLTHREAD_END(&wq->priority_wait_queue_head, curr);
+        } ITERATE_GLTHREAD_END(GLTHREAD_SKIPLIST_BASE(&wq->priority_wait_queue), curr);
     }
 
     if (lock_mutex) pthread_mutex_unlock(wq->appln_mutex);
@@ -775,9 +1337,9 @@ wait_queue_print(wait_queue_t *wq) {
 
     if (0 && wq->priority_flag) {
 
-        ITERATE_GLTHREAD_BEGIN(&wq->priority_wait_queue_head, curr) {
+        ITERATE_GLTHREAD_BEGIN(GLTHREAD_SKIPLIST_BASE(&wq->priority_wait_queue), curr) {
 
-            thread = wait_glue_to_thread(curr);
+            thread = wait_skip_node_to_thread(curr);
             thread_lib_print_thread(thread);
         } ITERATE_GLTHREAD_END(&wq->wait_queue_head, curr);
     }
@@ -892,24 +1454,306 @@ main (int argc, char **argv)
 
 
 
-/*
-Visit : www.csepracticals.com for more courses and projects
-Join Telegram Grp : telecsepracticals
-*/
-
-
+/* Futex Wait Queue Implementation Starts Here */
 
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#else
+#define cpu_relax() atomic_signal_fence(memory_order_seq_cst)
+#endif
 
+static inline void
+futex_wait(_Atomic uint32_t *uaddr, uint32_t val) {
+
+#ifdef __linux__
+    /* Returns immediately if *uaddr != val, spurious returns are fine
+       as caller always re-tests */
+    syscall(SYS_futex, (uint32_t *)uaddr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+#else
+    sched_yield();
+#endif
+}
 
+static inline void
+futex_wake(_Atomic uint32_t *uaddr, int n_threads) {
 
+#ifdef __linux__
+    syscall(SYS_futex, (uint32_t *)uaddr, FUTEX_WAKE_PRIVATE, n_threads, NULL, NULL, 0);
+#endif
+}
 
+void
+futex_wait_queue_init (futex_wait_queue_t *wq) {
 
-/* Thread Barrier Implementation Starts here */
+    atomic_init(&wq->thread_wait_count, 0);
+    atomic_init(&wq->n_sleepers, 0);
+    atomic_init(&wq->futex_word, 0);
+    wq->appln_mutex = NULL;
+    futex_wait_queue_set_auto_unlock_appln_mutex(wq, true);
+}
 
 void
-thread_barrier_print(th_barrier_t *th_barrier) {
+futex_wait_queue_set_auto_unlock_appln_mutex(futex_wait_queue_t *wq,
+        bool state) {
 
-    printf("th_barrier->threshold = %u\n", th_barrier->threshold);
+    wq->auto_unlock_appln_mutex = state;
+}
+
+/* Same contract as wait_queue_test_and_wait( ). The application mutex is
+   released while the thread waits and is locked again before re-testing
+   the predicate. Always returns curr_thread */
+thread_t *
+futex_wait_queue_test_and_wait (futex_wait_queue_t *wq,
+        wait_queue_block_fn wait_queue_block_fn_cb,
+        void *arg,
+        thread_t *curr_thread) {
+
+    bool should_block;
+    uint32_t spin;
+    uint32_t futex_val;
+    pthread_mutex_t *locked_appln_mutex = NULL;
+
+    should_block = wait_queue_block_fn_cb (arg, &locked_appln_mutex);
+
+    /* Application must return the mutex which it has already locked*/
+    assert (locked_appln_mutex);
+
+    if (!wq->appln_mutex) {
+        wq->appln_mutex = locked_appln_mutex;
+    }
+    else {
+        assert (wq->appln_mutex == locked_appln_mutex);
+    }
+
+    while (should_block) {
+
+        /* Register as a waiter and sample the futex word while still
+           holding the appln mutex. Any signal issued after the predicate
+           has been changed under appln mutex will see thread_wait_count
+           non-zero and bump the futex word past futex_val */
+        atomic_fetch_add(&wq->thread_wait_count, 1);
+        futex_val = atomic_load(&wq->futex_word);
+        pthread_mutex_unlock(wq->appln_mutex);
+
+        for (spin = 0; spin < FUTEX_WQ_SPIN_COUNT; spin++) {
+            if (atomic_load_explicit(&wq->futex_word,
+                    memory_order_acquire) != futex_val) break;
+            cpu_relax();
+        }
+
+        if (spin == FUTEX_WQ_SPIN_COUNT) {
+            atomic_fetch_add(&wq->n_sleepers, 1);
+            while (atomic_load(&wq->futex_word) == futex_val) {
+                futex_wait(&wq->futex_word, futex_val);
+            }
+            atomic_fetch_sub(&wq->n_sleepers, 1);
+        }
+
+        pthread_mutex_lock(wq->appln_mutex);
+        atomic_fetch_sub(&wq->thread_wait_count, 1);
+
+        /* Re-test the predicate, mutex is already locked */
+        should_block = wait_queue_block_fn_cb (arg, NULL);
+    }
+
+    if (wq->auto_unlock_appln_mutex){
+        pthread_mutex_unlock (locked_appln_mutex);
+    }
+    return curr_thread;
+}
+
+static void
+futex_wait_queue_wake(futex_wait_queue_t *wq, int n_threads) {
+
+    /* Fast path : nobody is waiting, no store, no syscall */
+    if (!atomic_load(&wq->thread_wait_count)) return;
+
+    atomic_fetch_add(&wq->futex_word, 1);
+
+    /* Spinning waiters notice the bump by themselves, enter the kernel
+       only if someone is asleep */
+    if (atomic_load(&wq->n_sleepers)) {
+        futex_wake(&wq->futex_word, n_threads);
+    }
+}
+
+void
+futex_wait_queue_signal (futex_wait_queue_t *wq, bool lock_mutex) {
+
+    (void)lock_mutex;
+    futex_wait_queue_wake(wq, 1);
+}
+
+void
+futex_wait_queue_broadcast (futex_wait_queue_t *wq, bool lock_mutex) {
+
+    (void)lock_mutex;
+    futex_wait_queue_wake(wq, INT32_MAX);
+}
+
+void
+futex_wait_queue_print(futex_wait_queue_t *wq) {
+
+    printf("wq->thread_wait_count = %u\n", atomic_load(&wq->thread_wait_count));
+    printf("wq->n_sleepers = %u\n", atomic_load(&wq->n_sleepers));
+    printf("wq->futex_word = %u\n", atomic_load(&wq->futex_word));
+    printf("wq->appl_result = %p\n", wq->appln_mutex);
+}
+
+/* Micro-benchmark : futex_wait_queue_t vs wait_queue_t */
+#if 0
+
+#define WQ_BENCH_ITERATIONS 200000
+
+static pthread_mutex_t bench_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t bench_turn;
+static wait_queue_t cv_wq[2];
+static futex_wait_queue_t futex_wq[2];
+
+typedef struct bench_arg_ {
+    uint32_t my_turn;
+} bench_arg_t;
+
+static bool
+bench_not_my_turn(void *arg, pthread_mutex_t **locked_appln_mutex) {
+
+    if (locked_appln_mutex) {
+        pthread_mutex_lock(&bench_mutex);
+        *locked_appln_mutex = &bench_mutex;
+    }
+    return bench_turn != ((bench_arg_t *)arg)->my_turn;
+}
+
+static uint64_t
+bench_now_ns(void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Two threads hand a token back and forth through two wait queues */
+static void *
+cv_ping_pong_fn(void *arg) {
+
+    uint32_t i;
+    bench_arg_t *barg = (bench_arg_t *)arg;
+    thread_t thread;
+    create_thread(&thread, "cv_bench", THREAD_ANY);
+
+    for (i = 0; i < WQ_BENCH_ITERATIONS; i++) {
+        wait_queue_test_and_wait(&cv_wq[barg->my_turn],
+                bench_not_my_turn, arg, &thread);
+        pthread_mutex_lock(&bench_mutex);
+        bench_turn = !barg->my_turn;
+        pthread_mutex_unlock(&bench_mutex);
+        wait_queue_signal(&cv_wq[!barg->my_turn], true);
+    }
+    return NULL;
+}
+
+static void *
+futex_ping_pong_fn(void *arg) {
+
+    uint32_t i;
+    bench_arg_t *barg = (bench_arg_t *)arg;
+
+    for (i = 0; i < WQ_BENCH_ITERATIONS; i++) {
+        futex_wait_queue_test_and_wait(&futex_wq[barg->my_turn],
+                bench_not_my_turn, arg, NULL);
+        pthread_mutex_lock(&bench_mutex);
+        bench_turn = !barg->my_turn;
+        pthread_mutex_unlock(&bench_mutex);
+        futex_wait_queue_signal(&futex_wq[!barg->my_turn], true);
+    }
+    return NULL;
+}
+
+static void
+bench_ping_pong(const char *name, void *(*fn)(void *)) {
+
+    pthread_t th[2];
+    bench_arg_t args[2] = {{0}, {1}};
+    uint64_t start;
+
+    bench_turn = 0;
+    start = bench_now_ns();
+    pthread_create(&th[0], NULL, fn, &args[0]);
+    pthread_create(&th[1], NULL, fn, &args[1]);
+    pthread_join(th[0], NULL);
+    pthread_join(th[1], NULL);
+    printf("%-8s ping-pong       : %6.1f ns/hand-off\n", name,
+        (double)(bench_now_ns() - start) / (2 * WQ_BENCH_ITERATIONS));
+}
+
+int
+main(int argc, char **argv) {
+
+    uint32_t i;
+    uint64_t start;
+    thread_t thread;
+
+    wait_queue_init(&cv_wq[0], false, NULL);
+    wait_queue_init(&cv_wq[1], false, NULL);
+    futex_wait_queue_init(&futex_wq[0]);
+    futex_wait_queue_init(&futex_wq[1]);
+
+    /* Cache the appln mutex in both CV wait queues */
+    create_thread(&thread, "main", THREAD_ANY);
+    bench_turn = 0;
+    {
+        bench_arg_t a = {0};
+        wait_queue_test_and_wait(&cv_wq[0], bench_not_my_turn, &a, &thread);
+        wait_queue_test_and_wait(&cv_wq[1], bench_not_my_turn, &a, &thread);
+    }
+
+    /* Signal with no waiters, the common case */
+    start = bench_now_ns();
+    for (i = 0; i < WQ_BENCH_ITERATIONS * 10; i++) {
+        wait_queue_signal(&cv_wq[0], true);
+    }
+    printf("%-8s signal no waiter : %6.1f ns/op\n", "cv",
+        (double)(bench_now_ns() - start) / (WQ_BENCH_ITERATIONS * 10));
+
+    start = bench_now_ns();
+    for (i = 0; i < WQ_BENCH_ITERATIONS * 10; i++) {
+        futex_wait_queue_signal(&futex_wq[0], true);
+    }
+    printf("%-8s signal no waiter : %6.1f ns/op\n", "futex",
+        (double)(bench_now_ns() - start) / (WQ_BENCH_ITERATIONS * 10));
+
+    bench_ping_pong("cv", cv_ping_pong_fn);
+    bench_ping_pong("futex", futex_ping_pong_fn);
+    return 0;
+}
+
+#endif
+
+/* Futex Wait Queue Implementation Ends Here */
+
+
+
+
+
+
+/*
+Visit : www.csepracticals.com for more courses and projects
+Join Telegram Grp : telecsepracticals
+*/
+
+
+
+
+
+
+
+
+/* Thread Barrier Implementation Starts here */
+
+void
+thread_barrier_print(th_barrier_t *th_barrier) {
+
+    printf("th_barrier->threshold = %u\n", th_barrier->threshold);
     printf("th_barrier->curr_wait_count = %u\n", th_barrier->curr_wait_count);
     printf("th_barrier->is_ready_again = %s\n", th_barrier->is_ready_again ? "true" : "false");
 }
@@ -1612,6 +2456,82 @@ main(int argc, char **argv) {
 
 /* Assembly line implementation starts here */
 
+#ifdef ASL_STATS
+
+static inline uint64_t
+asl_ticks(void) {
+
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+/* Items below 2^(LAT_HIST_SUB_BITS + 1) ticks get a bucket each, larger
+ * ones the bucket of their LAT_HIST_SUB_BITS + 1 leading bits */
+static inline uint32_t
+lat_hist_bucket(uint64_t value) {
+
+    uint32_t msb, shift;
+
+    if (value < (2ULL << LAT_HIST_SUB_BITS)) return (uint32_t)value;
+
+    msb = 63 - __builtin_clzll(value);
+    if (msb >= LAT_HIST_MAX_BITS) return LAT_HIST_N_BUCKETS - 1;
+
+    shift = msb - LAT_HIST_SUB_BITS;
+    return (shift << LAT_HIST_SUB_BITS) + (uint32_t)(value >> shift);
+}
+
+static uint64_t
+lat_hist_bucket_low(uint32_t bucket) {
+
+    uint32_t shift;
+
+    if (bucket < (2U << LAT_HIST_SUB_BITS)) return bucket;
+
+    shift = (bucket >> LAT_HIST_SUB_BITS) - 1;
+    return (uint64_t)((bucket & ((1U << LAT_HIST_SUB_BITS) - 1)) |
+                      (1U << LAT_HIST_SUB_BITS)) << shift;
+}
+
+/* Single writer, the snapshot reads concurrently */
+static inline void
+asl_stats_add(uint64_t *counter, uint64_t n) {
+
+    __atomic_store_n(counter, *counter + n, __ATOMIC_RELAXED);
+}
+
+static void
+asl_worker_stats_record(asl_worker_stats_t *stats, uint64_t wait_ticks,
+                        uint64_t service_ticks, uint32_t n_items) {
+
+    asl_stats_add(&stats->wait.count[lat_hist_bucket(wait_ticks)], n_items);
+    asl_stats_add(&stats->service.count[lat_hist_bucket(service_ticks)],
+                  n_items);
+}
+
+/* Per thread, the pushing threads of a replicated line pick the items to
+ * time without sharing a counter */
+static __thread uint32_t asl_stats_n_pushed;
+
+#endif
+
+/* Stamp of an item getting ready for a slot, 0 i.e. not timed when the
+ * stats are compiled out */
+static inline uint64_t
+asl_stats_now(void) {
+
+#ifdef ASL_STATS
+    return asl_ticks();
+#else
+    return 0;
+#endif
+}
+
 /* Fn to be used by wait_queue_t data structure to block all threads
  * until some specified condn is met. This fn is written as per wait-queue_t
  * specification
@@ -1639,11 +2559,16 @@ asl_wait_until_all_workers_ready(void *app_arg,
  */
 static void
 assembly_line_enqueue_new_item(assembly_line_t *asl,
-        void *object) {
+        void *object, uint64_t ready_ticks) {
 
     asl_worker_t *T0 = asl->T0;
     assert(asl->asl_q->elem[T0->curr_slot] == 0);
     Fifo_insert_or_replace_at_index(asl->asl_q, object, T0->curr_slot);
+#ifdef ASL_STATS
+    asl->elem_ready_ticks[T0->curr_slot] = ready_ticks;
+#else
+    (void)ready_ticks;
+#endif
 }
 
 static asl_worker_t *
@@ -1660,13 +2585,58 @@ assembly_line_create_new_worker_thread (assembly_line_t *asl,
     worker_thread->curr_slot = slot_no;
     worker_thread->asl = asl;
     init_glthread(&worker_thread->worker_thread_glue);
+#ifdef ASL_STATS
+    worker_thread->stats.slot_no = slot_no;
+#endif
     return worker_thread;
 }
 
+/* Runs the work fn on the object of a slot, i.e. on every item of it
+ * in batch mode */
+static void
+assembly_line_do_work(assembly_line_t *asl,
+        generic_fn_ptr work, void *object) {
+
+    uint32_t i;
+    asl_batch_t *batch;
+
+    if (asl->batch_size == 1) {
+        work(object);
+        return;
+    }
+
+    batch = (asl_batch_t *)object;
+    for (i = 0; i < batch->n_items; i++) {
+        work(batch->items[i]);
+    }
+}
+
+static void
+assembly_line_finish(assembly_line_t *asl, void *object) {
+
+    uint32_t i;
+    asl_batch_t *batch;
+
+    if (asl->batch_size == 1) {
+        asl->asl_process_finished_product(object);
+        return;
+    }
+
+    batch = (asl_batch_t *)object;
+    for (i = 0; i < batch->n_items; i++) {
+        asl->asl_process_finished_product(batch->items[i]);
+    }
+    free(batch);
+}
+
 static void *
 worker_thread_init(void *arg) {
 
     Fifo_Queue_t *asl_q;
+#ifdef ASL_STATS
+    uint64_t t_start, t_end;
+    uint32_t n_items;
+#endif
     asl_worker_t *worker_thread = (asl_worker_t *)arg;
     assembly_line_t *asl = worker_thread->asl;
 
@@ -1701,7 +2671,22 @@ worker_thread_init(void *arg) {
             /* Execute Worker thread operation on Object now. Note that, this code
              * needs to be run in parallel by all worker threads, Dont mutual exclusate
              * this section of the code*/
-            (worker_thread->work)( (void *) (asl_q->elem[worker_thread->curr_slot]));
+#ifdef ASL_STATS
+            n_items = asl->batch_size == 1 ? 1 :
+                ((asl_batch_t *)asl_q->elem[worker_thread->curr_slot])->n_items;
+            t_start = asl_ticks();
+#endif
+            assembly_line_do_work(asl, worker_thread->work,
+                    asl_q->elem[worker_thread->curr_slot]);
+#ifdef ASL_STATS
+            /* Ready for the next worker, which gets to it next cycle */
+            t_end = asl_ticks();
+            asl_stats_add(&worker_thread->stats.n_items, n_items);
+            asl_worker_stats_record(&worker_thread->stats,
+                    t_start - asl->elem_ready_ticks[worker_thread->curr_slot],
+                    (t_end - t_start) / n_items, n_items);
+            asl->elem_ready_ticks[worker_thread->curr_slot] = t_end;
+#endif
 
             if (worker_thread == asl->Tn) {
 
@@ -1713,7 +2698,7 @@ worker_thread_init(void *arg) {
                 void *finished_obj = Fifo_insert_or_replace_at_index(
                         asl->asl_q, 0,
                         worker_thread->curr_slot);
-                asl->asl_process_finished_product(finished_obj);
+                assembly_line_finish(asl, finished_obj);
                 pthread_mutex_unlock(&asl->mutex);
             }
         }
@@ -1745,16 +2730,278 @@ assembly_line_start_worker_thread(asl_worker_t *worker_thread) {
             (void *)worker_thread);
 }
 
+/* Replicated assembly line. Every slot owns a Fifo_Mpmc_Queue_t, its
+ * replicas pull objects from it, run the slot work fn and hand them
+ * over to the queue of the next slot, so that a slow slot can be given
+ * more workers instead of capping the throughput of the whole line.
+ *
+ * An in-order slot dequeues with tickets, i.e. the position of the object
+ * in its queue. A replica done with an object parks it in the reorder
+ * buffer at its ticket, and the one which completes the run starting
+ * at rob_next hands the run over, under rob_mutex to keep it in order.
+ * A replica whose ticket is ASL_REORDER_WINDOW ahead of rob_next waits,
+ * the object at rob_next being in the hands of a running replica this
+ * cannot dead lock */
+
+/* stamp, when the object is timed, is when it got ready for the slot */
+static inline void
+asl_slot_enqueue(asl_slot_t *slot, void *object, uint64_t stamp) {
+
+#ifdef ASL_STATS
+    Fifo_mpmc_enqueue_blocking_stamped(slot->in_q, object, stamp);
+#else
+    (void)stamp;
+    Fifo_mpmc_enqueue_blocking(slot->in_q, object);
+#endif
+}
+
+static inline void *
+asl_slot_deque(asl_slot_t *slot, size_t *ticket, uint64_t *stamp) {
+
+#ifdef ASL_STATS
+    return Fifo_mpmc_deque_blocking_stamped(slot->in_q, ticket, stamp);
+#else
+    *stamp = 0;
+    return Fifo_mpmc_deque_blocking_ticket(slot->in_q, ticket);
+#endif
+}
+
+static void
+asl_slot_hand_over(assembly_line_t *asl, asl_slot_t *slot,
+                   void *object, uint64_t stamp) {
+
+    if (slot->slot_no == asl->asl_size - 1) {
+        asl->asl_process_finished_product(object);
+    }
+    else {
+        asl_slot_enqueue(&asl->slots[slot->slot_no + 1], object, stamp);
+    }
+}
+
+static void
+asl_slot_reorder(assembly_line_t *asl, asl_slot_t *slot,
+                 void *object, size_t ticket, uint64_t stamp) {
+
+    uint32_t idx;
+
+    pthread_mutex_lock(&slot->rob_mutex);
+
+    while (ticket - slot->rob_next >= ASL_REORDER_WINDOW) {
+        slot->n_rob_waiters++;
+        pthread_cond_wait(&slot->rob_cv, &slot->rob_mutex);
+        slot->n_rob_waiters--;
+    }
+
+    slot->rob[ticket & (ASL_REORDER_WINDOW - 1)] = object;
+#ifdef ASL_STATS
+    slot->rob_stamps[ticket & (ASL_REORDER_WINDOW - 1)] = stamp;
+#endif
+
+    /* Some older object is still being worked on, its replica will hand
+     * over this one too */
+    if (ticket != slot->rob_next) {
+        pthread_mutex_unlock(&slot->rob_mutex);
+        return;
+    }
+
+    idx = slot->rob_next & (ASL_REORDER_WINDOW - 1);
+    while ((object = slot->rob[idx])) {
+        slot->rob[idx] = NULL;
+#ifdef ASL_STATS
+        stamp = slot->rob_stamps[idx];
+#endif
+        slot->rob_next++;
+        asl_slot_hand_over(asl, slot, object, stamp);
+        idx = slot->rob_next & (ASL_REORDER_WINDOW - 1);
+    }
+
+    if (slot->n_rob_waiters) {
+        pthread_cond_broadcast(&slot->rob_cv);
+    }
+    pthread_mutex_unlock(&slot->rob_mutex);
+}
+
+static void *
+asl_replica_fn(void *arg) {
+
+    void *object;
+    size_t ticket;
+    uint64_t stamp;
+#ifdef ASL_STATS
+    uint64_t t_start = 0, t_end;
+#endif
+    asl_worker_t *replica = (asl_worker_t *)arg;
+    assembly_line_t *asl = replica->asl;
+    asl_slot_t *slot = &asl->slots[replica->curr_slot];
+
+    while (1) {
+
+        object = asl_slot_deque(slot, &ticket, &stamp);
+#ifdef ASL_STATS
+        asl_stats_add(&replica->stats.n_items, 1);
+        if (stamp) {
+            t_start = asl_ticks();
+        }
+#endif
+        (replica->work)(object);
+#ifdef ASL_STATS
+        if (stamp) {
+            t_end = asl_ticks();
+            asl_worker_stats_record(&replica->stats, t_start - stamp,
+                                    t_end - t_start, 1);
+            stamp = t_end;
+        }
+#endif
+
+        if (slot->order == ASL_SLOT_UNORDERED) {
+            asl_slot_hand_over(asl, slot, object, stamp);
+        }
+        else {
+            asl_slot_reorder(asl, slot, object, ticket, stamp);
+        }
+    }
+
+    return NULL;
+}
+
+/* Caller has the responsibility to lock the ASL mutex if required */
+static void
+assembly_line_add_replica(assembly_line_t *asl, asl_slot_t *slot) {
+
+    char th_name[32];
+    asl_worker_t *replica =
+        (asl_worker_t *)calloc(1, sizeof(asl_worker_t));
+
+    snprintf(th_name, sizeof(th_name), "slot%u_replica%u",
+             slot->slot_no, slot->n_running);
+    replica->worker_thread = create_thread(0, th_name, THREAD_ANY);
+    replica->curr_slot = slot->slot_no;
+    replica->asl = asl;
+    replica->work = asl->work_fns[slot->slot_no];
+    replica->initialized = true;
+#ifdef ASL_STATS
+    replica->stats.slot_no = slot->slot_no;
+#endif
+    init_glthread(&replica->worker_thread_glue);
+    glthread_add_next(&slot->replicas_head, &replica->worker_thread_glue);
+
+    slot->n_running++;
+    asl->n_replicas_total++;
+
+    run_thread(replica->worker_thread, asl_replica_fn, (void *)replica);
+}
+
+/* Engine of a replicated line, grows the slot which is the furthest
+ * behind. Once a bottleneck pushes back, the slots upstream of it show
+ * queues as long as its own, give or take the objects in the hands of
+ * their replicas, while the ones downstream starve. Hence the most
+ * downstream slot whose queue is at least half the longest one */
+static void *
+asl_autoscale_fn(void *arg) {
+
+    uint32_t i, max_depth;
+    asl_slot_t *slot;
+    struct timespec next;
+    assembly_line_t *asl = (assembly_line_t *) arg;
+    uint32_t *depth = (uint32_t *)calloc(asl->asl_size, sizeof(uint32_t));
+
+    /* Replicated lines push without asl->mutex, holding it while sampling
+     * only serializes with assembly_line_stop_autoscale( ) */
+    pthread_mutex_lock(&asl->mutex);
+
+    while (!asl->autoscale_stop &&
+           asl->n_replicas_total < asl->autoscale_max_workers) {
+
+        clock_gettime(CLOCK_REALTIME, &next);
+        next.tv_nsec += ASL_AUTOSCALE_PERIOD_MS * 1000000L;
+        next.tv_sec += next.tv_nsec / 1000000000;
+        next.tv_nsec %= 1000000000;
+        pthread_cond_timedwait(&asl->asl_engine_thread->cv, &asl->mutex, &next);
+        if (asl->autoscale_stop) break;
+
+        max_depth = 0;
+        for (i = 0; i < asl->asl_size; i++) {
+            depth[i] = Fifo_mpmc_count(asl->slots[i].in_q);
+            if (depth[i] > max_depth) max_depth = depth[i];
+        }
+
+        if (max_depth < ASL_AUTOSCALE_MIN_DEPTH) continue;
+
+        for (i = asl->asl_size - 1; depth[i] * 2 < max_depth; i--);
+        slot = &asl->slots[i];
+
+        /* More replicas elsewhere would only queue up behind it */
+        if (slot->n_running == ASL_MAX_REPLICAS) continue;
+
+        assembly_line_add_replica(asl, slot);
+    }
+
+    pthread_mutex_unlock(&asl->mutex);
+    free(depth);
+    return NULL;
+}
+
+static void
+assembly_line_init_replicas(assembly_line_t *asl) {
+
+    uint32_t i, j;
+    asl_slot_t *slot;
+
+    pthread_mutex_lock(&asl->mutex);
+
+    for (i = 0; i < asl->asl_size; i++) {
+
+        slot = &asl->slots[i];
+        assert(asl->work_fns[i]);
+        slot->in_q = Fifo_mpmc_initQ(ASL_SLOT_QUEUE_SIZE);
+
+        if (slot->order == ASL_SLOT_IN_ORDER) {
+            slot->rob = (void **)calloc(ASL_REORDER_WINDOW, sizeof(void *));
+#ifdef ASL_STATS
+            slot->rob_stamps = (uint64_t *)calloc(ASL_REORDER_WINDOW,
+                                                  sizeof(uint64_t));
+#endif
+            slot->rob_next = 0;
+            pthread_mutex_init(&slot->rob_mutex, NULL);
+            pthread_cond_init(&slot->rob_cv, NULL);
+        }
+    }
+
+    /* All queues exist before the first replica may hand over */
+    for (i = 0; i < asl->asl_size; i++) {
+        for (j = 0; j < asl->slots[i].n_replicas; j++) {
+            assembly_line_add_replica(asl, &asl->slots[i]);
+        }
+    }
+
+    if (asl->autoscale_max_workers > asl->n_replicas_total) {
+
+        asl->asl_engine_thread =
+            create_thread (0, "assembly_line_autoscale_thread", THREAD_ANY);
+        asl->asl_state = ASL_IN_PROGRESS;
+        run_thread(asl->asl_engine_thread, asl_autoscale_fn, (void *)asl);
+    }
+
+    printf("%u replica workers ready \n", asl->n_replicas_total);
+    pthread_mutex_unlock(&asl->mutex);
+}
+
 void
 assembly_line_init_worker_threads (assembly_line_t *asl) {
 
-    int i;
+    uint32_t i;
     asl_worker_t *worker_thread;
+    thread_t *main_thread;
+
+    if (asl->replicated) {
+        assembly_line_init_replicas(asl);
+        return;
+    }
 
     /* A dummy thread data structure created to represent the main
        thread i.e. the thread which is executing 'this' code
        */
-    thread_t *main_thread = create_thread(0, "main-thread",  THREAD_ANY);
+    main_thread = create_thread(0, "main-thread",  THREAD_ANY);
 
     for (i = 0 ; i < asl->asl_size; i++) {
 
@@ -1794,6 +3041,7 @@ assembly_line_get_new_assembly_line(char *asl_name,
         uint32_t size,
         void (*asl_process_finished_product)(void *arg)){
 
+    uint32_t i;
     assembly_line_t *asl = (assembly_line_t *) calloc(1, sizeof(assembly_line_t));
 
     strncpy(asl->asl_name, asl_name, sizeof(asl->asl_name));
@@ -1821,9 +3069,64 @@ assembly_line_get_new_assembly_line(char *asl_name,
 
     asl->wait_lst_fq = Fifo_initQ(50, false);
 
+    asl->batch_size = 1;
+
+#ifdef ASL_STATS
+    clock_gettime(CLOCK_MONOTONIC, &asl->stats_start);
+    asl->stats_start_ticks = asl_ticks();
+    asl->elem_ready_ticks = (uint64_t *)calloc(asl->asl_size, sizeof(uint64_t));
+    asl->wait_lst_ticks = (uint64_t *)calloc(asl->wait_lst_fq->size,
+                                             sizeof(uint64_t));
+#endif
+
+    asl->slots = (asl_slot_t *)calloc(asl->asl_size, sizeof(asl_slot_t));
+    for (i = 0; i < asl->asl_size; i++) {
+        asl->slots[i].slot_no = i;
+        asl->slots[i].n_replicas = 1;
+        asl->slots[i].order = ASL_SLOT_IN_ORDER;
+        init_glthread(&asl->slots[i].replicas_head);
+    }
+
     return asl;
 }
 
+static bool
+assembly_line_open_batch_due(assembly_line_t *asl) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (now.tv_sec > asl->open_batch_deadline.tv_sec ||
+            (now.tv_sec == asl->open_batch_deadline.tv_sec &&
+             now.tv_nsec >= asl->open_batch_deadline.tv_nsec));
+}
+
+/* Next object to enter the ASL Queue : from the wait list, else in batch
+ * mode the open batch once its deadline has passed. Caller holds
+ * asl->mutex */
+static void *
+assembly_line_next_wait_lst_item(assembly_line_t *asl, uint64_t *ready_ticks) {
+
+    void *item;
+
+    *ready_ticks = 0;
+#ifdef ASL_STATS
+    *ready_ticks = asl->wait_lst_ticks[asl->wait_lst_fq->front];
+#endif
+    item = Fifo_deque(asl->wait_lst_fq);
+
+    if (item || !asl->open_batch || !assembly_line_open_batch_due(asl)) {
+        return item;
+    }
+
+#ifdef ASL_STATS
+    *ready_ticks = asl->open_batch_ticks;
+#endif
+    item = asl->open_batch;
+    asl->open_batch = NULL;
+    return item;
+}
+
 /* ASL engine function, this fn kick-starts all the ASL worker threads
  * and wait for all of them to complete processing on their respective
  * objects. When all worker threads finished processing, ASL engine is
@@ -1836,6 +3139,7 @@ asl_engine_fn(void *arg) {
     glthread_t *curr;
     asl_worker_t *worker_thread;
     void *wait_lst_item;
+    uint64_t ready_ticks;
 
     assembly_line_t *asl = (assembly_line_t *) arg;
 
@@ -1863,10 +3167,10 @@ asl_engine_fn(void *arg) {
         }
 
         /* ASL thread is unblocked, asl->mutex is not yet released by WQ */
-        wait_lst_item =  Fifo_deque(asl->wait_lst_fq);
+        wait_lst_item = assembly_line_next_wait_lst_item(asl, &ready_ticks);
 
         if (wait_lst_item) {
-            assembly_line_enqueue_new_item(asl, wait_lst_item);
+            assembly_line_enqueue_new_item(asl, wait_lst_item, ready_ticks);
         }
 
         if (asl->asl_q->count) {
@@ -1874,11 +3178,21 @@ asl_engine_fn(void *arg) {
         }
         /* No more objects in ASL Queue pipeline, ASL engine will block
          * itself, and will be woken up when some appln enqueues new
-         * object in ASL Queue */
+         * object in ASL Queue, or when the open batch is due */
         else {
             asl->asl_state = ASL_WAIT;
             printf("Assembly line came to halt\n");
-            pthread_cond_wait(&asl->asl_engine_thread->cv, &asl->mutex);
+            if (!asl->open_batch) {
+                pthread_cond_wait(&asl->asl_engine_thread->cv, &asl->mutex);
+                continue;
+            }
+            pthread_cond_timedwait(&asl->asl_engine_thread->cv, &asl->mutex,
+                    &asl->open_batch_deadline);
+            if (!asl->asl_q->count &&
+                    (wait_lst_item = assembly_line_next_wait_lst_item(
+                                        asl, &ready_ticks))) {
+                assembly_line_enqueue_new_item(asl, wait_lst_item, ready_ticks);
+            }
         }
     } while(1);
 
@@ -1912,6 +3226,36 @@ assembly_line_engine_start(assembly_line_t *asl) {
     }
 }
 
+/* Appends the item to the open batch, returns the batch once full */
+static asl_batch_t *
+assembly_line_batch_add(assembly_line_t *asl, void *item) {
+
+    asl_batch_t *batch = asl->open_batch;
+
+    if (!batch) {
+        batch = (asl_batch_t *)malloc(sizeof(asl_batch_t) +
+                    asl->batch_size * sizeof(void *));
+        batch->n_items = 0;
+        asl->open_batch = batch;
+#ifdef ASL_STATS
+        asl->open_batch_ticks = asl_ticks();
+#endif
+        clock_gettime(CLOCK_REALTIME, &asl->open_batch_deadline);
+        asl->open_batch_deadline.tv_nsec +=
+            (long)(asl->batch_deadline_us % 1000000) * 1000;
+        asl->open_batch_deadline.tv_sec +=
+            asl->batch_deadline_us / 1000000 +
+            asl->open_batch_deadline.tv_nsec / 1000000000;
+        asl->open_batch_deadline.tv_nsec %= 1000000000;
+    }
+
+    batch->items[batch->n_items++] = item;
+    if (batch->n_items < asl->batch_size) return NULL;
+
+    asl->open_batch = NULL;
+    return batch;
+}
+
 /*
  * Used by the Appns (clients of ASL) to push the new objects to be
  * passed through ASL processing. Appln could be multithreaded, so this
@@ -1921,15 +3265,42 @@ void
 assembly_line_push_new_item(assembly_line_t *asl,
         void *new_item) {
 
-    glthread_t *curr;
-    asl_worker_t *worker_thread;
+    uint64_t ready_ticks = 0;
+
+    /* No engine, no asl->mutex, the first slot queue is safe to fill
+     * from any no of appln threads */
+    if (asl->replicated) {
+#ifdef ASL_STATS
+        if (++asl_stats_n_pushed % ASL_STATS_SAMPLE == 0) {
+            ready_ticks = asl_ticks();
+        }
+#endif
+        asl_slot_enqueue(&asl->slots[0], new_item, ready_ticks);
+        return;
+    }
+
+    ready_ticks = asl_stats_now();
 
     /* lock the ASL, since we are going to update the ASL Queue */
     pthread_mutex_lock(&asl->mutex);
 
+    /* Batch mode, the item waits in the open batch until it is full or
+     * due. The engine is started anyway, to time out the open batch */
+    if (asl->batch_size > 1) {
+        new_item = assembly_line_batch_add(asl, new_item);
+        if (!new_item) {
+            assembly_line_engine_start(asl);
+            pthread_mutex_unlock(&asl->mutex);
+            return;
+        }
+#ifdef ASL_STATS
+        ready_ticks = asl->open_batch_ticks;
+#endif
+    }
+
     /* Push the first item in the assembly line */
     if (!asl->asl_q->count) {
-        assembly_line_enqueue_new_item(asl, new_item); 
+        assembly_line_enqueue_new_item(asl, new_item, ready_ticks);
     }
     /* It means, there are some objects in the ASL Queue in process,
      * let us Queue the new arrivals in backup Queue. Whenever ASL makes
@@ -1938,6 +3309,9 @@ assembly_line_push_new_item(assembly_line_t *asl,
      * possible */
     else if (!is_queue_full(asl->wait_lst_fq)) {
         Fifo_enqueue(asl->wait_lst_fq, new_item);
+#ifdef ASL_STATS
+        asl->wait_lst_ticks[asl->wait_lst_fq->rear] = ready_ticks;
+#endif
     }
     else {
         assert(0);
@@ -1959,6 +3333,271 @@ assembly_line_register_worker_fns(assembly_line_t *asl,
     asl->work_fns[slot] = work_fn;
 }
 
+void
+assembly_line_set_slot_replicas(assembly_line_t *asl,
+        uint32_t slot,
+        uint32_t n_replicas,
+        asl_slot_order_t order) {
+
+    assert(slot < asl->asl_size);
+    assert(n_replicas && n_replicas <= ASL_MAX_REPLICAS);
+    assert(!asl->n_replicas_total);
+
+    assert(asl->batch_size == 1);
+
+    asl->replicated = true;
+    asl->slots[slot].n_replicas = n_replicas;
+    asl->slots[slot].order = order;
+}
+
+void
+assembly_line_set_batching(assembly_line_t *asl,
+        uint32_t batch_size,
+        uint32_t deadline_us) {
+
+    assert(batch_size);
+    assert(!asl->replicated);
+    assert(!asl->asl_engine_thread);
+
+    asl->batch_size = batch_size;
+    asl->batch_deadline_us = deadline_us;
+}
+
+void
+assembly_line_enable_autoscale(assembly_line_t *asl,
+        uint32_t max_workers) {
+
+    assert(!asl->n_replicas_total);
+    assert(asl->batch_size == 1);
+
+    asl->replicated = true;
+    asl->autoscale_max_workers = max_workers;
+}
+
+void
+assembly_line_stop_autoscale(assembly_line_t *asl) {
+
+    thread_t *engine;
+
+    pthread_mutex_lock(&asl->mutex);
+    engine = asl->asl_engine_thread;
+    if (!asl->autoscale_max_workers || !engine) {
+        pthread_mutex_unlock(&asl->mutex);
+        return;
+    }
+    asl->autoscale_stop = true;
+    asl->asl_engine_thread = NULL;
+    pthread_cond_signal(&engine->cv);
+    pthread_mutex_unlock(&asl->mutex);
+
+    pthread_join(engine->thread, NULL);
+    pthread_attr_destroy(&engine->attributes);
+    pthread_cond_destroy(&engine->cv);
+    free(engine);
+}
+
+
+#ifdef ASL_STATS
+
+static uint64_t
+lat_hist_percentile(lat_hist_t *hist, uint64_t total, double fraction) {
+
+    uint32_t i;
+    uint64_t seen = 0;
+    uint64_t rank = (uint64_t)(fraction * total + 0.5);
+
+    if (!total) return 0;
+    if (rank < 1) rank = 1;
+
+    for (i = 0; i < LAT_HIST_N_BUCKETS - 1; i++) {
+        seen += hist->count[i];
+        if (seen >= rank) break;
+    }
+    return lat_hist_bucket_low(i + 1) - 1;
+}
+
+static void
+lat_hist_merge(lat_hist_t *dst, lat_hist_t *src) {
+
+    uint32_t i;
+
+    for (i = 0; i < LAT_HIST_N_BUCKETS; i++) {
+        dst->count[i] += __atomic_load_n(&src->count[i], __ATOMIC_RELAXED);
+    }
+}
+
+static void
+assembly_line_stats_merge_worker(asl_worker_t *worker,
+        asl_slot_snapshot_t *snapshots, lat_hist_t *wait, lat_hist_t *service) {
+
+    uint32_t slot_no = worker->stats.slot_no;
+
+    snapshots[slot_no].n_workers++;
+    snapshots[slot_no].n_items +=
+        __atomic_load_n(&worker->stats.n_items, __ATOMIC_RELAXED);
+    lat_hist_merge(&wait[slot_no], &worker->stats.wait);
+    lat_hist_merge(&service[slot_no], &worker->stats.service);
+}
+
+void
+assembly_line_stats_snapshot(assembly_line_t *asl,
+        asl_slot_snapshot_t *snapshots) {
+
+    uint32_t i, j;
+    glthread_t *curr;
+    uint64_t total;
+    struct timespec now;
+    double ns_per_tick, elapsed_ns;
+    uint64_t elapsed_ticks;
+    asl_slot_snapshot_t *snap;
+    lat_hist_t *wait = (lat_hist_t *)calloc(asl->asl_size, sizeof(lat_hist_t));
+    lat_hist_t *service = (lat_hist_t *)calloc(asl->asl_size, sizeof(lat_hist_t));
+
+    memset(snapshots, 0, asl->asl_size * sizeof(asl_slot_snapshot_t));
+
+    /* Replicas are added and wait list updated under asl->mutex */
+    pthread_mutex_lock(&asl->mutex);
+
+    if (asl->replicated) {
+        for (i = 0; i < asl->asl_size; i++) {
+            if (asl->slots[i].in_q) {
+                snapshots[i].queue_depth = Fifo_mpmc_count(asl->slots[i].in_q);
+            }
+            ITERATE_GLTHREAD_BEGIN(&asl->slots[i].replicas_head, curr) {
+                assembly_line_stats_merge_worker(
+                    worker_thread_glue_to_asl_worker_thread(curr),
+                    snapshots, wait, service);
+            } ITERATE_GLTHREAD_END(&asl->slots[i].replicas_head, curr)
+        }
+    }
+    else {
+        snapshots[0].queue_depth = asl->wait_lst_fq->count;
+        ITERATE_GLTHREAD_BEGIN(&asl->worker_threads_head, curr) {
+            assembly_line_stats_merge_worker(
+                worker_thread_glue_to_asl_worker_thread(curr),
+                snapshots, wait, service);
+        } ITERATE_GLTHREAD_END(&asl->worker_threads_head, curr)
+    }
+
+    pthread_mutex_unlock(&asl->mutex);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed_ticks = asl_ticks() - asl->stats_start_ticks;
+    elapsed_ns = (now.tv_sec - asl->stats_start.tv_sec) * 1e9 +
+                 (now.tv_nsec - asl->stats_start.tv_nsec);
+    ns_per_tick = elapsed_ticks ? elapsed_ns / elapsed_ticks : 1.0;
+
+    for (i = 0; i < asl->asl_size; i++) {
+
+        snap = &snapshots[i];
+        snap->slot_no = i;
+        snap->items_per_sec = elapsed_ns > 0 ? snap->n_items * 1e9 / elapsed_ns : 0;
+
+        for (total = 0, j = 0; j < LAT_HIST_N_BUCKETS; j++) {
+            total += wait[i].count[j];
+        }
+        snap->wait_p50_ns = lat_hist_percentile(&wait[i], total, 0.50) * ns_per_tick;
+        snap->wait_p99_ns = lat_hist_percentile(&wait[i], total, 0.99) * ns_per_tick;
+        snap->wait_p999_ns = lat_hist_percentile(&wait[i], total, 0.999) * ns_per_tick;
+        snap->wait_max_ns = lat_hist_percentile(&wait[i], total, 1.0) * ns_per_tick;
+
+        for (total = 0, j = 0; j < LAT_HIST_N_BUCKETS; j++) {
+            total += service[i].count[j];
+        }
+        snap->service_p50_ns = lat_hist_percentile(&service[i], total, 0.50) * ns_per_tick;
+        snap->service_p99_ns = lat_hist_percentile(&service[i], total, 0.99) * ns_per_tick;
+        snap->service_p999_ns = lat_hist_percentile(&service[i], total, 0.999) * ns_per_tick;
+        snap->service_max_ns = lat_hist_percentile(&service[i], total, 1.0) * ns_per_tick;
+    }
+
+    free(wait);
+    free(service);
+}
+
+/* Rates over interval_sec since prev if not NULL, else since the start */
+static void
+assembly_line_stats_print(assembly_line_t *asl, FILE *out,
+        asl_slot_snapshot_t *snaps, asl_slot_snapshot_t *prev,
+        double interval_sec) {
+
+    uint32_t i;
+    double rate;
+
+    fprintf(out, "Assembly line %s :\n", asl->asl_name);
+    fprintf(out, "  %4s %7s %6s %12s %10s   %-30s   %-30s\n",
+            "slot", "workers", "depth", "items", "items/sec",
+            "wait ns p50/p99/p99.9/max", "service ns p50/p99/p99.9/max");
+
+    for (i = 0; i < asl->asl_size; i++) {
+
+        rate = snaps[i].items_per_sec;
+        if (prev && interval_sec > 0) {
+            rate = (snaps[i].n_items - prev[i].n_items) / interval_sec;
+        }
+        fprintf(out, "  %4u %7u %6u %12llu %10.0f   %llu/%llu/%llu/%llu   %llu/%llu/%llu/%llu\n",
+                i, snaps[i].n_workers, snaps[i].queue_depth,
+                (unsigned long long)snaps[i].n_items, rate,
+                (unsigned long long)snaps[i].wait_p50_ns,
+                (unsigned long long)snaps[i].wait_p99_ns,
+                (unsigned long long)snaps[i].wait_p999_ns,
+                (unsigned long long)snaps[i].wait_max_ns,
+                (unsigned long long)snaps[i].service_p50_ns,
+                (unsigned long long)snaps[i].service_p99_ns,
+                (unsigned long long)snaps[i].service_p999_ns,
+                (unsigned long long)snaps[i].service_max_ns);
+    }
+    fflush(out);
+}
+
+void
+assembly_line_stats_dump(assembly_line_t *asl, FILE *out) {
+
+    asl_slot_snapshot_t *snaps = (asl_slot_snapshot_t *)
+        calloc(asl->asl_size, sizeof(asl_slot_snapshot_t));
+
+    assembly_line_stats_snapshot(asl, snaps);
+    assembly_line_stats_print(asl, out, snaps, NULL, 0);
+    free(snaps);
+}
+
+static void *
+assembly_line_stats_dump_fn(void *arg) {
+
+    assembly_line_t *asl = (assembly_line_t *)arg;
+    asl_slot_snapshot_t *tmp;
+    asl_slot_snapshot_t *snaps = (asl_slot_snapshot_t *)
+        calloc(asl->asl_size, sizeof(asl_slot_snapshot_t));
+    asl_slot_snapshot_t *prev = (asl_slot_snapshot_t *)
+        calloc(asl->asl_size, sizeof(asl_slot_snapshot_t));
+
+    /* Like the ASL engine, runs as long as the process */
+    while (1) {
+
+        usleep(asl->stats_dump_period_ms * 1000);
+        assembly_line_stats_snapshot(asl, snaps);
+        assembly_line_stats_print(asl, asl->stats_dump_out, snaps, prev,
+                                  asl->stats_dump_period_ms / 1000.0);
+        tmp = prev; prev = snaps; snaps = tmp;
+    }
+
+    return NULL;
+}
+
+void
+assembly_line_stats_start_dump(assembly_line_t *asl,
+        uint32_t period_ms,
+        FILE *out) {
+
+    assert(!asl->stats_dump_thread && period_ms);
+
+    asl->stats_dump_period_ms = period_ms;
+    asl->stats_dump_out = out;
+    asl->stats_dump_thread =
+        create_thread(0, "assembly_line_stats_dump_thread", THREAD_ANY);
+    run_thread(asl->stats_dump_thread, assembly_line_stats_dump_fn, (void *)asl);
+}
+
+#endif
 
 #if 1
 
@@ -26,9 +26,13 @@
 #ifndef __THREAD_LIB__
 #define __THREAD_LIB__
 
+#include <stdio.h>
 #include <pthread.h>
+#include <time.h>
 #include <semaphore.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
 #include "../gluethread/glthread.h"
 #include "Fifo_Queue.h"
 
@@ -51,10 +55,14 @@ typedef struct thread_{
     pthread_attr_t attributes;
     thread_op_type_t thread_op;
     glthread_t wait_glue;
+    /* Position in a thread pool or a priority wait queue */
+    glthread_skip_node_t wait_skip_node;
 	uint32_t flags;
 } thread_t;
 GLTHREAD_TO_STRUCT(wait_glue_to_thread,
         thread_t, wait_glue);
+GLTHREAD_TO_STRUCT(wait_skip_node_to_thread,
+        thread_t, wait_skip_node);
 
 thread_t *
 create_thread(thread_t *thread, char *name,
@@ -81,11 +89,17 @@ thread_lib_print_thread(thread_t *thread);
 
 /* Thread Pool Begin */
 
+typedef struct task_scheduler_ task_scheduler_t;
+
 typedef struct thread_pool_ {
   
-  glthread_t pool_head;
+  /* Parked threads, ordered by comp_fn */
+  glthread_skiplist_t pool_skiplist;
   int (*comp_fn)(void *, void *);
   pthread_mutex_t mutex;
+  /* Non-NULL when the pool runs in task-queue mode, see
+     thread_pool_enable_task_queue_mode( ) */
+  task_scheduler_t *task_sched;
 } thread_pool_t;
 
 typedef struct thread_execution_data_ {
@@ -105,7 +119,9 @@ typedef struct thread_execution_data_ {
     thread_t *thread;
 } thread_execution_data_t;
 
-void
+/* Returns false if the pool could not take the thread, i.e. in task-queue
+   mode once max_threads workers are running. The caller keeps the thread */
+bool
 thread_pool_insert_new_thread(thread_pool_t *th_pool, thread_t *thread);
 
 thread_t *
@@ -114,18 +130,135 @@ thread_pool_get_thread(thread_pool_t *th_pool);
 void
 thread_pool_init(thread_pool_t *th_pool, int (*comp_fn)(void *, void *));
 
-void
+/* Returns false if the work was not taken : no parked thread, or the
+   task scheduler of a task-queue mode pool is shut down. thread_fn has
+   then not run, even with block_caller */
+bool
 thread_pool_dispatch_thread (thread_pool_t *th_pool,
                             void *(*thread_fn)(void *),
                             void *arg,
                             bool block_caller);
 
+/* Switch the thread pool to task-queue mode. Must be called right after
+   thread_pool_init( ) and before any thread is inserted. In this mode every
+   thread inserted into the pool becomes a work-stealing worker, and
+   thread_pool_dispatch_thread( ) queues the work instead of handing it
+   to a parked thread, so work is never lost when all threads are busy */
+void
+thread_pool_enable_task_queue_mode(thread_pool_t *th_pool,
+                                   uint32_t max_threads,
+                                   uint32_t deque_size);
+
 /* Thread Pool End */
 
 
 
 
 
+/* Work Stealing Task Scheduler Begin */
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+/* Default no of slots in each worker's deque, must be power of 2 */
+#define WS_DEQUE_DEF_SIZE   1024
+
+typedef struct ws_task_ {
+
+    /* Actual user defined work and its argument */
+    void *(*task_fn)(void *);
+    void *arg;
+    /* Posted when task is done, if submitter chose to block */
+    sem_t *semaphore;
+    /* Glue for the scheduler's injection list */
+    struct ws_task_ *next;
+} ws_task_t;
+
+/* Bounded Chase-Lev deque. Owner worker pushes and pops at bottom,
+   thieves steal from top. top and bottom live on separate cache lines
+   so that thieves do not bounce the owner's line */
+typedef struct ws_deque_ {
+
+    _Alignas(CACHE_LINE_SIZE) _Atomic int64_t top;
+    _Alignas(CACHE_LINE_SIZE) _Atomic int64_t bottom;
+    _Alignas(CACHE_LINE_SIZE) _Atomic(ws_task_t *) *buffer;
+    uint32_t mask;
+} ws_deque_t;
+
+typedef struct ws_worker_ {
+
+    ws_deque_t deque;
+    task_scheduler_t *sched;
+    uint32_t worker_id;
+    /* Seed for random victim selection */
+    uint32_t rand_seed;
+    thread_t *thread;
+    /* Created by task_scheduler_add_worker( ), freed with the scheduler */
+    bool own_thread;
+} ws_worker_t;
+
+struct task_scheduler_ {
+
+    /* Fixed array of workers, deques are allocated upfront so that
+       thieves can scan them without any lock */
+    ws_worker_t *workers;
+    uint32_t max_workers;
+    /* Workers fully set up and running, thieves only look at these */
+    _Atomic uint32_t n_workers;
+    /* Serializes task_scheduler_add_worker( ) and the shutdown */
+    pthread_mutex_t workers_mutex;
+    /* Lock-free LIFO list of tasks submitted by non-worker threads */
+    _Alignas(CACHE_LINE_SIZE) _Atomic(ws_task_t *) inject_head;
+    /* Idle workers sleep on this semaphore */
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint32_t n_idle;
+    sem_t idle_sem;
+    _Atomic bool shutdown;
+    /* Stats */
+    _Atomic uint64_t n_submitted;
+    _Atomic uint64_t n_executed;
+    _Atomic uint64_t n_stolen;
+};
+
+task_scheduler_t *
+task_scheduler_create(uint32_t max_workers, uint32_t deque_size);
+
+/* Bind a new worker to thread (created if NULL) and start it. Returns
+   false if scheduler already has max_workers workers or is shut down, a
+   thread passed in then still belongs to the caller */
+bool
+task_scheduler_add_worker(task_scheduler_t *sched, thread_t *thread);
+
+/* Submission itself never blocks : from a worker thread the task goes to
+   worker's own deque (executed inline if deque is full), from any other
+   thread it goes to the lock-free injection list. If block_caller is true,
+   the caller waits until task has been executed */
+bool
+task_scheduler_submit(task_scheduler_t *sched,
+                      void *(*task_fn)(void *),
+                      void *arg,
+                      bool block_caller);
+
+/* Drains all pending tasks, stops and joins all workers. Further calls
+   do nothing */
+void
+task_scheduler_shutdown(task_scheduler_t *sched);
+
+/* Shuts the scheduler down if not done yet and frees it, along with the
+   threads it created. Threads passed to task_scheduler_add_worker( ) are
+   joined but left to the caller */
+void
+task_scheduler_destroy(task_scheduler_t *sched);
+
+void
+task_scheduler_print_stats(task_scheduler_t *sched);
+
+/* Work Stealing Task Scheduler End */
+
+
+
+
+
 /*
   Visit : www.csepracticals.com for more courses and projects
   Join Telegram Grp : telecsepracticals
@@ -212,8 +345,8 @@ typedef struct wait_queue_
   pthread_cond_t cv;
  /* Application owned Mutex cached by wait-queue */ 
   pthread_mutex_t *appln_mutex;
-  /* List of threads blocked on this wait Queue */
-  glthread_t priority_wait_queue_head;  
+  /* Threads blocked on this wait Queue, ordered by insert_cmp_fn */
+  glthread_skiplist_t priority_wait_queue;
   /* Comparison fn to insert the threads in the PQ */
   int (*insert_cmp_fn)(void *, void *);
   /* Unlock application mutex automatically, true by default */
@@ -249,6 +382,64 @@ wait_queue_print(wait_queue_t *wq);
 
 
 
+/* Futex wait queue Implementation starts here */
+
+/*
+   Drop-in alternative of wait_queue_t built on an atomic state word and
+   Linux futex. Same test-and-wait contract (wait_queue_block_fn), but
+   - signal/broadcast is a single atomic load when no thread is waiting,
+     and never needs the application mutex
+   - a waiter spins briefly on the state word before sleeping in kernel
+   FIFO ordering only, there is no priority variant. The application must
+   update the predicate under the application mutex, as with wait_queue_t
+*/
+typedef struct futex_wait_queue_
+{
+  /* No of threads waiting in a wait-queue (spinning or sleeping) */
+  _Atomic uint32_t thread_wait_count;
+  /* No of threads sleeping in kernel on futex_word */
+  _Atomic uint32_t n_sleepers;
+  /* Futex word, bumped by every signal/broadcast */
+  _Atomic uint32_t futex_word;
+  /* Application owned Mutex cached by wait-queue */
+  pthread_mutex_t *appln_mutex;
+  /* Unlock application mutex automatically, true by default */
+  bool auto_unlock_appln_mutex;
+} futex_wait_queue_t;
+
+/* No of times a waiter polls the futex word before sleeping */
+#define FUTEX_WQ_SPIN_COUNT 100
+
+void
+futex_wait_queue_init (futex_wait_queue_t *wq);
+
+void
+futex_wait_queue_set_auto_unlock_appln_mutex(futex_wait_queue_t *wq,
+                                             bool state);
+
+thread_t *
+futex_wait_queue_test_and_wait (futex_wait_queue_t *wq,
+                                wait_queue_block_fn wait_queue_block_fn_cb,
+                                void *arg,
+                                thread_t *thread);
+
+/* lock_mutex is accepted for parity with wait_queue_signal( ), futex
+   wait queue never needs the application mutex to signal */
+void
+futex_wait_queue_signal (futex_wait_queue_t *wq, bool lock_mutex);
+
+void
+futex_wait_queue_broadcast (futex_wait_queue_t *wq, bool lock_mutex);
+
+void
+futex_wait_queue_print(futex_wait_queue_t *wq);
+
+/* Futex wait queue Implementation ends here */
+
+
+
+
+
 /*
   Visit : www.csepracticals.com for more courses and projects
   Join Telegram Grp : telecsepracticals
@@ -431,6 +622,116 @@ typedef enum {
 
 typedef struct asl_worker_ asl_worker_t;
 
+/* Order in which a slot with several replicas hands its objects over */
+typedef enum {
+
+    /* Reassembled in arrival order through a reorder buffer */
+    ASL_SLOT_IN_ORDER,
+    /* As soon as a replica is done with it */
+    ASL_SLOT_UNORDERED
+} asl_slot_order_t;
+
+/* Upper bound of replica workers per slot */
+#define ASL_MAX_REPLICAS            16
+/* Capacity of the input queue of every slot */
+#define ASL_SLOT_QUEUE_SIZE         256
+/* Objects an in-order slot may hold back waiting for an older one,
+   power of 2 */
+#define ASL_REORDER_WINDOW          256
+/* Auto-scaling samples the slot queues this often */
+#define ASL_AUTOSCALE_PERIOD_MS     20
+/* and ignores slots with fewer objects queued */
+#define ASL_AUTOSCALE_MIN_DEPTH     4
+
+/* A slot of a replicated assembly line. Its replicas all pull from in_q,
+   the slot hands the objects over to the in_q of the next slot */
+typedef struct asl_slot_ {
+
+    uint32_t slot_no;
+    asl_slot_order_t order;
+    /* Replicas requested / running */
+    uint32_t n_replicas;
+    uint32_t n_running;
+    Fifo_Mpmc_Queue_t *in_q;
+    /* Reorder buffer, ASL_SLOT_IN_ORDER only. Indexed by the in_q ticket,
+       rob_next is the ticket of the next object to hand over */
+    void **rob;
+#ifdef ASL_STATS
+    uint64_t *rob_stamps;
+#endif
+    size_t rob_next;
+    uint32_t n_rob_waiters;
+    pthread_mutex_t rob_mutex;
+    pthread_cond_t rob_cv;
+    /* List of replica workers */
+    glthread_t replicas_head;
+} asl_slot_t;
+
+#ifdef ASL_STATS
+/* Per slot instrumentation, built with -DASL_STATS, see
+ * assembly_line_stats_snapshot( ). Every worker keeps its own counters and
+ * histograms so that recording takes no lock. The lockstep line times every
+ * cycle, a cycle already costs a round of cv signals. A replicated line
+ * times one item in ASL_STATS_SAMPLE : assembly_line_push_new_item( ) stamps
+ * it, and the stamp travels with it through the slot queues */
+
+/* 1 to time every item */
+#ifndef ASL_STATS_SAMPLE
+#define ASL_STATS_SAMPLE    64
+#endif
+
+/* Log-linear latency histogram of TSC ticks : 32 buckets per power of 2,
+ * about 3% precision, values from 0 to 2^LAT_HIST_MAX_BITS */
+#define LAT_HIST_SUB_BITS   5
+#define LAT_HIST_MAX_BITS   42
+#define LAT_HIST_N_BUCKETS  \
+    ((LAT_HIST_MAX_BITS - LAT_HIST_SUB_BITS + 1) << LAT_HIST_SUB_BITS)
+
+typedef struct lat_hist_ {
+
+    uint64_t count[LAT_HIST_N_BUCKETS];
+} lat_hist_t;
+
+typedef struct asl_worker_stats_ {
+
+    /* Slot whose work fn the worker runs */
+    uint32_t slot_no;
+    uint64_t n_items;
+    /* From the item being ready for this slot to the work fn picking it */
+    lat_hist_t wait;
+    /* Work fn, per item */
+    lat_hist_t service;
+} asl_worker_stats_t;
+
+/* Times in ns, percentiles are the upper bound of their bucket */
+typedef struct asl_slot_snapshot_ {
+
+    uint32_t slot_no;
+    uint32_t n_workers;
+    /* Items queued to the slot, the wait list for slot 0 of a lockstep
+     * line whose other slots never queue */
+    uint32_t queue_depth;
+    uint64_t n_items;
+    /* Average since assembly_line_get_new_assembly_line( ) */
+    double items_per_sec;
+    uint64_t wait_p50_ns;
+    uint64_t wait_p99_ns;
+    uint64_t wait_p999_ns;
+    uint64_t wait_max_ns;
+    uint64_t service_p50_ns;
+    uint64_t service_p99_ns;
+    uint64_t service_p999_ns;
+    uint64_t service_max_ns;
+} asl_slot_snapshot_t;
+#endif
+
+/* Unit moved through a batched line, see assembly_line_set_batching( ) */
+typedef struct asl_batch_ {
+
+    uint32_t n_items;
+    void *items[0];
+} asl_batch_t;
+
 typedef struct assembly_line_ {
 	
 	/* Name of the Assembly line */
@@ -464,6 +765,36 @@ typedef struct assembly_line_ {
         /* Cache the last worker thread, used to remove the ASL item
          * from ASL Queue eventually */
         struct asl_worker_ *Tn;
+        /* Slots are fed through queues by replica workers instead of
+         * the lockstep engine, see assembly_line_set_slot_replicas( ) */
+        bool replicated;
+        asl_slot_t *slots;
+        /* Replicas the auto-scaling may run in total, 0 if disabled */
+        uint32_t autoscale_max_workers;
+        uint32_t n_replicas_total;
+        /* Set under mutex by assembly_line_stop_autoscale( ) */
+        bool autoscale_stop;
+        /* Batch mode, asl_q and wait_lst_fq hold asl_batch_t of up to
+         * batch_size items. 1 if disabled */
+        uint32_t batch_size;
+        uint32_t batch_deadline_us;
+        /* Batch being filled by assembly_line_push_new_item( ), and when
+         * it enters the line even if not full */
+        asl_batch_t *open_batch;
+        struct timespec open_batch_deadline;
+#ifdef ASL_STATS
+        /* Origin of the stats clock, to turn ticks into ns */
+        uint64_t stats_start_ticks;
+        struct timespec stats_start;
+        /* Lockstep line : when the item of every asl_q index, of every
+         * wait list index and the open batch got ready for its next slot */
+        uint64_t *elem_ready_ticks;
+        uint64_t *wait_lst_ticks;
+        uint64_t open_batch_ticks;
+        uint32_t stats_dump_period_ms;
+        FILE *stats_dump_out;
+        thread_t *stats_dump_thread;
+#endif
 } assembly_line_t;
 
 struct asl_worker_ {
@@ -480,6 +811,9 @@ struct asl_worker_ {
 	glthread_t worker_thread_glue;
         /* Worker thread is ready to service assembly line */
 	bool initialized;
+#ifdef ASL_STATS
+        asl_worker_stats_t stats;
+#endif
 };
 GLTHREAD_TO_STRUCT(worker_thread_glue_to_asl_worker_thread,
 				  asl_worker_t, worker_thread_glue);
@@ -500,6 +834,59 @@ void
 assembly_line_push_new_item(assembly_line_t *asl,
 			    void *new_item);
 
+/* Run n_replicas workers on the slot, pulling from a shared queue.
+ * Must be called before assembly_line_init_worker_threads( ), and turns
+ * the whole line into a replicated one : every slot gets its own queue
+ * and at least one replica, objects flow from slot to slot without
+ * waiting for the other slots, and assembly_line_push_new_item( ) blocks
+ * while the first slot is ASL_SLOT_QUEUE_SIZE objects behind. Slots are
+ * ASL_SLOT_IN_ORDER by default. The finished product fn is called
+ * concurrently by the replicas of an ASL_SLOT_UNORDERED last slot */
+void
+assembly_line_set_slot_replicas(assembly_line_t *asl,
+                                uint32_t slot,
+                                uint32_t n_replicas,
+                                asl_slot_order_t order);
+
+/* Batch mode of the lockstep line : items are grouped in batches of up to
+ * batch_size, every worker runs its work fn on the whole batch of its slot
+ * per cycle, so the engine signals and the workers synchronize once per
+ * batch instead of once per item. A partial batch enters the line once its
+ * first item has waited deadline_us. Must be called before the first
+ * assembly_line_push_new_item( ), not supported by replicated lines */
+void
+assembly_line_set_batching(assembly_line_t *asl,
+                           uint32_t batch_size,
+                           uint32_t deadline_us);
+
+#ifdef ASL_STATS
+/* Fills asl->asl_size snapshots, one per slot. Safe to call while the
+ * line is running */
+void
+assembly_line_stats_snapshot(assembly_line_t *asl,
+                             asl_slot_snapshot_t *snapshots);
+
+void
+assembly_line_stats_dump(assembly_line_t *asl, FILE *out);
+
+/* Dumps every period_ms, with rates over the period */
+void
+assembly_line_stats_start_dump(assembly_line_t *asl,
+                               uint32_t period_ms,
+                               FILE *out);
+#endif
+
+/* Replicated line whose engine thread periodically adds a replica to the
+ * slot with the longest queue, until max_workers replicas run in total */
+void
+assembly_line_enable_autoscale(assembly_line_t *asl,
+                               uint32_t max_workers);
+
+/* Stops the auto-scaling engine and joins it, the replicas it added keep
+ * running. Also reaps an engine which is done with its budget */
+void
+assembly_line_stop_autoscale(assembly_line_t *asl);
+
 /*
  * Ques : 
  * Joining the two Assembly lines end-to-end
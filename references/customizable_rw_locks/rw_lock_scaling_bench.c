@@ -0,0 +1,93 @@
+/*
+ * Reader scaling benchmark : default rw_lock_t vs scalable readers flavor.
+ * Runs 1 to N reader threads (N = argv[1], default no of CPUs) doing short
+ * read-side critical sections, with one writer thread taking the lock
+ * every millisecond.
+ *
+ * gcc -O2 -g rw_locks.c rw_lock_scaling_bench.c -o rw_lock_scaling_bench -lpthread
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include "rw_locks.h"
+
+#define BENCH_DURATION_MS   500
+
+static rw_lock_t rw_lock;
+static _Atomic bool stop;
+static uint64_t shared_data[8];
+
+static void *
+bench_read_thread_fn (void *arg) {
+
+    uint64_t n_ops = 0, sum = 0;
+
+    while (!stop) {
+        rw_lock_rd_lock(&rw_lock);
+        sum += shared_data[n_ops & 7];
+        rw_lock_unlock(&rw_lock);
+        n_ops++;
+    }
+    *(uint64_t *)arg = n_ops;
+    return (void *)(uintptr_t)sum;
+}
+
+static void *
+bench_write_thread_fn (void *arg) {
+
+    uint64_t n_ops = 0;
+
+    while (!stop) {
+        rw_lock_wr_lock(&rw_lock);
+        shared_data[n_ops++ & 7]++;
+        rw_lock_unlock(&rw_lock);
+        usleep(1000);
+    }
+    *(uint64_t *)arg = n_ops;
+    return NULL;
+}
+
+static double
+bench_run (bool scalable, int n_readers) {
+
+    int i;
+    pthread_t writer, readers[n_readers];
+    uint64_t reader_ops[n_readers], writer_ops = 0, total = 0;
+
+    if (scalable) rw_lock_init_scalable(&rw_lock);
+    else rw_lock_init(&rw_lock);
+
+    stop = false;
+    pthread_create(&writer, NULL, bench_write_thread_fn, &writer_ops);
+    for (i = 0; i < n_readers; i++) {
+        pthread_create(&readers[i], NULL, bench_read_thread_fn, &reader_ops[i]);
+    }
+
+    usleep(BENCH_DURATION_MS * 1000);
+    stop = true;
+
+    for (i = 0; i < n_readers; i++) {
+        pthread_join(readers[i], NULL);
+        total += reader_ops[i];
+    }
+    pthread_join(writer, NULL);
+    rw_lock_destroy(&rw_lock);
+    return (double)total / (BENCH_DURATION_MS * 1000.0);
+}
+
+int
+main(int argc, char **argv) {
+
+    int n;
+    int max_readers = argc > 1 ? atoi(argv[1]) :
+                        (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (max_readers < 1) max_readers = 1;
+
+    printf("%8s %20s %20s\n", "readers", "default (Mops/s)", "scalable (Mops/s)");
+    for (n = 1; n <= max_readers; n = (n < 4) ? n + 1 : n * 2) {
+        printf("%8d %20.2f %20.2f\n", n, bench_run(false, n), bench_run(true, n));
+    }
+    return 0;
+}
@@ -1,6 +1,25 @@
+#define _GNU_SOURCE
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
 #include "rw_locks.h"
 
+/* Scalable readers flavor : a thread remembers the locks it holds through
+   the fast path, so that rw_lock_unlock( ) knows which slot to release */
+#define RW_LOCK_MAX_FAST_HELD   8
+
+typedef struct rw_lock_fast_hold_ {
+
+    rw_lock_t *rw_lock;
+    uint32_t slot;
+    uint32_t count;
+} rw_lock_fast_hold_t;
+
+static __thread rw_lock_fast_hold_t rw_lock_fast_holds[RW_LOCK_MAX_FAST_HELD];
+static __thread uint32_t rw_lock_n_fast_holds;
+
 void
 rw_lock_init (rw_lock_t *rw_lock) {
 
@@ -16,6 +35,172 @@ rw_lock_init (rw_lock_t *rw_lock) {
     rw_lock->n_max_writers = RW_LOCK_MAX_WRITER_THREADS_DEF;
     rw_lock->biasedness = RW_LOCK_BIASEDNESS_DEF;
     rw_lock->who_used_cs = true;
+    rw_lock->reader_slots = NULL;
+    atomic_init(&rw_lock->reader_bias, false);
+    rw_lock->reader_bias_inhibit_until = 0;
+}
+
+void
+rw_lock_init_scalable (rw_lock_t *rw_lock) {
+
+    rw_lock_init(rw_lock);
+    rw_lock->reader_slots = aligned_alloc(RW_LOCK_CACHE_LINE_SIZE,
+            RW_LOCK_N_READER_SLOTS * sizeof(rw_lock_reader_slot_t));
+    memset(rw_lock->reader_slots, 0,
+            RW_LOCK_N_READER_SLOTS * sizeof(rw_lock_reader_slot_t));
+    atomic_store(&rw_lock->reader_bias, true);
+}
+
+static uint64_t
+rw_lock_now_ns(void) {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint32_t
+rw_lock_get_reader_slot(void) {
+
+    static _Atomic uint32_t next_thread_idx;
+    static __thread int32_t thread_idx = -1;
+    int cpu = sched_getcpu();
+
+    if (cpu >= 0) {
+        return (uint32_t)cpu & (RW_LOCK_N_READER_SLOTS - 1);
+    }
+
+    /* No per-CPU info, spread threads over slots round robin */
+    if (thread_idx < 0) {
+        thread_idx = atomic_fetch_add(&next_thread_idx, 1);
+    }
+    return (uint32_t)thread_idx & (RW_LOCK_N_READER_SLOTS - 1);
+}
+
+static rw_lock_fast_hold_t *
+rw_lock_find_fast_hold(rw_lock_t *rw_lock) {
+
+    uint32_t i;
+
+    for (i = 0; i < rw_lock_n_fast_holds; i++) {
+        if (rw_lock_fast_holds[i].rw_lock == rw_lock) {
+            return &rw_lock_fast_holds[i];
+        }
+    }
+    return NULL;
+}
+
+/* Reader fast path. Returns false if caller must take the slow path */
+static bool
+rw_lock_rd_lock_fast (rw_lock_t *rw_lock) {
+
+    uint32_t slot;
+    rw_lock_fast_hold_t *hold;
+
+    if (!rw_lock->reader_slots) return false;
+
+    /* Already holding it via fast path, just nest. Before the bias test :
+       a writer clears the bias then waits for our slot to drain, so going
+       the slow path here would wait for that writer, i.e. for ourself */
+    hold = rw_lock_find_fast_hold(rw_lock);
+    if (hold) {
+        hold->count++;
+        return true;
+    }
+
+    if (!atomic_load_explicit(&rw_lock->reader_bias, memory_order_relaxed)) {
+        return false;
+    }
+
+    if (rw_lock_n_fast_holds == RW_LOCK_MAX_FAST_HELD) {
+        return false;
+    }
+
+    slot = rw_lock_get_reader_slot();
+    atomic_fetch_add(&rw_lock->reader_slots[slot].n_readers, 1);
+
+    /* Re-check after publishing ourself, a writer which cleared the bias
+       before this point will wait for our slot to drain */
+    if (!atomic_load(&rw_lock->reader_bias)) {
+        atomic_fetch_sub(&rw_lock->reader_slots[slot].n_readers, 1);
+        return false;
+    }
+
+    hold = &rw_lock_fast_holds[rw_lock_n_fast_holds++];
+    hold->rw_lock = rw_lock;
+    hold->slot = slot;
+    hold->count = 1;
+    return true;
+}
+
+/* Returns false if caller did not acquire the lock via fast path */
+static bool
+rw_lock_unlock_fast (rw_lock_t *rw_lock) {
+
+    rw_lock_fast_hold_t *hold;
+
+    if (!rw_lock->reader_slots) return false;
+
+    hold = rw_lock_find_fast_hold(rw_lock);
+    if (!hold) return false;
+
+    if (--hold->count) return true;
+
+    atomic_fetch_sub_explicit(&rw_lock->reader_slots[hold->slot].n_readers,
+            1, memory_order_release);
+    *hold = rw_lock_fast_holds[--rw_lock_n_fast_holds];
+    return true;
+}
+
+/* Assumes state mutex is already locked. Stops new readers from taking
+   the fast path */
+static void
+rw_lock_revoke_reader_bias (rw_lock_t *rw_lock) {
+
+    if (!rw_lock->reader_slots) return;
+    atomic_store(&rw_lock->reader_bias, false);
+}
+
+/* Assumes state mutex is already locked, and the calling writer already
+   owns the lock. Waits for all fast path readers to leave C.S */
+static void
+rw_lock_drain_fast_readers (rw_lock_t *rw_lock) {
+
+    uint32_t i;
+    uint64_t start;
+
+    if (!rw_lock->reader_slots) return;
+
+    start = rw_lock_now_ns();
+
+    for (i = 0; i < RW_LOCK_N_READER_SLOTS; i++) {
+        while (atomic_load_explicit(&rw_lock->reader_slots[i].n_readers,
+                    memory_order_acquire)) {
+            sched_yield();
+        }
+    }
+
+    /* Draining is expensive, keep the fast path off for a while so that
+       write heavy phases do not pay it again and again */
+    rw_lock->reader_bias_inhibit_until = rw_lock_now_ns() +
+        (rw_lock_now_ns() - start) * RW_LOCK_BIAS_INHIBIT_MULTIPLIER;
+}
+
+/* Assumes state mutex is already locked and calling reader owns the lock.
+   Turns the fast path back on when there are no writers around */
+static void
+rw_lock_restore_reader_bias (rw_lock_t *rw_lock) {
+
+    if (!rw_lock->reader_slots ||
+        atomic_load_explicit(&rw_lock->reader_bias, memory_order_relaxed) ||
+        rw_lock->n_writer_waiting ||
+        rw_lock->n_max_readers != RW_LOCK_MAX_READER_THREADS_DEF) {
+        return;
+    }
+
+    if (rw_lock_now_ns() < rw_lock->reader_bias_inhibit_until) return;
+
+    atomic_store(&rw_lock->reader_bias, true);
 }
 
 /* Assumes state mutex is already locked */
@@ -139,6 +324,8 @@ rw_lock_signal(rw_lock_t *rw_lock, bool broadcast,
 void
 rw_lock_rd_lock (rw_lock_t *rw_lock) {
 
+    if (rw_lock_rd_lock_fast(rw_lock)) return;
+
     pthread_mutex_lock(&rw_lock->state_mutex);
 
     EVALUATE_ALL_CONDNS_AGAIN2:
@@ -164,6 +351,7 @@ rw_lock_rd_lock (rw_lock_t *rw_lock) {
         rw_lock->is_locked_by_reader = true;
     }
     rw_lock->n_locks++;
+    rw_lock_restore_reader_bias(rw_lock);
     pthread_mutex_unlock(&rw_lock->state_mutex);
 }
 
@@ -172,6 +360,9 @@ rw_lock_wr_lock (rw_lock_t *rw_lock) {
 
     pthread_mutex_lock(&rw_lock->state_mutex);
 
+    /* No more fast path readers from now on */
+    rw_lock_revoke_reader_bias(rw_lock);
+
     EVALUATE_ALL_CONDNS_AGAIN1:
 
         while (rw_lock->is_locked_by_reader ||
@@ -193,6 +384,8 @@ rw_lock_wr_lock (rw_lock_t *rw_lock) {
     if (rw_lock->n_locks == 0) {
         /* First Writer thread Enter C.S */
         rw_lock->is_locked_by_writer = true;
+        /* Fast path readers do not show up in n_locks, wait for them */
+        rw_lock_drain_fast_readers(rw_lock);
     }
     rw_lock->n_locks++;
     pthread_mutex_unlock(&rw_lock->state_mutex);
@@ -202,6 +395,8 @@ rw_lock_wr_lock (rw_lock_t *rw_lock) {
 void
 rw_lock_unlock (rw_lock_t *rw_lock) {
 
+    if (rw_lock_unlock_fast(rw_lock)) return;
+
     pthread_mutex_lock(&rw_lock->state_mutex);
 
     assert(rw_lock->n_locks);
@@ -267,6 +462,10 @@ rw_lock_destroy(rw_lock_t *rw_lock) {
     pthread_cond_destroy(&rw_lock->cv);
     pthread_cond_destroy(&rw_lock->cv_readers);
     pthread_cond_destroy(&rw_lock->cv_writers);
+    if (rw_lock->reader_slots) {
+        free(rw_lock->reader_slots);
+        rw_lock->reader_slots = NULL;
+    }
 }
 
 void
@@ -275,6 +474,13 @@ rw_lock_set_max_readers_writers(rw_lock_t *rw_lock,
 
     rw_lock->n_max_readers = max_readers;
     rw_lock->n_max_writers = max_writers;
+
+    /* Fast path readers are not counted against n_max_readers */
+    if (max_readers != RW_LOCK_MAX_READER_THREADS_DEF) {
+        pthread_mutex_lock(&rw_lock->state_mutex);
+        rw_lock_revoke_reader_bias(rw_lock);
+        pthread_mutex_unlock(&rw_lock->state_mutex);
+    }
 }
 
 void
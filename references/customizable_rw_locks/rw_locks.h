@@ -4,6 +4,7 @@
 #include <pthread.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 
 #define RW_LOCK_MAX_READER_THREADS_DEF  0xFFFF
 #define RW_LOCK_MAX_WRITER_THREADS_DEF  1
@@ -13,6 +14,20 @@
 #define RW_LOCK_BIASEDNESS_OPPOSITE (3)
 #define RW_LOCK_BIASEDNESS_DEF  RW_LOCK_BIASEDNESS_NEUTRAL
 
+/* Scalable readers flavor : no of per-CPU reader slots, power of 2 */
+#define RW_LOCK_N_READER_SLOTS  64
+#define RW_LOCK_CACHE_LINE_SIZE 64
+/* After a writer revoked the reader bias, fast path stays disabled for
+   this many times the time it took to drain the fast readers */
+#define RW_LOCK_BIAS_INHIBIT_MULTIPLIER 9
+
+/* Each slot sits on its own cache line, readers running on different
+   CPUs never write to the same line */
+typedef struct rw_lock_reader_slot_ {
+
+    _Alignas(RW_LOCK_CACHE_LINE_SIZE) _Atomic uint32_t n_readers;
+} rw_lock_reader_slot_t;
+
 typedef struct rwlock_ {
 
     /* A Mutex to manipulate/inspect the state of rwlock 
@@ -43,6 +58,13 @@ typedef struct rwlock_ {
     uint8_t biasedness;
     /* Who used C.S last time, true for readers, false for writers. default is true */
     bool who_used_cs;
+    /* Scalable readers flavor only, NULL otherwise. Readers which find
+       reader_bias set, enter C.S by just bumping their CPU's slot */
+    rw_lock_reader_slot_t *reader_slots;
+    /* Cleared by writers, fast path readers must then take state_mutex */
+    _Atomic bool reader_bias;
+    /* Time (ns) before which reader_bias must not be set again */
+    uint64_t reader_bias_inhibit_until;
 }rw_lock_t;
 
 static inline bool
@@ -61,6 +83,15 @@ rw_lock_was_cs_used_by_writer_last_time (rw_lock_t *rw_lock) {
 void
 rw_lock_init (rw_lock_t *rw_lock);
 
+/* Init the lock in scalable readers flavor (BRAVO style). Uncontended
+   readers do not touch state_mutex at all, a writer revokes the fast path
+   and drains the fast readers before entering C.S. Fast path is in effect
+   only as long as n_max_readers is unlimited (default), but all other
+   knobs keep working since readers fall back to the slow path as soon
+   as a writer shows up */
+void
+rw_lock_init_scalable (rw_lock_t *rw_lock);
+
 void
 rw_lock_set_max_readers_writers(rw_lock_t *rw_lock,
                                                         uint16_t max_readers, uint16_t max_writers);
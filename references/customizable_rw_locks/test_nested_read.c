@@ -0,0 +1,65 @@
+/*
+ * A reader takes the lock again while it already holds it and a writer
+ * is waiting for it. The nested read must not wait for that writer, the
+ * writer waits for the reader to let go of both holds.
+ *
+ * gcc -g rw_locks.c test_nested_read.c -o test_nested_read -lpthread
+ * Exits 0 on success, killed by SIGALRM if it dead-locks.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <assert.h>
+#include <signal.h>
+#include "rw_locks.h"
+
+static rw_lock_t rw_lock;
+static volatile bool writer_done;
+
+void *
+write_thread_fn (void *arg) {
+
+    rw_lock_wr_lock(&rw_lock);
+    writer_done = true;
+    rw_lock_unlock(&rw_lock);
+    return NULL;
+}
+
+static void
+test_nested_read (bool scalable) {
+
+    pthread_t writer;
+
+    if (scalable) rw_lock_init_scalable(&rw_lock);
+    else rw_lock_init(&rw_lock);
+    writer_done = false;
+
+    rw_lock_rd_lock(&rw_lock);
+
+    pthread_create(&writer, NULL, write_thread_fn, NULL);
+    /* Let the writer revoke the reader bias and block */
+    usleep(100 * 1000);
+
+    rw_lock_rd_lock(&rw_lock);
+    assert(!writer_done);
+    rw_lock_unlock(&rw_lock);
+    assert(!writer_done);
+    rw_lock_unlock(&rw_lock);
+
+    pthread_join(writer, NULL);
+    assert(writer_done);
+    rw_lock_destroy(&rw_lock);
+
+    printf("nested read with waiting writer, %s : ok\n",
+           scalable ? "scalable" : "default");
+}
+
+int
+main(int argc, char **argv) {
+
+    alarm(10);
+    test_nested_read(false);
+    test_nested_read(true);
+    return 0;
+}